@@ -12,7 +12,7 @@ CREATE OR REPLACE FUNCTION pcst_fast(
     costs float8[],            -- array of floats
     root integer,              -- int (or -1 for no root)
     num_clusters integer,      -- int
-    pruning text,              -- string: 'none', 'simple', 'gw', 'strong'
+    pruning text,              -- string: 'none', 'simple', 'gw', 'strong', 'auto'
     verbosity integer          -- int
 )
 RETURNS TABLE(
@@ -258,7 +258,7 @@ CREATE OR REPLACE FUNCTION pgr_pcst_fast(
     nodes_sql text,              -- SQL query returning: id, prize (id can be integer or text)
     root_id text DEFAULT NULL,  -- Root node ID (text, or NULL for auto-select)
     num_clusters integer DEFAULT 1,  -- Number of clusters
-    pruning text DEFAULT 'simple',   -- Pruning method: 'none', 'simple', 'gw', 'strong'
+    pruning text DEFAULT 'simple',   -- Pruning method: 'none', 'simple', 'gw', 'strong', 'auto'
     verbosity integer DEFAULT 0      -- Verbosity level
 )
 RETURNS TABLE(
@@ -318,6 +318,31 @@ COMMENT ON FUNCTION pgr_pcst_fast(text, text, integer, integer, text, integer) I
 'Prize Collecting Steiner Tree Fast algorithm with pg_routing-style interface.
 Overloaded version that accepts integer root_id. Use -1 for auto-select root.';
 
+-- Overload taking the prizes as arrays instead of a nodes query, for callers
+-- that already hold them and want to skip the SPI round trip
+CREATE OR REPLACE FUNCTION pgr_pcst_fast(
+    edges_sql text,             -- SQL query returning: id, source, target, cost
+    node_ids anyarray,          -- node IDs (any type, matched like nodes_sql IDs)
+    prizes float8[],            -- prize of node_ids[i], same length as node_ids
+    root_id text DEFAULT NULL,  -- Root node ID (text, or NULL for auto-select)
+    num_clusters integer DEFAULT 1,  -- Number of clusters
+    pruning text DEFAULT 'simple',   -- Pruning method: 'none', 'simple', 'gw', 'strong', 'auto'
+    verbosity integer DEFAULT 0      -- Verbosity level
+)
+RETURNS TABLE(
+    seq integer,
+    edge text,
+    source text,
+    target text,
+    cost float8
+) AS '$libdir/pcst_fast', 'pcst_fast_pgr_arrays'
+LANGUAGE C;
+
+COMMENT ON FUNCTION pgr_pcst_fast(text, anyarray, float8[], text, integer, text, integer) IS
+'Prize Collecting Steiner Tree Fast algorithm with the prizes given as parallel node_ids and
+prizes arrays instead of a nodes query. IDs are probed against the node IDs of the edges
+query in one pass over the arrays; IDs not in the edges are ignored, NULL entries skipped.';
+
 -- Visualization function for pg_routing-style PCST
 -- Note: This function works with text IDs returned by pgr_pcst_fast
 CREATE OR REPLACE FUNCTION pgr_pcst_fast_with_viz(
@@ -325,7 +350,7 @@ CREATE OR REPLACE FUNCTION pgr_pcst_fast_with_viz(
     nodes_sql text,              -- SQL query returning: id, prize
     root_id text DEFAULT NULL,  -- Root node ID (text, or NULL for auto-select)
     num_clusters integer DEFAULT 1,  -- Number of clusters
-    pruning text DEFAULT 'simple',   -- Pruning method: 'none', 'simple', 'gw', 'strong'
+    pruning text DEFAULT 'simple',   -- Pruning method: 'none', 'simple', 'gw', 'strong', 'auto'
     verbosity integer DEFAULT 0      -- Verbosity level
 )
 RETURNS TEXT AS $$
@@ -588,4 +613,253 @@ $$ LANGUAGE plpgsql;
 
 -- Add comment
 COMMENT ON FUNCTION pgr_pcst_fast_with_viz(text, text, text, integer, text, integer) IS
-'Runs pgr_pcst_fast algorithm and returns ASCII art visualization of the result with edge costs and correct graph layout. Useful for debugging the pg_routing-style interface.';
\ No newline at end of file
+'Runs pgr_pcst_fast algorithm and returns ASCII art visualization of the result with edge costs and correct graph layout. Useful for debugging the pg_routing-style interface.';
+
+-- Solver statistics for a pgr_pcst_fast call: event counters plus current and
+-- peak bytes of every major loader and solver structure
+CREATE OR REPLACE FUNCTION pgr_pcst_fast_stats(
+    edges_sql text,             -- SQL query returning: id, source, target, cost
+    nodes_sql text,              -- SQL query returning: id, prize
+    root_id text DEFAULT NULL,  -- Root node ID (text, or NULL for auto-select)
+    num_clusters integer DEFAULT 1,  -- Number of clusters
+    pruning text DEFAULT 'simple'    -- Pruning method: 'none', 'simple', 'gw', 'strong', 'auto'
+)
+RETURNS TABLE(
+    stat text,                  -- statistic name, e.g. memory.solver.heap_nodes.peak_bytes
+    value float8                -- statistic value
+) AS '$libdir/pcst_fast', 'pcst_fast_pgr_stats'
+LANGUAGE C;
+
+COMMENT ON FUNCTION pgr_pcst_fast_stats(text, text, text, integer, text) IS
+'Runs pgr_pcst_fast and returns solver statistics as (stat, value) rows:
+graph and result sizes, GW event counters, and memory.<structure>.current_bytes /
+memory.<structure>.peak_bytes for the loader (SPI tuptables, ID arrays, node map)
+and the solver (edge parts, heap nodes, priority queues, clusters, pruning buffers).';
+
+-- Rooted strong-pruning payoff of every node of the pruned forest, so candidate
+-- roots (e.g. depot sites) can be ranked from a single solve
+CREATE OR REPLACE FUNCTION pgr_pcst_fast_root_payoffs(
+    edges_sql text,             -- SQL query returning: id, source, target, cost
+    nodes_sql text,              -- SQL query returning: id, prize
+    root_id text DEFAULT NULL,  -- Root node ID (text, or NULL for auto-select)
+    num_clusters integer DEFAULT 1   -- Number of clusters
+)
+RETURNS TABLE(
+    node text,                  -- node of the pruned forest (original ID)
+    component integer,          -- forest component the node belongs to
+    rooted_payoff float8        -- strong pruning payoff of the component rooted at node
+) AS '$libdir/pcst_fast', 'pcst_fast_pgr_root_payoffs'
+LANGUAGE C;
+
+COMMENT ON FUNCTION pgr_pcst_fast_root_payoffs(text, text, text, integer) IS
+'Runs pgr_pcst_fast with strong pruning and returns, for every node of the forest left
+after GW growth, the payoff (prizes minus costs) its component would keep under strong
+pruning if the tree were rooted at that node. The maximum per component is the root that
+strong pruning picks; ORDER BY rooted_payoff DESC ranks candidate roots.';
+
+-- pgr_pcst_fast with prizes on points along edges, like pgRouting's withPoints:
+-- edges are split virtually instead of splitting the network table
+CREATE OR REPLACE FUNCTION pgr_pcst_fast_withpoints(
+    edges_sql text,             -- SQL query returning: id, source, target, cost
+    nodes_sql text,              -- SQL query returning: id, prize
+    points_sql text,             -- SQL query returning: point_id, edge_id, fraction, prize
+    root_id text DEFAULT NULL,  -- Root node ID (text, or NULL for auto-select)
+    num_clusters integer DEFAULT 1,  -- Number of clusters
+    pruning text DEFAULT 'simple',   -- Pruning method: 'none', 'simple', 'gw', 'strong', 'auto'
+    verbosity integer DEFAULT 0      -- Verbosity level
+)
+RETURNS TABLE(
+    seq integer,                -- sequence number
+    edge text,                  -- original edge ID
+    source text,                -- original source node ID of the edge
+    target text,                -- original target node ID of the edge
+    fraction_start float8,      -- selected stretch of the edge, as fractions from source to target
+    fraction_end float8,
+    cost float8                 -- cost of the selected stretch
+) AS '$libdir/pcst_fast', 'pcst_fast_pgr_withpoints'
+LANGUAGE C;
+
+COMMENT ON FUNCTION pgr_pcst_fast_withpoints(text, text, text, text, integer, text, integer) IS
+'Runs pgr_pcst_fast with additional prizes on points along edges. points_sql returns
+(point_id, edge_id, fraction, prize) with fraction in [0, 1] measured from the edge source.
+Edges with points are split into sub-edges inside the loader only; results are mapped back
+to the original edge IDs with the selected fraction range, one row per contiguous stretch.
+Points at fraction 0 or 1 add their prize to the edge''s source or target node.';
+
+-- pgr_pcst_fast returning only what changed against a previous result, for
+-- callers that re-solve often and keep the last tree
+CREATE OR REPLACE FUNCTION pgr_pcst_fast_delta(
+    edges_sql text,             -- SQL query returning: id, source, target, cost
+    nodes_sql text,              -- SQL query returning: id, prize
+    previous_edges anyarray,    -- edge IDs of the previous result (NULL or empty: none)
+    root_id text DEFAULT NULL,  -- Root node ID (text, or NULL for auto-select)
+    num_clusters integer DEFAULT 1,  -- Number of clusters
+    pruning text DEFAULT 'simple'    -- Pruning method: 'none', 'simple', 'gw', 'strong', 'auto'
+)
+RETURNS TABLE(
+    seq integer,                -- sequence number
+    change text,                -- 'added' or 'removed'
+    edge text,                  -- edge ID
+    source text,                -- source node ID (NULL if the edge left the graph)
+    target text,                -- target node ID (NULL if the edge left the graph)
+    cost float8,                -- edge cost (NULL if the edge left the graph)
+    objective_delta float8      -- change of the objective due to this row
+) AS '$libdir/pcst_fast', 'pcst_fast_pgr_delta'
+LANGUAGE C;
+
+COMMENT ON FUNCTION pgr_pcst_fast_delta(text, text, anyarray, text, integer, text) IS
+'Runs pgr_pcst_fast and returns only the edges added to or removed from previous_edges,
+removed edges first. Previous edge IDs are matched against the edges query by value for
+integer IDs and as text otherwise; IDs no longer in the graph are reported as removed with
+NULL source, target and cost. sum(objective_delta) is the change of the objective, prizes of
+the nodes touched by the selected edges minus their costs.';
+
+-- pgr_pcst_fast on many independent graphs in one call, e.g. one per district:
+-- both queries are read once and the groups are solved in parallel
+CREATE OR REPLACE FUNCTION pgr_pcst_fast_grouped(
+    edges_sql text,             -- SQL query returning: group_id, id, source, target, cost
+    nodes_sql text,              -- SQL query returning: group_id, id, prize
+    num_clusters integer DEFAULT 1,  -- Number of clusters per group
+    pruning text DEFAULT 'simple',   -- Pruning method: 'none', 'simple', 'gw', 'strong', 'auto'
+    verbosity integer DEFAULT 0      -- Verbosity level
+)
+RETURNS TABLE(
+    group_id text,              -- group ID (text, can be cast back if needed)
+    seq integer,                -- sequence number within the group
+    edge text,                  -- edge ID
+    source text,                -- source node ID
+    target text,                -- target node ID
+    cost float8                 -- edge cost
+) AS '$libdir/pcst_fast', 'pcst_fast_pgr_grouped'
+LANGUAGE C;
+
+COMMENT ON FUNCTION pgr_pcst_fast_grouped(text, text, integer, text, integer) IS
+'Runs unrooted pgr_pcst_fast on every group of the edges query in one call. Both queries
+carry a leading group_id column; each group is a separate graph with its own node IDs, so
+the same node ID in two groups names two different nodes. Groups are solved in parallel on
+threads from pcst_fast.max_total_threads. Rows come grouped, groups in order of their first
+edge, and seq restarts at 1 in every group, so each group''s rows are what pgr_pcst_fast
+returns for that group alone. Node rows of groups without edges are ignored.';
+
+CREATE OR REPLACE FUNCTION pgr_pcst_fast_frontier(
+    edges_sql text,             -- SQL query taking node IDs as $1, returning: id, source, target, cost
+    nodes_sql text,              -- SQL query returning: id, prize
+    root_id text DEFAULT NULL,   -- Root node ID (NULL for unrooted)
+    num_clusters integer DEFAULT 1,  -- Number of clusters (ignored if root is set)
+    pruning text DEFAULT 'simple',   -- Pruning method: 'none', 'simple', 'gw', 'strong', 'auto'
+    verbosity integer DEFAULT 0      -- Verbosity level
+)
+RETURNS TABLE(
+    seq integer,                -- sequence number
+    edge text,                  -- edge ID
+    source text,                -- source node ID
+    target text,                -- target node ID
+    cost float8                 -- edge cost
+) AS '$libdir/pcst_fast', 'pcst_fast_pgr_frontier'
+LANGUAGE C;
+
+COMMENT ON FUNCTION pgr_pcst_fast_frontier(text, text, text, integer, text, integer) IS
+'pgr_pcst_fast reading only the part of the graph that moat growth reaches. edges_sql is run
+with $1 bound to an array of node IDs, of the type of the ID column of nodes_sql, and must
+return every edge touching one of them once, e.g. WHERE source = ANY($1) OR target = ANY($1)
+over indexed columns. It runs first for the nodes with a nonzero prize and the root, then for
+each batch of nodes growth reaches; nodes without a prize are only read when reached. The
+result is that of pgr_pcst_fast on the whole graph when rooted or when num_clusters does not
+exceed the number of prize nodes, up to how events at equal times are ordered.';
+
+-- A previous result repaired after edges failed, e.g. closed roads or cut
+-- links, without solving the whole graph again
+CREATE OR REPLACE FUNCTION pgr_pcst_fast_repair(
+    edges_sql text,             -- SQL query returning: id, source, target, cost
+    nodes_sql text,              -- SQL query returning: id, prize
+    tree_edges anyarray,        -- edge IDs of the previous result
+    failed_edges anyarray,      -- edge IDs that can no longer be used (NULL or empty: none)
+    root_id text DEFAULT NULL,  -- Root node ID the repaired tree keeps (NULL for none)
+    num_clusters integer DEFAULT 1  -- Clusters of the previous result (ignored if root is set)
+)
+RETURNS TABLE(
+    seq integer,                -- sequence number
+    edge text,                  -- edge ID
+    source text,                -- source node ID
+    target text,                -- target node ID
+    cost float8                 -- edge cost
+) AS '$libdir/pcst_fast', 'pcst_fast_pgr_repair'
+LANGUAGE C;
+
+COMMENT ON FUNCTION pgr_pcst_fast_repair(text, text, anyarray, anyarray, text, integer) IS
+'Repairs the tree tree_edges after failed_edges failed, without solving again. Edge IDs are
+matched like previous_edges of pgr_pcst_fast_delta; tree edges the edges query no longer
+returns count as failed. The pieces left are reconnected along the cheapest paths around
+the failures, and strong pruning keeps a piece only where its prizes minus costs pay for
+the path to it. The result is the piece holding the root, or else the best one. A result
+of num_clusters > 1 trees is repaired tree by tree, the trees told apart by the tree edges
+the edges query returns; trees that lost no edge come back as they were. The search stays
+near the pieces cut off, so a repair takes a fraction of a new solve.';
+
+-- pgr_pcst_fast_repair reading only the edges around the result it repairs
+CREATE OR REPLACE FUNCTION pgr_pcst_fast_repair_frontier(
+    edges_sql text,             -- SQL query taking node IDs as $1, returning: id, source, target, cost
+    nodes_sql text,              -- SQL query returning: id, prize
+    tree_sql text,              -- SQL query returning the previous result: id, source, target
+    failed_edges anyarray,      -- edge IDs that can no longer be used (NULL or empty: none)
+    root_id text DEFAULT NULL,  -- Root node ID the repaired tree keeps (NULL for none)
+    num_clusters integer DEFAULT 1  -- Clusters of the previous result (ignored if root is set)
+)
+RETURNS TABLE(
+    seq integer,                -- sequence number
+    edge text,                  -- edge ID
+    source text,                -- source node ID
+    target text,                -- target node ID
+    cost float8                 -- edge cost
+) AS '$libdir/pcst_fast', 'pcst_fast_pgr_repair_frontier'
+LANGUAGE C;
+
+COMMENT ON FUNCTION pgr_pcst_fast_repair_frontier(text, text, text, anyarray, text, integer) IS
+'pgr_pcst_fast_repair reading edges like pgr_pcst_fast_frontier: edges_sql is run with $1
+bound to an array of node IDs and must return every edge touching one of them once. It runs
+for the ends of the edges tree_sql returns and the root, then for the nodes the search
+reaches, and the repair runs again until it went through no node whose edges were not read.
+Prizes are taken from nodes_sql as nodes are read. The result is that of pgr_pcst_fast_repair
+up to how paths of equal cost are chosen, and the cost of a repair no longer grows with the
+size of the graph.';
+
+-- Solver thread budget shared by all backends (pcst_fast.max_total_threads)
+CREATE OR REPLACE FUNCTION pcst_fast_thread_budget(
+    OUT max_total_threads integer,   -- resolved budget (0 in the setting means one per CPU)
+    OUT threads_in_use integer,      -- threads held by running solves
+    OUT peak_threads_in_use integer, -- highest threads_in_use since server start
+    OUT grants bigint,               -- number of solves that took threads
+    OUT reduced_grants bigint,       -- solves that got fewer threads than requested
+    OUT shared boolean               -- budget is shared between backends
+) AS '$libdir/pcst_fast', 'pcst_fast_thread_budget'
+LANGUAGE C;
+
+COMMENT ON FUNCTION pcst_fast_thread_budget() IS
+'Totals of the server-wide solver thread budget. The budget is only shared between backends
+when pcst_fast is listed in shared_preload_libraries; otherwise shared is false and the
+totals describe the current backend only.';
+
+CREATE OR REPLACE FUNCTION pcst_fast_thread_holders()
+RETURNS TABLE(
+    pid integer,                 -- backend process ID
+    threads_requested integer,
+    threads_granted integer
+) AS '$libdir/pcst_fast', 'pcst_fast_thread_holders'
+LANGUAGE C;
+
+COMMENT ON FUNCTION pcst_fast_thread_holders() IS
+'Backends currently holding threads from the solver thread budget.';
+
+CREATE OR REPLACE VIEW pcst_fast_thread_usage AS
+SELECT h.pid,
+       a.usename,
+       h.threads_requested,
+       h.threads_granted,
+       b.max_total_threads,
+       a.query
+FROM pcst_fast_thread_holders() h
+CROSS JOIN pcst_fast_thread_budget() b
+LEFT JOIN pg_stat_activity a ON a.pid = h.pid;
+
+COMMENT ON VIEW pcst_fast_thread_usage IS
+'Solver threads held per backend, next to the server-wide budget.';
@@ -53,6 +53,10 @@ class PairingHeap {
     return root == NULL;
   }
 
+  static size_t node_size() {
+    return sizeof(Node);
+  }
+
   bool get_min(ValueType* value, PayloadType* payload) {
     if (root != NULL) {
       //printf("In get_min, current root: %x\n", root);
@@ -0,0 +1,236 @@
+#include "pcst_distance_network.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+#include "pcst_fast.h"
+
+using cluster_approx::DistanceNetwork;
+using cluster_approx::PCSTFast;
+using std::make_pair;
+using std::pair;
+using std::vector;
+
+
+static void ignore_output(const char*) {}
+
+
+// Union-find root with path halving
+static int find_component(vector<int>& parent, int node) {
+  while (parent[node] != node) {
+    parent[node] = parent[parent[node]];
+    node = parent[node];
+  }
+  return node;
+}
+
+
+DistanceNetwork::DistanceNetwork(const vector<pair<int, int> >& edges_,
+                                 const vector<double>& prizes_,
+                                 const vector<double>& costs_,
+                                 int root_)
+    : edges(edges_), prizes(prizes_), costs(costs_), root(root_),
+      network_root(-1) {
+  int num_nodes = static_cast<int>(prizes.size());
+  int num_edges = static_cast<int>(edges.size());
+
+  vector<int> region(num_nodes, -1);
+  for (int ii = 0; ii < num_nodes; ++ii) {
+    if (prizes[ii] > 0.0 || ii == root) {
+      region[ii] = static_cast<int>(terminal.size());
+      if (ii == root) {
+        network_root = region[ii];
+      }
+      terminal.push_back(ii);
+      network_prizes.push_back(prizes[ii] > 0.0 ? prizes[ii] : 0.0);
+    }
+  }
+
+  // Incidence lists in CSR form
+  vector<int> adjacency_start(num_nodes + 1, 0);
+  for (int ii = 0; ii < num_edges; ++ii) {
+    adjacency_start[edges[ii].first + 1] += 1;
+    adjacency_start[edges[ii].second + 1] += 1;
+  }
+  for (int ii = 0; ii < num_nodes; ++ii) {
+    adjacency_start[ii + 1] += adjacency_start[ii];
+  }
+  vector<int> adjacency_edge(2 * num_edges);
+  vector<int> fill(adjacency_start.begin(), adjacency_start.end() - 1);
+  for (int ii = 0; ii < num_edges; ++ii) {
+    adjacency_edge[fill[edges[ii].first]++] = ii;
+    adjacency_edge[fill[edges[ii].second]++] = ii;
+  }
+
+  // Multi-source Dijkstra from all terminals; every node joins the region of
+  // its nearest terminal
+  const double kInfinity = std::numeric_limits<double>::infinity();
+  vector<double> distance(num_nodes, kInfinity);
+  vector<bool> settled(num_nodes, false);
+  pred_edge.assign(num_nodes, -1);
+  typedef pair<double, int> QueueEntry;
+  std::priority_queue<QueueEntry, vector<QueueEntry>,
+                      std::greater<QueueEntry> > queue;
+  for (size_t ii = 0; ii < terminal.size(); ++ii) {
+    distance[terminal[ii]] = 0.0;
+    queue.push(make_pair(0.0, terminal[ii]));
+  }
+  while (!queue.empty()) {
+    QueueEntry cur = queue.top();
+    queue.pop();
+    int cur_node = cur.second;
+    if (settled[cur_node]) {
+      continue;
+    }
+    settled[cur_node] = true;
+    for (int ii = adjacency_start[cur_node];
+         ii < adjacency_start[cur_node + 1]; ++ii) {
+      int cur_edge = adjacency_edge[ii];
+      int next_node = edges[cur_edge].first == cur_node
+                      ? edges[cur_edge].second : edges[cur_edge].first;
+      double next_distance = cur.first + costs[cur_edge];
+      if (next_distance < distance[next_node]) {
+        distance[next_node] = next_distance;
+        region[next_node] = region[cur_node];
+        pred_edge[next_node] = cur_edge;
+        queue.push(make_pair(next_distance, next_node));
+      }
+    }
+  }
+
+  // Cheapest path through a boundary edge for every pair of adjacent regions
+  long long num_terminals = static_cast<long long>(terminal.size());
+  std::unordered_map<long long, int> pair_index;
+  for (int ii = 0; ii < num_edges; ++ii) {
+    int uu = edges[ii].first;
+    int vv = edges[ii].second;
+    if (region[uu] < 0 || region[vv] < 0 || region[uu] == region[vv]) {
+      continue;
+    }
+    int aa = std::min(region[uu], region[vv]);
+    int bb = std::max(region[uu], region[vv]);
+    double path_cost = distance[uu] + costs[ii] + distance[vv];
+    std::unordered_map<long long, int>::iterator it =
+        pair_index.find(aa * num_terminals + bb);
+    if (it == pair_index.end()) {
+      pair_index[aa * num_terminals + bb] =
+          static_cast<int>(network_edges.size());
+      network_edges.push_back(make_pair(aa, bb));
+      network_costs.push_back(path_cost);
+      bridge_edge.push_back(ii);
+    } else if (path_cost < network_costs[it->second]) {
+      network_costs[it->second] = path_cost;
+      bridge_edge[it->second] = ii;
+    }
+  }
+}
+
+
+void DistanceNetwork::finish(const vector<int>& network_result_nodes,
+                             const vector<int>& network_result_edges,
+                             vector<int>* result_nodes,
+                             vector<int>* result_edges) const {
+  result_nodes->clear();
+  result_edges->clear();
+  int num_nodes = static_cast<int>(prizes.size());
+  int num_edges = static_cast<int>(edges.size());
+
+  // Nodes on the shortest paths behind the chosen distance edges. A marked
+  // node's whole path to its terminal is marked already.
+  vector<int> local_index(num_nodes, -1);
+  vector<int> touched;
+  for (size_t ii = 0; ii < network_result_nodes.size(); ++ii) {
+    int cur_node = terminal[network_result_nodes[ii]];
+    if (local_index[cur_node] < 0) {
+      local_index[cur_node] = static_cast<int>(touched.size());
+      touched.push_back(cur_node);
+    }
+  }
+  for (size_t ii = 0; ii < network_result_edges.size(); ++ii) {
+    int cur_edge = bridge_edge[network_result_edges[ii]];
+    int ends[2] = {edges[cur_edge].first, edges[cur_edge].second};
+    for (int jj = 0; jj < 2; ++jj) {
+      int cur_node = ends[jj];
+      while (local_index[cur_node] < 0) {
+        local_index[cur_node] = static_cast<int>(touched.size());
+        touched.push_back(cur_node);
+        if (pred_edge[cur_node] < 0) {
+          break;
+        }
+        int path_edge = pred_edge[cur_node];
+        cur_node = edges[path_edge].first == cur_node
+                   ? edges[path_edge].second : edges[path_edge].first;
+      }
+    }
+  }
+  if (touched.size() <= 1) {
+    result_nodes->assign(touched.begin(), touched.end());
+    return;
+  }
+
+  // Minimum spanning tree over the edges between the touched nodes
+  vector<int> candidates;
+  for (int ii = 0; ii < num_edges; ++ii) {
+    if (local_index[edges[ii].first] >= 0
+        && local_index[edges[ii].second] >= 0) {
+      candidates.push_back(ii);
+    }
+  }
+  std::sort(candidates.begin(), candidates.end(),
+            [this](int aa, int bb) {
+              return costs[aa] < costs[bb] || (costs[aa] == costs[bb] && aa < bb);
+            });
+  vector<int> component(touched.size());
+  for (size_t ii = 0; ii < touched.size(); ++ii) {
+    component[ii] = static_cast<int>(ii);
+  }
+  vector<int> tree_edges;
+  vector<pair<int, int> > local_edges;
+  vector<double> local_costs;
+  for (size_t ii = 0; ii < candidates.size(); ++ii) {
+    int uu = local_index[edges[candidates[ii]].first];
+    int vv = local_index[edges[candidates[ii]].second];
+    int cu = find_component(component, uu);
+    int cv = find_component(component, vv);
+    if (cu != cv) {
+      component[cu] = cv;
+      tree_edges.push_back(candidates[ii]);
+      local_edges.push_back(make_pair(uu, vv));
+      local_costs.push_back(costs[candidates[ii]]);
+    }
+  }
+
+  // Strong pruning of the tree, exact on a single tree
+  vector<double> local_prizes(touched.size());
+  for (size_t ii = 0; ii < touched.size(); ++ii) {
+    local_prizes[ii] = prizes[touched[ii]];
+  }
+  int local_root = root >= 0 ? local_index[root] : PCSTFast::kNoRoot;
+  PCSTFast pruner(local_edges, local_prizes, local_costs, local_root,
+                  local_root >= 0 ? 0 : 1, PCSTFast::kStrongPruning, 0,
+                  ignore_output);
+  pruner.set_tree_dp(true);
+  vector<int> pruned_nodes;
+  vector<int> pruned_edges;
+  pruner.run(&pruned_nodes, &pruned_edges);
+  for (size_t ii = 0; ii < pruned_nodes.size(); ++ii) {
+    result_nodes->push_back(touched[pruned_nodes[ii]]);
+  }
+  for (size_t ii = 0; ii < pruned_edges.size(); ++ii) {
+    result_edges->push_back(tree_edges[pruned_edges[ii]]);
+  }
+}
+
+
+size_t DistanceNetwork::memory_bytes() const {
+  return pred_edge.capacity() * sizeof(int)
+         + terminal.capacity() * sizeof(int)
+         + network_edges.capacity() * sizeof(network_edges[0])
+         + network_prizes.capacity() * sizeof(double)
+         + network_costs.capacity() * sizeof(double)
+         + bridge_edge.capacity() * sizeof(int);
+}
@@ -0,0 +1,74 @@
+#ifndef __PCST_DISTANCE_NETWORK_H__
+#define __PCST_DISTANCE_NETWORK_H__
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace cluster_approx {
+
+// Replaces a graph with few prize nodes by the distance network between
+// them. One multi-source Dijkstra from the terminals (the positive-prize
+// nodes and the root) splits the graph into Voronoi regions; every edge
+// between two regions gives a network edge between their terminals, costing
+// the path through it, and the cheapest such path is kept per terminal pair
+// (Mehlhorn's construction). GW then only runs on the network, which has one
+// node per terminal.
+//
+// finish() maps a network solution back: distance edges are expanded into
+// their shortest paths, the nodes touched are reconnected by a minimum
+// spanning tree over the edges between them, and strong pruning of that tree
+// drops the parts not worth their cost.
+//
+// An approximation like GW itself, but not GW's tree on the full graph. Only
+// for solves that want one tree: rooted, or unrooted with one cluster.
+class DistanceNetwork {
+ public:
+  // root is -1 without a root
+  DistanceNetwork(const std::vector<std::pair<int, int> >& edges,
+                  const std::vector<double>& prizes,
+                  const std::vector<double>& costs,
+                  int root);
+
+  // The network. Network node ii is original node terminal[ii]; network_root
+  // is -1 without a root.
+  int num_terminals() const { return static_cast<int>(terminal.size()); }
+  const std::vector<std::pair<int, int> >& get_network_edges() const {
+    return network_edges;
+  }
+  const std::vector<double>& get_network_prizes() const {
+    return network_prizes;
+  }
+  const std::vector<double>& get_network_costs() const {
+    return network_costs;
+  }
+  int get_network_root() const { return network_root; }
+
+  // Map a solution of the network back to a tree of the original graph
+  void finish(const std::vector<int>& network_result_nodes,
+              const std::vector<int>& network_result_edges,
+              std::vector<int>* result_nodes,
+              std::vector<int>* result_edges) const;
+
+  size_t memory_bytes() const;
+
+ private:
+  const std::vector<std::pair<int, int> >& edges;
+  const std::vector<double>& prizes;
+  const std::vector<double>& costs;
+  int root;
+
+  // Shortest path forest of the Voronoi regions
+  std::vector<int> pred_edge;     // next edge towards the terminal, -1 at it
+
+  std::vector<int> terminal;
+  std::vector<std::pair<int, int> > network_edges;
+  std::vector<double> network_prizes;
+  std::vector<double> network_costs;
+  std::vector<int> bridge_edge;   // original edge joining the two regions
+  int network_root;
+};
+
+}  // namespace cluster_approx
+
+#endif
@@ -0,0 +1,45 @@
+#include "pcst_edge_source.h"
+
+#include <algorithm>
+#include <vector>
+
+using cluster_approx::VectorEdgeSource;
+
+
+bool VectorEdgeSource::next(double max_cost, int* source, int* target,
+                            double* cost, int* id) {
+  if (next_edge >= costs.size()) {
+    return false;
+  }
+  int ii = order.empty() ? static_cast<int>(next_edge) : order[next_edge];
+  if (costs[ii] > max_cost) {
+    return false;
+  }
+  next_edge += 1;
+  *source = edges[ii].first;
+  *target = edges[ii].second;
+  *cost = costs[ii];
+  *id = ii;
+  return true;
+}
+
+
+void VectorEdgeSource::rewind() {
+  next_edge = 0;
+  order.clear();
+  bool sorted = true;
+  for (size_t ii = 1; ii < costs.size() && sorted; ++ii) {
+    sorted = costs[ii - 1] <= costs[ii];
+  }
+  if (sorted) {
+    return;
+  }
+  order.resize(costs.size());
+  for (size_t ii = 0; ii < costs.size(); ++ii) {
+    order[ii] = static_cast<int>(ii);
+  }
+  std::stable_sort(order.begin(), order.end(),
+                   [this](int aa, int bb) {
+                     return costs[aa] < costs[bb];
+                   });
+}
@@ -0,0 +1,50 @@
+#ifndef __PCST_EDGE_SOURCE_H__
+#define __PCST_EDGE_SOURCE_H__
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace cluster_approx {
+
+// Edges handed to lazy edge insertion in order of nondecreasing cost. The
+// solver reads only as far as growth gets, so a source backed by a file
+// never needs the rest of its edges in memory.
+class EdgeSource {
+ public:
+  virtual ~EdgeSource() {}
+
+  // Read the next edge if there is one and its cost is at most max_cost.
+  // id names the edge in the solver's result.
+  virtual bool next(double max_cost, int* source, int* target, double* cost,
+                    int* id) = 0;
+
+  // Back to the first edge, before every solve
+  virtual void rewind() = 0;
+
+  virtual long long num_edges() const = 0;
+};
+
+// Edges in memory, visited through a stable sort by cost unless they are
+// sorted already. id is the index into the vectors.
+class VectorEdgeSource : public EdgeSource {
+ public:
+  VectorEdgeSource(const std::vector<std::pair<int, int> >& edges_,
+                   const std::vector<double>& costs_)
+      : edges(edges_), costs(costs_), next_edge(0) {}
+
+  bool next(double max_cost, int* source, int* target, double* cost,
+            int* id);
+  void rewind();
+  long long num_edges() const { return static_cast<long long>(costs.size()); }
+
+ private:
+  const std::vector<std::pair<int, int> >& edges;
+  const std::vector<double>& costs;
+  std::vector<int> order;   // empty when the costs are sorted
+  size_t next_edge;
+};
+
+}  // namespace cluster_approx
+
+#endif
@@ -0,0 +1,652 @@
+#include "pcst_exact.h"
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "pcst_fast.h"
+
+using cluster_approx::ExactComponents;
+using cluster_approx::PCSTFast;
+using std::make_pair;
+using std::pair;
+using std::vector;
+
+
+// Subproblems per improve(), over all components; each is a GW solve on at
+// most max_nodes nodes
+static const long long kMaxSubproblems = 10000;
+
+// Values this close, relative to the prize total, count as equal
+static const double kRelativeTolerance = 1e-9;
+
+// Subproblem state of a node
+static const signed char kUndecided = 0;
+static const signed char kIn = 1;
+static const signed char kOut = 2;
+
+
+static void ignore_output(const char*) {}
+
+
+// Union-find root with path halving
+static int find_component(vector<int>& parent, int node) {
+  while (parent[node] != node) {
+    parent[node] = parent[parent[node]];
+    node = parent[node];
+  }
+  return node;
+}
+
+
+namespace {
+
+// Wong's dual ascent on the trees of a subproblem, seen as Steiner
+// arborescences: arcs both ways along every edge, and for every node with a
+// prize or fixed in a terminal that is reached from the node at cost 0 and,
+// unless the node is fixed in, straight from the root at the cost of the
+// prize. Such an arborescence costs what the tree costs plus the prizes it
+// leaves out, so the ascent bounds the GW objective from below, usually
+// much closer than the GW moats. The reduced costs it leaves bound each
+// node as well: a tree containing the node costs at least the bound plus
+// the reduced distance of the node from the root.
+class DualAscent {
+ public:
+  // Node 0 is the root. Returns the bound, infinity when a node fixed in
+  // cannot be reached.
+  double run(int num_nodes, const vector<pair<int, int> >& edges,
+             const vector<double>& costs, const vector<double>& prizes,
+             const vector<bool>& fixed_in);
+
+  // After run(): reduced distance of every node from the root
+  void root_distances(vector<double>* distance) const;
+
+ private:
+  void add_arc(int tail, int head, double cost);
+
+  int num_nodes;
+  vector<int> arc_tail;
+  vector<int> arc_head;
+  vector<double> reduced;
+  vector<int> in_begin;         // arcs into node ii: in_arcs[in_begin[ii]..]
+  vector<int> in_arcs;
+  vector<int> active;
+  vector<int> next_active;
+  vector<int> cut;              // nodes reaching the current terminal
+  vector<int> mark;             // visit stamp per node
+};
+
+
+void DualAscent::add_arc(int tail, int head, double cost) {
+  arc_tail.push_back(tail);
+  arc_head.push_back(head);
+  reduced.push_back(cost);
+}
+
+
+double DualAscent::run(int num_nodes_, const vector<pair<int, int> >& edges,
+                       const vector<double>& costs,
+                       const vector<double>& prizes,
+                       const vector<bool>& fixed_in) {
+  num_nodes = num_nodes_;
+  arc_tail.clear();
+  arc_head.clear();
+  reduced.clear();
+  active.clear();
+  for (size_t ii = 0; ii < edges.size(); ++ii) {
+    add_arc(edges[ii].first, edges[ii].second, costs[ii]);
+    add_arc(edges[ii].second, edges[ii].first, costs[ii]);
+  }
+  int num_all = num_nodes;
+  for (int ii = 1; ii < num_nodes; ++ii) {
+    if (prizes[ii] > 0.0 || fixed_in[ii]) {
+      add_arc(ii, num_all, 0.0);
+      if (!fixed_in[ii]) {
+        add_arc(0, num_all, prizes[ii]);
+      }
+      active.push_back(num_all);
+      num_all += 1;
+    }
+  }
+
+  int num_arcs = static_cast<int>(reduced.size());
+  in_begin.assign(num_all + 1, 0);
+  for (int ii = 0; ii < num_arcs; ++ii) {
+    in_begin[arc_head[ii] + 1] += 1;
+  }
+  for (int ii = 0; ii < num_all; ++ii) {
+    in_begin[ii + 1] += in_begin[ii];
+  }
+  in_arcs.resize(num_arcs);
+  vector<int> fill(in_begin.begin(), in_begin.end() - 1);
+  for (int ii = 0; ii < num_arcs; ++ii) {
+    in_arcs[fill[arc_head[ii]]++] = ii;
+  }
+  mark.assign(num_all, 0);
+  int stamp = 0;
+
+  // One ascent step per active terminal and round: the nodes that reach
+  // it along arcs of reduced cost 0 form a cut, which is raised until an
+  // arc into it is saturated. A terminal the root reaches is done.
+  double bound = 0.0;
+  while (!active.empty()) {
+    next_active.clear();
+    for (size_t tt = 0; tt < active.size(); ++tt) {
+      stamp += 1;
+      cut.clear();
+      cut.push_back(active[tt]);
+      mark[active[tt]] = stamp;
+      bool reached = false;
+      for (size_t head = 0; head < cut.size() && !reached; ++head) {
+        int node = cut[head];
+        for (int ii = in_begin[node]; ii < in_begin[node + 1]; ++ii) {
+          int arc = in_arcs[ii];
+          int tail = arc_tail[arc];
+          if (reduced[arc] == 0.0 && mark[tail] != stamp) {
+            mark[tail] = stamp;
+            cut.push_back(tail);
+            reached = reached || tail == 0;
+          }
+        }
+      }
+      if (reached) {
+        continue;
+      }
+      double delta = std::numeric_limits<double>::infinity();
+      for (size_t ii = 0; ii < cut.size(); ++ii) {
+        int node = cut[ii];
+        for (int jj = in_begin[node]; jj < in_begin[node + 1]; ++jj) {
+          int arc = in_arcs[jj];
+          if (mark[arc_tail[arc]] != stamp) {
+            delta = std::min(delta, reduced[arc]);
+          }
+        }
+      }
+      if (delta == std::numeric_limits<double>::infinity()) {
+        return delta;
+      }
+      bound += delta;
+      for (size_t ii = 0; ii < cut.size(); ++ii) {
+        int node = cut[ii];
+        for (int jj = in_begin[node]; jj < in_begin[node + 1]; ++jj) {
+          int arc = in_arcs[jj];
+          if (mark[arc_tail[arc]] != stamp) {
+            reduced[arc] = reduced[arc] <= delta ? 0.0 : reduced[arc] - delta;
+          }
+        }
+      }
+      next_active.push_back(active[tt]);
+    }
+    active.swap(next_active);
+  }
+  return bound;
+}
+
+
+void DualAscent::root_distances(vector<double>* distance) const {
+  // Dijkstra without a heap; the graphs have at most max_nodes nodes
+  distance->assign(num_nodes, std::numeric_limits<double>::infinity());
+  vector<bool> done(num_nodes, false);
+  (*distance)[0] = 0.0;
+  for (int round = 0; round < num_nodes; ++round) {
+    int node = -1;
+    for (int ii = 0; ii < num_nodes; ++ii) {
+      if (!done[ii] && (node < 0 || (*distance)[ii] < (*distance)[node])) {
+        node = ii;
+      }
+    }
+    if ((*distance)[node] == std::numeric_limits<double>::infinity()) {
+      break;
+    }
+    done[node] = true;
+    // Only edge arcs enter nodes, and they come in pairs: the arcs out of
+    // a node are the reverses of the arcs into it
+    for (int ii = in_begin[node]; ii < in_begin[node + 1]; ++ii) {
+      int out = in_arcs[ii] ^ 1;
+      double next = (*distance)[node] + reduced[out];
+      if (next < (*distance)[arc_head[out]]) {
+        (*distance)[arc_head[out]] = next;
+      }
+    }
+  }
+}
+
+}  // namespace
+
+
+ExactComponents::ExactComponents(const vector<pair<int, int> >& edges_,
+                                 const vector<double>& prizes_,
+                                 const vector<double>& costs_,
+                                 int root_,
+                                 int max_nodes_)
+    : edges(edges_), prizes(prizes_), costs(costs_), root(root_),
+      max_nodes(max_nodes_), best_value(0.0), optimal(false),
+      interrupted(false), upper_bound(0.0), num_solved(0), subproblems(0),
+      peak_search_bytes(0) {
+  int num_nodes = static_cast<int>(prizes.size());
+  int num_edges = static_cast<int>(edges.size());
+
+  double total_prize = 0.0;
+  for (int ii = 0; ii < num_nodes; ++ii) {
+    total_prize += prizes[ii];
+  }
+  tolerance = kRelativeTolerance * std::max(1.0, total_prize);
+
+  // Incidence lists in CSR form
+  adjacency_begin.assign(num_nodes + 1, 0);
+  for (int ii = 0; ii < num_edges; ++ii) {
+    adjacency_begin[edges[ii].first + 1] += 1;
+    adjacency_begin[edges[ii].second + 1] += 1;
+  }
+  for (int ii = 0; ii < num_nodes; ++ii) {
+    adjacency_begin[ii + 1] += adjacency_begin[ii];
+  }
+  adjacency.resize(2 * num_edges);
+  vector<int> fill(adjacency_begin.begin(), adjacency_begin.end() - 1);
+  for (int ii = 0; ii < num_edges; ++ii) {
+    adjacency[fill[edges[ii].first]++] = ii;
+    adjacency[fill[edges[ii].second]++] = ii;
+  }
+
+  component.resize(num_nodes);
+  for (int ii = 0; ii < num_nodes; ++ii) {
+    component[ii] = ii;
+  }
+  for (int ii = 0; ii < num_edges; ++ii) {
+    int uu = find_component(component, edges[ii].first);
+    int vv = find_component(component, edges[ii].second);
+    if (uu != vv) {
+      component[uu] = vv;
+    }
+  }
+  for (int ii = 0; ii < num_nodes; ++ii) {
+    component[ii] = find_component(component, ii);
+  }
+}
+
+
+bool ExactComponents::improve(double dual_bound, int (*interrupt)(void*),
+                              void* interrupt_arg, vector<int>* nodes,
+                              vector<int>* tree_edges) {
+  int num_nodes = static_cast<int>(prizes.size());
+
+  best_nodes = *nodes;
+  best_edges = *tree_edges;
+  best_value = 0.0;
+  for (size_t ii = 0; ii < best_nodes.size(); ++ii) {
+    best_value += prizes[best_nodes[ii]];
+  }
+  for (size_t ii = 0; ii < best_edges.size(); ++ii) {
+    best_value -= costs[best_edges[ii]];
+  }
+  // Without a root a single node is a tree as well
+  if (root < 0) {
+    for (int ii = 0; ii < num_nodes; ++ii) {
+      offer(prizes[ii], vector<int>(1, ii), vector<int>());
+    }
+  }
+
+  double total_prize = 0.0;
+  vector<double> component_prize(num_nodes, 0.0);
+  vector<int> component_size(num_nodes, 0);
+  for (int ii = 0; ii < num_nodes; ++ii) {
+    total_prize += prizes[ii];
+    component_prize[component[ii]] += prizes[ii];
+    component_size[component[ii]] += 1;
+  }
+  upper_bound = total_prize - dual_bound;
+  optimal = best_value >= upper_bound - tolerance;
+  if (optimal) {
+    *nodes = best_nodes;
+    *tree_edges = best_edges;
+    return true;
+  }
+
+  // Components that may hold a better tree, most prize first. A tree is
+  // worth at most the prize sum of its component.
+  vector<int> candidates;
+  for (int ii = 0; ii < num_nodes; ++ii) {
+    if (component[ii] == ii && (root < 0 || component[root] == ii)) {
+      candidates.push_back(ii);
+    }
+  }
+  std::sort(candidates.begin(), candidates.end(),
+            [&component_prize](int aa, int bb) {
+              return component_prize[aa] > component_prize[bb];
+            });
+  double unsolved_bound = -1.0;
+  vector<int> members;
+  for (size_t ii = 0; ii < candidates.size(); ++ii) {
+    int cur = candidates[ii];
+    if (component_prize[cur] <= best_value + tolerance) {
+      continue;
+    }
+    if (component_size[cur] > max_nodes || subproblems >= kMaxSubproblems) {
+      unsolved_bound = std::max(unsolved_bound, component_prize[cur]);
+      continue;
+    }
+    members.clear();
+    for (int jj = 0; jj < num_nodes; ++jj) {
+      if (component[jj] == cur) {
+        members.push_back(jj);
+      }
+    }
+    if (solve_component(members, interrupt, interrupt_arg)) {
+      num_solved += 1;
+    } else if (interrupted) {
+      return false;
+    } else {
+      unsolved_bound = std::max(unsolved_bound, component_prize[cur]);
+    }
+  }
+
+  upper_bound = std::min(upper_bound, std::max(best_value, unsolved_bound));
+  optimal = best_value >= upper_bound - tolerance;
+  *nodes = best_nodes;
+  *tree_edges = best_edges;
+  return true;
+}
+
+
+bool ExactComponents::solve_component(const vector<int>& component_nodes,
+                                      int (*interrupt)(void*),
+                                      void* interrupt_arg) {
+  int num_local = static_cast<int>(component_nodes.size());
+
+  // Component nodes are sorted, so their local index is found by bisection
+  vector<pair<int, int> > local_edges;
+  vector<double> local_costs;
+  vector<int> local_edge_map;
+  vector<int> local_begin(num_local + 1, 0);
+  vector<pair<int, int> > local_adjacency;   // neighbor, local edge
+  for (int ii = 0; ii < num_local; ++ii) {
+    int node = component_nodes[ii];
+    for (int jj = adjacency_begin[node]; jj < adjacency_begin[node + 1]; ++jj) {
+      int edge = adjacency[jj];
+      // Each edge once, from its first node; self-loops are never worth it
+      int other = edges[edge].second;
+      if (edges[edge].first != node || other == node) {
+        continue;
+      }
+      int other_local = static_cast<int>(
+          std::lower_bound(component_nodes.begin(), component_nodes.end(),
+                           other) - component_nodes.begin());
+      local_edge_map.push_back(edge);
+      local_edges.push_back(make_pair(ii, other_local));
+      local_costs.push_back(costs[edge]);
+    }
+  }
+  for (size_t ii = 0; ii < local_edges.size(); ++ii) {
+    local_begin[local_edges[ii].first + 1] += 1;
+    local_begin[local_edges[ii].second + 1] += 1;
+  }
+  for (int ii = 0; ii < num_local; ++ii) {
+    local_begin[ii + 1] += local_begin[ii];
+  }
+  local_adjacency.resize(2 * local_edges.size());
+  vector<int> fill(local_begin.begin(), local_begin.end() - 1);
+  for (int ii = 0; ii < static_cast<int>(local_edges.size()); ++ii) {
+    local_adjacency[fill[local_edges[ii].first]++] =
+        make_pair(local_edges[ii].second, ii);
+    local_adjacency[fill[local_edges[ii].second]++] =
+        make_pair(local_edges[ii].first, ii);
+  }
+
+  // Prize of nodes fixed in: more than any tree of the component costs
+  double big_prize = 1.0;
+  for (int ii = 0; ii < num_local; ++ii) {
+    big_prize += prizes[component_nodes[ii]];
+  }
+  for (size_t ii = 0; ii < local_costs.size(); ++ii) {
+    big_prize += local_costs[ii];
+  }
+
+  vector<Subproblem> stack;
+  if (root >= 0) {
+    Subproblem first;
+    first.root = static_cast<int>(
+        std::lower_bound(component_nodes.begin(), component_nodes.end(),
+                         root) - component_nodes.begin());
+    first.state.assign(num_local, kUndecided);
+    first.state[first.root] = kIn;
+    stack.push_back(first);
+  } else {
+    // The best tree contains a prize node: root it at the first one in
+    // order of prize that it contains
+    vector<int> prize_nodes;
+    for (int ii = 0; ii < num_local; ++ii) {
+      if (prizes[component_nodes[ii]] > 0.0) {
+        prize_nodes.push_back(ii);
+      }
+    }
+    std::stable_sort(prize_nodes.begin(), prize_nodes.end(),
+                     [this, &component_nodes](int aa, int bb) {
+                       return prizes[component_nodes[aa]]
+                              > prizes[component_nodes[bb]];
+                     });
+    for (int ii = static_cast<int>(prize_nodes.size()) - 1; ii >= 0; --ii) {
+      Subproblem first;
+      first.root = prize_nodes[ii];
+      first.state.assign(num_local, kUndecided);
+      for (int jj = 0; jj < ii; ++jj) {
+        first.state[prize_nodes[jj]] = kOut;
+      }
+      first.state[first.root] = kIn;
+      stack.push_back(first);
+    }
+  }
+
+  vector<int> reach;
+  vector<int> sub_index(num_local, -1);
+  vector<pair<int, int> > sub_edges;
+  vector<double> sub_prizes;
+  vector<double> sub_costs;
+  vector<int> sub_edge_map;
+  vector<int> tree_nodes;
+  vector<int> tree_edges;
+  vector<int> global_nodes;
+  vector<int> global_edges;
+  vector<int> parent;
+  vector<int> order;
+  vector<bool> fixed_in;
+  vector<double> distance;
+  DualAscent ascent;
+  size_t fixed_bytes = local_edges.capacity() * sizeof(local_edges[0])
+                       + local_adjacency.capacity() * sizeof(local_adjacency[0])
+                       + local_costs.capacity() * sizeof(double)
+                       + num_local * (3 * sizeof(int) + sizeof(double));
+
+  while (!stack.empty()) {
+    if (subproblems >= kMaxSubproblems) {
+      return false;
+    }
+    if (interrupt && interrupt(interrupt_arg)) {
+      interrupted = true;
+      return false;
+    }
+    subproblems += 1;
+    peak_search_bytes = std::max(peak_search_bytes, fixed_bytes
+        + stack.size() * (sizeof(Subproblem) + num_local));
+
+    Subproblem cur;
+    cur.root = stack.back().root;
+    cur.state.swap(stack.back().state);
+    stack.pop_back();
+
+    // Nodes reachable from the root without passing nodes fixed out
+    for (size_t ii = 0; ii < reach.size(); ++ii) {
+      sub_index[reach[ii]] = -1;
+    }
+    reach.clear();
+    sub_index[cur.root] = 0;
+    reach.push_back(cur.root);
+    for (size_t head = 0; head < reach.size(); ++head) {
+      int node = reach[head];
+      for (int ii = local_begin[node]; ii < local_begin[node + 1]; ++ii) {
+        int next = local_adjacency[ii].first;
+        if (sub_index[next] < 0 && cur.state[next] != kOut) {
+          sub_index[next] = static_cast<int>(reach.size());
+          reach.push_back(next);
+        }
+      }
+    }
+    bool feasible = true;
+    for (int ii = 0; ii < num_local && feasible; ++ii) {
+      feasible = cur.state[ii] != kIn || sub_index[ii] >= 0;
+    }
+    double reach_prize = 0.0;
+    bool undecided = false;
+    for (size_t ii = 0; ii < reach.size(); ++ii) {
+      reach_prize += prizes[component_nodes[reach[ii]]];
+      undecided = undecided || cur.state[reach[ii]] == kUndecided;
+    }
+    if (!feasible || reach_prize <= best_value + tolerance) {
+      continue;
+    }
+
+    sub_edges.clear();
+    sub_costs.clear();
+    sub_edge_map.clear();
+    for (int ii = 0; ii < static_cast<int>(local_edges.size()); ++ii) {
+      int uu = sub_index[local_edges[ii].first];
+      int vv = sub_index[local_edges[ii].second];
+      if (uu >= 0 && vv >= 0) {
+        sub_edges.push_back(make_pair(uu, vv));
+        sub_costs.push_back(local_costs[ii]);
+        sub_edge_map.push_back(ii);
+      }
+    }
+    global_nodes.clear();
+    global_edges.clear();
+
+    if (!undecided) {
+      // Every node is fixed in: the best tree is a minimum spanning tree
+      order.resize(sub_edges.size());
+      for (size_t ii = 0; ii < order.size(); ++ii) {
+        order[ii] = static_cast<int>(ii);
+      }
+      std::sort(order.begin(), order.end(), [&sub_costs](int aa, int bb) {
+        return sub_costs[aa] < sub_costs[bb];
+      });
+      parent.resize(reach.size());
+      for (size_t ii = 0; ii < reach.size(); ++ii) {
+        parent[ii] = static_cast<int>(ii);
+        global_nodes.push_back(component_nodes[reach[ii]]);
+      }
+      double value = reach_prize;
+      for (size_t ii = 0; ii < order.size(); ++ii) {
+        int uu = find_component(parent, sub_edges[order[ii]].first);
+        int vv = find_component(parent, sub_edges[order[ii]].second);
+        if (uu != vv) {
+          parent[uu] = vv;
+          value -= sub_costs[order[ii]];
+          global_edges.push_back(local_edge_map[sub_edge_map[order[ii]]]);
+        }
+      }
+      offer(value, global_nodes, global_edges);
+      continue;
+    }
+
+    // Rooted GW on what is left: its tree is a candidate, its dual bounds
+    // every tree of the subproblem
+    sub_prizes.resize(reach.size());
+    for (size_t ii = 0; ii < reach.size(); ++ii) {
+      sub_prizes[ii] = cur.state[reach[ii]] == kIn && reach[ii] != cur.root
+                       ? big_prize : prizes[component_nodes[reach[ii]]];
+    }
+    double lower_bound = 0.0;
+    tree_nodes.clear();
+    PCSTFast solver(sub_edges, sub_prizes, sub_costs, 0, 0,
+                    PCSTFast::kStrongPruning, 0, ignore_output);
+    if (solver.run(&tree_nodes, &tree_edges)) {
+      lower_bound = solver.get_dual_bound();
+      double value = 0.0;
+      for (size_t ii = 0; ii < tree_nodes.size(); ++ii) {
+        int node = component_nodes[reach[tree_nodes[ii]]];
+        global_nodes.push_back(node);
+        value += prizes[node];
+      }
+      for (size_t ii = 0; ii < tree_edges.size(); ++ii) {
+        global_edges.push_back(local_edge_map[sub_edge_map[tree_edges[ii]]]);
+        value -= sub_costs[tree_edges[ii]];
+      }
+      offer(value, global_nodes, global_edges);
+    }
+    fixed_in.resize(reach.size());
+    for (size_t ii = 0; ii < reach.size(); ++ii) {
+      fixed_in[ii] = cur.state[reach[ii]] == kIn;
+    }
+    double ascent_bound = ascent.run(static_cast<int>(reach.size()), sub_edges,
+                                     sub_costs, sub_prizes, fixed_in);
+    if (reach_prize - std::max(lower_bound, ascent_bound)
+        <= best_value + tolerance) {
+      continue;
+    }
+
+    // Nodes too far from the root in reduced costs cannot be in a better
+    // tree; leaving them out shrinks the subproblem, which is solved again
+    ascent.root_distances(&distance);
+    bool fixed_out = false;
+    for (size_t ii = 0; ii < reach.size(); ++ii) {
+      if (cur.state[reach[ii]] == kUndecided
+          && reach_prize - ascent_bound - distance[ii] <= best_value + tolerance) {
+        cur.state[reach[ii]] = kOut;
+        fixed_out = true;
+      }
+    }
+    if (fixed_out) {
+      stack.push_back(Subproblem());
+      stack.back().root = cur.root;
+      stack.back().state.swap(cur.state);
+      continue;
+    }
+
+    // Branch on the undecided node of largest prize, in the tree if any
+    int branch = -1;
+    for (size_t ii = 0; ii < tree_nodes.size(); ++ii) {
+      int node = reach[tree_nodes[ii]];
+      if (cur.state[node] == kUndecided && (branch < 0
+          || prizes[component_nodes[node]] > prizes[component_nodes[branch]])) {
+        branch = node;
+      }
+    }
+    bool in_tree = branch >= 0;
+    for (size_t ii = 0; ii < reach.size() && !in_tree; ++ii) {
+      int node = reach[ii];
+      if (cur.state[node] == kUndecided && (branch < 0
+          || prizes[component_nodes[node]] > prizes[component_nodes[branch]])) {
+        branch = node;
+      }
+    }
+
+    stack.push_back(Subproblem());
+    stack.back().root = cur.root;
+    stack.back().state = cur.state;
+    stack.back().state[branch] = kOut;
+    stack.push_back(Subproblem());
+    stack.back().root = cur.root;
+    stack.back().state.swap(cur.state);
+    stack.back().state[branch] = kIn;
+  }
+  return true;
+}
+
+
+void ExactComponents::offer(double value, const vector<int>& tree_nodes,
+                            const vector<int>& tree_edges) {
+  if (value > best_value + tolerance) {
+    best_value = value;
+    best_nodes = tree_nodes;
+    best_edges = tree_edges;
+  }
+}
+
+
+size_t ExactComponents::memory_bytes() const {
+  return adjacency_begin.capacity() * sizeof(int)
+         + adjacency.capacity() * sizeof(int)
+         + component.capacity() * sizeof(int)
+         + best_nodes.capacity() * sizeof(int)
+         + best_edges.capacity() * sizeof(int)
+         + peak_search_bytes;
+}
@@ -0,0 +1,99 @@
+#ifndef __PCST_EXACT_H__
+#define __PCST_EXACT_H__
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace cluster_approx {
+
+// Solves the small connected components of a graph exactly once GW has
+// found its tree, when one tree is wanted (unrooted, or containing the
+// root), and tells whether the result is optimal.
+//
+// The GW tree is the first incumbent and the GW dual its first bound: when
+// the tree is worth the prize total minus the dual bound, it is optimal as
+// it is. Otherwise every component of at most max_nodes nodes that could
+// hold a better tree is searched by branch and bound. A subproblem roots the
+// tree at one node and fixes others in or out. It is solved by rooted GW on
+// the nodes still reachable, with the nodes fixed in given a prize too large
+// to leave out; the GW tree is a new incumbent when it is better. Its bound
+// is the larger of the GW dual and a dual ascent on the Steiner
+// arborescence form of the subproblem, whose reduced costs also fix out
+// every node that no better tree can contain. Unrooted components are split
+// into one subproblem per prize node as the root, each leaving out the
+// roots tried before. Branching takes the undecided node of largest prize
+// in the GW tree of the subproblem, else in the rest of it, and tries it in
+// first.
+//
+// A component is given up when the subproblems of the whole solve run out;
+// the result is then optimal only if the bounds still show it.
+class ExactComponents {
+ public:
+  ExactComponents(const std::vector<std::pair<int, int> >& edges,
+                  const std::vector<double>& prizes,
+                  const std::vector<double>& costs,
+                  int root,
+                  int max_nodes);
+
+  // Replace the GW tree, given as nodes and edges of the graph, by a better
+  // one where there is one. dual_bound is PCSTFast::get_dual_bound() of the
+  // GW solve. interrupt is polled between subproblems; when it fires,
+  // returns false and leaves the tree as it was.
+  bool improve(double dual_bound, int (*interrupt)(void*), void* interrupt_arg,
+               std::vector<int>* nodes, std::vector<int>* edges);
+
+  // After improve(): the tree is optimal (within a relative 1e-9 of the
+  // prize total), and an upper bound on prizes minus costs of any tree
+  bool is_optimal() const { return optimal; }
+  double get_upper_bound() const { return upper_bound; }
+
+  // Components whose search finished, and subproblems solved in total
+  int num_solved_components() const { return num_solved; }
+  long long num_subproblems() const { return subproblems; }
+
+  size_t memory_bytes() const;
+
+ private:
+  struct Subproblem {
+    int root;
+    std::vector<signed char> state;   // kUndecided, kIn or kOut per node
+  };
+
+  // Branch and bound over one component; false when it was given up or
+  // interrupted
+  bool solve_component(const std::vector<int>& component_nodes,
+                       int (*interrupt)(void*), void* interrupt_arg);
+
+  // Replace the incumbent when the tree is worth more
+  void offer(double value, const std::vector<int>& tree_nodes,
+             const std::vector<int>& tree_edges);
+
+  const std::vector<std::pair<int, int> >& edges;
+  const std::vector<double>& prizes;
+  const std::vector<double>& costs;
+  int root;
+  int max_nodes;
+  double tolerance;
+
+  // Adjacency of the graph: the edges of node ii are
+  // adjacency[adjacency_begin[ii]] to adjacency[adjacency_begin[ii + 1] - 1]
+  std::vector<int> adjacency_begin;
+  std::vector<int> adjacency;
+  std::vector<int> component;          // component label of every node
+
+  double best_value;
+  std::vector<int> best_nodes;
+  std::vector<int> best_edges;
+
+  bool optimal;
+  bool interrupted;
+  double upper_bound;
+  int num_solved;
+  long long subproblems;
+  size_t peak_search_bytes;
+};
+
+}  // namespace cluster_approx
+
+#endif
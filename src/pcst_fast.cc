@@ -11,6 +11,21 @@ using std::make_pair;
 using std::vector;
 
 
+namespace {
+
+// Closes whichever perf phase is still open when run() returns.
+class PerfPhaseGuard {
+ public:
+  explicit PerfPhaseGuard(pcst_perf_session_t* perf_) : perf(perf_) {}
+  ~PerfPhaseGuard() { pcst_perf_end(perf); }
+
+ private:
+  pcst_perf_session_t* perf;
+};
+
+}  // namespace
+
+
 PCSTFast::Statistics::Statistics() : total_num_edge_events(0),
                                      num_deleted_edge_events(0),
                                      num_merged_edge_events(0),
@@ -20,7 +35,23 @@ PCSTFast::Statistics::Statistics() : total_num_edge_events(0),
                                      total_num_edge_growth_events(0),
                                      num_active_active_edge_growth_events(0),
                                      num_active_inactive_edge_growth_events(0),
-                                     num_cluster_events(0) { };
+                                     num_cluster_events(0),
+                                     final_growth_time(0.0),
+                                     growth_time_capped(false),
+                                     num_uninserted_edges(0),
+                                     num_event_buckets(0),
+                                     num_expanded_nodes(0) { };
+
+
+PCSTFast::MemoryUsage::MemoryUsage() : current_bytes(0), peak_bytes(0) { };
+
+
+void PCSTFast::MemoryUsage::set(size_t bytes) {
+  current_bytes = bytes;
+  if (bytes > peak_bytes) {
+    peak_bytes = bytes;
+  }
+}
 
 
 PCSTFast::PruningMethod PCSTFast::parse_pruning_method(
@@ -56,12 +87,88 @@ PCSTFast::PCSTFast(const std::vector<std::pair<int, int> >& edges_,
     : edges(edges_), prizes(prizes_), costs(costs_), root(root_),
       target_num_active_clusters(target_num_active_clusters_),
       pruning(pruning_), verbosity_level(verbosity_level_),
-      output_function(output_function_) {
+      output_function(output_function_), given_edges(edges_, costs_) {
+  perf = NULL;
+  record_rooted_payoffs = false;
+  max_growth_time = std::numeric_limits<double>::infinity();
+  tree_dp = false;
+  lazy_edges = false;
+  edge_source = &given_edges;
+  reads_edges = false;
+  event_bucket_epsilon = 0.0;
+  node_expansion = false;
+  initialize();
+}
+
 
+PCSTFast::PCSTFast(EdgeSource* edge_source_,
+                   const std::vector<double>& prizes_,
+                   int root_,
+                   int target_num_active_clusters_,
+                   PruningMethod pruning_,
+                   int verbosity_level_,
+                   void (*output_function_)(const char*))
+    : edges(read_edges), prizes(prizes_), costs(read_costs), root(root_),
+      target_num_active_clusters(target_num_active_clusters_),
+      pruning(pruning_), verbosity_level(verbosity_level_),
+      output_function(output_function_), given_edges(read_edges, read_costs) {
+  perf = NULL;
+  record_rooted_payoffs = false;
+  max_growth_time = std::numeric_limits<double>::infinity();
+  tree_dp = false;
+  lazy_edges = true;
+  edge_source = edge_source_;
+  reads_edges = true;
+  event_bucket_epsilon = 0.0;
+  node_expansion = false;
+  initialize();
+}
+
+
+void PCSTFast::reset(int root_,
+                     int target_num_active_clusters_,
+                     PruningMethod pruning_) {
+  for (size_t ii = 0; ii < clusters.size(); ++ii) {
+    clusters[ii].edge_parts.release_memory();
+  }
+  clusters.clear();
+  inactive_merge_events.clear();
+  clusters_deactivation.clear();
+  clusters_next_edge_event.clear();
+  node_good.clear();
+  node_deleted.clear();
+  phase1_result.clear();
+  phase2_result.clear();
+  solution_nodes.clear();
+  solution_edges.clear();
+  phase3_neighbors.clear();
+  final_component_label.clear();
+  final_components.clear();
+  strong_pruning_parent.clear();
+  strong_pruning_payoff.clear();
+  rooted_payoffs.clear();
+  node_expanded.clear();
+  nodes_to_expand.clear();
+  read_edges.clear();
+  read_costs.clear();
+  read_edge_ids.clear();
+  stats = Statistics();
+
+  root = root_;
+  target_num_active_clusters = target_num_active_clusters_;
+  pruning = pruning_;
+  initialize();
+}
+
+
+void PCSTFast::initialize() {
+    state = kStateStart;
+    num_active_clusters = 0;
+    num_heap_nodes = 0;
     edge_parts.resize(2 * edges.size());
     node_deleted.resize(prizes.size(), false);
 
-    edge_info.resize(edges_.size());
+    edge_info.resize(edges.size());
     for (size_t ii = 0; ii < edge_info.size(); ++ii) {
       edge_info[ii].inactive_merge_event = -1;
     }
@@ -98,28 +205,44 @@ PCSTFast::PCSTFast(const std::vector<std::pair<int, int> >& edges_,
       }
     }
 
+  for (int ii = 0; ii < static_cast<int>(edges.size()); ++ii) {
+    check_edge(ii);
+    edge_parts[2 * ii].deleted = false;
+    edge_parts[2 * ii + 1].deleted = false;
+  }
+
+  num_read_edges = 0;
+  num_leaf_clusters = static_cast<int>(prizes.size());
+  num_known_edges = static_cast<int>(edges.size());
+
+  update_memory_statistics();
+}
+
+void PCSTFast::check_edge(int edge_index) {
+  int uu = edges[edge_index].first;
+  int vv = edges[edge_index].second;
+  if (uu < 0 || vv < 0) {
+    throw std::invalid_argument("Edge endpoint negative.");
+  }
+  if (uu >= static_cast<int>(prizes.size())
+      || vv >= static_cast<int>(prizes.size())) {
+    throw std::invalid_argument("Edge endpoint out of range (too large).");
+  }
+  if (costs[edge_index] < 0.0) {
+    throw std::invalid_argument("Edge cost negative.");
+  }
+}
+
+void PCSTFast::insert_all_edges() {
   for (int ii = 0; ii < static_cast<int>(edges.size()); ++ii) {
     int uu = edges[ii].first;
     int vv = edges[ii].second;
-    if (uu < 0 || vv < 0) {
-      throw std::invalid_argument("Edge endpoint negative.");
-    }
-    if (uu >= static_cast<int>(prizes.size())
-        || vv >= static_cast<int>(prizes.size())) {
-      throw std::invalid_argument("Edge endpoint out of range (too large).");
-    }
     double cost = costs[ii];
-    if (cost < 0.0) {
-      throw std::invalid_argument("Edge cost negative.");
-    }
     EdgePart& uu_part = edge_parts[2 * ii];
     EdgePart& vv_part = edge_parts[2 * ii + 1];
     Cluster& uu_cluster = clusters[uu];
     Cluster& vv_cluster = clusters[vv];
 
-    uu_part.deleted = false;
-    vv_part.deleted = false;
-
     if (uu_cluster.active && vv_cluster.active) {
       double event_time = cost / 2.0;
       uu_part.next_event_val = event_time;
@@ -141,6 +264,7 @@ PCSTFast::PCSTFast(const std::vector<std::pair<int, int> >& edges_,
         uu_part.next_event_val, 2 * ii);
     vv_part.heap_node = vv_cluster.edge_parts.insert(
         vv_part.next_event_val, 2 * ii + 1);
+    num_heap_nodes += 2;
   }
 
   for (int ii = 0; ii < static_cast<int>(prizes.size()); ++ii) {
@@ -155,6 +279,236 @@ PCSTFast::PCSTFast(const std::vector<std::pair<int, int> >& edges_,
   }
 }
 
+bool PCSTFast::insert_lazy_edges(double horizon) {
+  bool inserted_active = false;
+  int uu, vv, id;
+  double cost;
+  // Both sides of an edge read here have grown by at most
+  // current_time <= cost / 2, so the edge is not tight yet
+  while (edge_source->next(2.0 * horizon, &uu, &vv, &cost, &id)) {
+    num_read_edges += 1;
+    double event_time;
+    if (reads_edges) {
+      insert_read_edge(uu, vv, cost, id, &event_time);
+    } else {
+      event_time = insert_edge_now(id);
+    }
+    if (event_time < std::numeric_limits<double>::infinity()) {
+      // The next event may now be this edge, which moves the horizon in
+      horizon = std::min(horizon, event_time);
+      inserted_active = true;
+    }
+  }
+  return inserted_active;
+}
+
+int PCSTFast::insert_read_edge(int source, int target, double cost, int id,
+                               double* event_time) {
+  int ii = static_cast<int>(read_edges.size());
+  read_edges.push_back(make_pair(source, target));
+  read_costs.push_back(cost);
+  read_edge_ids.push_back(id);
+  check_edge(ii);
+  edge_parts.resize(2 * (ii + 1));
+  edge_info.resize(ii + 1);
+  edge_info[ii].inactive_merge_event = -1;
+  edge_parts[2 * ii].deleted = false;
+  edge_parts[2 * ii + 1].deleted = false;
+
+  *event_time = insert_edge_now(ii);
+  if (edge_parts[2 * ii].deleted) {
+    read_edges.pop_back();
+    read_costs.pop_back();
+    read_edge_ids.pop_back();
+    edge_parts.resize(2 * ii);
+    edge_info.resize(ii);
+    return -1;
+  }
+  return ii;
+}
+
+double PCSTFast::insert_edge_now(int edge_index) {
+  int ii = edge_index;
+  double cost = costs[ii];
+  double uu_sum, uu_finished_moat_sum, vv_sum, vv_finished_moat_sum;
+  int uu_cluster_index, vv_cluster_index;
+  get_sum_on_edge_part(2 * ii, &uu_sum, &uu_finished_moat_sum,
+                       &uu_cluster_index);
+  get_sum_on_edge_part(2 * ii + 1, &vv_sum, &vv_finished_moat_sum,
+                       &vv_cluster_index);
+  EdgePart& uu_part = edge_parts[2 * ii];
+  EdgePart& vv_part = edge_parts[2 * ii + 1];
+  if (uu_cluster_index == vv_cluster_index) {
+    uu_part.deleted = true;
+    vv_part.deleted = true;
+    stats.num_uninserted_edges += 1;
+    return std::numeric_limits<double>::infinity();
+  }
+  double remainder = std::max(0.0, cost - uu_sum - vv_sum);
+  const Cluster& uu_cluster = clusters[uu_cluster_index];
+  const Cluster& vv_cluster = clusters[vv_cluster_index];
+  double uu_time, vv_time;
+  if (uu_cluster.active && vv_cluster.active) {
+    uu_time = current_time + remainder / 2.0;
+    vv_time = uu_time;
+    uu_part.next_event_val = uu_sum + remainder / 2.0;
+    vv_part.next_event_val = vv_sum + remainder / 2.0;
+  } else if (uu_cluster.active) {
+    uu_time = current_time + remainder;
+    vv_time = vv_cluster.active_end_time;
+    uu_part.next_event_val = cost - vv_finished_moat_sum;
+    vv_part.next_event_val = vv_finished_moat_sum;
+  } else if (vv_cluster.active) {
+    uu_time = uu_cluster.active_end_time;
+    vv_time = current_time + remainder;
+    uu_part.next_event_val = uu_finished_moat_sum;
+    vv_part.next_event_val = cost - uu_finished_moat_sum;
+  } else {
+    uu_time = uu_cluster.active_end_time;
+    vv_time = vv_cluster.active_end_time;
+    uu_part.next_event_val = uu_finished_moat_sum;
+    vv_part.next_event_val = vv_finished_moat_sum;
+  }
+  double event_time = std::numeric_limits<double>::infinity();
+  if (uu_cluster.active) {
+    event_time = std::min(event_time, uu_time);
+  }
+  if (vv_cluster.active) {
+    event_time = std::min(event_time, vv_time);
+  }
+  insert_edge_part(uu_cluster_index, 2 * ii, uu_time);
+  insert_edge_part(vv_cluster_index, 2 * ii + 1, vv_time);
+  return event_time;
+}
+
+void PCSTFast::insert_edge_part(int cluster_index, int edge_part_index,
+                                double event_time) {
+  Cluster& cluster = clusters[cluster_index];
+  if (cluster.active && !cluster.edge_parts.is_empty()) {
+    clusters_next_edge_event.delete_element(cluster_index);
+  }
+  edge_parts[edge_part_index].heap_node = cluster.edge_parts.insert(
+      event_time, edge_part_index);
+  num_heap_nodes += 1;
+  if (cluster.active) {
+    double val;
+    int edge_part;
+    cluster.edge_parts.get_min(&val, &edge_part);
+    clusters_next_edge_event.insert(val, cluster_index);
+  }
+}
+
+void PCSTFast::add_discovered_graph() {
+  for (size_t ii = 0; ii < nodes_to_expand.size(); ++ii) {
+    node_expanded[nodes_to_expand[ii]] = true;
+  }
+  nodes_to_expand.clear();
+
+  int num_nodes = static_cast<int>(prizes.size());
+  int num_old_nodes = static_cast<int>(node_expanded.size());
+  int num_edges = static_cast<int>(edges.size());
+  if (num_nodes == num_old_nodes && num_edges == num_known_edges) {
+    return;
+  }
+
+  // New nodes join as zero-prize nodes do at time 0: deactivated at once
+  for (int ii = num_old_nodes; ii < num_nodes; ++ii) {
+    if (prizes[ii] != 0.0) {
+      throw std::invalid_argument("Prize of an added node not 0.");
+    }
+  }
+  if (num_nodes > num_leaf_clusters) {
+    grow_leaf_capacity(num_nodes);
+  }
+  node_expanded.resize(num_nodes, false);
+  node_deleted.resize(num_nodes, false);
+
+  edge_parts.resize(2 * num_edges);
+  edge_info.resize(num_edges);
+  for (int ii = num_known_edges; ii < num_edges; ++ii) {
+    check_edge(ii);
+    edge_info[ii].inactive_merge_event = -1;
+    edge_parts[2 * ii].deleted = false;
+    edge_parts[2 * ii + 1].deleted = false;
+    insert_edge_now(ii);
+  }
+  num_known_edges = num_edges;
+
+  update_memory_statistics();
+}
+
+void PCSTFast::grow_leaf_capacity(int num_nodes) {
+  // Doubling keeps the moves to a logarithmic number
+  int old_capacity = num_leaf_clusters;
+  int new_capacity = std::max(num_nodes, 2 * old_capacity);
+  int shift = new_capacity - old_capacity;
+  int old_size = static_cast<int>(clusters.size());
+
+  clusters.resize(old_size + shift, Cluster(&pairing_heap_buffer));
+  for (int ii = old_size - 1; ii >= old_capacity; --ii) {
+    clusters[ii + shift] = clusters[ii];
+  }
+  for (int ii = old_capacity; ii < new_capacity; ++ii) {
+    Cluster& leaf = clusters[ii];
+    leaf = Cluster(&pairing_heap_buffer);
+    leaf.active = false;
+    leaf.active_start_time = 0.0;
+    leaf.active_end_time = 0.0;
+    leaf.merged_into = -1;
+    leaf.prize_sum = 0.0;
+    leaf.subcluster_moat_sum = 0.0;
+    leaf.moat = 0.0;
+    leaf.contains_root = false;
+    leaf.skip_up = -1;
+    leaf.skip_up_sum = 0.0;
+    leaf.merged_along = -1;
+    leaf.child_cluster_1 = -1;
+    leaf.child_cluster_2 = -1;
+    leaf.necessary = false;
+  }
+
+  for (size_t ii = 0; ii < clusters.size(); ++ii) {
+    Cluster& cluster = clusters[ii];
+    int* links[4] = {&cluster.merged_into, &cluster.skip_up,
+                     &cluster.child_cluster_1, &cluster.child_cluster_2};
+    for (int jj = 0; jj < 4; ++jj) {
+      if (*links[jj] >= old_capacity) {
+        *links[jj] += shift;
+      }
+    }
+  }
+  for (size_t ii = 0; ii < inactive_merge_events.size(); ++ii) {
+    InactiveMergeEvent& merge_event = inactive_merge_events[ii];
+    if (merge_event.active_cluster_index >= old_capacity) {
+      merge_event.active_cluster_index += shift;
+    }
+    if (merge_event.inactive_cluster_index >= old_capacity) {
+      merge_event.inactive_cluster_index += shift;
+    }
+  }
+
+  // Both queues are keyed by cluster index; the active clusters are in them
+  // with the values growth gave them
+  clusters_deactivation.clear();
+  clusters_next_edge_event.clear();
+  for (int ii = 0; ii < static_cast<int>(clusters.size()); ++ii) {
+    Cluster& cluster = clusters[ii];
+    if (!cluster.active) {
+      continue;
+    }
+    clusters_deactivation.insert(cluster.active_start_time + cluster.prize_sum
+                                 - cluster.subcluster_moat_sum, ii);
+    if (!cluster.edge_parts.is_empty()) {
+      double val;
+      int edge_part;
+      cluster.edge_parts.get_min(&val, &edge_part);
+      clusters_next_edge_event.insert(val, ii);
+    }
+  }
+
+  num_leaf_clusters = new_capacity;
+}
+
 void PCSTFast::get_next_edge_event(double* next_time,
                                    int* next_cluster_index,
                                    int* next_edge_part_index) {
@@ -166,8 +520,13 @@ void PCSTFast::get_next_edge_event(double* next_time,
   }
 
   clusters_next_edge_event.get_min(next_time, next_cluster_index);
-  clusters[*next_cluster_index].edge_parts.get_min(next_time,
+  double edge_part_time = *next_time;
+  clusters[*next_cluster_index].edge_parts.get_min(&edge_part_time,
                                                    next_edge_part_index);
+  // Bucketed events happen at the rounded time the queue holds
+  if (event_bucket_epsilon == 0.0) {
+    *next_time = edge_part_time;
+  }
 }
 
 void PCSTFast::remove_next_edge_event(int next_cluster_index) {
@@ -176,6 +535,7 @@ void PCSTFast::remove_next_edge_event(int next_cluster_index) {
   int tmp_edge_part;
   clusters[next_cluster_index].edge_parts.delete_min(&tmp_value,
                                                      &tmp_edge_part);
+  num_heap_nodes -= 1;
   if (!clusters[next_cluster_index].edge_parts.is_empty()) {
     clusters[next_cluster_index].edge_parts.get_min(&tmp_value, &tmp_edge_part);
     clusters_next_edge_event.insert(tmp_value, next_cluster_index);
@@ -297,25 +657,131 @@ void PCSTFast::mark_nodes_as_deleted(int start_node_index,
 
 bool PCSTFast::run(std::vector<int>* result_nodes,
                    std::vector<int>* result_edges) {
-  result_nodes->clear();
-  result_edges->clear();
+  StepStatus status;
+  do {
+    status = step(std::numeric_limits<long long>::max());
+  } while (status == kInProgress);
+  get_result(result_nodes, result_edges);
+  return status == kDone;
+}
 
-  //////////////////////////////////////////
-  if (root >= 0 && target_num_active_clusters > 0) {
-    snprintf(output_buffer, kOutputBufferSize,
-        "Error: target_num_active_clusters must be 0 in the rooted case.\n");
-    output_function(output_buffer);
-    return false;
+
+PCSTFast::StepStatus PCSTFast::step(long long max_events) {
+  PerfPhaseGuard perf_guard(perf);
+
+  if (state == kStateStart) {
+    //////////////////////////////////////////
+    if (root >= 0 && target_num_active_clusters > 0) {
+      snprintf(output_buffer, kOutputBufferSize,
+          "Error: target_num_active_clusters must be 0 in the rooted case.\n");
+      output_function(output_buffer);
+      state = kStateFailed;
+      return kFailed;
+    }
+    if (reads_edges && (tree_dp || node_expansion)) {
+      snprintf(output_buffer, kOutputBufferSize,
+          "Error: an edge source is not combined with tree_dp or node "
+          "expansion.\n");
+      output_function(output_buffer);
+      state = kStateFailed;
+      return kFailed;
+    }
+    //////////////////////////////////////////
+
+    num_active_clusters = prizes.size();
+    if (root >= 0) {
+      num_active_clusters -= 1;
+    }
+    if (node_expansion) {
+      node_expanded.resize(prizes.size());
+      for (int ii = 0; ii < static_cast<int>(prizes.size()); ++ii) {
+        node_expanded[ii] = prizes[ii] > 0.0 || ii == root;
+      }
+    }
+    if (tree_dp) {
+      // No growth, so the heaps are never needed
+    } else if (!lazy_edges) {
+      insert_all_edges();
+      update_memory_statistics();
+    } else {
+      edge_source->rewind();
+    }
+    state = kStateGrowth;
   }
-  //////////////////////////////////////////
 
-  vector<int> phase1_result;
-  int num_active_clusters = prizes.size();
-  if (root >= 0) {
-    num_active_clusters -= 1;
+  if (state == kStateGrowth) {
+    pcst_perf_begin(perf, PCST_PHASE_GROWTH);
+    if (node_expansion) {
+      add_discovered_graph();
+    }
+    if (grow(max_events)) {
+      nodes_to_expand.clear();
+      state = kStateSimplePruning;
+    } else if (!nodes_to_expand.empty()) {
+      return kExpandNodes;
+    }
+    return kInProgress;
   }
 
-  while (num_active_clusters > target_num_active_clusters) {
+  if (state == kStateSimplePruning) {
+    pcst_perf_begin(perf, PCST_PHASE_SIMPLE_PRUNING);
+    state = simple_pruning() ? kStateDone : kStateFinalPruning;
+    return state == kStateDone ? kDone : kInProgress;
+  }
+
+  if (state == kStateFinalPruning) {
+    pcst_perf_begin(perf, pruning == kStrongPruning ? PCST_PHASE_STRONG_PRUNING
+                                                   : PCST_PHASE_GW_PRUNING);
+    state = final_pruning() ? kStateDone : kStateFailed;
+  }
+
+  return state == kStateDone ? kDone : kFailed;
+}
+
+
+void PCSTFast::get_result(std::vector<int>* result_nodes,
+                          std::vector<int>* result_edges) const {
+  *result_nodes = solution_nodes;
+  *result_edges = solution_edges;
+  if (reads_edges) {
+    for (size_t ii = 0; ii < result_edges->size(); ++ii) {
+      (*result_edges)[ii] = read_edge_ids[(*result_edges)[ii]];
+    }
+  }
+}
+
+
+double PCSTFast::get_dual_bound() const {
+  // Clusters only merge into clusters of higher index, so the moats
+  // enclosing each cluster can be summed from the top down. Root clusters
+  // never grow and keep a moat of 0.
+  vector<double> enclosing(clusters.size(), 0.0);
+  double total = 0.0;
+  double max_enclosing = 0.0;
+  for (int ii = static_cast<int>(clusters.size()) - 1; ii >= 0; --ii) {
+    const Cluster& cluster = clusters[ii];
+    double moat = cluster.active ? current_time - cluster.active_start_time
+                                 : cluster.moat;
+    total += moat;
+    enclosing[ii] = moat;
+    if (cluster.merged_into >= 0) {
+      enclosing[ii] += enclosing[cluster.merged_into];
+    }
+    if (ii < num_leaf_clusters) {
+      max_enclosing = std::max(max_enclosing, enclosing[ii]);
+    }
+  }
+  return root >= 0 ? total : total - max_enclosing;
+}
+
+
+bool PCSTFast::grow(long long max_events) {
+  long long num_events = 0;
+  while (!tree_dp && num_active_clusters > target_num_active_clusters) {
+    if (num_events >= max_events || !nodes_to_expand.empty()) {
+      return false;
+    }
+    num_events += 1;
 
     //////////////////////////////////////////
     if (verbosity_level >= 2) {
@@ -336,6 +802,20 @@ bool PCSTFast::run(std::vector<int>* result_nodes,
     int next_cluster_index;
     get_next_cluster_event(&next_cluster_time, &next_cluster_index);
 
+    if (lazy_edges && insert_lazy_edges(std::min(next_edge_time,
+                                                 next_cluster_time))) {
+      get_next_edge_event(&next_edge_time,
+                          &next_edge_cluster_index,
+                          &next_edge_part_index);
+    }
+
+    // Events that fell into the bucket being processed, for example the
+    // deactivation of a cluster merged over budget, happen now
+    if (event_bucket_epsilon > 0.0) {
+      next_edge_time = std::max(next_edge_time, current_time);
+      next_cluster_time = std::max(next_cluster_time, current_time);
+    }
+
     //////////////////////////////////////////
     if (verbosity_level >= 2) {
       snprintf(output_buffer, kOutputBufferSize,
@@ -349,6 +829,29 @@ bool PCSTFast::run(std::vector<int>* result_nodes,
     }
     //////////////////////////////////////////
 
+    // Time horizon reached: the clusters that are still active stay active
+    // (and good in the unrooted case), exactly as if growth had finished.
+    if (std::min(next_edge_time, next_cluster_time) > max_growth_time) {
+      current_time = max_growth_time;
+      stats.growth_time_capped = true;
+
+      //////////////////////////////////////////
+      if (verbosity_level >= 1) {
+        snprintf(output_buffer, kOutputBufferSize,
+            "Growth stopped at max_growth_time %e with %d active clusters\n",
+            max_growth_time, num_active_clusters);
+        output_function(output_buffer);
+      }
+      //////////////////////////////////////////
+
+      break;
+    }
+
+    if (event_bucket_epsilon > 0.0
+        && std::min(next_edge_time, next_cluster_time) > current_time) {
+      stats.num_event_buckets += 1;
+    }
+
     if (next_edge_time < next_cluster_time) {
       stats.total_num_edge_events += 1;
 
@@ -435,6 +938,13 @@ bool PCSTFast::run(std::vector<int>* result_nodes,
       if (remainder < eps * current_edge_cost || remainder == 0.0) {
         stats.total_num_merge_events += 1;
 
+        // With bucketed events the edge may have become tight earlier in
+        // the bucket; both clusters have grown up to now regardless
+        double merge_time = current_time + remainder;
+        if (event_bucket_epsilon > 0.0) {
+          merge_time = std::max(merge_time, current_time);
+        }
+
         phase1_result.push_back(next_edge_part_index / 2);
         edge_parts[other_edge_part_index].deleted = true;
 
@@ -473,7 +983,7 @@ bool PCSTFast::run(std::vector<int>* result_nodes,
         new_cluster.merged_into = -1;
 
         current_cluster.active = false;
-        current_cluster.active_end_time = current_time + remainder;
+        current_cluster.active_end_time = merge_time;
         current_cluster.merged_into = new_cluster_index;
         current_cluster.moat = current_cluster.active_end_time
                                - current_cluster.active_start_time;
@@ -487,7 +997,7 @@ bool PCSTFast::run(std::vector<int>* result_nodes,
           stats.num_active_active_merge_events += 1;
 
           other_cluster.active = false;
-          other_cluster.active_end_time = current_time + remainder;
+          other_cluster.active_end_time = merge_time;
           other_cluster.moat = other_cluster.active_end_time
                                - other_cluster.active_start_time;
           clusters_deactivation.delete_element(other_cluster_index);
@@ -499,7 +1009,7 @@ bool PCSTFast::run(std::vector<int>* result_nodes,
           stats.num_active_inactive_merge_events += 1;
 
           if (!other_cluster.contains_root) {
-            double edge_event_update_time = current_time + remainder
+            double edge_event_update_time = merge_time
                                             - other_cluster.active_end_time;
             other_cluster.edge_parts.add_to_heap(edge_event_update_time);
             inactive_merge_events.push_back(InactiveMergeEvent());
@@ -529,8 +1039,8 @@ bool PCSTFast::run(std::vector<int>* result_nodes,
         new_cluster.subcluster_moat_sum += other_cluster.moat;
 
         if (new_cluster.active) {
-          new_cluster.active_start_time = current_time + remainder;
-          double becoming_inactive_time = current_time + remainder
+          new_cluster.active_start_time = merge_time;
+          double becoming_inactive_time = merge_time
                                           + new_cluster.prize_sum
                                           - new_cluster.subcluster_moat_sum;
           clusters_deactivation.insert(becoming_inactive_time,
@@ -542,7 +1052,22 @@ bool PCSTFast::run(std::vector<int>* result_nodes,
             clusters_next_edge_event.insert(tmp_val, new_cluster_index);
           }
           num_active_clusters += 1;
+
+          // Nodes joining an active cluster can grow along edges not
+          // given yet
+          if (node_expansion) {
+            int children[2] = {current_cluster_index, other_cluster_index};
+            for (int ii = 0; ii < 2; ++ii) {
+              if (children[ii] < num_leaf_clusters
+                  && !node_expanded[children[ii]]) {
+                nodes_to_expand.push_back(children[ii]);
+                stats.num_expanded_nodes += 1;
+              }
+            }
+          }
         }
+
+        update_growth_memory_statistics();
       } else if (other_cluster.active) {
         stats.total_num_edge_growth_events += 1;
         stats.num_active_active_edge_growth_events += 1;
@@ -554,6 +1079,7 @@ bool PCSTFast::run(std::vector<int>* result_nodes,
         }
         next_edge_part.heap_node = current_cluster.edge_parts.insert(
             next_event_time, next_edge_part_index);
+        num_heap_nodes += 1;
         double tmp_val = -1.0;
         int tmp_index = -1;
         current_cluster.edge_parts.get_min(&tmp_val, &tmp_index);
@@ -588,6 +1114,7 @@ bool PCSTFast::run(std::vector<int>* result_nodes,
         }
         next_edge_part.heap_node = current_cluster.edge_parts.insert(
             next_event_time, next_edge_part_index);
+        num_heap_nodes += 1;
         double tmp_val = -1.0;
         int tmp_index = -1;
         current_cluster.edge_parts.get_min(&tmp_val, &tmp_index);
@@ -638,6 +1165,19 @@ bool PCSTFast::run(std::vector<int>* result_nodes,
     }
   }
 
+  stats.final_growth_time = current_time;
+  if (lazy_edges) {
+    stats.num_uninserted_edges += edge_source->num_edges() - num_read_edges;
+  }
+
+  if (tree_dp) {
+    // The input tree itself is the forest handed to pruning
+    phase1_result.resize(edges.size());
+    for (int ii = 0; ii < static_cast<int>(edges.size()); ++ii) {
+      phase1_result[ii] = ii;
+    }
+  }
+
   //////////////////////////////////////////
   if (verbosity_level >= 1) {
     snprintf(output_buffer, kOutputBufferSize,
@@ -647,11 +1187,18 @@ bool PCSTFast::run(std::vector<int>* result_nodes,
   }
   //////////////////////////////////////////
 
+  return true;
+}
 
+
+bool PCSTFast::simple_pruning() {
   // Mark root cluster or active clusters as good.
   node_good.resize(prizes.size(), false);
+  update_memory_statistics();
 
-  if (root >= 0) {
+  if (tree_dp) {
+    node_good.assign(prizes.size(), true);
+  } else if (root >= 0) {
     // find the root cluster
     for (size_t ii = 0; ii < clusters.size(); ++ii) {
       if (clusters[ii].contains_root && clusters[ii].merged_into == -1) {
@@ -668,8 +1215,8 @@ bool PCSTFast::run(std::vector<int>* result_nodes,
   }
 
   if (pruning == kNoPruning) {
-    build_phase1_node_set(phase1_result, result_nodes);
-    *result_edges = phase1_result;
+    build_phase1_node_set(phase1_result, &solution_nodes);
+    solution_edges = phase1_result;
     return true;
   }
 
@@ -691,11 +1238,15 @@ bool PCSTFast::run(std::vector<int>* result_nodes,
   }
 
   if (pruning == kSimplePruning) {
-    build_phase2_node_set(result_nodes);
-    *result_edges = phase2_result;
+    build_phase2_node_set(&solution_nodes);
+    solution_edges = phase2_result;
     return true;
   }
+  return false;
+}
 
+
+bool PCSTFast::final_pruning() {
   vector<int> phase3_result;
   phase3_neighbors.resize(prizes.size());
   for (size_t ii = 0; ii < phase2_result.size(); ++ii) {
@@ -706,6 +1257,7 @@ bool PCSTFast::run(std::vector<int>* result_nodes,
     phase3_neighbors[uu].push_back(make_pair(vv, cur_cost));
     phase3_neighbors[vv].push_back(make_pair(uu, cur_cost));
   }
+  update_memory_statistics();
 
   if (pruning == kGWPruning) {
 
@@ -795,8 +1347,8 @@ bool PCSTFast::run(std::vector<int>* result_nodes,
       }
     }
 
-    build_phase3_node_set(result_nodes);
-    *result_edges = phase3_result;
+    build_phase3_node_set(&solution_nodes);
+    solution_edges = phase3_result;
     return true;
   } else if (pruning == kStrongPruning) {
 
@@ -848,10 +1400,17 @@ bool PCSTFast::run(std::vector<int>* result_nodes,
         }
         //////////////////////////////////////////
 
+        if (record_rooted_payoffs) {
+          find_best_component_root(ii);
+          record_component_payoffs(ii);
+        }
         strong_pruning_from(root, true);
       } else {
 
         int best_component_root = find_best_component_root(ii);
+        if (record_rooted_payoffs) {
+          record_component_payoffs(ii);
+        }
 
         //////////////////////////////////////////
         if (verbosity_level >= 2) {
@@ -865,6 +1424,7 @@ bool PCSTFast::run(std::vector<int>* result_nodes,
         strong_pruning_from(best_component_root, true);
       }
     }
+    update_memory_statistics();
 
     for (int ii = 0; ii < static_cast<int>(phase2_result.size()); ++ii) {
       int cur_edge_index = phase2_result[ii];
@@ -887,8 +1447,8 @@ bool PCSTFast::run(std::vector<int>* result_nodes,
       }
     }
 
-    build_phase3_node_set(result_nodes);
-    *result_edges = phase3_result;
+    build_phase3_node_set(&solution_nodes);
+    solution_edges = phase3_result;
     return true;
   }
 
@@ -1026,6 +1586,19 @@ int PCSTFast::find_best_component_root(int component_index) {
 }
 
 
+void PCSTFast::record_component_payoffs(int component_index) {
+  // find_best_component_root leaves the rerooted payoff of every node of the
+  // component in strong_pruning_payoff.
+  for (size_t ii = 0; ii < final_components[component_index].size(); ++ii) {
+    RootedPayoff entry;
+    entry.node = final_components[component_index][ii];
+    entry.component = component_index;
+    entry.payoff = strong_pruning_payoff[entry.node];
+    rooted_payoffs.push_back(entry);
+  }
+}
+
+
 void PCSTFast::build_phase3_node_set(std::vector<int>* node_set) {
   node_set->clear();
   for (int ii = 0; ii < static_cast<int>(prizes.size()); ++ii) {
@@ -1077,6 +1650,102 @@ PCSTFast::~PCSTFast() {
 }
 
 
+void PCSTFast::update_growth_memory_statistics() {
+  stats.edge_parts_memory.set(
+      edge_parts.capacity() * sizeof(EdgePart)
+      + edge_info.capacity() * sizeof(EdgeInfo)
+      + read_edges.capacity() * sizeof(read_edges[0])
+      + read_costs.capacity() * sizeof(double)
+      + read_edge_ids.capacity() * sizeof(int));
+  stats.heap_node_memory.set(
+      num_heap_nodes * PairingHeapType::node_size()
+      + pairing_heap_buffer.capacity()
+        * sizeof(PairingHeapType::ItemHandle));
+  stats.priority_queue_memory.set(clusters_deactivation.memory_usage()
+                                  + clusters_next_edge_event.memory_usage());
+  stats.cluster_memory.set(
+      clusters.capacity() * sizeof(Cluster)
+      + inactive_merge_events.capacity() * sizeof(InactiveMergeEvent));
+}
+
+
+void PCSTFast::update_memory_statistics() {
+  update_growth_memory_statistics();
+
+  size_t neighbors_bytes = phase3_neighbors.capacity()
+                           * sizeof(phase3_neighbors[0]);
+  for (size_t ii = 0; ii < phase3_neighbors.size(); ++ii) {
+    neighbors_bytes += phase3_neighbors[ii].capacity()
+                       * sizeof(phase3_neighbors[ii][0]);
+  }
+  stats.phase3_neighbors_memory.set(neighbors_bytes);
+
+  size_t components_bytes = final_components.capacity()
+                            * sizeof(final_components[0]);
+  for (size_t ii = 0; ii < final_components.size(); ++ii) {
+    components_bytes += final_components[ii].capacity() * sizeof(int);
+  }
+  stats.pruning_memory.set(
+      (node_good.capacity() + node_deleted.capacity()) / 8
+      + phase2_result.capacity() * sizeof(int)
+      + path_compression_visited.capacity()
+        * sizeof(path_compression_visited[0])
+      + cluster_queue.capacity() * sizeof(int)
+      + final_component_label.capacity() * sizeof(int)
+      + components_bytes
+      + strong_pruning_parent.capacity() * sizeof(strong_pruning_parent[0])
+      + strong_pruning_payoff.capacity() * sizeof(double)
+      + stack.capacity() * sizeof(stack[0])
+      + stack2.capacity() * sizeof(int)
+      + rooted_payoffs.capacity() * sizeof(RootedPayoff));
+}
+
+
 void PCSTFast::get_statistics(PCSTFast::Statistics* s) {
   *s = stats;
 }
+
+
+void PCSTFast::set_perf_session(pcst_perf_session_t* perf_) {
+  perf = perf_;
+}
+
+
+void PCSTFast::set_record_rooted_payoffs(bool record) {
+  record_rooted_payoffs = record;
+}
+
+
+void PCSTFast::get_rooted_payoffs(std::vector<RootedPayoff>* payoffs) {
+  *payoffs = rooted_payoffs;
+}
+
+
+void PCSTFast::set_max_growth_time(double max_growth_time_) {
+  max_growth_time = max_growth_time_;
+}
+
+void PCSTFast::set_lazy_edge_insertion(bool lazy_edges_) {
+  lazy_edges = lazy_edges_ || reads_edges;
+}
+
+void PCSTFast::set_event_bucket_epsilon(double event_bucket_epsilon_) {
+  event_bucket_epsilon = std::max(event_bucket_epsilon_, 0.0);
+  clusters_deactivation.set_bucket_epsilon(event_bucket_epsilon);
+  clusters_next_edge_event.set_bucket_epsilon(event_bucket_epsilon);
+}
+
+
+void PCSTFast::set_tree_dp(bool tree_dp_) {
+  tree_dp = tree_dp_;
+}
+
+
+void PCSTFast::set_node_expansion(bool node_expansion_) {
+  node_expansion = node_expansion_;
+}
+
+
+void PCSTFast::get_nodes_to_expand(std::vector<int>* nodes) const {
+  *nodes = nodes_to_expand;
+}
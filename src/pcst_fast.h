@@ -6,6 +6,8 @@
 #include <vector>
 
 #include "pairing_heap.h"
+#include "pcst_edge_source.h"
+#include "pcst_perf.h"
 #include "priority_queue.h"
 
 namespace cluster_approx {
@@ -20,6 +22,14 @@ class PCSTFast {
     kUnknownPruning,
   };
 
+  struct MemoryUsage {
+    size_t current_bytes;
+    size_t peak_bytes;
+
+    MemoryUsage();
+    void set(size_t bytes);
+  };
+
   struct Statistics {
     long long total_num_edge_events;
     long long num_deleted_edge_events;
@@ -31,10 +41,31 @@ class PCSTFast {
     long long num_active_active_edge_growth_events;
     long long num_active_inactive_edge_growth_events;
     long long num_cluster_events;
+    double final_growth_time;           // current_time when growth stopped
+    bool growth_time_capped;            // stopped by max_growth_time
+    long long num_uninserted_edges;     // never given heap nodes (lazy edges,
+                                        // node expansion)
+    long long num_event_buckets;        // distinct event times (bucketed events)
+    long long num_expanded_nodes;       // nodes handed out by node expansion
+
+    // Approximate footprint of the major solver structures.
+    MemoryUsage edge_parts_memory;      // edge_parts, edge_info, edges read
+    MemoryUsage heap_node_memory;       // pairing heap nodes + shared buffer
+    MemoryUsage priority_queue_memory;  // std::set nodes of both queues
+    MemoryUsage cluster_memory;         // clusters, inactive_merge_events
+    MemoryUsage phase3_neighbors_memory;
+    MemoryUsage pruning_memory;         // node flags, strong pruning buffers
 
     Statistics();
   };
 
+  // Strong pruning payoff of a phase 2 component if it were rooted at node.
+  struct RootedPayoff {
+    int node;
+    int component;
+    double payoff;
+  };
+
   const static int kNoRoot = -1;
 
   static PruningMethod parse_pruning_method(const std::string& input);
@@ -48,14 +79,117 @@ class PCSTFast {
            PruningMethod pruning_,
            int verbosity_level_,
            void (*output_function_)(const char*));
+
+  // Semi-external solve: edges are read from edge_source, in cost order, as
+  // growth reaches them (lazy edge insertion), and only those inserted into
+  // the heaps are kept, so the edges beyond the final growth time and those
+  // inside a cluster by the time they are read never take memory. Nodes and
+  // clusters stay in memory. Result edges are the ids edge_source gave. Not
+  // combined with tree_dp or node expansion.
+  PCSTFast(EdgeSource* edge_source_,
+           const std::vector<double>& prizes_,
+           int root_,
+           int target_num_active_clusters_,
+           PruningMethod pruning_,
+           int verbosity_level_,
+           void (*output_function_)(const char*));
   
   ~PCSTFast();
 
+  // Prepare another run() on the same graph, keeping the allocated buffers.
+  // The prize vector passed to the constructor may have been modified in the
+  // meantime (values only, not its size).
+  void reset(int root_, int target_num_active_clusters_, PruningMethod pruning_);
+
   bool run(std::vector<int>* result_nodes,
            std::vector<int>* result_edges);
 
+  enum StepStatus {
+    kInProgress = 0,
+    kDone,
+    kFailed,
+    kExpandNodes      // see set_node_expansion()
+  };
+
+  // Resumable form of run(). Each call processes at most max_events growth
+  // events, or one pruning phase, and returns kInProgress until the solution
+  // is ready; get_result() then returns it. Solves can be time-sliced or
+  // abandoned between calls. run() is step() until done.
+  StepStatus step(long long max_events);
+
+  void get_result(std::vector<int>* result_nodes,
+                  std::vector<int>* result_edges) const;
+
   void get_statistics(Statistics* s);
 
+  // Lower bound on the GW objective (edge costs plus the prizes of the nodes
+  // left out) of every tree containing the root, or of every tree at all
+  // without a root, after the solve. The moats are a feasible solution of
+  // the dual LP; without a root, the moats around the best single node are
+  // left out. The prize total minus this bound is an upper bound on prizes
+  // minus costs. Not valid with event_bucket_epsilon, whose moats may
+  // overlap edges.
+  double get_dual_bound() const;
+
+  // Attribute time and hardware counters of run() to the growth and pruning
+  // phases of the given session. The session must outlive run().
+  void set_perf_session(pcst_perf_session_t* perf_);
+
+  // With strong pruning, keep the result of the rerooting pass: the payoff
+  // of every node of the phase 2 forest as the root of its component. The
+  // component containing the given root is rerooted as well.
+  void set_record_rooted_payoffs(bool record);
+
+  void get_rooted_payoffs(std::vector<RootedPayoff>* payoffs);
+
+  // Stop moat growth once the next event would happen after the given time.
+  // Clusters still active at that point are frozen and the forest built so
+  // far is pruned as usual. The default (infinity) grows until the target
+  // number of active clusters is reached.
+  void set_max_growth_time(double max_growth_time_);
+
+  // The input is a single tree: skip moat growth and strong-prune the input
+  // itself. On a tree that dynamic program is exact, for the unrooted case
+  // with one target cluster as well as the rooted case. Requires
+  // kStrongPruning.
+  void set_tree_dp(bool tree_dp_);
+
+  // Insert edges into the cluster heaps in order of cost, only once growth
+  // time reaches half their cost (no event can happen earlier), instead of
+  // all of them up front. Edges whose endpoints are already in the same
+  // cluster by then are never inserted. Heap nodes then exist only for the
+  // edges growth got to, and the edges are read in one pass in cost order,
+  // fastest when they are given sorted by cost. Same result as eager
+  // insertion up to tie-breaking between simultaneous events. Edge parts
+  // are still sized to all edges given; the EdgeSource constructor keeps
+  // only the inserted ones. Call before the first step().
+  void set_lazy_edge_insertion(bool lazy_edges_);
+
+  // (1 + epsilon)-approximate growth: every event time is rounded up to the
+  // next power of (1 + epsilon), and all events of one such bucket are
+  // processed at that time, in no particular order (cluster deactivations
+  // before edge events). Clusters merging in a bucket have grown up to its
+  // end, so moats may overlap an edge by a relative epsilon. The result is
+  // not the GW forest but usually close to it. 0 (the default) is exact.
+  // Call before the first step().
+  void set_event_bucket_epsilon(double event_bucket_epsilon_);
+
+  // Grow over a graph that is read while growth reaches it. Nodes with a
+  // prize and the root count as expanded: all their edges are given. Any
+  // other node may have more edges than given so far. When such a node
+  // first joins an active cluster, step() returns kExpandNodes and
+  // get_nodes_to_expand() names it. The caller then appends its missing
+  // edges, and the new nodes they lead to (prize 0), to the vectors passed
+  // to the constructor and calls step() again, which picks them up at the
+  // current growth time. An edge between two nodes that were never expanded
+  // cannot become tight, so the forest is the GW forest of the whole graph
+  // up to tie-breaking. Not combined with lazy edge insertion or tree_dp.
+  // Call before the first step().
+  void set_node_expansion(bool node_expansion_);
+
+  // Nodes whose edges are needed before the next step(), after kExpandNodes
+  void get_nodes_to_expand(std::vector<int>* nodes) const;
+
 
  private:
   typedef PairingHeap<double, int> PairingHeapType;
@@ -100,6 +234,12 @@ class PCSTFast {
   };
 
 
+  // With an EdgeSource constructor, the edges read and inserted so far,
+  // which edges and costs then refer to, and their ids in the source
+  std::vector<std::pair<int, int> > read_edges;
+  std::vector<double> read_costs;
+  std::vector<int> read_edge_ids;
+
   const std::vector<std::pair<int, int> >& edges;
   const std::vector<double>& prizes;
   const std::vector<double>& costs;
@@ -135,11 +275,49 @@ class PCSTFast {
   std::vector<double> strong_pruning_payoff;
   std::vector<std::pair<bool, int> > stack;
   std::vector<int> stack2;
+  bool record_rooted_payoffs;
+  std::vector<RootedPayoff> rooted_payoffs;
+  double max_growth_time;
+  bool tree_dp;
+  bool lazy_edges;
+  VectorEdgeSource given_edges;       // lazy insertion of the edges given
+  EdgeSource* edge_source;            // given_edges or the constructor's
+  bool reads_edges;                   // edges come from the constructor's
+  long long num_read_edges;
+  double event_bucket_epsilon;
+  bool node_expansion;
+  std::vector<bool> node_expanded;    // all edges given; sized to the known nodes
+  std::vector<int> nodes_to_expand;
+  int num_leaf_clusters;              // index of the first merged cluster
+  int num_known_edges;                // edges with edge parts
+
+  enum SolveState {
+    kStateStart = 0,
+    kStateGrowth,
+    kStateSimplePruning,
+    kStateFinalPruning,    // GW or strong pruning
+    kStateDone,
+    kStateFailed
+  };
+  SolveState state;
+  int num_active_clusters;
+  std::vector<int> phase1_result;
+  std::vector<int> solution_nodes;
+  std::vector<int> solution_edges;
+
+  long long num_heap_nodes;
+  pcst_perf_session_t* perf;
  
 
   const static int kOutputBufferSize = 10000;
   char output_buffer[kOutputBufferSize];
   
+  // Phases of step(). grow() returns false when max_events ran out first;
+  // simple_pruning() returns true when no further pruning is needed.
+  bool grow(long long max_events);
+  bool simple_pruning();
+  bool final_pruning();
+
   void get_next_edge_event(double* next_time,
                            int* next_cluster_index,
                            int* next_edge_part_index);
@@ -149,6 +327,34 @@ class PCSTFast {
   void get_next_cluster_event(double* next_time, int* next_cluster_index);
 
   void remove_next_cluster_event();
+
+  void insert_all_edges();
+
+  // Insert the edges with half their cost at most horizon, the time of the
+  // next event, which shrinks as edges are inserted; returns whether any
+  // edge part went into the heap of an active cluster
+  bool insert_lazy_edges(double horizon);
+
+  // Keep an edge read from the constructor's edge source; returns its index,
+  // or -1 when its endpoints are in the same cluster already and it was
+  // dropped again. *event_time as for insert_edge_now().
+  int insert_read_edge(int source, int target, double cost, int id,
+                       double* event_time);
+
+  // Insert both parts of an edge in the state eager insertion would have
+  // brought them to by current_time, unless its endpoints are in the same
+  // cluster already. Returns the earliest event time of a part that went
+  // into an active cluster, infinity if none did.
+  double insert_edge_now(int edge_index);
+
+  void insert_edge_part(int cluster_index, int edge_part_index,
+                        double event_time);
+
+  // Node expansion: take in the nodes and edges appended by the caller
+  void add_discovered_graph();
+
+  // Move the merged clusters up to make room for num_nodes leaf clusters
+  void grow_leaf_capacity(int num_nodes);
   
   void get_sum_on_edge_part(int edge_part_index,
                             double* total_sum,
@@ -167,6 +373,8 @@ class PCSTFast {
 
   int find_best_component_root(int component_index);
 
+  void record_component_payoffs(int component_index);
+
   void build_phase1_node_set(const std::vector<int>& edge_set,
                              std::vector<int>* node_set);
 
@@ -174,6 +382,16 @@ class PCSTFast {
 
   void build_phase2_node_set(std::vector<int>* node_set);
 
+  // Footprint of the growth structures, constant time, for every merge
+  void update_growth_memory_statistics();
+
+  // All structures, at phase boundaries
+  void update_memory_statistics();
+
+  void initialize();
+
+  void check_edge(int edge_index);
+
 
   int get_other_edge_part_index(int edge_part_index) {
     if (edge_part_index % 2 == 0) {
@@ -0,0 +1,231 @@
+#include "pcst_fast_builder.h"
+
+#include <signal.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <new>
+#include <system_error>
+
+using cluster_approx::PCSTFastBuilder;
+using std::make_pair;
+using std::vector;
+
+
+// Union-find root with path halving
+static int find_component(vector<int>& parent, int node) {
+  while (parent[node] != node) {
+    parent[node] = parent[parent[node]];
+    node = parent[node];
+  }
+  return node;
+}
+
+
+PCSTFastBuilder::PCSTFastBuilder(bool use_thread_, bool profile_)
+    : profile(profile_), num_unions(0), min_positive_cost(0.0),
+      max_cost(0.0), first_invalid_edge(-1), max_node(-1),
+      out_of_memory(false), finalized(false), use_thread(use_thread_),
+      queue_closed(false) {}
+
+
+PCSTFastBuilder::~PCSTFastBuilder() {
+  stop_worker();
+}
+
+
+void PCSTFastBuilder::reserve(int num_nodes, int num_edges) {
+  if (worker.joinable()) {
+    return;
+  }
+  edges.reserve(num_edges);
+  costs.reserve(num_edges);
+  grow_nodes(num_nodes);
+}
+
+
+void PCSTFastBuilder::add_edges(const int* sources_, const int* targets_,
+                                const double* costs_, int num_edges) {
+  if (use_thread && !worker.joinable() && !queue_closed) {
+    // The thread inherits the signal mask, so the caller's handlers keep
+    // running on the caller's thread only
+    sigset_t all_signals;
+    sigset_t old_signals;
+    sigfillset(&all_signals);
+    pthread_sigmask(SIG_SETMASK, &all_signals, &old_signals);
+    try {
+      worker = std::thread(&PCSTFastBuilder::run_worker, this);
+    } catch (const std::system_error&) {
+      use_thread = false;
+    }
+    pthread_sigmask(SIG_SETMASK, &old_signals, NULL);
+  }
+  if (!worker.joinable()) {
+    append(sources_, targets_, costs_, num_edges);
+    return;
+  }
+
+  Batch batch;
+  batch.sources.assign(sources_, sources_ + num_edges);
+  batch.targets.assign(targets_, targets_ + num_edges);
+  batch.costs.assign(costs_, costs_ + num_edges);
+  std::unique_lock<std::mutex> lock(queue_mutex);
+  queue_changed.wait(lock, [this] {
+    return queue.size() < kMaxQueuedBatches;
+  });
+  queue.push_back(std::move(batch));
+  queue_changed.notify_all();
+}
+
+
+void PCSTFastBuilder::set_prizes(const double* prizes_, int num_nodes) {
+  prizes.assign(prizes_, prizes_ + num_nodes);
+}
+
+
+bool PCSTFastBuilder::finalize(std::string* error) {
+  stop_worker();
+  if (!finalized) {
+    finalized = true;
+    char buffer[256];
+    if (out_of_memory) {
+      error_message = "Out of memory while building the solver input";
+    } else if (first_invalid_edge >= 0) {
+      snprintf(buffer, sizeof(buffer),
+               "Edge %d has negative node ID: source=%d, target=%d",
+               first_invalid_edge, edges[first_invalid_edge].first,
+               edges[first_invalid_edge].second);
+      error_message = buffer;
+    } else if (max_node >= static_cast<int>(prizes.size())) {
+      int num_nodes = static_cast<int>(prizes.size());
+      snprintf(buffer, sizeof(buffer),
+               "Edge references node %d but only %d prizes provided "
+               "(valid range: 0-%d)",
+               max_node, num_nodes, num_nodes - 1);
+      error_message = buffer;
+    } else {
+      // Reserved nodes beyond the prizes are dropped again
+      int num_nodes = static_cast<int>(prizes.size());
+      grow_nodes(num_nodes);
+      degree.resize(num_nodes);
+      if (profile) {
+        component_parent.resize(num_nodes);
+      }
+    }
+  }
+  if (!error_message.empty()) {
+    *error = error_message;
+    return false;
+  }
+  return true;
+}
+
+
+int PCSTFastBuilder::num_components() const {
+  if (!profile) {
+    return -1;
+  }
+  return static_cast<int>(prizes.size()) - num_unions;
+}
+
+
+size_t PCSTFastBuilder::memory_bytes() const {
+  return edges.capacity() * sizeof(edges[0])
+         + prizes.capacity() * sizeof(double)
+         + costs.capacity() * sizeof(double)
+         + degree.capacity() * sizeof(int)
+         + component_parent.capacity() * sizeof(int);
+}
+
+
+void PCSTFastBuilder::append(const int* sources_, const int* targets_,
+                             const double* costs_, int num_edges) {
+  for (int ii = 0; ii < num_edges; ++ii) {
+    int uu = sources_[ii];
+    int vv = targets_[ii];
+    double cost = costs_[ii];
+    edges.push_back(make_pair(uu, vv));
+    costs.push_back(cost);
+    if (uu < 0 || vv < 0) {
+      if (first_invalid_edge < 0) {
+        first_invalid_edge = static_cast<int>(edges.size()) - 1;
+      }
+      continue;
+    }
+
+    int larger = std::max(uu, vv);
+    if (larger >= static_cast<int>(degree.size())) {
+      grow_nodes(larger + 1);
+    }
+    max_node = std::max(max_node, larger);
+    degree[uu] += 1;
+    degree[vv] += 1;
+    if (profile) {
+      int cu = find_component(component_parent, uu);
+      int cv = find_component(component_parent, vv);
+      if (cu != cv) {
+        component_parent[cu] = cv;
+        num_unions += 1;
+      }
+    }
+    if (cost > 0.0) {
+      min_positive_cost = min_positive_cost == 0.0
+                          ? cost : std::min(min_positive_cost, cost);
+      max_cost = std::max(max_cost, cost);
+    }
+  }
+}
+
+
+void PCSTFastBuilder::grow_nodes(int num_nodes) {
+  int old_size = static_cast<int>(degree.size());
+  if (num_nodes <= old_size) {
+    return;
+  }
+  degree.resize(num_nodes, 0);
+  if (profile) {
+    component_parent.resize(num_nodes);
+    for (int ii = old_size; ii < num_nodes; ++ii) {
+      component_parent[ii] = ii;
+    }
+  }
+}
+
+
+void PCSTFastBuilder::run_worker() {
+  std::unique_lock<std::mutex> lock(queue_mutex);
+  while (true) {
+    queue_changed.wait(lock, [this] {
+      return !queue.empty() || queue_closed;
+    });
+    if (queue.empty()) {
+      return;
+    }
+    Batch batch = std::move(queue.front());
+    queue.pop_front();
+    queue_changed.notify_all();
+    lock.unlock();
+
+    if (!out_of_memory) {
+      try {
+        append(batch.sources.data(), batch.targets.data(), batch.costs.data(),
+               static_cast<int>(batch.sources.size()));
+      } catch (const std::bad_alloc&) {
+        out_of_memory = true;
+      }
+    }
+    lock.lock();
+  }
+}
+
+
+void PCSTFastBuilder::stop_worker() {
+  {
+    std::lock_guard<std::mutex> lock(queue_mutex);
+    queue_closed = true;
+  }
+  queue_changed.notify_all();
+  if (worker.joinable()) {
+    worker.join();
+  }
+}
@@ -0,0 +1,105 @@
+#ifndef __PCST_FAST_BUILDER_H__
+#define __PCST_FAST_BUILDER_H__
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace cluster_approx {
+
+// Collects the solver input while it is still being read. Edge batches are
+// checked and appended as they arrive, together with the node degrees, the
+// cost range and optionally the connected components, so a loader reading
+// its input in batches leaves only the heap building for the solver once the
+// last batch is in.
+//
+// With a helper thread, add_edges() only copies the batch into a queue and
+// returns; the thread does the rest while the caller reads the next batch.
+// The thread blocks all signals and never calls back into the caller.
+class PCSTFastBuilder {
+ public:
+  // profile also tracks the connected components (union-find over all
+  // edges), which only the automatic plan needs
+  PCSTFastBuilder(bool use_thread_, bool profile_);
+
+  // Waits for the helper thread
+  ~PCSTFastBuilder();
+
+  // Size hints, before the first add_edges(); both counts may be exceeded
+  void reserve(int num_nodes, int num_edges);
+
+  // Append edges in index order, before finalize(). The arrays are copied
+  // before returning.
+  void add_edges(const int* sources_, const int* targets_,
+                 const double* costs_, int num_edges);
+
+  void set_prizes(const double* prizes_, int num_nodes);
+
+  // Wait for the queued batches and check that every edge endpoint is a
+  // node with a prize entry. Returns false and sets *error otherwise. Can be
+  // called again; later calls return the same outcome.
+  bool finalize(std::string* error);
+
+  // The input, complete after finalize()
+  const std::vector<std::pair<int, int> >& get_edges() const { return edges; }
+  const std::vector<double>& get_prizes() const { return prizes; }
+  const std::vector<double>& get_costs() const { return costs; }
+
+  // Profile of the input, valid after finalize(). num_components() is -1
+  // unless the builder was created with profile.
+  const std::vector<int>& get_degrees() const { return degree; }
+  int num_components() const;
+  double get_min_positive_cost() const { return min_positive_cost; }
+  double get_max_cost() const { return max_cost; }
+
+  size_t memory_bytes() const;
+
+ private:
+  struct Batch {
+    std::vector<int> sources;
+    std::vector<int> targets;
+    std::vector<double> costs;
+  };
+
+  // Queued batches at most before add_edges() waits for the helper thread
+  const static size_t kMaxQueuedBatches = 8;
+
+  bool profile;
+  std::vector<std::pair<int, int> > edges;
+  std::vector<double> prizes;
+  std::vector<double> costs;
+
+  std::vector<int> degree;
+  std::vector<int> component_parent;
+  int num_unions;
+  double min_positive_cost;
+  double max_cost;
+  int first_invalid_edge;       // first edge with a negative endpoint, or -1
+  int max_node;
+  bool out_of_memory;
+  bool finalized;
+  std::string error_message;
+
+  // The helper thread starts with the first batch
+  bool use_thread;
+  std::thread worker;
+  std::mutex queue_mutex;
+  std::condition_variable queue_changed;
+  std::deque<Batch> queue;
+  bool queue_closed;
+
+  void append(const int* sources_, const int* targets_, const double* costs_,
+              int num_edges);
+  void grow_nodes(int num_nodes);
+  void run_worker();
+  void stop_worker();
+};
+
+}  // namespace cluster_approx
+
+#endif
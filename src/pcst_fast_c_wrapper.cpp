@@ -1,191 +1,1085 @@
 #include "pcst_fast_c_wrapper.h"
+#include "pcst_distance_network.h"
+#include "pcst_exact.h"
 #include "pcst_fast.h"
+#include "pcst_fast_builder.h"
+#include "pcst_prize_balls.h"
+#include "pcst_repair.h"
+#include "pcst_tails.h"
+#include <signal.h>
+#include <algorithm>
+#include <atomic>
 #include <cstring>
 #include <cstdlib>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
 #include <vector>
 #include <utility>
 
 using namespace cluster_approx;
+using std::unique_ptr;
 using std::vector;
 using std::pair;
 using std::make_pair;
 
+// Growth events between two polls of pcst_options_t.interrupt
+static const long long kInterruptCheckEvents = 16384;
+
+// PCST_PRUNING_AUTO solves on the distance network of the prize nodes when
+// the graph has at least this many nodes and at most this fraction of them
+// has a prize
+static const int kDistanceNetworkMinNodes = 100000;
+static const double kDistanceNetworkMaxDensity = 0.001;
+
 // Simple output function for C wrapper
 static void default_output_function(const char* message) {
     // For PostgreSQL extension, we might want to use elog here
     // For now, just ignore output to avoid issues
 }
 
-extern "C" {
+static void add_memory_entry(pcst_stats_t* stats, const char* name,
+                             const PCSTFast::MemoryUsage& usage) {
+    if (stats->num_memory_entries >= PCST_MAX_MEMORY_ENTRIES) {
+        return;
+    }
+    pcst_memory_usage_t* entry = &stats->memory[stats->num_memory_entries++];
+    entry->name = name;
+    entry->current_bytes = usage.current_bytes;
+    entry->peak_bytes = usage.peak_bytes;
+}
 
-pcst_result_t* pcst_solve(
-    int* edge_sources,
-    int* edge_targets,
-    double* edge_costs,
-    int num_edges,
-    double* node_prizes,
-    int num_nodes,
-    int root_node,
-    int target_num_active_clusters,
-    int pruning_method,
-    int verbosity_level
-) {
+// Copy the solver counters and memory high-water marks into the C result
+static void copy_statistics(PCSTFast& solver, size_t input_bytes,
+                            pcst_stats_t* stats) {
+    PCSTFast::Statistics s;
+    solver.get_statistics(&s);
+
+    stats->total_num_edge_events = s.total_num_edge_events;
+    stats->num_deleted_edge_events = s.num_deleted_edge_events;
+    stats->num_merged_edge_events = s.num_merged_edge_events;
+    stats->total_num_merge_events = s.total_num_merge_events;
+    stats->num_active_active_merge_events = s.num_active_active_merge_events;
+    stats->num_active_inactive_merge_events = s.num_active_inactive_merge_events;
+    stats->total_num_edge_growth_events = s.total_num_edge_growth_events;
+    stats->num_active_active_edge_growth_events = s.num_active_active_edge_growth_events;
+    stats->num_active_inactive_edge_growth_events = s.num_active_inactive_edge_growth_events;
+    stats->num_cluster_events = s.num_cluster_events;
+    stats->final_growth_time = s.final_growth_time;
+    stats->growth_time_capped = s.growth_time_capped;
+    stats->num_uninserted_edges = s.num_uninserted_edges;
+    stats->num_event_buckets = s.num_event_buckets;
+    stats->num_expanded_nodes = s.num_expanded_nodes;
+
+    // The wrapper's own vector copies of the input stay alive for the whole solve
+    PCSTFast::MemoryUsage input_usage;
+    input_usage.set(input_bytes);
+
+    stats->num_memory_entries = 0;
+    add_memory_entry(stats, "solver.input", input_usage);
+    add_memory_entry(stats, "solver.edge_parts", s.edge_parts_memory);
+    add_memory_entry(stats, "solver.heap_nodes", s.heap_node_memory);
+    add_memory_entry(stats, "solver.priority_queues", s.priority_queue_memory);
+    add_memory_entry(stats, "solver.clusters", s.cluster_memory);
+    add_memory_entry(stats, "solver.phase3_neighbors", s.phase3_neighbors_memory);
+    add_memory_entry(stats, "solver.pruning", s.pruning_memory);
+}
+
+// Union-find root with path halving
+static int find_component(vector<int>& parent, int node) {
+    while (parent[node] != node) {
+        parent[node] = parent[parent[node]];
+        node = parent[node];
+    }
+    return node;
+}
+
+// Degree, component and cost profile. The builder counted degrees and costs
+// while the edges arrived, and components too when asked to; otherwise they
+// take one more pass over the edges here.
+static void profile_graph(const PCSTFastBuilder& input, pcst_profile_t* profile) {
+    const vector<pair<int, int>>& edges = input.get_edges();
+    const vector<double>& prizes = input.get_prizes();
+    const vector<int>& degree = input.get_degrees();
+    int num_nodes = static_cast<int>(prizes.size());
+
+    int num_components = input.num_components();
+    if (num_components < 0) {
+        vector<int> parent(num_nodes);
+        for (int i = 0; i < num_nodes; i++) {
+            parent[i] = i;
+        }
+        num_components = num_nodes;
+        for (size_t i = 0; i < edges.size(); i++) {
+            int uu = find_component(parent, edges[i].first);
+            int vv = find_component(parent, edges[i].second);
+            if (uu != vv) {
+                parent[uu] = vv;
+                num_components--;
+            }
+        }
+    }
+
+    int max_degree = 0;
+    int num_leaves = 0;
+    int num_prized = 0;
+    for (int i = 0; i < num_nodes; i++) {
+        max_degree = std::max(max_degree, degree[i]);
+        if (degree[i] == 1) {
+            num_leaves++;
+        }
+        if (prizes[i] > 0.0) {
+            num_prized++;
+        }
+    }
+
+    double min_cost = input.get_min_positive_cost();
+    profile->num_components = num_components;
+    profile->cycle_rank = static_cast<long long>(edges.size()) - num_nodes + num_components;
+    profile->max_degree = max_degree;
+    profile->num_leaves = num_leaves;
+    profile->mean_degree = num_nodes > 0 ? 2.0 * edges.size() / num_nodes : 0.0;
+    profile->prize_density = num_nodes > 0 ? static_cast<double>(num_prized) / num_nodes : 0.0;
+    profile->cost_spread = min_cost > 0.0 ? input.get_max_cost() / min_cost : 0.0;
+}
+
+// Plan for PCST_PRUNING_AUTO. A single tree is solved exactly by strong
+// pruning on the input, as long as only one tree is wanted and growth is not
+// capped (the cap asks for GW's local trees). Under the same conditions,
+// other graphs with leaves get their tree-shaped tails peeled off and solved
+// exactly, so GW only runs on the 2-core. Unrooted one-tree solves with
+// zero-prize nodes first drop the nodes beyond reach of every prize, which
+// GW could never grow to. Large graphs with very few prize nodes are instead
+// solved on the distance network between those nodes, which trades GW's tree
+// for a near-linear solve. Growth always uses strong pruning, which costs
+// little more than the cheaper pruning methods and never returns a worse
+// tree, and inserts edges lazily, which never costs much and saves the heap
+// nodes of every edge growth does not get to.
+static void choose_plan(const pcst_profile_t& profile, int num_nodes, int root_node,
+                        int target_num_active_clusters, bool growth_capped,
+                        pcst_plan_t* plan) {
+    bool one_tree = (root_node >= 0 || target_num_active_clusters <= 1) && !growth_capped;
+    plan->automatic = 1;
+    plan->pruning_method = 3;
+    plan->tree_dp = one_tree && profile.cycle_rank == 0 && profile.num_components == 1;
+    plan->peel_tails = one_tree && !plan->tree_dp && profile.num_leaves > 0;
+    plan->prize_balls = root_node < 0 && target_num_active_clusters <= 1 && !plan->tree_dp
+                        && profile.prize_density > 0.0 && profile.prize_density < 1.0;
+    plan->lazy_edges = !plan->tree_dp;
+    plan->distance_network = one_tree && !plan->tree_dp && num_nodes >= kDistanceNetworkMinNodes
+                             && profile.prize_density > 0.0
+                             && profile.prize_density <= kDistanceNetworkMaxDensity;
+}
+
+// Result with nothing solved yet, or NULL when out of memory
+static pcst_result_t* new_result() {
     pcst_result_t* result = (pcst_result_t*)malloc(sizeof(pcst_result_t));
     if (!result) {
         return nullptr;
     }
-
-    // Initialize result
     result->result_nodes = nullptr;
     result->result_edges = nullptr;
     result->num_nodes = 0;
     result->num_edges = 0;
     result->success = 0;
+    result->interrupted = 0;
     strcpy(result->error_message, "");
+    memset(&result->stats, 0, sizeof(result->stats));
+    result->payoff_nodes = nullptr;
+    result->payoff_components = nullptr;
+    result->rooted_payoffs = nullptr;
+    result->num_rooted_payoffs = 0;
+    memset(&result->plan, 0, sizeof(result->plan));
+    memset(&result->profile, 0, sizeof(result->profile));
+    return result;
+}
 
-    try {
-        // Validate root node if specified
-        if (root_node >= 0) {
-            if (root_node >= num_nodes) {
-                snprintf(result->error_message, sizeof(result->error_message),
-                        "Root node %d is out of range. Valid range is 0-%d",
-                        root_node, num_nodes - 1);
-                return result;
-            }
+// Copy the nodes and edges of a solution into result. Returns false, with
+// the error message set, when out of memory.
+static bool copy_solution(const vector<int>& result_nodes_vec,
+                          const vector<int>& result_edges_vec, pcst_result_t* result) {
+    // Allocate memory for results
+    result->num_nodes = result_nodes_vec.size();
+    result->num_edges = result_edges_vec.size();
 
-            // Check if root node appears in any edge (connectivity check)
-            bool root_connected = false;
-            for (int i = 0; i < num_edges; i++) {
-                if (edge_sources[i] == root_node || edge_targets[i] == root_node) {
-                    root_connected = true;
-                    break;
-                }
-            }
+    if (result->num_nodes > 0) {
+        result->result_nodes = (int*)malloc(result->num_nodes * sizeof(int));
+        if (!result->result_nodes) {
+            strcpy(result->error_message, "Failed to allocate memory for result nodes");
+            return false;
+        }
+        for (int i = 0; i < result->num_nodes; i++) {
+            result->result_nodes[i] = result_nodes_vec[i];
+        }
+    }
 
-            if (!root_connected) {
-                snprintf(result->error_message, sizeof(result->error_message),
-                        "Root node %d is not connected to any edges", root_node);
-                return result;
+    if (result->num_edges > 0) {
+        result->result_edges = (int*)malloc(result->num_edges * sizeof(int));
+        if (!result->result_edges) {
+            strcpy(result->error_message, "Failed to allocate memory for result edges");
+            if (result->result_nodes) {
+                free(result->result_nodes);
+                result->result_nodes = nullptr;
             }
+            return false;
         }
+        for (int i = 0; i < result->num_edges; i++) {
+            result->result_edges[i] = result_edges_vec[i];
+        }
+    }
+    return true;
+}
 
-        // Convert input data to C++ format
-        vector<pair<int, int>> edges;
-        vector<double> prizes;
-        vector<double> costs;
-
-        // Build edges vector and validate node IDs
-        int max_node_id = -1;
-        for (int i = 0; i < num_edges; i++) {
-            if (edge_sources[i] < 0 || edge_targets[i] < 0) {
-                snprintf(result->error_message, sizeof(result->error_message),
-                        "Edge %d has negative node ID: source=%d, target=%d",
-                        i, edge_sources[i], edge_targets[i]);
-                return result;
-            }
+// Plan, reduce and solve the input of a builder; errors are reported in
+// result. The caller has begun the construction phase.
+static void solve_input(PCSTFastBuilder& input, int root_node, int target_num_active_clusters,
+                        int pruning_method, int verbosity_level, const pcst_options_t* options,
+                        pcst_result_t* result) {
+    pcst_perf_session_t* perf = options ? options->perf : nullptr;
+    std::string input_error;
+    bool input_valid = input.finalize(&input_error);
+    const vector<pair<int, int>>& edges = input.get_edges();
+    const vector<double>& prizes = input.get_prizes();
+    const vector<double>& costs = input.get_costs();
+    int num_nodes = static_cast<int>(prizes.size());
+    int num_edges = static_cast<int>(edges.size());
 
-            max_node_id = std::max(max_node_id, std::max(edge_sources[i], edge_targets[i]));
-            edges.push_back(make_pair(edge_sources[i], edge_targets[i]));
-            costs.push_back(edge_costs[i]);
+    // Validate root node if specified
+    if (root_node >= 0) {
+        if (root_node >= num_nodes) {
+            snprintf(result->error_message, sizeof(result->error_message),
+                    "Root node %d is out of range. Valid range is 0-%d",
+                    root_node, num_nodes - 1);
+            return;
         }
-
-        // Validate that all edge node IDs have corresponding prizes
-        if (max_node_id >= num_nodes) {
+        if (input_valid && input.get_degrees()[root_node] == 0) {
             snprintf(result->error_message, sizeof(result->error_message),
-                    "Edge references node %d but only %d prizes provided (valid range: 0-%d)",
-                    max_node_id, num_nodes, num_nodes - 1);
-            return result;
+                    "Root node %d is not connected to any edges", root_node);
+            return;
         }
+    }
+    if (!input_valid) {
+        snprintf(result->error_message, sizeof(result->error_message),
+                "%s", input_error.c_str());
+        return;
+    }
 
-        // Build prizes vector
-        for (int i = 0; i < num_nodes; i++) {
-            prizes.push_back(node_prizes[i]);
+    if (options && options->plan) {
+        result->plan = *options->plan;
+        pruning_method = result->plan.pruning_method;
+    } else if (pruning_method == PCST_PRUNING_AUTO) {
+        profile_graph(input, &result->profile);
+        choose_plan(result->profile, num_nodes, root_node, target_num_active_clusters,
+                    options && options->max_growth_time >= 0.0, &result->plan);
+        pruning_method = result->plan.pruning_method;
+    } else {
+        result->plan.pruning_method = (pruning_method >= 0 && pruning_method <= 3) ? pruning_method : 2;
+    }
+    if (options && !options->plan && options->lazy_edges) {
+        result->plan.lazy_edges = 1;
+    }
+    if (options && !options->plan && options->distance_network >= 0) {
+        result->plan.distance_network = options->distance_network
+            && (root_node >= 0 || target_num_active_clusters <= 1);
+    }
+    // Rooted payoffs describe the forest of the graph that was grown
+    if (options && options->rooted_payoffs) {
+        result->plan.peel_tails = 0;
+        result->plan.distance_network = 0;
+    }
+    // The network replaces both reductions
+    if (result->plan.distance_network) {
+        result->plan.peel_tails = 0;
+        result->plan.prize_balls = 0;
+    }
+    // The exact step needs exact GW moats on the graph itself, and a single
+    // tree is solved exactly by tree_dp already
+    if (options && !options->plan) {
+        result->plan.exact = options->exact_max_nodes > 0
+            && (root_node >= 0 || target_num_active_clusters <= 1)
+            && options->max_growth_time < 0.0 && options->event_bucket_epsilon <= 0.0
+            && !options->rooted_payoffs && !result->plan.distance_network
+            && !result->plan.tree_dp;
+    }
+
+    // Convert pruning method
+    PCSTFast::PruningMethod pruning = PCSTFast::kGWPruning;
+    switch (pruning_method) {
+        case 0: pruning = PCSTFast::kNoPruning; break;
+        case 1: pruning = PCSTFast::kSimplePruning; break;
+        case 2: pruning = PCSTFast::kGWPruning; break;
+        case 3: pruning = PCSTFast::kStrongPruning; break;
+        default: pruning = PCSTFast::kGWPruning; break;
+    }
+
+    // Handle root node (-1 means no root in C++ API)
+    int cpp_root = (root_node < 0) ? PCSTFast::kNoRoot : root_node;
+
+    // Add detailed logging for debugging
+    if (verbosity_level > 0) {
+        snprintf(result->error_message, sizeof(result->error_message),
+                "Debug: Creating solver with %d edges, %d nodes, root=%d, clusters=%d",
+                num_edges, num_nodes, cpp_root, target_num_active_clusters);
+    }
+
+    unique_ptr<DistanceNetwork> network;
+    if (result->plan.distance_network) {
+        network.reset(new DistanceNetwork(edges, prizes, costs, root_node));
+        result->stats.num_terminals = network->num_terminals();
+        if (network->num_terminals() == 0) {
+            network.reset();
+            result->plan.distance_network = 0;
         }
+    }
 
-        // Convert pruning method
-        PCSTFast::PruningMethod pruning = PCSTFast::kGWPruning;
-        switch (pruning_method) {
-            case 0: pruning = PCSTFast::kNoPruning; break;
-            case 1: pruning = PCSTFast::kSimplePruning; break;
-            case 2: pruning = PCSTFast::kGWPruning; break;
-            case 3: pruning = PCSTFast::kStrongPruning; break;
-            default: pruning = PCSTFast::kGWPruning; break;
+    // Nodes no prize can reach are dropped (unrooted only), then tails
+    // are solved here; the solver only sees the core of what is left
+    unique_ptr<PrizeBalls> balls;
+    if (result->plan.prize_balls) {
+        balls.reset(new PrizeBalls(edges, prizes, costs,
+                                   options ? options->max_growth_time : -1.0));
+        result->stats.num_distant_nodes = balls->num_removed_nodes();
+        if (balls->num_removed_nodes() == 0) {
+            balls.reset();
         }
+    }
+    const vector<pair<int, int>>& kept_edges = balls ? balls->get_edges() : edges;
+    const vector<double>& kept_prizes = balls ? balls->get_prizes() : prizes;
+    const vector<double>& kept_costs = balls ? balls->get_costs() : costs;
 
-        // Handle root node (-1 means no root in C++ API)
-        int cpp_root = (root_node < 0) ? PCSTFast::kNoRoot : root_node;
+    unique_ptr<TailPeeling> peeling;
+    if (result->plan.peel_tails) {
+        peeling.reset(new TailPeeling(kept_edges, kept_prizes, kept_costs, cpp_root));
+        result->stats.num_peeled_nodes = peeling->num_peeled_nodes();
+    }
+    const vector<pair<int, int>>& solve_edges = network ? network->get_network_edges()
+                                                : peeling ? peeling->get_core_edges() : kept_edges;
+    const vector<double>& solve_prizes = network ? network->get_network_prizes()
+                                         : peeling ? peeling->get_core_prizes() : kept_prizes;
+    const vector<double>& solve_costs = network ? network->get_network_costs()
+                                        : peeling ? peeling->get_core_costs() : kept_costs;
+    int solve_root = network ? network->get_network_root()
+                     : peeling ? peeling->get_core_root() : cpp_root;
 
-        // Add detailed logging for debugging
-        if (verbosity_level > 0) {
-            snprintf(result->error_message, sizeof(result->error_message),
-                    "Debug: Creating solver with %d edges, %d nodes, root=%d, clusters=%d",
-                    num_edges, num_nodes, cpp_root, target_num_active_clusters);
+    // Create PCST solver
+    PCSTFast solver(solve_edges, solve_prizes, solve_costs, solve_root, target_num_active_clusters,
+                   pruning, verbosity_level, default_output_function);
+    solver.set_perf_session(perf);
+    solver.set_record_rooted_payoffs(options && options->rooted_payoffs);
+    if (options && options->max_growth_time >= 0.0) {
+        solver.set_max_growth_time(options->max_growth_time);
+    }
+    solver.set_tree_dp(result->plan.tree_dp);
+    solver.set_lazy_edge_insertion(result->plan.lazy_edges);
+    if (options && options->event_bucket_epsilon > 0.0) {
+        solver.set_event_bucket_epsilon(options->event_bucket_epsilon);
+    }
+
+    // Add more detailed error reporting
+    if (verbosity_level > 0) {
+        strcpy(result->error_message, "Debug: Solver created, calling run()");
+    }
+
+    // Solve
+    vector<int> result_nodes_vec;
+    vector<int> result_edges_vec;
+
+    bool success;
+    if (options && options->interrupt) {
+        PCSTFast::StepStatus status;
+        do {
+            status = solver.step(kInterruptCheckEvents);
+        } while (status == PCSTFast::kInProgress
+                 && !options->interrupt(options->interrupt_arg));
+        if (status == PCSTFast::kInProgress) {
+            result->interrupted = 1;
+            strcpy(result->error_message, "Solve interrupted");
+            return;
         }
+        solver.get_result(&result_nodes_vec, &result_edges_vec);
+        success = status == PCSTFast::kDone;
+    } else {
+        success = solver.run(&result_nodes_vec, &result_edges_vec);
+    }
 
-        // Create PCST solver
-        PCSTFast solver(edges, prizes, costs, cpp_root, target_num_active_clusters,
-                       pruning, verbosity_level, default_output_function);
+    // Small components of what GW solved are searched for a better tree
+    unique_ptr<ExactComponents> exact;
+    if (success && result->plan.exact) {
+        pcst_perf_begin(perf, PCST_PHASE_EXACT);
+        exact.reset(new ExactComponents(solve_edges, solve_prizes, solve_costs, solve_root,
+                                        options ? options->exact_max_nodes : 0));
+        bool finished = exact->improve(solver.get_dual_bound(),
+                                       options ? options->interrupt : nullptr,
+                                       options ? options->interrupt_arg : nullptr,
+                                       &result_nodes_vec, &result_edges_vec);
+        pcst_perf_end(perf);
+        if (!finished) {
+            result->interrupted = 1;
+            strcpy(result->error_message, "Solve interrupted");
+            return;
+        }
+    }
 
-        // Add more detailed error reporting
-        if (verbosity_level > 0) {
-            strcpy(result->error_message, "Debug: Solver created, calling run()");
+    copy_statistics(solver, input.memory_bytes(), &result->stats);
+    result->stats.optimal = success && result->plan.tree_dp;
+    if (exact) {
+        result->stats.optimal = exact->is_optimal();
+        result->stats.objective_bound = exact->get_upper_bound();
+        // Trees inside a tail are not part of the core that was bounded
+        if (peeling && cpp_root < 0) {
+            result->stats.objective_bound = std::max(result->stats.objective_bound,
+                                                     peeling->get_best_tail_value());
         }
+        result->stats.num_exact_components = exact->num_solved_components();
+        result->stats.num_exact_subproblems = exact->num_subproblems();
+        PCSTFast::MemoryUsage exact_usage;
+        exact_usage.set(exact->memory_bytes());
+        add_memory_entry(&result->stats, "solver.exact", exact_usage);
+    }
+    if (peeling) {
+        PCSTFast::MemoryUsage peeling_usage;
+        peeling_usage.set(peeling->memory_bytes());
+        add_memory_entry(&result->stats, "solver.tail_peeling", peeling_usage);
+    }
+    if (balls) {
+        PCSTFast::MemoryUsage balls_usage;
+        balls_usage.set(balls->memory_bytes());
+        add_memory_entry(&result->stats, "solver.prize_balls", balls_usage);
+    }
+    if (network) {
+        PCSTFast::MemoryUsage network_usage;
+        network_usage.set(network->memory_bytes());
+        add_memory_entry(&result->stats, "solver.distance_network", network_usage);
+    }
 
-        // Solve
-        vector<int> result_nodes_vec;
-        vector<int> result_edges_vec;
+    if (success && network) {
+        vector<int> network_nodes;
+        vector<int> network_edges;
+        network_nodes.swap(result_nodes_vec);
+        network_edges.swap(result_edges_vec);
+        network->finish(network_nodes, network_edges, &result_nodes_vec, &result_edges_vec);
+    }
 
-        bool success = solver.run(&result_nodes_vec, &result_edges_vec);
+    if (success && peeling) {
+        vector<int> core_nodes;
+        vector<int> core_edges;
+        core_nodes.swap(result_nodes_vec);
+        core_edges.swap(result_edges_vec);
+        peeling->expand(core_nodes, core_edges, cpp_root < 0 && target_num_active_clusters <= 1,
+                        &result_nodes_vec, &result_edges_vec);
+    }
+    if (success && balls) {
+        balls->restore(&result_nodes_vec, &result_edges_vec);
+    }
 
-        if (success) {
-            // Allocate memory for results
-            result->num_nodes = result_nodes_vec.size();
-            result->num_edges = result_edges_vec.size();
+    if (success) {
+        if (!copy_solution(result_nodes_vec, result_edges_vec, result)) {
+            return;
+        }
 
-            if (result->num_nodes > 0) {
-                result->result_nodes = (int*)malloc(result->num_nodes * sizeof(int));
-                if (!result->result_nodes) {
-                    strcpy(result->error_message, "Failed to allocate memory for result nodes");
-                    return result;
+        if (options && options->rooted_payoffs) {
+            vector<PCSTFast::RootedPayoff> payoffs;
+            solver.get_rooted_payoffs(&payoffs);
+            int n = static_cast<int>(payoffs.size());
+            if (n > 0) {
+                result->payoff_nodes = (int*)malloc(n * sizeof(int));
+                result->payoff_components = (int*)malloc(n * sizeof(int));
+                result->rooted_payoffs = (double*)malloc(n * sizeof(double));
+                if (!result->payoff_nodes || !result->payoff_components
+                    || !result->rooted_payoffs) {
+                    strcpy(result->error_message, "Failed to allocate memory for rooted payoffs");
+                    return;
                 }
-                for (int i = 0; i < result->num_nodes; i++) {
-                    result->result_nodes[i] = result_nodes_vec[i];
+                for (int i = 0; i < n; i++) {
+                    result->payoff_nodes[i] = balls ? balls->original_node(payoffs[i].node)
+                                                    : payoffs[i].node;
+                    result->payoff_components[i] = payoffs[i].component;
+                    result->rooted_payoffs[i] = payoffs[i].payoff;
                 }
+                result->num_rooted_payoffs = n;
             }
+        }
+
+        result->success = 1;
+    } else {
+        // Enhanced failure reporting
+        snprintf(result->error_message, sizeof(result->error_message),
+                "PCST algorithm failed: root=%d, clusters=%d, pruning=%d, nodes=%d, edges=%d",
+                cpp_root, target_num_active_clusters, pruning_method, num_nodes, num_edges);
+    }
+}
 
-            if (result->num_edges > 0) {
-                result->result_edges = (int*)malloc(result->num_edges * sizeof(int));
-                if (!result->result_edges) {
-                    strcpy(result->error_message, "Failed to allocate memory for result edges");
-                    if (result->result_nodes) {
-                        free(result->result_nodes);
-                        result->result_nodes = nullptr;
-                    }
-                    return result;
+// Opaque handle of the C API
+struct pcst_builder {
+    PCSTFastBuilder input;
+
+    pcst_builder(bool use_thread, bool profile) : input(use_thread, profile) {}
+};
+
+// Opaque handle of repeated repairs. The input is checked and the incidence
+// lists are built on the first run; a failed check fails every run.
+struct pcst_repairer {
+    PCSTFastBuilder input;
+    unique_ptr<TreeRepair> repair;
+    bool checked;
+    std::string input_error;
+
+    pcst_repairer() : input(false, false), checked(false) {}
+
+    // False when the input is invalid, with input_error set
+    bool prepare() {
+        if (!checked) {
+            checked = true;
+            try {
+                if (input.finalize(&input_error)) {
+                    repair.reset(new TreeRepair(input.get_edges(), input.get_prizes(),
+                                                input.get_costs()));
                 }
-                for (int i = 0; i < result->num_edges; i++) {
-                    result->result_edges[i] = result_edges_vec[i];
+            } catch (const std::exception& e) {
+                input_error = std::string("Exception: ") + e.what();
+            }
+        }
+        return repair != nullptr;
+    }
+};
+
+// Opaque handle of a frontier solve. The solver refers to the vectors, which
+// grow as nodes are expanded, and is created on the first continue.
+struct pcst_frontier {
+    vector<pair<int, int>> edges;
+    vector<double> prizes;
+    vector<double> costs;
+    int root_node;
+    int target_num_active_clusters;
+    PCSTFast::PruningMethod pruning;
+    int verbosity_level;
+    const pcst_options_t* options;
+    pcst_plan_t plan;
+    unique_ptr<PCSTFast> solver;
+    PCSTFast::StepStatus status;
+    vector<int> nodes_to_expand;
+    std::string error;           // solver setup or growth failed
+};
+
+// Validate the root and set up the solver of a frontier solve
+static void start_frontier(pcst_frontier* frontier) {
+    const pcst_options_t* options = frontier->options;
+    int num_nodes = static_cast<int>(frontier->prizes.size());
+    int root_node = frontier->root_node;
+    char message[256];
+
+    if (root_node >= 0) {
+        if (root_node >= num_nodes) {
+            snprintf(message, sizeof(message),
+                    "Root node %d is out of range. Valid range is 0-%d",
+                    root_node, num_nodes - 1);
+            throw std::invalid_argument(message);
+        }
+        bool connected = false;
+        for (size_t i = 0; i < frontier->edges.size() && !connected; i++) {
+            connected = frontier->edges[i].first == root_node
+                        || frontier->edges[i].second == root_node;
+        }
+        if (!connected) {
+            snprintf(message, sizeof(message),
+                    "Root node %d is not connected to any edges", root_node);
+            throw std::invalid_argument(message);
+        }
+    }
+
+    frontier->solver.reset(new PCSTFast(
+        frontier->edges, frontier->prizes, frontier->costs,
+        root_node < 0 ? PCSTFast::kNoRoot : root_node, frontier->target_num_active_clusters,
+        frontier->pruning, frontier->verbosity_level, default_output_function));
+    PCSTFast& solver = *frontier->solver;
+    solver.set_perf_session(options ? options->perf : nullptr);
+    if (options && options->max_growth_time >= 0.0) {
+        solver.set_max_growth_time(options->max_growth_time);
+    }
+    if (options && options->event_bucket_epsilon > 0.0) {
+        solver.set_event_bucket_epsilon(options->event_bucket_epsilon);
+    }
+    solver.set_node_expansion(true);
+}
+
+extern "C" {
+
+void pcst_init_options(pcst_options_t* options) {
+    options->perf = nullptr;
+    options->rooted_payoffs = 0;
+    options->max_growth_time = -1.0;
+    options->interrupt = nullptr;
+    options->interrupt_arg = nullptr;
+    options->distance_network = -1;
+    options->lazy_edges = 0;
+    options->event_bucket_epsilon = 0.0;
+    options->plan = nullptr;
+    options->exact_max_nodes = 0;
+}
+
+pcst_result_t* pcst_solve(
+    int* edge_sources,
+    int* edge_targets,
+    double* edge_costs,
+    int num_edges,
+    double* node_prizes,
+    int num_nodes,
+    int root_node,
+    int target_num_active_clusters,
+    int pruning_method,
+    int verbosity_level
+) {
+    return pcst_solve_with_options(edge_sources, edge_targets, edge_costs, num_edges,
+                                   node_prizes, num_nodes, root_node,
+                                   target_num_active_clusters, pruning_method,
+                                   verbosity_level, nullptr);
+}
+
+pcst_result_t* pcst_solve_with_options(
+    int* edge_sources,
+    int* edge_targets,
+    double* edge_costs,
+    int num_edges,
+    double* node_prizes,
+    int num_nodes,
+    int root_node,
+    int target_num_active_clusters,
+    int pruning_method,
+    int verbosity_level,
+    const pcst_options_t* options
+) {
+    pcst_result_t* result = new_result();
+    if (!result) {
+        return nullptr;
+    }
+
+    try {
+        // Input conversion and solver setup count as construction
+        pcst_perf_begin(options ? options->perf : nullptr, PCST_PHASE_CONSTRUCT);
+        PCSTFastBuilder input(false, pruning_method == PCST_PRUNING_AUTO
+                                     && !(options && options->plan));
+        input.reserve(num_nodes, num_edges);
+        input.add_edges(edge_sources, edge_targets, edge_costs, num_edges);
+        input.set_prizes(node_prizes, num_nodes);
+        solve_input(input, root_node, target_num_active_clusters, pruning_method,
+                    verbosity_level, options, result);
+    } catch (const std::exception& e) {
+        snprintf(result->error_message, sizeof(result->error_message),
+                "Exception: %s", e.what());
+    } catch (...) {
+        strcpy(result->error_message, "Unknown exception occurred");
+    }
+
+    return result;
+}
+
+void pcst_solve_batch(
+    const pcst_problem_t* problems,
+    int num_problems,
+    int num_threads,
+    int pruning_method,
+    int verbosity_level,
+    const pcst_options_t* options,
+    pcst_result_t** results
+) {
+    std::atomic<int> next_problem(0);
+    auto solve_remaining = [&]() {
+        for (int ii = next_problem++; ii < num_problems; ii = next_problem++) {
+            const pcst_problem_t& problem = problems[ii];
+            if (options && options->interrupt && options->interrupt(options->interrupt_arg)) {
+                results[ii] = new_result();
+                if (results[ii]) {
+                    results[ii]->interrupted = 1;
                 }
+                continue;
             }
+            results[ii] = pcst_solve_with_options(
+                problem.edge_sources, problem.edge_targets, problem.edge_costs,
+                problem.num_edges, problem.node_prizes, problem.num_nodes,
+                problem.root_node, problem.target_num_active_clusters, pruning_method,
+                verbosity_level, options);
+        }
+    };
 
-            result->success = 1;
-        } else {
-            // Enhanced failure reporting
+    // Helpers inherit the signal mask, so the caller's handlers keep running
+    // on the caller's thread only
+    vector<std::thread> helpers;
+    sigset_t all_signals;
+    sigset_t old_signals;
+    sigfillset(&all_signals);
+    pthread_sigmask(SIG_SETMASK, &all_signals, &old_signals);
+    try {
+        int num_helpers = std::min(num_threads, num_problems) - 1;
+        helpers.reserve(std::max(num_helpers, 0));
+        for (int ii = 0; ii < num_helpers; ++ii) {
+            helpers.emplace_back(solve_remaining);
+        }
+    } catch (const std::exception&) {
+        // Fewer helpers; the problems are shared out all the same
+    }
+    pthread_sigmask(SIG_SETMASK, &old_signals, NULL);
+
+    solve_remaining();
+    for (std::thread& helper : helpers) {
+        helper.join();
+    }
+}
+
+pcst_builder_t* pcst_builder_create(int use_thread, int profile) {
+    try {
+        return new pcst_builder(use_thread != 0, profile != 0);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void pcst_builder_reserve(pcst_builder_t* builder, int num_nodes, int num_edges) {
+    try {
+        builder->input.reserve(num_nodes, num_edges);
+    } catch (...) {
+        // Only a hint
+    }
+}
+
+int pcst_builder_add_edges(pcst_builder_t* builder, const int* edge_sources,
+                           const int* edge_targets, const double* edge_costs,
+                           int num_edges) {
+    try {
+        builder->input.add_edges(edge_sources, edge_targets, edge_costs, num_edges);
+        return 1;
+    } catch (...) {
+        return 0;
+    }
+}
+
+int pcst_builder_set_prizes(pcst_builder_t* builder, const double* node_prizes, int num_nodes) {
+    try {
+        builder->input.set_prizes(node_prizes, num_nodes);
+        return 1;
+    } catch (...) {
+        return 0;
+    }
+}
+
+pcst_result_t* pcst_solve_builder(
+    pcst_builder_t* builder,
+    int root_node,
+    int target_num_active_clusters,
+    int pruning_method,
+    int verbosity_level,
+    const pcst_options_t* options
+) {
+    pcst_result_t* result = new_result();
+    if (!result) {
+        return nullptr;
+    }
+
+    try {
+        // Waiting for the helper thread to catch up counts as construction
+        pcst_perf_begin(options ? options->perf : nullptr, PCST_PHASE_CONSTRUCT);
+        solve_input(builder->input, root_node, target_num_active_clusters, pruning_method,
+                    verbosity_level, options, result);
+    } catch (const std::exception& e) {
+        snprintf(result->error_message, sizeof(result->error_message),
+                "Exception: %s", e.what());
+    } catch (...) {
+        strcpy(result->error_message, "Unknown exception occurred");
+    }
+
+    return result;
+}
+
+void pcst_builder_free(pcst_builder_t* builder) {
+    delete builder;
+}
+
+pcst_frontier_t* pcst_frontier_create(
+    int root_node,
+    int target_num_active_clusters,
+    int pruning_method,
+    int verbosity_level,
+    const pcst_options_t* options
+) {
+    pcst_frontier* frontier;
+    try {
+        frontier = new pcst_frontier();
+    } catch (...) {
+        return nullptr;
+    }
+    frontier->root_node = root_node;
+    frontier->target_num_active_clusters = target_num_active_clusters;
+    frontier->verbosity_level = verbosity_level;
+    frontier->options = options;
+    frontier->status = PCSTFast::kInProgress;
+
+    // Nothing is known about the graph up front, so there is no profile to
+    // plan from: automatic pruning is strong pruning without reductions
+    memset(&frontier->plan, 0, sizeof(frontier->plan));
+    if (options && options->plan) {
+        pruning_method = options->plan->pruning_method;
+    } else if (pruning_method == PCST_PRUNING_AUTO) {
+        frontier->plan.automatic = 1;
+        pruning_method = 3;
+    }
+    frontier->plan.pruning_method = (pruning_method >= 0 && pruning_method <= 3) ? pruning_method : 2;
+    switch (frontier->plan.pruning_method) {
+        case 0: frontier->pruning = PCSTFast::kNoPruning; break;
+        case 1: frontier->pruning = PCSTFast::kSimplePruning; break;
+        case 3: frontier->pruning = PCSTFast::kStrongPruning; break;
+        default: frontier->pruning = PCSTFast::kGWPruning; break;
+    }
+    return frontier;
+}
+
+int pcst_frontier_add_nodes(pcst_frontier_t* frontier, const double* node_prizes, int num_nodes) {
+    try {
+        frontier->prizes.insert(frontier->prizes.end(), node_prizes, node_prizes + num_nodes);
+        return 1;
+    } catch (...) {
+        return 0;
+    }
+}
+
+int pcst_frontier_add_edges(pcst_frontier_t* frontier, const int* edge_sources,
+                            const int* edge_targets, const double* edge_costs,
+                            int num_edges) {
+    try {
+        for (int i = 0; i < num_edges; i++) {
+            frontier->edges.push_back(make_pair(edge_sources[i], edge_targets[i]));
+        }
+        frontier->costs.insert(frontier->costs.end(), edge_costs, edge_costs + num_edges);
+        return 1;
+    } catch (...) {
+        return 0;
+    }
+}
+
+int pcst_frontier_continue(pcst_frontier_t* frontier, const int** nodes) {
+    const pcst_options_t* options = frontier->options;
+    bool polled = options && options->interrupt;
+
+    *nodes = nullptr;
+    if (frontier->status != PCSTFast::kInProgress
+        && frontier->status != PCSTFast::kExpandNodes) {
+        return 0;
+    }
+    try {
+        if (!frontier->solver) {
+            pcst_perf_begin(options ? options->perf : nullptr, PCST_PHASE_CONSTRUCT);
+            start_frontier(frontier);
+        }
+        PCSTFast::StepStatus status;
+        do {
+            status = frontier->solver->step(polled ? kInterruptCheckEvents
+                                                   : std::numeric_limits<long long>::max());
+        } while (status == PCSTFast::kInProgress
+                 && !(polled && options->interrupt(options->interrupt_arg)));
+        frontier->status = status;
+        if (status == PCSTFast::kExpandNodes) {
+            frontier->solver->get_nodes_to_expand(&frontier->nodes_to_expand);
+            *nodes = frontier->nodes_to_expand.data();
+            return static_cast<int>(frontier->nodes_to_expand.size());
+        }
+    } catch (const std::exception& e) {
+        frontier->status = PCSTFast::kFailed;
+        frontier->error = std::string("Exception: ") + e.what();
+    } catch (...) {
+        frontier->status = PCSTFast::kFailed;
+        frontier->error = "Unknown exception occurred";
+    }
+    return 0;
+}
+
+pcst_result_t* pcst_frontier_result(pcst_frontier_t* frontier) {
+    pcst_result_t* result = new_result();
+    if (!result) {
+        return nullptr;
+    }
+
+    result->plan = frontier->plan;
+    if (!frontier->error.empty()) {
+        snprintf(result->error_message, sizeof(result->error_message),
+                "%s", frontier->error.c_str());
+        return result;
+    }
+    if (frontier->status == PCSTFast::kInProgress
+        || frontier->status == PCSTFast::kExpandNodes) {
+        result->interrupted = 1;
+        strcpy(result->error_message, "Solve interrupted");
+        return result;
+    }
+
+    try {
+        PCSTFast& solver = *frontier->solver;
+        size_t input_bytes = frontier->edges.capacity() * sizeof(frontier->edges[0])
+                             + frontier->prizes.capacity() * sizeof(double)
+                             + frontier->costs.capacity() * sizeof(double);
+        copy_statistics(solver, input_bytes, &result->stats);
+        if (frontier->status != PCSTFast::kDone) {
             snprintf(result->error_message, sizeof(result->error_message),
                     "PCST algorithm failed: root=%d, clusters=%d, pruning=%d, nodes=%d, edges=%d",
-                    cpp_root, target_num_active_clusters, pruning_method, num_nodes, num_edges);
+                    frontier->root_node, frontier->target_num_active_clusters,
+                    frontier->plan.pruning_method, static_cast<int>(frontier->prizes.size()),
+                    static_cast<int>(frontier->edges.size()));
+            return result;
+        }
+        vector<int> result_nodes_vec;
+        vector<int> result_edges_vec;
+        solver.get_result(&result_nodes_vec, &result_edges_vec);
+        if (copy_solution(result_nodes_vec, result_edges_vec, result)) {
+            result->success = 1;
         }
-
     } catch (const std::exception& e) {
         snprintf(result->error_message, sizeof(result->error_message),
                 "Exception: %s", e.what());
     } catch (...) {
         strcpy(result->error_message, "Unknown exception occurred");
     }
+    return result;
+}
+
+void pcst_frontier_free(pcst_frontier_t* frontier) {
+    delete frontier;
+}
+
+pcst_result_t* pcst_repair(
+    int* edge_sources,
+    int* edge_targets,
+    double* edge_costs,
+    int num_edges,
+    double* node_prizes,
+    int num_nodes,
+    const int* tree_edges,
+    int num_tree_edges,
+    const int* failed_edges,
+    int num_failed_edges,
+    int root_node,
+    int one_tree,
+    const pcst_options_t* options
+) {
+    pcst_perf_session_t* perf = options ? options->perf : nullptr;
+    pcst_perf_begin(perf, PCST_PHASE_CONSTRUCT);
+    pcst_repairer_t* repairer = pcst_repairer_create(edge_sources, edge_targets, edge_costs,
+                                                     num_edges, node_prizes, num_nodes);
+    pcst_perf_end(perf);
+    if (!repairer) {
+        return nullptr;
+    }
+    pcst_result_t* result = pcst_repairer_run(repairer, tree_edges, num_tree_edges,
+                                              failed_edges, num_failed_edges,
+                                              root_node, one_tree, options);
+    pcst_repairer_free(repairer);
+    return result;
+}
 
+pcst_repairer_t* pcst_repairer_create(const int* edge_sources, const int* edge_targets,
+                                      const double* edge_costs, int num_edges,
+                                      const double* node_prizes, int num_nodes) {
+    try {
+        unique_ptr<pcst_repairer> repairer(new pcst_repairer());
+        repairer->input.reserve(num_nodes, num_edges);
+        repairer->input.add_edges(edge_sources, edge_targets, edge_costs, num_edges);
+        repairer->input.set_prizes(node_prizes, num_nodes);
+        return repairer.release();
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+pcst_result_t* pcst_repairer_run(
+    pcst_repairer_t* repairer,
+    const int* tree_edges,
+    int num_tree_edges,
+    const int* failed_edges,
+    int num_failed_edges,
+    int root_node,
+    int one_tree,
+    const pcst_options_t* options
+) {
+    pcst_result_t* result = new_result();
+    if (!result) {
+        return nullptr;
+    }
+    pcst_perf_session_t* perf = options ? options->perf : nullptr;
+    result->plan.pruning_method = 3;
+
+    try {
+        // The first run checks the input and builds the incidence lists
+        pcst_perf_begin(perf, PCST_PHASE_CONSTRUCT);
+        bool prepared = repairer->prepare();
+        pcst_perf_end(perf);
+        if (!prepared) {
+            snprintf(result->error_message, sizeof(result->error_message),
+                    "%s", repairer->input_error.c_str());
+            return result;
+        }
+        int num_nodes = static_cast<int>(repairer->input.get_prizes().size());
+        int num_edges = static_cast<int>(repairer->input.get_edges().size());
+        if (root_node >= num_nodes) {
+            snprintf(result->error_message, sizeof(result->error_message),
+                    "Root node %d is out of range. Valid range is 0-%d",
+                    root_node, num_nodes - 1);
+            return result;
+        }
+        vector<int> tree(tree_edges, tree_edges + num_tree_edges);
+        vector<int> failed(failed_edges, failed_edges + num_failed_edges);
+        for (int i = 0; i < num_tree_edges + num_failed_edges; i++) {
+            int edge = i < num_tree_edges ? tree[i] : failed[i - num_tree_edges];
+            if (edge < 0 || edge >= num_edges) {
+                snprintf(result->error_message, sizeof(result->error_message),
+                        "Edge %d is out of range. Valid range is 0-%d",
+                        edge, num_edges - 1);
+                return result;
+            }
+        }
+
+        pcst_perf_begin(perf, PCST_PHASE_REPAIR);
+        vector<int> result_nodes_vec;
+        vector<int> result_edges_vec;
+        repairer->repair->repair(tree, failed, root_node, one_tree != 0,
+                                 &result_nodes_vec, &result_edges_vec);
+        pcst_perf_end(perf);
+
+        result->stats.num_repair_fragments = repairer->repair->num_fragments();
+        result->stats.num_repair_paths = repairer->repair->num_reconnections();
+        result->stats.num_repair_settled_nodes = repairer->repair->num_settled_nodes();
+        PCSTFast::MemoryUsage input_usage;
+        input_usage.set(repairer->input.memory_bytes());
+        add_memory_entry(&result->stats, "solver.input", input_usage);
+        PCSTFast::MemoryUsage repair_usage;
+        repair_usage.set(repairer->repair->memory_bytes());
+        add_memory_entry(&result->stats, "solver.repair", repair_usage);
+        if (copy_solution(result_nodes_vec, result_edges_vec, result)) {
+            result->success = 1;
+        }
+    } catch (const std::exception& e) {
+        snprintf(result->error_message, sizeof(result->error_message),
+                "Exception: %s", e.what());
+    } catch (...) {
+        strcpy(result->error_message, "Unknown exception occurred");
+    }
     return result;
 }
 
+void pcst_repairer_searched_nodes(const pcst_repairer_t* repairer,
+                                  const int** scanned_nodes, int* num_scanned,
+                                  const int** reached_nodes, int* num_reached) {
+    static const vector<int> none;
+    const vector<int>& scanned = repairer->repair ? repairer->repair->get_scanned_nodes() : none;
+    const vector<int>& reached = repairer->repair ? repairer->repair->get_reached_nodes() : none;
+    *scanned_nodes = scanned.data();
+    *num_scanned = static_cast<int>(scanned.size());
+    *reached_nodes = reached.data();
+    *num_reached = static_cast<int>(reached.size());
+}
+
+void pcst_repairer_free(pcst_repairer_t* repairer) {
+    delete repairer;
+}
+
 void pcst_free_result(pcst_result_t* result) {
     if (result) {
         if (result->result_nodes) {
@@ -194,6 +1088,9 @@ void pcst_free_result(pcst_result_t* result) {
         if (result->result_edges) {
             free(result->result_edges);
         }
+        free(result->payoff_nodes);
+        free(result->payoff_components);
+        free(result->rooted_payoffs);
         free(result);
     }
 }
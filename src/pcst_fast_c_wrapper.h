@@ -1,10 +1,80 @@
 #ifndef PCST_FAST_C_WRAPPER_H
 #define PCST_FAST_C_WRAPPER_H
 
+#include <stddef.h>
+
+#include "pcst_perf.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+#define PCST_MAX_MEMORY_ENTRIES 10
+
+// pruning_method that picks the plan from a profile of the input graph
+#define PCST_PRUNING_AUTO 4
+
+// Structural profile of the input, computed in one pass for PCST_PRUNING_AUTO
+typedef struct {
+    int num_components;          // connected components, isolated nodes included
+    long long cycle_rank;        // edges - nodes + components, 0 for forests
+    int max_degree;
+    int num_leaves;              // nodes of degree 1
+    double mean_degree;
+    double prize_density;        // fraction of nodes with a positive prize
+    double cost_spread;          // max / min positive edge cost, 0 without such edges
+} pcst_profile_t;
+
+// How a solve was run
+typedef struct {
+    int automatic;               // chosen from the profile
+    int pruning_method;          // 0 none, 1 simple, 2 gw, 3 strong
+    int tree_dp;                 // input is one tree: no growth, exact strong pruning
+    int peel_tails;              // tree-shaped tails solved exactly, GW on the 2-core
+    int prize_balls;             // nodes out of reach of every prize dropped first
+    int distance_network;        // GW on the distance network of the prize nodes
+    int lazy_edges;              // edges enter the heaps in cost order as growth reaches them
+    int exact;                   // components of at most exact_max_nodes nodes solved exactly
+} pcst_plan_t;
+
+// Current and peak bytes of one solver-side structure
+typedef struct {
+    const char* name;
+    size_t current_bytes;
+    size_t peak_bytes;
+} pcst_memory_usage_t;
+
+// Solver statistics (mirrors PCSTFast::Statistics)
+typedef struct {
+    long long total_num_edge_events;
+    long long num_deleted_edge_events;
+    long long num_merged_edge_events;
+    long long total_num_merge_events;
+    long long num_active_active_merge_events;
+    long long num_active_inactive_merge_events;
+    long long total_num_edge_growth_events;
+    long long num_active_active_edge_growth_events;
+    long long num_active_inactive_edge_growth_events;
+    long long num_cluster_events;
+    double final_growth_time;    // moat growth time when growth stopped
+    int growth_time_capped;      // growth stopped at max_growth_time
+    int num_peeled_nodes;        // nodes solved by tail peeling instead of GW
+    int num_distant_nodes;       // nodes outside every prize ball, dropped before solving
+    int num_terminals;           // nodes of the distance network, 0 when not used
+    long long num_uninserted_edges;  // edges lazy insertion never put into a heap
+    long long num_event_buckets; // event times processed with event_bucket_epsilon
+    long long num_expanded_nodes;  // nodes whose edges a frontier solve asked for
+    int optimal;                 // result proven optimal, by tree_dp or the exact step
+    double objective_bound;      // prizes minus costs no tree exceeds, set by the exact step
+    int num_exact_components;    // components the exact step searched to the end
+    long long num_exact_subproblems;  // its branch and bound subproblems, one GW solve each
+    int num_repair_fragments;    // fragments the failed edges left, set by pcst_repair
+    int num_repair_paths;        // paths it added between them
+    long long num_repair_settled_nodes;  // nodes its search settled
+    int num_memory_entries;
+    pcst_memory_usage_t memory[PCST_MAX_MEMORY_ENTRIES];
+} pcst_stats_t;
+
 // C structure to hold the result
 typedef struct {
     int* result_nodes;
@@ -12,9 +82,56 @@ typedef struct {
     int num_nodes;
     int num_edges;
     int success;
+    int interrupted;             // abandoned through pcst_options_t.interrupt
     char error_message[256];
+    pcst_stats_t stats;
+    // Filled when pcst_options_t.rooted_payoffs is set (strong pruning only)
+    int* payoff_nodes;           // node of the phase 2 forest
+    int* payoff_components;      // strong pruning component of that node
+    double* rooted_payoffs;      // component payoff when rooted at that node
+    int num_rooted_payoffs;
+    pcst_plan_t plan;
+    pcst_profile_t profile;      // only filled for PCST_PRUNING_AUTO
 } pcst_result_t;
 
+// Optional settings for pcst_solve_with_options
+typedef struct {
+    pcst_perf_session_t* perf;   // phase timing / hardware counters, or NULL
+    int rooted_payoffs;          // return the rerooted payoff of every forest node
+    double max_growth_time;      // freeze growth at this moat time, negative: no cap
+    // Polled between slices of the solve; returning nonzero abandons it and
+    // sets pcst_result_t.interrupted. NULL solves in one go.
+    int (*interrupt)(void* arg);
+    void* interrupt_arg;
+    // Solve on the distance network of the prize nodes: 1 whenever one tree
+    // is wanted, 0 never, -1 when PCST_PRUNING_AUTO picks it
+    int distance_network;
+    // Insert edges into the GW heaps lazily, in order of cost (see
+    // PCSTFast::set_lazy_edge_insertion); edges sorted by cost are read in
+    // one pass. Same result up to tie-breaking, much less memory when growth
+    // ends early.
+    int lazy_edges;
+    // Round GW event times up to powers of (1 + epsilon) and process each
+    // bucket as a batch (see PCSTFast::set_event_bucket_epsilon). Faster,
+    // but no longer the exact GW forest. 0 is exact.
+    double event_bucket_epsilon;
+    // Run this plan instead of pruning_method, distance_network and
+    // lazy_edges. For testing solver variants; the caller must only ask for
+    // steps that fit the input (tree_dp needs a single tree, the reductions
+    // one wanted tree). NULL plans as usual.
+    const pcst_plan_t* plan;
+    // When one tree is wanted, check the GW tree against the GW dual and
+    // solve the connected components of at most this many nodes (after the
+    // reductions) by branch and bound, see ExactComponents. Sets
+    // pcst_stats_t.optimal when that proves the result optimal. Not with
+    // max_growth_time, event_bucket_epsilon, rooted_payoffs or the distance
+    // network. 0 never.
+    int exact_max_nodes;
+} pcst_options_t;
+
+// Fill options with defaults (everything off)
+void pcst_init_options(pcst_options_t* options);
+
 // C function to solve PCST
 pcst_result_t* pcst_solve(
     int* edge_sources,
@@ -29,6 +146,184 @@ pcst_result_t* pcst_solve(
     int verbosity_level
 );
 
+// Same as pcst_solve; options may be NULL
+pcst_result_t* pcst_solve_with_options(
+    int* edge_sources,
+    int* edge_targets,
+    double* edge_costs,
+    int num_edges,
+    double* node_prizes,
+    int num_nodes,
+    int root_node,
+    int target_num_active_clusters,
+    int pruning_method,
+    int verbosity_level,
+    const pcst_options_t* options
+);
+
+// One graph of a batch of independent solves
+typedef struct {
+    int* edge_sources;
+    int* edge_targets;
+    double* edge_costs;
+    int num_edges;
+    double* node_prizes;
+    int num_nodes;
+    int root_node;
+    int target_num_active_clusters;
+} pcst_problem_t;
+
+// pcst_solve_with_options on every problem, spread over up to num_threads
+// threads including the caller's; results[i] is the result of problems[i]
+// (NULL when out of memory). The extra threads block all signals and take
+// the next unsolved problem until none is left. options->interrupt is polled
+// from all threads, and once it fires the problems not yet started come
+// back interrupted without solving. options->perf must be NULL.
+void pcst_solve_batch(
+    const pcst_problem_t* problems,
+    int num_problems,
+    int num_threads,
+    int pruning_method,
+    int verbosity_level,
+    const pcst_options_t* options,
+    pcst_result_t** results
+);
+
+// Input built incrementally while it is read, for loaders that get edges in
+// batches. With use_thread a helper thread checks and profiles each batch
+// while the caller reads the next one, so that pcst_solve_builder is left
+// with little more than the solve itself. profile also counts components for
+// PCST_PRUNING_AUTO on the way.
+typedef struct pcst_builder pcst_builder_t;
+
+// NULL when out of memory
+pcst_builder_t* pcst_builder_create(int use_thread, int profile);
+
+// Size hints, before the first batch
+void pcst_builder_reserve(pcst_builder_t* builder, int num_nodes, int num_edges);
+
+// Append edges in index order; the arrays are copied. Returns 0 when out of
+// memory. Invalid edges are reported by pcst_solve_builder.
+int pcst_builder_add_edges(pcst_builder_t* builder, const int* edge_sources,
+                           const int* edge_targets, const double* edge_costs,
+                           int num_edges);
+
+// Prizes of all nodes, any time before solving. Returns 0 when out of memory.
+int pcst_builder_set_prizes(pcst_builder_t* builder, const double* node_prizes, int num_nodes);
+
+// Same as pcst_solve_with_options on the edges and prizes of the builder.
+// Waits for the helper thread first; no more edges can be added afterwards.
+pcst_result_t* pcst_solve_builder(
+    pcst_builder_t* builder,
+    int root_node,
+    int target_num_active_clusters,
+    int pruning_method,
+    int verbosity_level,
+    const pcst_options_t* options
+);
+
+// Free a builder, stopping its helper thread
+void pcst_builder_free(pcst_builder_t* builder);
+
+// Solve over a graph that is read as growth reaches it (see
+// PCSTFast::set_node_expansion). The caller adds the prize nodes, the root
+// and all their edges, then calls pcst_frontier_continue, which grows until
+// it needs the edges of nodes it has reached. The caller adds those edges
+// and the nodes they lead to, and continues until 0 is returned. Only
+// max_growth_time, event_bucket_epsilon, interrupt, perf and the pruning
+// method of plan are taken from options, which must outlive the solve.
+// PCST_PRUNING_AUTO is strong pruning, as there is no graph to profile.
+typedef struct pcst_frontier pcst_frontier_t;
+
+// NULL when out of memory
+pcst_frontier_t* pcst_frontier_create(
+    int root_node,
+    int target_num_active_clusters,
+    int pruning_method,
+    int verbosity_level,
+    const pcst_options_t* options
+);
+
+// Append nodes in index order. Nodes added after the first
+// pcst_frontier_continue must have prize 0. Returns 0 when out of memory.
+int pcst_frontier_add_nodes(pcst_frontier_t* frontier, const double* node_prizes, int num_nodes);
+
+// Append edges between nodes added so far; the arrays are copied. Each edge
+// must be added once. Returns 0 when out of memory.
+int pcst_frontier_add_edges(pcst_frontier_t* frontier, const int* edge_sources,
+                            const int* edge_targets, const double* edge_costs,
+                            int num_edges);
+
+// Grow until the edges of more nodes are needed and return how many, with
+// *nodes pointing at them until the next call. All edges of these nodes not
+// added yet must be added before continuing. 0 once the solve is finished,
+// has failed or was interrupted; pcst_frontier_result tells which.
+int pcst_frontier_continue(pcst_frontier_t* frontier, const int** nodes);
+
+// Result of a frontier solve after pcst_frontier_continue returned 0, like
+// that of pcst_solve_with_options. NULL when out of memory.
+pcst_result_t* pcst_frontier_result(pcst_frontier_t* frontier);
+
+void pcst_frontier_free(pcst_frontier_t* frontier);
+
+// Repair a previous result after some edges failed, without solving again
+// (see TreeRepair). tree_edges is the result and failed_edges the edges that
+// can no longer be used. The fragments left are reconnected along the
+// cheapest paths around the failures where their net prize pays for the
+// path, and trees that lost no edge are returned as they were. With
+// one_tree, tree_edges is one tree even where it is split already, for
+// callers whose failed edges are gone from the graph. A rooted result keeps
+// root_node (-1 for none). Only perf is taken from options, which may be
+// NULL. The plan is strong pruning.
+pcst_result_t* pcst_repair(
+    int* edge_sources,
+    int* edge_targets,
+    double* edge_costs,
+    int num_edges,
+    double* node_prizes,
+    int num_nodes,
+    const int* tree_edges,
+    int num_tree_edges,
+    const int* failed_edges,
+    int num_failed_edges,
+    int root_node,
+    int one_tree,
+    const pcst_options_t* options
+);
+
+// pcst_repair in two steps, for repeated repairs on one graph. The incidence
+// lists are built once by pcst_repairer_create, so that every run only costs
+// the neighbourhood of its failures.
+typedef struct pcst_repairer pcst_repairer_t;
+
+// The arrays are copied. NULL when out of memory; invalid input is reported
+// by pcst_repairer_run.
+pcst_repairer_t* pcst_repairer_create(const int* edge_sources, const int* edge_targets,
+                                      const double* edge_costs, int num_edges,
+                                      const double* node_prizes, int num_nodes);
+
+// Same as pcst_repair on the graph of the repairer
+pcst_result_t* pcst_repairer_run(
+    pcst_repairer_t* repairer,
+    const int* tree_edges,
+    int num_tree_edges,
+    const int* failed_edges,
+    int num_failed_edges,
+    int root_node,
+    int one_tree,
+    const pcst_options_t* options
+);
+
+// Nodes whose edges the last run read and all nodes it reached, valid until
+// the next run (see TreeRepair::get_scanned_nodes). A caller that loads the
+// graph as the search gets to it reads the edges of the reached nodes and
+// runs again on a new repairer until it had those of every scanned node.
+void pcst_repairer_searched_nodes(const pcst_repairer_t* repairer,
+                                  const int** scanned_nodes, int* num_scanned,
+                                  const int** reached_nodes, int* num_reached);
+
+void pcst_repairer_free(pcst_repairer_t* repairer);
+
 // Free the result structure
 void pcst_free_result(pcst_result_t* result);
 
@@ -1,5 +1,7 @@
 #include "postgres.h"
+#include <float.h>
 #include "fmgr.h"
+#include "miscadmin.h"
 #include "funcapi.h"
 #include "access/htup_details.h"
 #include "catalog/pg_type.h"
@@ -9,13 +11,74 @@
 #include "executor/spi.h"
 #include "lib/stringinfo.h"
 #include "utils/hsearch.h"
+#include "utils/guc.h"
 #include "pcst_fast_c_wrapper.h"
+#include "pcst_loader.h"
+#include "pcst_perf.h"
+#include "pcst_slow_log.h"
+#include "pcst_threads.h"
 
 PG_MODULE_MAGIC;
 
+/* GUC: sample hardware performance counters in pgr_pcst_fast_stats */
+static bool pcst_perf_counters = false;
+
+/* GUC: moat growth time horizon for all solves, negative for none */
+static double pcst_max_growth_time = -1.0;
+
+/* GUC: server-wide solver thread budget, 0 for one thread per CPU */
+static int pcst_max_total_threads = 0;
+
+/* GUC: insert edges into the GW heaps in cost order as growth reaches them */
+static bool pcst_lazy_edges = false;
+
+/* GUC: round GW event times up to powers of (1 + epsilon), 0 for exact growth */
+static double pcst_event_bucket_epsilon = 0.0;
+
+/* GUC: build the solver input on a helper thread while the edges are read */
+static bool pcst_builder_thread = false;
+
+/* GUC: solve components of up to this many nodes exactly after GW, 0 for none */
+static int pcst_exact_max_nodes = 0;
+
+/* GUC: solve on the distance network of the prize nodes (pcst_options_t values) */
+static int pcst_distance_network = -1;
+
+static const struct config_enum_entry distance_network_options[] = {
+    {"off", 0, false},
+    {"auto", -1, false},
+    {"on", 1, false},
+    {NULL, 0, false}
+};
+
+/* GUC: log calls taking at least this many milliseconds, -1 for none */
+static int pcst_log_min_duration = -1;
+
+/* GUC: format of those log lines */
+static int pcst_slow_log_format = PCST_LOG_FORMAT_TEXT;
+
+static const struct config_enum_entry log_format_options[] = {
+    {"text", PCST_LOG_FORMAT_TEXT, false},
+    {"json", PCST_LOG_FORMAT_JSON, false},
+    {NULL, 0, false}
+};
+
+void _PG_init(void);
+
 /* Function declarations */
 PG_FUNCTION_INFO_V1(pcst_fast_pg);
 PG_FUNCTION_INFO_V1(pcst_fast_pgr);
+PG_FUNCTION_INFO_V1(pcst_fast_pgr_arrays);
+PG_FUNCTION_INFO_V1(pcst_fast_pgr_stats);
+PG_FUNCTION_INFO_V1(pcst_fast_pgr_root_payoffs);
+PG_FUNCTION_INFO_V1(pcst_fast_pgr_withpoints);
+PG_FUNCTION_INFO_V1(pcst_fast_pgr_delta);
+PG_FUNCTION_INFO_V1(pcst_fast_pgr_grouped);
+PG_FUNCTION_INFO_V1(pcst_fast_pgr_frontier);
+PG_FUNCTION_INFO_V1(pcst_fast_pgr_repair);
+PG_FUNCTION_INFO_V1(pcst_fast_pgr_repair_frontier);
+PG_FUNCTION_INFO_V1(pcst_fast_thread_budget);
+PG_FUNCTION_INFO_V1(pcst_fast_thread_holders);
 
 /* Helper structures for storing intermediate data */
 typedef struct {
@@ -30,10 +93,10 @@ typedef struct {
 
 /* Structure to store ID mapping and result data for pgr-style function */
 typedef struct {
-    text **index_to_node_id;     // Maps internal index -> original node ID (text)
-    text **index_to_edge_id;     // Maps internal index -> original edge ID (text)
-    text **edge_sources;         // Original source node IDs for edges (text)
-    text **edge_targets;         // Original target node IDs for edges (text)
+    text **index_to_node_id;     // Maps internal index -> original node ID (text), nodes of selected edges only
+    text **index_to_edge_id;     // Maps internal index -> original edge ID (text), selected edges only
+    text **edge_sources;         // Original source node IDs for edges (text), selected edges only
+    text **edge_targets;         // Original target node IDs for edges (text), selected edges only
     double *edge_costs;          // Edge costs
     int num_nodes;               // Number of unique nodes
     int num_edges;               // Number of edges
@@ -42,6 +105,390 @@ typedef struct {
     int verbosity;               // Verbosity level for debugging
 } pgr_result_data;
 
+/* Name/value rows returned by pgr_pcst_fast_stats */
+typedef struct {
+    char **names;
+    double *values;
+    int num_stats;
+    int max_stats;
+    MemoryContext mcxt;          // Context the rows are allocated in
+} pcst_stat_rows;
+
+/* (node, component, rooted_payoff) rows returned by pgr_pcst_fast_root_payoffs */
+typedef struct {
+    text **nodes;                // Original node IDs, materialized before SPI_finish
+    int *components;
+    double *payoffs;
+    int num_rows;
+} pcst_payoff_rows;
+
+/* Selected stretch of an original edge returned by pgr_pcst_fast_withpoints */
+typedef struct {
+    int edge;                    // Original edge index
+    double start;                // Fractions along the original edge
+    double end;
+    double cost;
+} pcst_edge_piece;
+
+typedef struct {
+    text **edge_ids;             // Original IDs, materialized before SPI_finish
+    text **sources;
+    text **targets;
+    pcst_edge_piece *pieces;
+    int num_rows;
+} pcst_withpoints_rows;
+
+/* Added or removed edge returned by pgr_pcst_fast_delta */
+typedef struct {
+    bool added;
+    text *edge_id;               // Original IDs, materialized before SPI_finish
+    text *source;                // NULL for previous edges missing from the graph
+    text *target;
+    double cost;
+    double objective_delta;      // Change of prizes minus costs due to this row
+    bool in_graph;               // cost and objective_delta are known
+} pcst_delta_row;
+
+typedef struct {
+    pcst_delta_row *rows;
+    int num_rows;
+} pcst_delta_rows;
+
+/* Rows returned by pgr_pcst_fast_grouped, materialized before SPI_finish */
+typedef struct {
+    text **group_ids;            // Group of each row
+    int *seqs;                   // Position within the group, 1-based
+    text **edge_ids;
+    text **sources;
+    text **targets;
+    double *costs;
+    int num_rows;
+} pcst_grouped_rows;
+
+/*
+ * Rows returned by pgr_pcst_fast_frontier and pgr_pcst_fast_repair,
+ * materialized before SPI_finish
+ */
+typedef struct {
+    text **edge_ids;
+    text **sources;
+    text **targets;
+    double *costs;
+    int num_rows;
+} pcst_frontier_rows;
+
+void _PG_init(void) {
+    DefineCustomBoolVariable("pcst_fast.perf_counters",
+                             "Collect hardware performance counters per solver phase.",
+                             "Used by pgr_pcst_fast_stats. Counters that perf_event_open "
+                             "cannot provide are left out of the output.",
+                             &pcst_perf_counters,
+                             false,
+                             PGC_USERSET,
+                             0,
+                             NULL, NULL, NULL);
+
+    DefineCustomRealVariable("pcst_fast.max_growth_time",
+                             "Stop GW moat growth at this time.",
+                             "Clusters still growing at that time are frozen and the forest "
+                             "built so far is pruned as usual, which bounds both runtime and "
+                             "how far the solution reaches from prize nodes. -1 disables the cap.",
+                             &pcst_max_growth_time,
+                             -1.0,
+                             -1.0,
+                             DBL_MAX,
+                             PGC_USERSET,
+                             0,
+                             NULL, NULL, NULL);
+
+    DefineCustomRealVariable("pcst_fast.event_bucket_epsilon",
+                             "Round moat growth event times up to powers of (1 + epsilon).",
+                             "All events of one bucket are processed together at its end "
+                             "instead of one by one in time order. Faster on large graphs, "
+                             "but the result is only close to the exact GW forest, and the "
+                             "loss grows with epsilon. 0 grows exactly.",
+                             &pcst_event_bucket_epsilon,
+                             0.0,
+                             0.0,
+                             1.0,
+                             PGC_USERSET,
+                             0,
+                             NULL, NULL, NULL);
+
+    DefineCustomIntVariable("pcst_fast.max_total_threads",
+                            "Maximum number of solver threads across all backends.",
+                            "Each solve gets what is left of this budget when it starts, "
+                            "but always at least one thread. The budget is only shared "
+                            "between backends when pcst_fast is in shared_preload_libraries. "
+                            "0 means one thread per CPU.",
+                            &pcst_max_total_threads,
+                            0,
+                            0,
+                            INT_MAX,
+                            PGC_SIGHUP,
+                            0,
+                            NULL, NULL, NULL);
+
+    DefineCustomBoolVariable("pcst_fast.lazy_edges",
+                             "Insert edges into the moat growth heaps only when growth reaches them.",
+                             "Edges enter in order of cost once growth time reaches half their "
+                             "cost, and edges inside a cluster by then never do. Saves memory "
+                             "and events when growth ends early; results only differ in how "
+                             "ties between simultaneous events are broken. pruning => 'auto' "
+                             "always does this.",
+                             &pcst_lazy_edges,
+                             false,
+                             PGC_USERSET,
+                             0,
+                             NULL, NULL, NULL);
+
+    DefineCustomBoolVariable("pcst_fast.builder_thread",
+                             "Build the solver input on a helper thread while edges are read.",
+                             "Edges are handed over in batches as the edges query is read, and "
+                             "a helper thread checks and profiles them in the meantime, so the "
+                             "solve starts with its input ready. Takes a second thread from "
+                             "pcst_fast.max_total_threads; without one the batches are "
+                             "processed in between reading. Applies to pgr_pcst_fast and "
+                             "pgr_pcst_fast_stats.",
+                             &pcst_builder_thread,
+                             false,
+                             PGC_USERSET,
+                             0,
+                             NULL, NULL, NULL);
+
+    DefineCustomEnumVariable("pcst_fast.distance_network",
+                             "Solve on the distance network between prize nodes.",
+                             "The network has one node per prize node (and the root) and "
+                             "one edge per pair of neighbouring shortest-path regions. GW "
+                             "runs on it and the chosen paths are expanded and pruned "
+                             "again, which is near-linear on graphs with few prize nodes. "
+                             "'auto' leaves it to pruning => 'auto'; 'on' uses it for every "
+                             "solve that wants one tree.",
+                             &pcst_distance_network,
+                             -1,
+                             distance_network_options,
+                             PGC_USERSET,
+                             0,
+                             NULL, NULL, NULL);
+
+    DefineCustomIntVariable("pcst_fast.exact_max_nodes",
+                            "Solve components of at most this many nodes exactly.",
+                            "After GW, connected components of the reduced graph up to this "
+                            "size that may hold a better tree are searched by branch and "
+                            "bound, seeded with the GW tree and bounded by its dual. Only "
+                            "for solves of one tree without a growth cap, event buckets or "
+                            "the distance network. Stops after 10000 subproblems, and "
+                            "pgr_pcst_fast_stats reports whether the result is optimal. "
+                            "0 disables it.",
+                            &pcst_exact_max_nodes,
+                            0,
+                            0,
+                            INT_MAX,
+                            PGC_USERSET,
+                            0,
+                            NULL, NULL, NULL);
+
+    DefineCustomIntVariable("pcst_fast.log_min_duration",
+                            "Log calls that take at least this long.",
+                            "Each such call logs one line with the graph size, parameters, "
+                            "plan, time per solver phase, event counters and memory peaks. "
+                            "0 logs every call, -1 none.",
+                            &pcst_log_min_duration,
+                            -1,
+                            -1,
+                            INT_MAX,
+                            PGC_SUSET,
+                            GUC_UNIT_MS,
+                            NULL, NULL, NULL);
+
+    DefineCustomEnumVariable("pcst_fast.log_format",
+                             "Format of the lines logged for slow calls.",
+                             "text writes key=value pairs, json one JSON object.",
+                             &pcst_slow_log_format,
+                             PCST_LOG_FORMAT_TEXT,
+                             log_format_options,
+                             PGC_SUSET,
+                             0,
+                             NULL, NULL, NULL);
+
+    MarkGUCPrefixReserved("pcst_fast");
+    pcst_threads_shmem_init();
+}
+
+/*
+ * Polled by the solver between slices of growth. Only reads the flags set by
+ * the signal handlers; the error itself is raised by CHECK_FOR_INTERRUPTS
+ * once the solver has returned, as ereport cannot unwind the C++ frames.
+ */
+static int solve_interrupted(void *arg) {
+    return QueryCancelPending || ProcDiePending;
+}
+
+/* Solver options shared by all SQL entry points, taken from the GUCs */
+static void init_solve_options(pcst_options_t *options) {
+    pcst_init_options(options);
+    options->max_growth_time = pcst_max_growth_time;
+    options->interrupt = solve_interrupted;
+    options->distance_network = pcst_distance_network;
+    options->lazy_edges = pcst_lazy_edges;
+    options->event_bucket_epsilon = pcst_event_bucket_epsilon;
+    options->exact_max_nodes = pcst_exact_max_nodes;
+}
+
+/* Start timing a call for pcst_fast.log_min_duration; see pcst_slow_log_begin */
+static void slow_log_begin(pcst_slow_log *log, pcst_options_t *options) {
+    pcst_slow_log_begin(log, pcst_log_min_duration, options);
+}
+
+/* Log a call that succeeded if it was slow */
+static void slow_log_end(pcst_slow_log *log, const char *function, text *root_id,
+                         int num_nodes, int num_edges, int num_clusters, int pruning_method,
+                         const pcst_options_t *options, pcst_result_t *result) {
+    pcst_slow_log_call call;
+
+    if (!log->active)
+        return;
+    call.function = function;
+    call.root_id = root_id ? text_to_cstring(root_id) : NULL;
+    call.num_nodes = num_nodes;
+    call.num_edges = num_edges;
+    call.num_groups = 0;
+    call.num_clusters = num_clusters;
+    call.pruning_method = pruning_method;
+    pcst_slow_log_end(log, pcst_log_min_duration, (pcst_log_format) pcst_slow_log_format, &call,
+                      options, &result, 1);
+}
+
+/*
+ * A cancelled solve raises the pending query cancel or termination; anything
+ * else is returned for the caller to check.
+ */
+static pcst_result_t *raise_if_interrupted(pcst_result_t *result, const pcst_options_t *options) {
+    if (result && result->interrupted) {
+        pcst_free_result(result);
+        if (options->perf)
+            pcst_perf_close(options->perf);
+        CHECK_FOR_INTERRUPTS();
+        ereport(ERROR, (errcode(ERRCODE_QUERY_CANCELED),
+                        errmsg("PCST solve was interrupted")));
+    }
+    return result;
+}
+
+/*
+ * pcst_solve_with_options holding threads from the server-wide budget. The
+ * solver is single-threaded, so one thread is requested.
+ */
+static pcst_result_t *solve_within_budget(int *edge_sources, int *edge_targets,
+                                          double *edge_costs, int num_edges,
+                                          double *node_prizes, int num_nodes,
+                                          int root, int num_clusters, int pruning_method,
+                                          int verbosity, const pcst_options_t *options) {
+    int threads = pcst_threads_acquire(1, pcst_max_total_threads);
+    pcst_result_t *result = pcst_solve_with_options(
+        edge_sources, edge_targets, edge_costs, num_edges, node_prizes, num_nodes,
+        root, num_clusters, pruning_method, verbosity, options);
+    pcst_threads_release(threads);
+
+    return raise_if_interrupted(result, options);
+}
+
+/*
+ * pcst_solve_batch with one thread per problem from the server-wide budget,
+ * as far as the budget goes. An interrupted batch raises like a single solve.
+ */
+static void solve_batch_within_budget(const pcst_problem_t *problems, int num_problems,
+                                      int pruning_method, int verbosity,
+                                      const pcst_options_t *options, pcst_result_t **results) {
+    int threads = pcst_threads_acquire(num_problems, pcst_max_total_threads);
+    pcst_solve_batch(problems, num_problems, threads, pruning_method, verbosity, options,
+                     results);
+    pcst_threads_release(threads);
+
+    for (int i = 0; i < num_problems; i++) {
+        if (results[i] && results[i]->interrupted) {
+            for (int j = 0; j < num_problems; j++) {
+                if (j != i)
+                    pcst_free_result(results[j]);
+            }
+            raise_if_interrupted(results[i], options);
+        }
+    }
+}
+
+/*
+ * Solver input builder of a graph being loaded, with the threads it holds
+ * from the budget: the backend's own and the helper's. If loading errors
+ * out, the builder is freed and the threads returned along with the memory
+ * context it was created in.
+ */
+typedef struct {
+    MemoryContextCallback callback;
+    pcst_builder_t *builder;
+    int threads;
+} pcst_builder_handle;
+
+static void free_builder_handle(void *arg) {
+    pcst_builder_handle *handle = (pcst_builder_handle *) arg;
+
+    pcst_builder_free(handle->builder);
+    handle->builder = NULL;
+    pcst_threads_release(handle->threads);
+    handle->threads = 0;
+}
+
+/*
+ * pcst_load_graph for a solve, with the prizes from nodes_sql or, when that
+ * is NULL, from the node_ids and prizes arrays. With
+ * pcst_fast.builder_thread the edges also go to a solver input builder in
+ * batches as they are read, processed by a helper thread if the budget has a
+ * second thread left, and the returned handle is passed on to
+ * solve_graph_within_budget. Otherwise NULL.
+ */
+static pcst_builder_handle *load_graph_for_solve(pcst_graph *graph, const char *edges_sql,
+                                                 const char *nodes_sql, ArrayType *node_ids,
+                                                 ArrayType *prizes, int pruning_method,
+                                                 int verbosity) {
+    pcst_builder_handle *handle = NULL;
+
+    if (pcst_builder_thread) {
+        handle = (pcst_builder_handle *) palloc0(sizeof(pcst_builder_handle));
+        handle->threads = pcst_threads_acquire(2, pcst_max_total_threads);
+        handle->builder = pcst_builder_create(handle->threads >= 2,
+                                              pruning_method == PCST_PRUNING_AUTO);
+        if (!handle->builder)
+            ereport(ERROR, (errcode(ERRCODE_OUT_OF_MEMORY),
+                            errmsg("out of memory creating the solver input builder")));
+        handle->callback.func = free_builder_handle;
+        handle->callback.arg = handle;
+        MemoryContextRegisterResetCallback(CurrentMemoryContext, &handle->callback);
+    }
+    if (nodes_sql)
+        pcst_load_graph_with_builder(graph, edges_sql, nodes_sql, verbosity,
+                                     handle ? handle->builder : NULL);
+    else
+        pcst_load_graph_with_prize_arrays(graph, edges_sql, node_ids, prizes, verbosity,
+                                          handle ? handle->builder : NULL);
+    return handle;
+}
+
+/* solve_within_budget on a loaded graph, through its builder if it has one */
+static pcst_result_t *solve_graph_within_budget(pcst_graph *graph, pcst_builder_handle *handle,
+                                                int root, int num_clusters, int pruning_method,
+                                                int verbosity, const pcst_options_t *options) {
+    pcst_result_t *result;
+
+    if (!handle)
+        return solve_within_budget(graph->edge_sources, graph->edge_targets, graph->edge_costs,
+                                   graph->num_edges, graph->node_prizes, graph->num_nodes,
+                                   root, num_clusters, pruning_method, verbosity, options);
+
+    result = pcst_solve_builder(handle->builder, root, num_clusters, pruning_method,
+                                verbosity, options);
+    free_builder_handle(handle);
+    return raise_if_interrupted(result, options);
+}
+
 /* Main PCST function */
 Datum pcst_fast_pg(PG_FUNCTION_ARGS) {
     ArrayType *edges_array = PG_GETARG_ARRAYTYPE_P(0);
@@ -106,14 +553,20 @@ Datum pcst_fast_pg(PG_FUNCTION_ARGS) {
             pruning_method = 2;
         else if (strcmp(pruning_str, "strong") == 0)
             pruning_method = 3;
+        else if (strcmp(pruning_str, "auto") == 0)
+            pruning_method = PCST_PRUNING_AUTO;
         else
             pruning_method = 2; // default to GW
 
         // Call the C function (prizes/costs are in arrays indexed by internal node/edge indices)
-        pcst_result_t *result = pcst_solve(
+        pcst_options_t options;
+        pcst_slow_log slow_log;
+        init_solve_options(&options);
+        slow_log_begin(&slow_log, &options);
+        pcst_result_t *result = solve_within_budget(
             edge_sources, edge_targets, costs_data, num_edges,
             prizes_data, num_nodes,
-            root, num_clusters, pruning_method, verbosity
+            root, num_clusters, pruning_method, verbosity, &options
         );
 
         if (!result || !result->success) {
@@ -122,6 +575,8 @@ Datum pcst_fast_pg(PG_FUNCTION_ARGS) {
             ereport(ERROR, (errcode(ERRCODE_EXTERNAL_ROUTINE_EXCEPTION),
                            errmsg("PCST algorithm failed: %s", error_msg)));
         }
+        slow_log_end(&slow_log, "pcst_fast", root >= 0 ? cstring_to_text(psprintf("%d", root)) : NULL,
+                     num_nodes, num_edges, num_clusters, pruning_method, &options, result);
 
         // Store result for return
         funcctx->user_fctx = result;
@@ -168,143 +623,27 @@ Datum pcst_fast_pg(PG_FUNCTION_ARGS) {
     }
 }
 
-/* Hash table entry structure for node ID mapping (using text pointer keys) */
-typedef struct {
-    text *node_id;  // Key (pointer to text)
-    int index;      // Value
-} node_map_entry;
-
-/* Forward declaration */
-static int text_cmp(const text *t1, const text *t2);
-
-/* Hash function for text pointer keys - hashes the text content */
-static uint32 node_id_hash(const void *key, Size keysize) {
-    const text **tkey_ptr = (const text **) key;
-    const text *tkey = *tkey_ptr;
-    // Simple hash function: djb2 algorithm
-    const unsigned char *data = (const unsigned char *) VARDATA(tkey);
-    int len = VARSIZE(tkey) - VARHDRSZ;
-    uint32 hash = 5381;
-    for (int i = 0; i < len; i++) {
-        hash = ((hash << 5) + hash) + data[i]; /* hash * 33 + c */
-    }
-    return hash;
-}
-
-/* Match function for text pointer keys - compares text content */
-static int node_id_match(const void *key1, const void *key2, Size keysize) {
-    const text **k1_ptr = (const text **) key1;
-    const text **k2_ptr = (const text **) key2;
-    const text *k1 = *k1_ptr;
-    const text *k2 = *k2_ptr;
-    return (text_cmp(k1, k2) == 0) ? 0 : 1;
-}
-
-/* Helper function to compare two text values */
-static int text_cmp(const text *t1, const text *t2) {
-    int len1 = VARSIZE(t1) - VARHDRSZ;
-    int len2 = VARSIZE(t2) - VARHDRSZ;
-    int minlen = (len1 < len2) ? len1 : len2;
-    int cmp = memcmp(VARDATA(t1), VARDATA(t2), minlen);
-    if (cmp != 0)
-        return cmp;
-    return len1 - len2;
-}
-
-/* Helper function to convert any Datum to text */
-/* Always returns a text value allocated in the current memory context */
-static text *datum_to_text(Datum value, Oid type) {
-    if (type == TEXTOID) {
-        // For text type, we need to make a copy to ensure it's in the current memory context
-        text *input_text = DatumGetTextP(value);
-        int len = VARSIZE(input_text);
-        text *result = (text *) palloc(len);
-        memcpy(result, input_text, len);
-        return result;
-    } else {
-        // Use the type's output function to get a string, then convert to text
-        Oid output_func;
-        bool isvarlena;
-        getTypeOutputInfo(type, &output_func, &isvarlena);
-        char *str = OidOutputFunctionCall(output_func, value);
-        text *result = cstring_to_text(str);
-        pfree(str);
-        return result;
-    }
-}
-
-/* Helper function to find or add node ID to mapping using hash table */
-static int get_node_index(HTAB *node_map, int *next_index, text *node_id, text ***index_to_node_id, int verbosity) {
-    bool found;
-    node_map_entry *entry;
-    int node_id_len = VARSIZE(node_id);
-
-    // Make a copy of the node_id text for storage
-    text *node_id_copy = (text *) palloc(node_id_len);
-    memcpy(node_id_copy, node_id, node_id_len);
-
-    // Search for existing entry using the text pointer as key
-    entry = (node_map_entry *) hash_search(node_map, &node_id_copy, HASH_ENTER, &found);
-
-    if (!found) {
-        // New entry - set the index
-        int new_index = (*next_index)++;
-        entry->node_id = node_id_copy;  // Store the copy
-        entry->index = new_index;
-
-        // Reallocate index_to_node_id array if needed
-        *index_to_node_id = (text **) repalloc(*index_to_node_id, (*next_index) * sizeof(text *));
-        (*index_to_node_id)[new_index] = node_id_copy;
-
-        if (verbosity > 1) {
-            char *node_id_str = text_to_cstring(node_id_copy);
-            elog(INFO, "get_node_index: NEW node_id=%s -> index=%d", node_id_str, new_index);
-            pfree(node_id_str);
-        }
-    } else {
-        // Entry already exists, free the copy we made
-        pfree(node_id_copy);
-        if (verbosity > 1) {
-            char *node_id_str = text_to_cstring(entry->node_id);
-            elog(INFO, "get_node_index: FOUND node_id=%s -> index=%d", node_id_str, entry->index);
-            pfree(node_id_str);
-        }
-    }
-
-    return entry->index;
-}
-
-/* pg_routing-style PCST function that takes SQL queries */
-Datum pcst_fast_pgr(PG_FUNCTION_ARGS) {
+/*
+ * pg_routing-style PCST function that takes SQL queries. With prize_arrays
+ * the node_ids and prizes arrays take the place of nodes_sql, shifting the
+ * remaining arguments by one.
+ */
+static Datum pgr_pcst_fast_rows(FunctionCallInfo fcinfo, bool prize_arrays) {
+    int arg = prize_arrays ? 3 : 2;  // First argument after the prizes
     text *edges_sql = PG_GETARG_TEXT_P(0);
-    text *nodes_sql = PG_GETARG_TEXT_P(1);
-    text *root_id = PG_ARGISNULL(2) ? NULL : PG_GETARG_TEXT_P(2);  // Original node ID (text), or NULL for auto-select
-    int num_clusters = PG_ARGISNULL(3) ? 1 : PG_GETARG_INT32(3);
-    text *pruning_text = PG_ARGISNULL(4) ? NULL : PG_GETARG_TEXT_P(4);
-    int verbosity = PG_ARGISNULL(5) ? 0 : PG_GETARG_INT32(5);
+    text *root_id = PG_ARGISNULL(arg) ? NULL : PG_GETARG_TEXT_P(arg);  // Original node ID (text), or NULL for auto-select
+    int num_clusters = PG_ARGISNULL(arg + 1) ? 1 : PG_GETARG_INT32(arg + 1);
+    text *pruning_text = PG_ARGISNULL(arg + 2) ? NULL : PG_GETARG_TEXT_P(arg + 2);
+    int verbosity = PG_ARGISNULL(arg + 3) ? 0 : PG_GETARG_INT32(arg + 3);
 
     FuncCallContext *funcctx;
     TupleDesc tupdesc;
-    HASHCTL hash_ctl;
-    HTAB *node_map = NULL;
     MemoryContext oldcontext;
 
     if (SRF_IS_FIRSTCALL()) {
         int ret;
-        int next_node_index = 0;
-        int num_edges = 0;
-        int num_nodes = 0;
-        int max_edges = 1024;
-        text **edge_ids = NULL;
-        int *edge_sources = NULL;  // Internal indices
-        int *edge_targets = NULL;   // Internal indices
-        double *edge_costs = NULL;
-        text **index_to_node_id = NULL;
-        double *node_prizes = NULL;
+        pcst_graph graph;
         int root_index = -1;
-        char *edges_sql_str;
-        char *nodes_sql_str;
-        char *pruning_str;
         int pruning_method;
         pgr_result_data *pgr_data;
 
@@ -326,453 +665,37 @@ Datum pcst_fast_pgr(PG_FUNCTION_ARGS) {
                     (errcode(ERRCODE_INTERNAL_ERROR),
                      errmsg("SPI_connect failed: %d", ret)));
 
-        // Initialize hash table for node ID mapping (using text pointer keys)
-        memset(&hash_ctl, 0, sizeof(hash_ctl));
-        hash_ctl.keysize = sizeof(text *);  // Key is a pointer to text
-        hash_ctl.entrysize = sizeof(node_map_entry);  // Entry contains node_id (text*) and index
-        hash_ctl.hash = node_id_hash;
-        hash_ctl.match = node_id_match;
-        hash_ctl.hcxt = CurrentMemoryContext;
-        node_map = hash_create("node_id_map", 1024, &hash_ctl,
-                               HASH_ELEM | HASH_FUNCTION | HASH_COMPARE | HASH_CONTEXT);
-
-        // Allocate arrays
-        edge_ids = (text **) palloc(max_edges * sizeof(text *));
-        edge_sources = (int *) palloc(max_edges * sizeof(int));  // Internal indices
-        edge_targets = (int *) palloc(max_edges * sizeof(int));   // Internal indices
-        edge_costs = (double *) palloc(max_edges * sizeof(double));
-        // Allocate initial array - will be reallocated as needed
-        index_to_node_id = (text **) palloc(1024 * sizeof(text *));
-
-        // Execute edges query
-        edges_sql_str = text_to_cstring(edges_sql);
-        ret = SPI_execute(edges_sql_str, true, 0);
-        if (ret != SPI_OK_SELECT)
-            ereport(ERROR,
-                    (errcode(ERRCODE_INTERNAL_ERROR),
-                     errmsg("edges query failed: %s", SPI_result_code_string(ret))));
-
-        if (SPI_tuptable == NULL || SPI_processed == 0)
-            ereport(ERROR,
-                    (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
-                     errmsg("edges query returned no rows")));
-
-        // Check tuple descriptor for edges (expect: id, source, target, cost)
-        TupleDesc edges_tupdesc = SPI_tuptable->tupdesc;
-        if (edges_tupdesc->natts < 4)
-            ereport(ERROR,
-                    (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
-                     errmsg("edges query must return at least 4 columns: id, source, target, cost")));
-
-        // Process edges
-        num_edges = SPI_processed;
-        if (num_edges > max_edges) {
-            max_edges = num_edges;
-            edge_ids = (text **) repalloc(edge_ids, max_edges * sizeof(text *));
-            edge_sources = (int *) repalloc(edge_sources, max_edges * sizeof(int));
-            edge_targets = (int *) repalloc(edge_targets, max_edges * sizeof(int));
-            edge_costs = (double *) repalloc(edge_costs, max_edges * sizeof(double));
-        }
-
-        for (unsigned long i = 0; i < SPI_processed; i++) {
-            HeapTuple tuple = SPI_tuptable->vals[i];
-            bool isnull;
-            Datum edge_id_datum = SPI_getbinval(tuple, edges_tupdesc, 1, &isnull);
-            Datum source_datum = SPI_getbinval(tuple, edges_tupdesc, 2, &isnull);
-            Datum target_datum = SPI_getbinval(tuple, edges_tupdesc, 3, &isnull);
-            Datum cost_datum = SPI_getbinval(tuple, edges_tupdesc, 4, &isnull);
-
-            if (isnull)
-                ereport(ERROR,
-                        (errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED),
-                         errmsg("edges query cannot return NULL values")));
-
-            // Convert IDs to text (handles both integer and text input)
-            Oid edge_id_type = SPI_gettypeid(edges_tupdesc, 1);
-            Oid source_id_type = SPI_gettypeid(edges_tupdesc, 2);
-            Oid target_id_type = SPI_gettypeid(edges_tupdesc, 3);
-
-            // Convert IDs to text - datum_to_text already makes a copy in current memory context
-            text *edge_id_text = datum_to_text(edge_id_datum, edge_id_type);
-            text *source_id_text = datum_to_text(source_datum, source_id_type);
-            text *target_id_text = datum_to_text(target_datum, target_id_type);
-
-            double cost = DatumGetFloat8(cost_datum);
-
-            // Store the edge_id_text directly - it's already a copy in the current memory context
-            // No need for another memcpy since datum_to_text already handles the copy
-            edge_ids[i] = edge_id_text;
-
-            // Verify the stored text is valid
-            if (edge_ids[i] == NULL || VARSIZE(edge_ids[i]) < VARHDRSZ) {
-                char *edge_id_str = edge_id_text ? text_to_cstring(edge_id_text) : NULL;
-                ereport(ERROR,
-                        (errcode(ERRCODE_INTERNAL_ERROR),
-                         errmsg("Invalid edge_id: '%s', len=%d",
-                                edge_id_str ? edge_id_str : "NULL",
-                                edge_ids[i] ? VARSIZE(edge_ids[i]) : 0)));
-                if (edge_id_str) pfree(edge_id_str);
-            }
-
-            // Debug: verify edge ID storage
-            if (verbosity > 1) {
-                char *edge_id_str = text_to_cstring(edge_ids[i]);
-                elog(INFO, "pgr_pcst_fast: Stored edge[%lu] id: '%s', ptr=%p, len=%d",
-                     (unsigned long) i, edge_id_str, (void *) edge_ids[i], VARSIZE(edge_ids[i]));
-                pfree(edge_id_str);
-            }
-
-            edge_sources[i] = get_node_index(node_map, &next_node_index, source_id_text, &index_to_node_id, verbosity);
-            edge_targets[i] = get_node_index(node_map, &next_node_index, target_id_text, &index_to_node_id, verbosity);
-            edge_costs[i] = cost;
-        }
-
-        num_nodes = next_node_index;
-
-        // Allocate node prizes array (zero-initialized)
-        // All nodes that appear in edges will have prize 0 by default
-        node_prizes = (double *) palloc0(num_nodes * sizeof(double));
-
-        // Execute nodes query
-        nodes_sql_str = text_to_cstring(nodes_sql);
-        ret = SPI_execute(nodes_sql_str, true, 0);
-        if (ret != SPI_OK_SELECT)
-            ereport(ERROR,
-                    (errcode(ERRCODE_INTERNAL_ERROR),
-                     errmsg("nodes query failed: %s", SPI_result_code_string(ret))));
-
-        if (SPI_tuptable != NULL && SPI_processed > 0) {
-            TupleDesc nodes_tupdesc = SPI_tuptable->tupdesc;
-            if (nodes_tupdesc->natts < 2)
-                ereport(ERROR,
-                        (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
-                         errmsg("nodes query must return at least 2 columns: id, prize")));
-
-            // Process nodes and set prizes
-            // Note: nodes that appear in edges but not in nodes query will have prize 0
-            Oid node_id_type = SPI_gettypeid(nodes_tupdesc, 1);
-
-            if (verbosity > 0) {
-                elog(INFO, "pgr_pcst_fast: Processing %lu nodes from nodes query", SPI_processed);
-            }
-
-            int nodes_matched = 0;
-            int nodes_not_found = 0;
-
-            for (unsigned long i = 0; i < SPI_processed; i++) {
-                HeapTuple tuple = SPI_tuptable->vals[i];
-                bool isnull;
-                Datum node_id_datum = SPI_getbinval(tuple, nodes_tupdesc, 1, &isnull);
-                Datum prize_datum = SPI_getbinval(tuple, nodes_tupdesc, 2, &isnull);
-
-                if (isnull)
-                    continue;  // Skip NULL values
-
-                text *node_id_text = datum_to_text(node_id_datum, node_id_type);
-                double prize = DatumGetFloat8(prize_datum);
-
-                // Debug: log the node ID we're looking for (first few only)
-                if (verbosity > 0 && i < 5) {
-                    char *node_id_str = text_to_cstring(node_id_text);
-                    elog(INFO, "pgr_pcst_fast: Looking up node_id='%s' (len=%d, prize=%.2f)",
-                         node_id_str, VARSIZE(node_id_text) - VARHDRSZ, prize);
-                    pfree(node_id_str);
-                }
-
-                // Find node index using hash table
-                // Try hash_search first, but if it fails, fall back to manual iteration
-                bool found = false;
-                node_map_entry *entry = NULL;
-                bool hash_seq_initialized = false;
-                HASH_SEQ_STATUS hash_seq;
-
-                // Initialize hash_seq to avoid uninitialized variable issues
-                MemSet(&hash_seq, 0, sizeof(HASH_SEQ_STATUS));
-
-                // First try: use hash_search with the text pointer
-                text *node_id_key = node_id_text;
-                entry = (node_map_entry *) hash_search(node_map, &node_id_key, HASH_FIND, &found);
-
-                // Fallback: if hash_search fails, manually iterate through hash table
-                // This is slower but more reliable if there's a hash function issue
-                // Use PG_TRY/PG_CATCH to ensure we always terminate the sequence scan
-                if (!found || entry == NULL) {
-                    PG_TRY();
-                    {
-                        node_map_entry *hentry;
-                        bool broke_early = false;
-
-                        hash_seq_init(&hash_seq, node_map);
-                        hash_seq_initialized = true;
-                        while ((hentry = (node_map_entry *) hash_seq_search(&hash_seq)) != NULL) {
-                            if (hentry->node_id != NULL && text_cmp(hentry->node_id, node_id_text) == 0) {
-                                entry = hentry;
-                                found = true;
-                                broke_early = true;
-                                break;
-                            }
-                        }
-                        // Only terminate if we broke early - if loop completed normally (returned NULL),
-                        // the scan is already terminated by PostgreSQL
-                        if (hash_seq_initialized && broke_early) {
-                            hash_seq_term(&hash_seq);
-                            hash_seq_initialized = false;
-                        } else if (hash_seq_initialized) {
-                            // Loop completed normally, scan already terminated, just reset flag
-                            hash_seq_initialized = false;
-                        }
-                    }
-                    PG_CATCH();
-                    {
-                        // Always terminate hash sequence scan if we initialized it, even on error
-                        if (hash_seq_initialized) {
-                            hash_seq_term(&hash_seq);
-                            hash_seq_initialized = false;
-                        }
-                        PG_RE_THROW();
-                    }
-                    PG_END_TRY();
-                }
-
-                // Debug: log lookup result (first few only)
-                if (verbosity > 0 && i < 5) {
-                    char *node_id_str = text_to_cstring(node_id_text);
-                    if (found && entry) {
-                        char *stored_id_str = text_to_cstring(entry->node_id);
-                        elog(INFO, "pgr_pcst_fast: Hash lookup FOUND: looking_for='%s', stored='%s', index=%d",
-                             node_id_str, stored_id_str, entry->index);
-                        pfree(stored_id_str);
-                    } else {
-                        elog(INFO, "pgr_pcst_fast: Hash lookup NOT FOUND: node_id='%s'", node_id_str);
-                    }
-                    pfree(node_id_str);
-                }
-
-                if (found && entry != NULL) {
-                    int node_index = entry->index;
-                    if (node_index >= 0 && node_index < num_nodes) {
-                        node_prizes[node_index] = prize;
-                        nodes_matched++;
-                        if (verbosity > 0 && i < 10) {  // Only log first 10 for large datasets
-                            char *node_id_str = text_to_cstring(node_id_text);
-                            elog(INFO, "pgr_pcst_fast: Setting prize for node_id=%s (index=%d) to %.2f",
-                                 node_id_str, node_index, prize);
-                            pfree(node_id_str);
-                        }
-                    } else {
-                        if (verbosity > 0) {
-                            char *node_id_str = text_to_cstring(node_id_text);
-                            elog(WARNING, "pgr_pcst_fast: node_id=%s mapped to invalid index %d (num_nodes=%d)",
-                                 node_id_str, node_index, num_nodes);
-                            pfree(node_id_str);
-                        }
-                    }
-                } else {
-                    // Node in nodes query but not in edges
-                    nodes_not_found++;
-                    char *node_id_str = text_to_cstring(node_id_text);
-
-                    // Collect missing node IDs for error reporting
-                    // Store up to 10 missing node IDs to avoid excessive memory usage
-                    if (nodes_not_found <= 10) {
-                        // We'll report these at the end
-                        if (verbosity > 0) {
-                            elog(WARNING, "pgr_pcst_fast: Prize node '%s' (prize=%.2f) not found in edges query - will be skipped",
-                                 node_id_str, prize);
-                        }
-                    } else if (nodes_not_found == 11) {
-                        if (verbosity > 0) {
-                            elog(WARNING, "pgr_pcst_fast: Additional prize nodes not found in edges (suppressing further warnings)");
-                        }
-                    }
-                    pfree(node_id_str);
-                }
-
-                // Free the temporary node_id_text (it was created by datum_to_text)
-                pfree(node_id_text);
-            }
-
-            // Summary of node matching (only if verbosity > 0)
-            if (verbosity > 0) {
-                elog(INFO, "pgr_pcst_fast: Nodes query summary: %lu rows processed, %d matched, %d not found in edges",
-                     SPI_processed, nodes_matched, nodes_not_found);
-                if (nodes_not_found > 0) {
-                    elog(WARNING, "pgr_pcst_fast: %d prize node(s) from nodes query were not found in edges query and will be ignored",
-                         nodes_not_found);
-                }
-            }
-
-            // Debug: Log node prizes with better visibility
-            if (verbosity > 0) {
-                elog(INFO, "pgr_pcst_fast: Total nodes processed: %d", num_nodes);
-
-                // Count nodes with prizes > 0
-                int nodes_with_prizes = 0;
-                double total_prize_sum = 0.0;
-                double max_prize = 0.0;
-                int max_prize_index = -1;
-
-                for (int i = 0; i < num_nodes; i++) {
-                    if (node_prizes[i] > 0.0) {
-                        nodes_with_prizes++;
-                        total_prize_sum += node_prizes[i];
-                        if (node_prizes[i] > max_prize) {
-                            max_prize = node_prizes[i];
-                            max_prize_index = i;
-                        }
-                    }
-                }
-
-                elog(INFO, "pgr_pcst_fast: Prize statistics: %d nodes with prizes > 0, total prize sum=%.2f, max prize=%.2f",
-                     nodes_with_prizes, total_prize_sum, max_prize);
-
-                // Show first 10 nodes (always)
-                elog(INFO, "pgr_pcst_fast: First 10 nodes:");
-                for (int i = 0; i < num_nodes && i < 10; i++) {
-                    char *node_id_str = text_to_cstring(index_to_node_id[i]);
-                    elog(INFO, "pgr_pcst_fast:   node[%d] (id=%s) prize=%.2f",
-                         i, node_id_str, node_prizes[i]);
-                    pfree(node_id_str);
-                }
-
-                // Show nodes with prizes > 0 (up to 20)
-                if (nodes_with_prizes > 0) {
-                    elog(INFO, "pgr_pcst_fast: Nodes with prizes > 0 (showing up to 20):");
-                    int shown = 0;
-                    for (int i = 0; i < num_nodes && shown < 20; i++) {
-                        if (node_prizes[i] > 0.0) {
-                            char *node_id_str = text_to_cstring(index_to_node_id[i]);
-                            elog(INFO, "pgr_pcst_fast:   node[%d] (id=%s) prize=%.2f",
-                                 i, node_id_str, node_prizes[i]);
-                            pfree(node_id_str);
-                            shown++;
-                        }
-                    }
-                    if (nodes_with_prizes > 20) {
-                        elog(INFO, "pgr_pcst_fast:   ... and %d more nodes with prizes > 0", nodes_with_prizes - 20);
-                    }
-                } else {
-                    elog(WARNING, "pgr_pcst_fast: WARNING - No nodes have prizes > 0! All prizes are 0.00");
-                }
-
-                // Show the node with maximum prize
-                if (max_prize_index >= 0) {
-                    char *max_prize_id_str = text_to_cstring(index_to_node_id[max_prize_index]);
-                    elog(INFO, "pgr_pcst_fast: Node with maximum prize: node[%d] (id=%s) prize=%.2f",
-                         max_prize_index, max_prize_id_str, max_prize);
-                    pfree(max_prize_id_str);
-                }
-            }
-        } else {
-            // No nodes query results - all prizes remain 0
-            if (verbosity > 0) {
-                elog(WARNING, "pgr_pcst_fast: nodes query returned no results, all node prizes are 0");
-            }
-        }
-
-        // Map root node ID to index
-        // Handle special case: -1 or '-1' means auto-select (no root)
-        if (root_id != NULL) {
-            char *root_id_str = text_to_cstring(root_id);
-            // Check if root_id is -1 or '-1' (auto-select)
-            if (strcmp(root_id_str, "-1") == 0) {
-                pfree(root_id_str);
-                root_index = -1;  // Auto-select
-            } else {
-                bool found = false;
-                node_map_entry *entry = NULL;
-                bool hash_seq_initialized = false;
-                HASH_SEQ_STATUS hash_seq;
-
-                // Initialize hash_seq to avoid uninitialized variable issues
-                MemSet(&hash_seq, 0, sizeof(HASH_SEQ_STATUS));
-
-                // First try: use hash_search with the text pointer
-                text *root_id_key = root_id;
-                entry = (node_map_entry *) hash_search(node_map, &root_id_key, HASH_FIND, &found);
-
-                // Fallback: if hash_search fails, manually iterate through hash table
-                // This is slower but more reliable if there's a hash function issue
-                // Use PG_TRY/PG_CATCH to ensure we always terminate the sequence scan
-                if (!found || entry == NULL) {
-                    PG_TRY();
-                    {
-                        node_map_entry *hentry;
-                        bool broke_early = false;
-
-                        hash_seq_init(&hash_seq, node_map);
-                        hash_seq_initialized = true;
-                        while ((hentry = (node_map_entry *) hash_seq_search(&hash_seq)) != NULL) {
-                            if (hentry->node_id != NULL && text_cmp(hentry->node_id, root_id) == 0) {
-                                entry = hentry;
-                                found = true;
-                                broke_early = true;
-                                break;
-                            }
-                        }
-                        // Only terminate if we broke early - if loop completed normally (returned NULL),
-                        // the scan is already terminated by PostgreSQL
-                        if (hash_seq_initialized && broke_early) {
-                            hash_seq_term(&hash_seq);
-                            hash_seq_initialized = false;
-                        } else if (hash_seq_initialized) {
-                            // Loop completed normally, scan already terminated, just reset flag
-                            hash_seq_initialized = false;
-                        }
-                    }
-                    PG_CATCH();
-                    {
-                        // Always terminate hash sequence scan if we initialized it, even on error
-                        if (hash_seq_initialized) {
-                            hash_seq_term(&hash_seq);
-                            hash_seq_initialized = false;
-                        }
-                        PG_RE_THROW();
-                    }
-                    PG_END_TRY();
-                }
-
-                if (!found || entry == NULL) {
-                    ereport(ERROR,
-                            (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
-                             errmsg("root node ID '%s' not found in edges", root_id_str)));
-                }
-                root_index = entry->index;
-
-                // Validate root_index is in valid range (should always be true if node is in hash table)
-                if (root_index < 0 || root_index >= num_nodes) {
-                    ereport(ERROR,
-                            (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
-                             errmsg("root node ID '%s' maps to invalid index %d (valid range: 0-%d)",
-                                    root_id_str, root_index, num_nodes - 1)));
-                }
-
-                // Log root node mapping for debugging (only if verbosity > 0)
-                if (verbosity > 0) {
-                    elog(INFO, "pgr_pcst_fast: Root node ID '%s' mapped to index %d (num_nodes=%d)",
-                         root_id_str, root_index, num_nodes);
-                }
-
-                pfree(root_id_str);
-            }
-        }
-
         // Convert pruning string to enum
-        if (pruning_text == NULL) {
-            pruning_str = "simple";  // Default
-        } else {
-            pruning_str = text_to_cstring(pruning_text);
-        }
-        if (strcmp(pruning_str, "none") == 0)
-            pruning_method = 0;
-        else if (strcmp(pruning_str, "simple") == 0)
-            pruning_method = 1;
-        else if (strcmp(pruning_str, "gw") == 0)
-            pruning_method = 2;
-        else if (strcmp(pruning_str, "strong") == 0)
-            pruning_method = 3;
+        pruning_method = pcst_parse_pruning(pruning_text);
+
+        pcst_options_t options;
+        pcst_slow_log slow_log;
+        init_solve_options(&options);
+        slow_log_begin(&slow_log, &options);
+
+        // Load edges and node prizes, mapping original IDs to internal indices
+        pcst_builder_handle *builder;
+        pcst_perf_begin(options.perf, PCST_PHASE_LOAD);
+        if (prize_arrays)
+            builder = load_graph_for_solve(&graph, text_to_cstring(edges_sql), NULL,
+                                           PG_ARGISNULL(1) ? NULL : PG_GETARG_ARRAYTYPE_P(1),
+                                           PG_ARGISNULL(2) ? NULL : PG_GETARG_ARRAYTYPE_P(2),
+                                           pruning_method, verbosity);
         else
-            pruning_method = 1; // default to simple
+            builder = load_graph_for_solve(&graph, text_to_cstring(edges_sql),
+                                           text_to_cstring(PG_GETARG_TEXT_P(1)), NULL, NULL,
+                                           pruning_method, verbosity);
+        pcst_perf_end(options.perf);
+
+        int num_edges = graph.num_edges;
+        int num_nodes = graph.num_nodes;
+        int *edge_sources = graph.edge_sources;  // Internal indices
+        int *edge_targets = graph.edge_targets;  // Internal indices
+        double *edge_costs = graph.edge_costs;
+        double *node_prizes = graph.node_prizes;
+
+        // Map root node ID to index
+        root_index = pcst_resolve_root(&graph, root_id, verbosity);
 
         // Debug: Verify node prizes and edges
         if (verbosity > 0) {
@@ -782,7 +705,7 @@ Datum pcst_fast_pgr(PG_FUNCTION_ARGS) {
             // Show first 10 nodes
             elog(INFO, "pgr_pcst_fast: First 10 nodes:");
             for (int i = 0; i < num_nodes && i < 10; i++) {
-                char *node_id_str = text_to_cstring(index_to_node_id[i]);
+                char *node_id_str = text_to_cstring(pcst_node_id_text(&graph, i));
                 elog(INFO, "  node[%d] (id=%s) prize=%.2f",
                      i, node_id_str, node_prizes[i]);
                 pfree(node_id_str);
@@ -804,9 +727,9 @@ Datum pcst_fast_pgr(PG_FUNCTION_ARGS) {
             // Show first 10 edges (with internal indices)
             elog(INFO, "pgr_pcst_fast: First 10 edges (showing internal indices):");
             for (int i = 0; i < num_edges && i < 10; i++) {
-                char *edge_id_str = text_to_cstring(edge_ids[i]);
-                char *source_id_str = text_to_cstring(index_to_node_id[edge_sources[i]]);
-                char *target_id_str = text_to_cstring(index_to_node_id[edge_targets[i]]);
+                char *edge_id_str = text_to_cstring(pcst_edge_id_text(&graph, i));
+                char *source_id_str = text_to_cstring(pcst_node_id_text(&graph, edge_sources[i]));
+                char *target_id_str = text_to_cstring(pcst_node_id_text(&graph, edge_targets[i]));
                 elog(INFO, "  edge[%d] (id=%s): %s[%d]->%s[%d] cost=%.2f",
                      i, edge_id_str, source_id_str, edge_sources[i], target_id_str, edge_targets[i], edge_costs[i]);
                 pfree(edge_id_str);
@@ -819,9 +742,9 @@ Datum pcst_fast_pgr(PG_FUNCTION_ARGS) {
                 elog(INFO, "pgr_pcst_fast: Last 5 edges:");
                 int start = (num_edges > 5) ? num_edges - 5 : 10;
                 for (int i = start; i < num_edges; i++) {
-                    char *edge_id_str = text_to_cstring(edge_ids[i]);
-                    char *source_id_str = text_to_cstring(index_to_node_id[edge_sources[i]]);
-                    char *target_id_str = text_to_cstring(index_to_node_id[edge_targets[i]]);
+                    char *edge_id_str = text_to_cstring(pcst_edge_id_text(&graph, i));
+                    char *source_id_str = text_to_cstring(pcst_node_id_text(&graph, edge_sources[i]));
+                    char *target_id_str = text_to_cstring(pcst_node_id_text(&graph, edge_targets[i]));
                     elog(INFO, "  edge[%d] (id=%s): %s->%s cost=%.2f",
                          i, edge_id_str, source_id_str, target_id_str, edge_costs[i]);
                     pfree(edge_id_str);
@@ -839,10 +762,6 @@ Datum pcst_fast_pgr(PG_FUNCTION_ARGS) {
         MemoryContextSwitchTo(ec_oldctx);
         memcpy(edge_costs_original, edge_costs, num_edges * sizeof(double));
 
-        // Make a copy of edge_costs for the algorithm to modify
-        double *edge_costs_copy = (double *) palloc(num_edges * sizeof(double));
-        memcpy(edge_costs_copy, edge_costs, num_edges * sizeof(double));
-
         // When root is specified, algorithm requires num_clusters to be 0
         // (see pcst_fast.cc line 304: "target_num_active_clusters must be 0 in the rooted case")
         int effective_num_clusters = (root_index >= 0) ? 0 : num_clusters;
@@ -872,16 +791,12 @@ Datum pcst_fast_pgr(PG_FUNCTION_ARGS) {
             }
         }
 
-        // Call the C function (may modify the costs array)
-        pcst_result_t *result = pcst_solve(
-            edge_sources, edge_targets, edge_costs_copy, num_edges,
-            node_prizes, num_nodes,
-            root_index, effective_num_clusters, pruning_method, verbosity
+        // Call the C function
+        pcst_result_t *result = solve_graph_within_budget(
+            &graph, builder, root_index, effective_num_clusters, pruning_method, verbosity,
+            &options
         );
 
-        // Free the copy after algorithm completes
-        pfree(edge_costs_copy);
-
         // Debug: Log algorithm result
         if (verbosity > 0 && result) {
             elog(INFO, "pgr_pcst_fast: Algorithm returned: success=%d, num_nodes=%d, num_edges=%d",
@@ -903,57 +818,44 @@ Datum pcst_fast_pgr(PG_FUNCTION_ARGS) {
             ereport(ERROR, (errcode(ERRCODE_EXTERNAL_ROUTINE_EXCEPTION),
                            errmsg("PCST algorithm failed: %s", error_msg)));
         }
+        slow_log_end(&slow_log, "pgr_pcst_fast", root_id, num_nodes, num_edges, num_clusters,
+                     pruning_method, &options, result);
 
         // Store original edge source/target IDs for result rows
         // Map internal indices back to original node IDs (text)
         /* Ensure all long-lived data is copied into the multi-call context */
         MemoryContext data_mctx_prev = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
 
-        text **node_id_copies = (text **) palloc(num_nodes * sizeof(text *));
-        for (int i = 0; i < num_nodes; i++) {
-            if (index_to_node_id[i] != NULL && VARSIZE(index_to_node_id[i]) >= VARHDRSZ) {
-                int len = VARSIZE(index_to_node_id[i]);
-                node_id_copies[i] = (text *) palloc(len);
-                memcpy(node_id_copies[i], index_to_node_id[i], len);
-            } else {
-                node_id_copies[i] = NULL;
-            }
-        }
-
-        text **original_edge_sources = (text **) palloc(num_edges * sizeof(text *));
-        text **original_edge_targets = (text **) palloc(num_edges * sizeof(text *));
+        // Only nodes of selected edges are turned back into text; node IDs may
+        // be interned as binary keys, so this is where they get formatted
+        text **node_id_copies = (text **) palloc0(num_nodes * sizeof(text *));
+        text **original_edge_sources = (text **) palloc0(num_edges * sizeof(text *));
+        text **original_edge_targets = (text **) palloc0(num_edges * sizeof(text *));
 
-        for (int i = 0; i < num_edges; i++) {
+        for (int r = 0; r < result->num_edges; r++) {
+            int i = result->result_edges[r];
+            if (i < 0 || i >= num_edges)
+                continue;
             if (edge_sources[i] >= 0 && edge_sources[i] < num_nodes) {
+                if (node_id_copies[edge_sources[i]] == NULL)
+                    node_id_copies[edge_sources[i]] = pcst_node_id_text(&graph, edge_sources[i]);
                 original_edge_sources[i] = node_id_copies[edge_sources[i]];
-            } else {
-                original_edge_sources[i] = NULL;
             }
             if (edge_targets[i] >= 0 && edge_targets[i] < num_nodes) {
+                if (node_id_copies[edge_targets[i]] == NULL)
+                    node_id_copies[edge_targets[i]] = pcst_node_id_text(&graph, edge_targets[i]);
                 original_edge_targets[i] = node_id_copies[edge_targets[i]];
-            } else {
-                original_edge_targets[i] = NULL;
             }
         }
 
         // Store result with mappings
-        // Make a deep copy of edge_ids array to ensure pointers are stable
-        text **edge_ids_copy = (text **) palloc(num_edges * sizeof(text *));
-        for (int i = 0; i < num_edges; i++) {
-            if (edge_ids[i] != NULL && VARSIZE(edge_ids[i]) >= VARHDRSZ) {
-                // Make a deep copy of each text object
-                int len = VARSIZE(edge_ids[i]);
-                edge_ids_copy[i] = (text *) palloc(len);
-                memcpy(edge_ids_copy[i], edge_ids[i], len);
-                // Verify the copy
-                if (VARSIZE(edge_ids_copy[i]) != len) {
-                    ereport(ERROR,
-                            (errcode(ERRCODE_INTERNAL_ERROR),
-                             errmsg("Failed to copy edge_id[%d]", i)));
-                }
-            } else {
-                edge_ids_copy[i] = NULL;
-            }
+        // Edge IDs are likewise materialized for the selected edges only,
+        // while the loader's compact IDs / retained rows are still valid
+        text **edge_ids_copy = (text **) palloc0(num_edges * sizeof(text *));
+        for (int r = 0; r < result->num_edges; r++) {
+            int i = result->result_edges[r];
+            if (i >= 0 && i < num_edges && edge_ids_copy[i] == NULL)
+                edge_ids_copy[i] = pcst_edge_id_text(&graph, i);
         }
 
         pgr_data = (pgr_result_data *) palloc(sizeof(pgr_result_data));
@@ -977,8 +879,10 @@ Datum pcst_fast_pgr(PG_FUNCTION_ARGS) {
             if (num_edges > 10) {
                 elog(INFO, "  ... and %d more edges", num_edges - 10);
             }
-            elog(INFO, "pgr_pcst_fast: Storing edge_ids_copy array (num_edges=%d, showing first 10):", num_edges);
-            for (int i = 0; i < num_edges && i < 10; i++) {
+            elog(INFO, "pgr_pcst_fast: Storing edge_ids_copy array (%d selected of num_edges=%d, showing first 10):",
+                 result->num_edges, num_edges);
+            for (int r = 0; r < result->num_edges && r < 10; r++) {
+                int i = result->result_edges[r];
                 if (edge_ids_copy[i] != NULL) {
                     char *edge_id_str = text_to_cstring(edge_ids_copy[i]);
                     elog(INFO, "  edge_ids_copy[%d] = '%s', ptr=%p, size=%d",
@@ -988,8 +892,8 @@ Datum pcst_fast_pgr(PG_FUNCTION_ARGS) {
                     elog(INFO, "  edge_ids_copy[%d] = NULL", i);
                 }
             }
-            if (num_edges > 10) {
-                elog(INFO, "  ... and %d more edge IDs", num_edges - 10);
+            if (result->num_edges > 10) {
+                elog(INFO, "  ... and %d more edge IDs", result->num_edges - 10);
             }
             elog(INFO, "pgr_pcst_fast: Result contains %d edges:", result->num_edges);
             for (int i = 0; i < result->num_edges && i < 10; i++) {
@@ -1157,4 +1061,1401 @@ Datum pcst_fast_pgr(PG_FUNCTION_ARGS) {
 
         SRF_RETURN_DONE(funcctx);
     }
-}
\ No newline at end of file
+}
+
+/* pgr_pcst_fast with nodes_sql */
+Datum pcst_fast_pgr(PG_FUNCTION_ARGS) {
+    return pgr_pcst_fast_rows(fcinfo, false);
+}
+
+/* pgr_pcst_fast with node_ids and prizes arrays instead of nodes_sql */
+Datum pcst_fast_pgr_arrays(PG_FUNCTION_ARGS) {
+    return pgr_pcst_fast_rows(fcinfo, true);
+}
+
+/* Append one statistic, allocating in the rows' own (multi-call) context */
+static void add_stat(pcst_stat_rows *rows, const char *name, double value) {
+    MemoryContext prev = MemoryContextSwitchTo(rows->mcxt);
+    if (rows->num_stats == rows->max_stats) {
+        rows->max_stats *= 2;
+        rows->names = (char **) repalloc(rows->names, rows->max_stats * sizeof(char *));
+        rows->values = (double *) repalloc(rows->values, rows->max_stats * sizeof(double));
+    }
+    rows->names[rows->num_stats] = pstrdup(name);
+    rows->values[rows->num_stats] = value;
+    rows->num_stats++;
+    MemoryContextSwitchTo(prev);
+}
+
+static void add_perf_stats(pcst_stat_rows *rows, const pcst_perf_session_t *perf) {
+    char name[NAMEDATALEN * 2];
+
+    add_stat(rows, "perf.num_available_counters", perf->num_available_counters);
+    for (int p = 0; p < PCST_NUM_PHASES; p++) {
+        const pcst_phase_sample_t *sample = &perf->phases[p];
+        const char *phase = pcst_perf_phase_name((pcst_phase_t) p);
+
+        if (sample->num_samples == 0)
+            continue;
+        snprintf(name, sizeof(name), "perf.%s.wall_seconds", phase);
+        add_stat(rows, name, sample->wall_seconds);
+        for (int c = 0; c < PCST_NUM_COUNTERS; c++) {
+            if (!pcst_perf_counter_available(perf, (pcst_counter_t) c))
+                continue;
+            snprintf(name, sizeof(name), "perf.%s.%s", phase,
+                     pcst_perf_counter_name((pcst_counter_t) c));
+            add_stat(rows, name, (double) sample->counters[c]);
+        }
+    }
+}
+
+static void add_memory_stat(pcst_stat_rows *rows, const char *structure,
+                            Size current_bytes, Size peak_bytes) {
+    char name[NAMEDATALEN * 2];
+    snprintf(name, sizeof(name), "memory.%s.current_bytes", structure);
+    add_stat(rows, name, (double) current_bytes);
+    snprintf(name, sizeof(name), "memory.%s.peak_bytes", structure);
+    add_stat(rows, name, (double) peak_bytes);
+}
+
+/*
+ * Solve like pgr_pcst_fast, but return solver statistics instead of edges:
+ * event counters, current/peak bytes of every major loader and solver
+ * structure, and per-phase wall time (plus hardware counters when
+ * pcst_fast.perf_counters is on).
+ */
+Datum pcst_fast_pgr_stats(PG_FUNCTION_ARGS) {
+    FuncCallContext *funcctx;
+    TupleDesc tupdesc;
+
+    if (SRF_IS_FIRSTCALL()) {
+        text *edges_sql = PG_GETARG_TEXT_P(0);
+        text *nodes_sql = PG_GETARG_TEXT_P(1);
+        text *root_id = PG_ARGISNULL(2) ? NULL : PG_GETARG_TEXT_P(2);
+        int num_clusters = PG_ARGISNULL(3) ? 1 : PG_GETARG_INT32(3);
+        text *pruning_text = PG_ARGISNULL(4) ? NULL : PG_GETARG_TEXT_P(4);
+        MemoryContext oldcontext;
+        pcst_stat_rows *rows;
+        pcst_graph graph;
+        pcst_perf_session_t perf;
+        pcst_options_t options;
+        int ret;
+
+        funcctx = SRF_FIRSTCALL_INIT();
+        oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+        if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+            ereport(ERROR,
+                    (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                     errmsg("function returning record called in context "
+                            "that cannot accept a set")));
+        funcctx->tuple_desc = BlessTupleDesc(tupdesc);
+
+        rows = (pcst_stat_rows *) palloc(sizeof(pcst_stat_rows));
+        rows->max_stats = 64;
+        rows->num_stats = 0;
+        rows->names = (char **) palloc(rows->max_stats * sizeof(char *));
+        rows->values = (double *) palloc(rows->max_stats * sizeof(double));
+        rows->mcxt = funcctx->multi_call_memory_ctx;
+
+        if ((ret = SPI_connect()) != SPI_OK_CONNECT)
+            ereport(ERROR,
+                    (errcode(ERRCODE_INTERNAL_ERROR),
+                     errmsg("SPI_connect failed: %d", ret)));
+
+        /* Counter file descriptors must not leak if loading errors out */
+        int root_index = -1;
+        int pruning_method = pcst_parse_pruning(pruning_text);
+        pcst_builder_handle *volatile builder = NULL;
+        pcst_slow_log slow_log;
+        pcst_perf_open(&perf, pcst_perf_counters);
+        init_solve_options(&options);
+        options.perf = &perf;
+        slow_log_begin(&slow_log, &options);
+        PG_TRY();
+        {
+            pcst_perf_begin(&perf, PCST_PHASE_LOAD);
+            builder = load_graph_for_solve(&graph, text_to_cstring(edges_sql),
+                                           text_to_cstring(nodes_sql), NULL, NULL,
+                                           pruning_method, 0);
+            pcst_perf_end(&perf);
+            root_index = pcst_resolve_root(&graph, root_id, 0);
+        }
+        PG_CATCH();
+        {
+            pcst_perf_close(&perf);
+            PG_RE_THROW();
+        }
+        PG_END_TRY();
+
+        int effective_num_clusters = (root_index >= 0) ? 0 : num_clusters;
+
+        pcst_result_t *result = solve_graph_within_budget(
+            &graph, builder, root_index, effective_num_clusters, pruning_method, 0, &options
+        );
+        pcst_perf_close(&perf);
+
+        if (!result || !result->success) {
+            char error_msg[256];
+            strlcpy(error_msg, result ? result->error_message : "Unknown error", sizeof(error_msg));
+            if (result) pcst_free_result(result);
+            SPI_finish();
+            ereport(ERROR, (errcode(ERRCODE_EXTERNAL_ROUTINE_EXCEPTION),
+                           errmsg("PCST algorithm failed: %s", error_msg)));
+        }
+        slow_log_end(&slow_log, "pgr_pcst_fast_stats", root_id, graph.num_nodes, graph.num_edges,
+                     num_clusters, pruning_method, &options, result);
+
+        double objective = 0.0;
+        for (int i = 0; i < result->num_nodes; i++)
+            objective += graph.node_prizes[result->result_nodes[i]];
+        for (int i = 0; i < result->num_edges; i++)
+            objective -= graph.edge_costs[result->result_edges[i]];
+
+        add_stat(rows, "graph.num_nodes", graph.num_nodes);
+        add_stat(rows, "graph.num_edges", graph.num_edges);
+        add_stat(rows, "result.num_nodes", result->num_nodes);
+        add_stat(rows, "result.num_edges", result->num_edges);
+        add_stat(rows, "result.objective", objective);
+        add_stat(rows, "result.optimal", result->stats.optimal);
+        if (result->plan.exact)
+            add_stat(rows, "result.objective_bound", result->stats.objective_bound);
+
+        pcst_stats_t *stats = &result->stats;
+        add_stat(rows, "events.total_num_edge_events", stats->total_num_edge_events);
+        add_stat(rows, "events.num_deleted_edge_events", stats->num_deleted_edge_events);
+        add_stat(rows, "events.num_merged_edge_events", stats->num_merged_edge_events);
+        add_stat(rows, "events.total_num_merge_events", stats->total_num_merge_events);
+        add_stat(rows, "events.num_active_active_merge_events", stats->num_active_active_merge_events);
+        add_stat(rows, "events.num_active_inactive_merge_events", stats->num_active_inactive_merge_events);
+        add_stat(rows, "events.total_num_edge_growth_events", stats->total_num_edge_growth_events);
+        add_stat(rows, "events.num_active_active_edge_growth_events", stats->num_active_active_edge_growth_events);
+        add_stat(rows, "events.num_active_inactive_edge_growth_events", stats->num_active_inactive_edge_growth_events);
+        add_stat(rows, "events.num_cluster_events", stats->num_cluster_events);
+        add_stat(rows, "events.num_uninserted_edges", stats->num_uninserted_edges);
+        add_stat(rows, "events.num_event_buckets", stats->num_event_buckets);
+        add_stat(rows, "growth.final_time", stats->final_growth_time);
+        add_stat(rows, "growth.time_capped", stats->growth_time_capped);
+
+        // Plan the solve ran with; the profile only exists for pruning => 'auto'
+        add_stat(rows, "plan.automatic", result->plan.automatic);
+        add_stat(rows, "plan.pruning_method", result->plan.pruning_method);
+        add_stat(rows, "plan.tree_dp", result->plan.tree_dp);
+        add_stat(rows, "plan.peel_tails", result->plan.peel_tails);
+        add_stat(rows, "plan.num_peeled_nodes", stats->num_peeled_nodes);
+        add_stat(rows, "plan.prize_balls", result->plan.prize_balls);
+        add_stat(rows, "plan.num_distant_nodes", stats->num_distant_nodes);
+        add_stat(rows, "plan.lazy_edges", result->plan.lazy_edges);
+        add_stat(rows, "plan.distance_network", result->plan.distance_network);
+        add_stat(rows, "plan.num_terminals", stats->num_terminals);
+        add_stat(rows, "plan.exact", result->plan.exact);
+        add_stat(rows, "plan.num_exact_components", stats->num_exact_components);
+        add_stat(rows, "plan.num_exact_subproblems", (double) stats->num_exact_subproblems);
+        if (result->plan.automatic) {
+            add_stat(rows, "profile.num_components", result->profile.num_components);
+            add_stat(rows, "profile.cycle_rank", (double) result->profile.cycle_rank);
+            add_stat(rows, "profile.max_degree", result->profile.max_degree);
+            add_stat(rows, "profile.num_leaves", result->profile.num_leaves);
+            add_stat(rows, "profile.mean_degree", result->profile.mean_degree);
+            add_stat(rows, "profile.prize_density", result->profile.prize_density);
+            add_stat(rows, "profile.cost_spread", result->profile.cost_spread);
+        }
+
+        add_perf_stats(rows, &perf);
+
+        for (int i = 0; i < PCST_MEM_NUM_ENTRIES; i++)
+            add_memory_stat(rows, pcst_mem_entry_names[i],
+                            graph.mem.current_bytes[i], graph.mem.peak_bytes[i]);
+        for (int i = 0; i < stats->num_memory_entries; i++)
+            add_memory_stat(rows, stats->memory[i].name,
+                            stats->memory[i].current_bytes, stats->memory[i].peak_bytes);
+
+        pcst_free_result(result);
+        SPI_finish();
+
+        funcctx->user_fctx = rows;
+        funcctx->max_calls = rows->num_stats;
+        MemoryContextSwitchTo(oldcontext);
+    }
+
+    funcctx = SRF_PERCALL_SETUP();
+
+    if (funcctx->call_cntr < funcctx->max_calls) {
+        pcst_stat_rows *rows = (pcst_stat_rows *) funcctx->user_fctx;
+        Datum values[2];
+        bool nulls[2] = {false, false};
+        HeapTuple tuple;
+
+        values[0] = CStringGetTextDatum(rows->names[funcctx->call_cntr]);
+        values[1] = Float8GetDatum(rows->values[funcctx->call_cntr]);
+
+        tuple = heap_form_tuple(funcctx->tuple_desc, values, nulls);
+        SRF_RETURN_NEXT(funcctx, HeapTupleGetDatum(tuple));
+    } else {
+        SRF_RETURN_DONE(funcctx);
+    }
+}
+
+/* Rooted strong-pruning payoff of every node of the pruned forest, from one solve */
+Datum pcst_fast_pgr_root_payoffs(PG_FUNCTION_ARGS) {
+    FuncCallContext *funcctx;
+    TupleDesc tupdesc;
+
+    if (SRF_IS_FIRSTCALL()) {
+        text *edges_sql = PG_GETARG_TEXT_P(0);
+        text *nodes_sql = PG_GETARG_TEXT_P(1);
+        text *root_id = PG_ARGISNULL(2) ? NULL : PG_GETARG_TEXT_P(2);
+        int num_clusters = PG_ARGISNULL(3) ? 1 : PG_GETARG_INT32(3);
+        MemoryContext oldcontext;
+        pcst_payoff_rows *rows;
+        pcst_graph graph;
+        pcst_options_t options;
+        int ret;
+
+        funcctx = SRF_FIRSTCALL_INIT();
+        oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+        if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+            ereport(ERROR,
+                    (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                     errmsg("function returning record called in context "
+                            "that cannot accept a set")));
+        funcctx->tuple_desc = BlessTupleDesc(tupdesc);
+
+        if ((ret = SPI_connect()) != SPI_OK_CONNECT)
+            ereport(ERROR,
+                    (errcode(ERRCODE_INTERNAL_ERROR),
+                     errmsg("SPI_connect failed: %d", ret)));
+
+        pcst_slow_log slow_log;
+        init_solve_options(&options);
+        slow_log_begin(&slow_log, &options);
+        pcst_perf_begin(options.perf, PCST_PHASE_LOAD);
+        pcst_load_graph(&graph, text_to_cstring(edges_sql), text_to_cstring(nodes_sql), 0);
+        pcst_perf_end(options.perf);
+        int root_index = pcst_resolve_root(&graph, root_id, 0);
+        int effective_num_clusters = (root_index >= 0) ? 0 : num_clusters;
+
+        // The payoffs come out of the strong pruning rerooting pass
+        options.rooted_payoffs = 1;
+        pcst_result_t *result = solve_within_budget(
+            graph.edge_sources, graph.edge_targets, graph.edge_costs, graph.num_edges,
+            graph.node_prizes, graph.num_nodes,
+            root_index, effective_num_clusters, 3, 0, &options
+        );
+
+        if (!result || !result->success) {
+            char error_msg[256];
+            strlcpy(error_msg, result ? result->error_message : "Unknown error", sizeof(error_msg));
+            if (result) pcst_free_result(result);
+            SPI_finish();
+            ereport(ERROR, (errcode(ERRCODE_EXTERNAL_ROUTINE_EXCEPTION),
+                           errmsg("PCST algorithm failed: %s", error_msg)));
+        }
+        slow_log_end(&slow_log, "pgr_pcst_fast_root_payoffs", root_id, graph.num_nodes,
+                     graph.num_edges, num_clusters, 3, &options, result);
+
+        // SPI_connect switched to the SPI procedure context; the rows must outlive SPI_finish
+        MemoryContext spicontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+        rows = (pcst_payoff_rows *) palloc(sizeof(pcst_payoff_rows));
+        rows->num_rows = result->num_rooted_payoffs;
+        rows->nodes = (text **) palloc((rows->num_rows + 1) * sizeof(text *));
+        rows->components = (int *) palloc((rows->num_rows + 1) * sizeof(int));
+        rows->payoffs = (double *) palloc((rows->num_rows + 1) * sizeof(double));
+        for (int i = 0; i < rows->num_rows; i++) {
+            rows->nodes[i] = pcst_node_id_text(&graph, result->payoff_nodes[i]);
+            rows->components[i] = result->payoff_components[i];
+            rows->payoffs[i] = result->rooted_payoffs[i];
+        }
+        MemoryContextSwitchTo(spicontext);
+
+        pcst_free_result(result);
+        SPI_finish();
+
+        funcctx->user_fctx = rows;
+        funcctx->max_calls = rows->num_rows;
+        MemoryContextSwitchTo(oldcontext);
+    }
+
+    funcctx = SRF_PERCALL_SETUP();
+
+    if (funcctx->call_cntr < funcctx->max_calls) {
+        pcst_payoff_rows *rows = (pcst_payoff_rows *) funcctx->user_fctx;
+        Datum values[3];
+        bool nulls[3] = {false, false, false};
+        HeapTuple tuple;
+
+        values[0] = PointerGetDatum(rows->nodes[funcctx->call_cntr]);
+        values[1] = Int32GetDatum(rows->components[funcctx->call_cntr]);
+        values[2] = Float8GetDatum(rows->payoffs[funcctx->call_cntr]);
+
+        tuple = heap_form_tuple(funcctx->tuple_desc, values, nulls);
+        SRF_RETURN_NEXT(funcctx, HeapTupleGetDatum(tuple));
+    } else {
+        SRF_RETURN_DONE(funcctx);
+    }
+}
+
+/* Order selected sub-edges by original edge, then along the edge */
+static int edge_piece_cmp(const void *a, const void *b) {
+    const pcst_edge_piece *p1 = (const pcst_edge_piece *) a;
+    const pcst_edge_piece *p2 = (const pcst_edge_piece *) b;
+    if (p1->edge != p2->edge)
+        return (p1->edge < p2->edge) ? -1 : 1;
+    if (p1->start != p2->start)
+        return (p1->start < p2->start) ? -1 : 1;
+    return 0;
+}
+
+/* pgr_pcst_fast with prizes on points along edges (virtual edge splits) */
+Datum pcst_fast_pgr_withpoints(PG_FUNCTION_ARGS) {
+    FuncCallContext *funcctx;
+    TupleDesc tupdesc;
+
+    if (SRF_IS_FIRSTCALL()) {
+        text *edges_sql = PG_GETARG_TEXT_P(0);
+        text *nodes_sql = PG_GETARG_TEXT_P(1);
+        text *points_sql = PG_GETARG_TEXT_P(2);
+        text *root_id = PG_ARGISNULL(3) ? NULL : PG_GETARG_TEXT_P(3);
+        int num_clusters = PG_ARGISNULL(4) ? 1 : PG_GETARG_INT32(4);
+        text *pruning_text = PG_ARGISNULL(5) ? NULL : PG_GETARG_TEXT_P(5);
+        int verbosity = PG_ARGISNULL(6) ? 0 : PG_GETARG_INT32(6);
+        MemoryContext oldcontext;
+        pcst_withpoints_rows *rows;
+        pcst_graph graph;
+        pcst_options_t options;
+        int ret;
+
+        funcctx = SRF_FIRSTCALL_INIT();
+        oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+        if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+            ereport(ERROR,
+                    (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                     errmsg("function returning record called in context "
+                            "that cannot accept a set")));
+        funcctx->tuple_desc = BlessTupleDesc(tupdesc);
+
+        if ((ret = SPI_connect()) != SPI_OK_CONNECT)
+            ereport(ERROR,
+                    (errcode(ERRCODE_INTERNAL_ERROR),
+                     errmsg("SPI_connect failed: %d", ret)));
+
+        pcst_slow_log slow_log;
+        init_solve_options(&options);
+        slow_log_begin(&slow_log, &options);
+        pcst_perf_begin(options.perf, PCST_PHASE_LOAD);
+        pcst_load_graph(&graph, text_to_cstring(edges_sql), text_to_cstring(nodes_sql), verbosity);
+        pcst_load_points(&graph, text_to_cstring(points_sql), verbosity);
+        pcst_perf_end(options.perf);
+        int root_index = pcst_resolve_root(&graph, root_id, verbosity);
+        int pruning_method = pcst_parse_pruning(pruning_text);
+        int effective_num_clusters = (root_index >= 0) ? 0 : num_clusters;
+
+        pcst_result_t *result = solve_within_budget(
+            graph.edge_sources, graph.edge_targets, graph.edge_costs, graph.num_edges,
+            graph.node_prizes, graph.num_nodes,
+            root_index, effective_num_clusters, pruning_method, 0, &options
+        );
+
+        if (!result || !result->success) {
+            char error_msg[256];
+            strlcpy(error_msg, result ? result->error_message : "Unknown error", sizeof(error_msg));
+            if (result) pcst_free_result(result);
+            SPI_finish();
+            ereport(ERROR, (errcode(ERRCODE_EXTERNAL_ROUTINE_EXCEPTION),
+                           errmsg("PCST algorithm failed: %s", error_msg)));
+        }
+        slow_log_end(&slow_log, "pgr_pcst_fast_withpoints", root_id, graph.num_nodes,
+                     graph.num_edges, num_clusters, pruning_method, &options, result);
+
+        // SPI_connect switched to the SPI procedure context; the rows must outlive SPI_finish
+        MemoryContext spicontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+        rows = (pcst_withpoints_rows *) palloc(sizeof(pcst_withpoints_rows));
+        rows->pieces = (pcst_edge_piece *) palloc((result->num_edges + 1) * sizeof(pcst_edge_piece));
+        for (int i = 0; i < result->num_edges; i++) {
+            int e = result->result_edges[i];
+            pcst_edge_piece *piece = &rows->pieces[i];
+            piece->edge = graph.sub_edge_parent ? graph.sub_edge_parent[e] : e;
+            piece->start = graph.sub_edge_parent ? graph.sub_edge_start[e] : 0.0;
+            piece->end = graph.sub_edge_parent ? graph.sub_edge_end[e] : 1.0;
+            piece->cost = graph.edge_costs[e];
+        }
+        qsort(rows->pieces, result->num_edges, sizeof(pcst_edge_piece), edge_piece_cmp);
+
+        // Adjacent selected sub-edges of one original edge form a single row
+        rows->num_rows = 0;
+        for (int i = 0; i < result->num_edges; i++) {
+            pcst_edge_piece *last = rows->num_rows > 0 ? &rows->pieces[rows->num_rows - 1] : NULL;
+            if (last && last->edge == rows->pieces[i].edge && last->end == rows->pieces[i].start) {
+                last->end = rows->pieces[i].end;
+                last->cost += rows->pieces[i].cost;
+            } else {
+                rows->pieces[rows->num_rows++] = rows->pieces[i];
+            }
+        }
+
+        rows->edge_ids = (text **) palloc((rows->num_rows + 1) * sizeof(text *));
+        rows->sources = (text **) palloc((rows->num_rows + 1) * sizeof(text *));
+        rows->targets = (text **) palloc((rows->num_rows + 1) * sizeof(text *));
+        for (int i = 0; i < rows->num_rows; i++) {
+            int e = rows->pieces[i].edge;
+            int target = graph.original_targets ? graph.original_targets[e] : graph.edge_targets[e];
+            rows->edge_ids[i] = pcst_edge_id_text(&graph, e);
+            rows->sources[i] = pcst_node_id_text(&graph, graph.edge_sources[e]);
+            rows->targets[i] = pcst_node_id_text(&graph, target);
+        }
+        MemoryContextSwitchTo(spicontext);
+
+        pcst_free_result(result);
+        SPI_finish();
+
+        funcctx->user_fctx = rows;
+        funcctx->max_calls = rows->num_rows;
+        MemoryContextSwitchTo(oldcontext);
+    }
+
+    funcctx = SRF_PERCALL_SETUP();
+
+    if (funcctx->call_cntr < funcctx->max_calls) {
+        pcst_withpoints_rows *rows = (pcst_withpoints_rows *) funcctx->user_fctx;
+        int i = funcctx->call_cntr;
+        Datum values[7];
+        bool nulls[7] = {false, false, false, false, false, false, false};
+        HeapTuple tuple;
+
+        values[0] = Int32GetDatum(i + 1);
+        values[1] = PointerGetDatum(rows->edge_ids[i]);
+        values[2] = PointerGetDatum(rows->sources[i]);
+        values[3] = PointerGetDatum(rows->targets[i]);
+        values[4] = Float8GetDatum(rows->pieces[i].start);
+        values[5] = Float8GetDatum(rows->pieces[i].end);
+        values[6] = Float8GetDatum(rows->pieces[i].cost);
+        nulls[1] = rows->edge_ids[i] == NULL;
+
+        tuple = heap_form_tuple(funcctx->tuple_desc, values, nulls);
+        SRF_RETURN_NEXT(funcctx, HeapTupleGetDatum(tuple));
+    } else {
+        SRF_RETURN_DONE(funcctx);
+    }
+}
+
+/*
+ * Append the row of one added or removed edge. A node's prize is credited to
+ * the first row that brings it into or drops it out of the selection, so the
+ * objective deltas of all rows sum to the change of the objective (prizes of
+ * the nodes touched by selected edges minus their costs).
+ */
+static void add_delta_row(pcst_delta_rows *rows, pcst_graph *graph, int edge, bool added,
+                          const bool *prev_nodes, const bool *cur_nodes, bool *credited) {
+    pcst_delta_row *row = &rows->rows[rows->num_rows++];
+    int ends[2] = {graph->edge_sources[edge], graph->edge_targets[edge]};
+
+    row->added = added;
+    row->edge_id = pcst_edge_id_text(graph, edge);
+    row->source = pcst_node_id_text(graph, ends[0]);
+    row->target = pcst_node_id_text(graph, ends[1]);
+    row->cost = graph->edge_costs[edge];
+    row->objective_delta = added ? -row->cost : row->cost;
+    row->in_graph = true;
+    for (int i = 0; i < 2; i++) {
+        int v = ends[i];
+        if (credited[v] || prev_nodes[v] == cur_nodes[v])
+            continue;
+        credited[v] = true;
+        row->objective_delta += added ? graph->node_prizes[v] : -graph->node_prizes[v];
+    }
+}
+
+/* pgr_pcst_fast returning only the edges added and removed since a previous result */
+Datum pcst_fast_pgr_delta(PG_FUNCTION_ARGS) {
+    FuncCallContext *funcctx;
+    TupleDesc tupdesc;
+
+    if (SRF_IS_FIRSTCALL()) {
+        text *edges_sql = PG_GETARG_TEXT_P(0);
+        text *nodes_sql = PG_GETARG_TEXT_P(1);
+        ArrayType *previous_edges = PG_ARGISNULL(2) ? NULL : PG_GETARG_ARRAYTYPE_P(2);
+        text *root_id = PG_ARGISNULL(3) ? NULL : PG_GETARG_TEXT_P(3);
+        int num_clusters = PG_ARGISNULL(4) ? 1 : PG_GETARG_INT32(4);
+        text *pruning_text = PG_ARGISNULL(5) ? NULL : PG_GETARG_TEXT_P(5);
+        MemoryContext oldcontext;
+        pcst_delta_rows *rows;
+        pcst_graph graph;
+        pcst_options_t options;
+        text **unmatched = NULL;
+        int num_unmatched = 0;
+        int ret;
+
+        funcctx = SRF_FIRSTCALL_INIT();
+        oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+        if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+            ereport(ERROR,
+                    (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                     errmsg("function returning record called in context "
+                            "that cannot accept a set")));
+        funcctx->tuple_desc = BlessTupleDesc(tupdesc);
+
+        if ((ret = SPI_connect()) != SPI_OK_CONNECT)
+            ereport(ERROR,
+                    (errcode(ERRCODE_INTERNAL_ERROR),
+                     errmsg("SPI_connect failed: %d", ret)));
+
+        pcst_slow_log slow_log;
+        init_solve_options(&options);
+        slow_log_begin(&slow_log, &options);
+        pcst_perf_begin(options.perf, PCST_PHASE_LOAD);
+        pcst_load_graph(&graph, text_to_cstring(edges_sql), text_to_cstring(nodes_sql), 0);
+        pcst_perf_end(options.perf);
+        int root_index = pcst_resolve_root(&graph, root_id, 0);
+        int pruning_method = pcst_parse_pruning(pruning_text);
+        int effective_num_clusters = (root_index >= 0) ? 0 : num_clusters;
+
+        // Selections of the previous and the new result, by internal edge
+        bool *prev_edges = (bool *) palloc0((graph.num_edges + 1) * sizeof(bool));
+        bool *cur_edges = (bool *) palloc0((graph.num_edges + 1) * sizeof(bool));
+        if (previous_edges)
+            pcst_match_edge_ids(&graph, previous_edges, prev_edges, &unmatched, &num_unmatched);
+
+        pcst_result_t *result = solve_within_budget(
+            graph.edge_sources, graph.edge_targets, graph.edge_costs, graph.num_edges,
+            graph.node_prizes, graph.num_nodes,
+            root_index, effective_num_clusters, pruning_method, 0, &options
+        );
+
+        if (!result || !result->success) {
+            char error_msg[256];
+            strlcpy(error_msg, result ? result->error_message : "Unknown error", sizeof(error_msg));
+            if (result) pcst_free_result(result);
+            SPI_finish();
+            ereport(ERROR, (errcode(ERRCODE_EXTERNAL_ROUTINE_EXCEPTION),
+                           errmsg("PCST algorithm failed: %s", error_msg)));
+        }
+        slow_log_end(&slow_log, "pgr_pcst_fast_delta", root_id, graph.num_nodes, graph.num_edges,
+                     num_clusters, pruning_method, &options, result);
+
+        bool *prev_nodes = (bool *) palloc0((graph.num_nodes + 1) * sizeof(bool));
+        bool *cur_nodes = (bool *) palloc0((graph.num_nodes + 1) * sizeof(bool));
+        bool *credited = (bool *) palloc0((graph.num_nodes + 1) * sizeof(bool));
+        int num_changed = 0;
+        for (int i = 0; i < result->num_edges; i++)
+            cur_edges[result->result_edges[i]] = true;
+        for (int i = 0; i < graph.num_edges; i++) {
+            if (prev_edges[i]) {
+                prev_nodes[graph.edge_sources[i]] = true;
+                prev_nodes[graph.edge_targets[i]] = true;
+            }
+            if (cur_edges[i]) {
+                cur_nodes[graph.edge_sources[i]] = true;
+                cur_nodes[graph.edge_targets[i]] = true;
+            }
+            if (prev_edges[i] != cur_edges[i])
+                num_changed++;
+        }
+
+        // SPI_connect switched to the SPI procedure context; the rows must outlive SPI_finish
+        MemoryContext spicontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+        rows = (pcst_delta_rows *) palloc(sizeof(pcst_delta_rows));
+        rows->rows = (pcst_delta_row *) palloc((num_changed + num_unmatched + 1) * sizeof(pcst_delta_row));
+        rows->num_rows = 0;
+        for (int i = 0; i < graph.num_edges; i++) {
+            if (prev_edges[i] && !cur_edges[i])
+                add_delta_row(rows, &graph, i, false, prev_nodes, cur_nodes, credited);
+        }
+        // Previous edges that are no longer in the graph at all
+        for (int i = 0; i < num_unmatched; i++) {
+            pcst_delta_row *row = &rows->rows[rows->num_rows++];
+            memset(row, 0, sizeof(pcst_delta_row));
+            row->edge_id = (text *) palloc(VARSIZE(unmatched[i]));
+            memcpy(row->edge_id, unmatched[i], VARSIZE(unmatched[i]));
+        }
+        for (int i = 0; i < graph.num_edges; i++) {
+            if (cur_edges[i] && !prev_edges[i])
+                add_delta_row(rows, &graph, i, true, prev_nodes, cur_nodes, credited);
+        }
+        MemoryContextSwitchTo(spicontext);
+
+        pcst_free_result(result);
+        SPI_finish();
+
+        funcctx->user_fctx = rows;
+        funcctx->max_calls = rows->num_rows;
+        MemoryContextSwitchTo(oldcontext);
+    }
+
+    funcctx = SRF_PERCALL_SETUP();
+
+    if (funcctx->call_cntr < funcctx->max_calls) {
+        pcst_delta_rows *rows = (pcst_delta_rows *) funcctx->user_fctx;
+        pcst_delta_row *row = &rows->rows[funcctx->call_cntr];
+        Datum values[7];
+        bool nulls[7] = {false, false, false, false, false, false, false};
+        HeapTuple tuple;
+
+        values[0] = Int32GetDatum(funcctx->call_cntr + 1);
+        values[1] = CStringGetTextDatum(row->added ? "added" : "removed");
+        values[2] = PointerGetDatum(row->edge_id);
+        values[3] = PointerGetDatum(row->source);
+        values[4] = PointerGetDatum(row->target);
+        values[5] = Float8GetDatum(row->cost);
+        values[6] = Float8GetDatum(row->objective_delta);
+        nulls[2] = row->edge_id == NULL;
+        nulls[3] = row->source == NULL;
+        nulls[4] = row->target == NULL;
+        nulls[5] = !row->in_graph;
+        nulls[6] = !row->in_graph;
+
+        tuple = heap_form_tuple(funcctx->tuple_desc, values, nulls);
+        SRF_RETURN_NEXT(funcctx, HeapTupleGetDatum(tuple));
+    } else {
+        SRF_RETURN_DONE(funcctx);
+    }
+}
+
+/* pgr_pcst_fast on every group of grouped edges and nodes queries in one call */
+Datum pcst_fast_pgr_grouped(PG_FUNCTION_ARGS) {
+    FuncCallContext *funcctx;
+    TupleDesc tupdesc;
+
+    if (SRF_IS_FIRSTCALL()) {
+        text *edges_sql = PG_GETARG_TEXT_P(0);
+        text *nodes_sql = PG_GETARG_TEXT_P(1);
+        int num_clusters = PG_ARGISNULL(2) ? 1 : PG_GETARG_INT32(2);
+        text *pruning_text = PG_ARGISNULL(3) ? NULL : PG_GETARG_TEXT_P(3);
+        int verbosity = PG_ARGISNULL(4) ? 0 : PG_GETARG_INT32(4);
+        MemoryContext oldcontext;
+        pcst_graph_groups groups;
+        pcst_grouped_rows *rows;
+        pcst_options_t options;
+        int ret;
+
+        funcctx = SRF_FIRSTCALL_INIT();
+        oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+        if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+            ereport(ERROR,
+                    (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                     errmsg("function returning record called in context "
+                            "that cannot accept a set")));
+        funcctx->tuple_desc = BlessTupleDesc(tupdesc);
+
+        if ((ret = SPI_connect()) != SPI_OK_CONNECT)
+            ereport(ERROR,
+                    (errcode(ERRCODE_INTERNAL_ERROR),
+                     errmsg("SPI_connect failed: %d", ret)));
+
+        // The groups are solved on several threads, which cannot share a phase timer
+        pcst_slow_log slow_log;
+        slow_log_begin(&slow_log, NULL);
+        int pruning_method = pcst_parse_pruning(pruning_text);
+        pcst_load_graph_groups(&groups, text_to_cstring(edges_sql), text_to_cstring(nodes_sql),
+                               verbosity);
+
+        int num_groups = groups.num_groups;
+        pcst_problem_t *problems = (pcst_problem_t *) palloc(num_groups * sizeof(pcst_problem_t));
+        pcst_result_t **results = (pcst_result_t **) palloc0(num_groups * sizeof(pcst_result_t *));
+        for (int g = 0; g < num_groups; g++) {
+            pcst_graph *graph = &groups.graphs[g];
+            problems[g].edge_sources = graph->edge_sources;
+            problems[g].edge_targets = graph->edge_targets;
+            problems[g].edge_costs = graph->edge_costs;
+            problems[g].num_edges = graph->num_edges;
+            problems[g].node_prizes = graph->node_prizes;
+            problems[g].num_nodes = graph->num_nodes;
+            problems[g].root_node = -1;
+            problems[g].target_num_active_clusters = num_clusters;
+        }
+
+        init_solve_options(&options);
+        solve_batch_within_budget(problems, num_groups, pruning_method, verbosity, &options,
+                                  results);
+
+        int num_rows = 0;
+        for (int g = 0; g < num_groups; g++) {
+            if (!results[g] || !results[g]->success) {
+                // The message has to outlive SPI_finish
+                MemoryContext spicontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+                char *group_id = text_to_cstring(groups.group_ids[g]);
+                char *error_msg = pstrdup(results[g] ? results[g]->error_message : "Unknown error");
+                MemoryContextSwitchTo(spicontext);
+                for (int i = 0; i < num_groups; i++)
+                    pcst_free_result(results[i]);
+                SPI_finish();
+                ereport(ERROR, (errcode(ERRCODE_EXTERNAL_ROUTINE_EXCEPTION),
+                               errmsg("PCST algorithm failed for group %s: %s", group_id, error_msg)));
+            }
+            num_rows += results[g]->num_edges;
+        }
+        if (slow_log.active) {
+            pcst_slow_log_call call;
+            call.function = "pgr_pcst_fast_grouped";
+            call.root_id = NULL;
+            call.num_nodes = 0;
+            call.num_edges = 0;
+            for (int g = 0; g < num_groups; g++) {
+                call.num_nodes += groups.graphs[g].num_nodes;
+                call.num_edges += groups.graphs[g].num_edges;
+            }
+            call.num_groups = num_groups;
+            call.num_clusters = num_clusters;
+            call.pruning_method = pruning_method;
+            pcst_slow_log_end(&slow_log, pcst_log_min_duration, (pcst_log_format) pcst_slow_log_format,
+                              &call, &options, results, num_groups);
+        }
+
+        // SPI_connect switched to the SPI procedure context; the rows must outlive SPI_finish
+        MemoryContext spicontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+        rows = (pcst_grouped_rows *) palloc(sizeof(pcst_grouped_rows));
+        rows->group_ids = (text **) palloc((num_rows + 1) * sizeof(text *));
+        rows->seqs = (int *) palloc((num_rows + 1) * sizeof(int));
+        rows->edge_ids = (text **) palloc((num_rows + 1) * sizeof(text *));
+        rows->sources = (text **) palloc((num_rows + 1) * sizeof(text *));
+        rows->targets = (text **) palloc((num_rows + 1) * sizeof(text *));
+        rows->costs = (double *) palloc((num_rows + 1) * sizeof(double));
+        rows->num_rows = 0;
+        for (int g = 0; g < num_groups; g++) {
+            pcst_graph *graph = &groups.graphs[g];
+            pcst_result_t *result = results[g];
+            text *group_id = (text *) palloc(VARSIZE(groups.group_ids[g]));
+            memcpy(group_id, groups.group_ids[g], VARSIZE(groups.group_ids[g]));
+            for (int r = 0; r < result->num_edges; r++) {
+                int i = result->result_edges[r];
+                int row = rows->num_rows++;
+                rows->group_ids[row] = group_id;
+                rows->seqs[row] = r + 1;
+                rows->edge_ids[row] = pcst_edge_id_text(graph, i);
+                rows->sources[row] = pcst_node_id_text(graph, graph->edge_sources[i]);
+                rows->targets[row] = pcst_node_id_text(graph, graph->edge_targets[i]);
+                rows->costs[row] = graph->edge_costs[i];
+            }
+            pcst_free_result(result);
+        }
+        MemoryContextSwitchTo(spicontext);
+
+        SPI_finish();
+
+        funcctx->user_fctx = rows;
+        funcctx->max_calls = rows->num_rows;
+        MemoryContextSwitchTo(oldcontext);
+    }
+
+    funcctx = SRF_PERCALL_SETUP();
+
+    if (funcctx->call_cntr < funcctx->max_calls) {
+        pcst_grouped_rows *rows = (pcst_grouped_rows *) funcctx->user_fctx;
+        int row = funcctx->call_cntr;
+        Datum values[6];
+        bool nulls[6] = {false, false, false, false, false, false};
+        HeapTuple tuple;
+
+        values[0] = PointerGetDatum(rows->group_ids[row]);
+        values[1] = Int32GetDatum(rows->seqs[row]);
+        values[2] = PointerGetDatum(rows->edge_ids[row]);
+        values[3] = PointerGetDatum(rows->sources[row]);
+        values[4] = PointerGetDatum(rows->targets[row]);
+        values[5] = Float8GetDatum(rows->costs[row]);
+        nulls[2] = rows->edge_ids[row] == NULL;
+
+        tuple = heap_form_tuple(funcctx->tuple_desc, values, nulls);
+        SRF_RETURN_NEXT(funcctx, HeapTupleGetDatum(tuple));
+    } else {
+        SRF_RETURN_DONE(funcctx);
+    }
+}
+
+/*
+ * Frontier solve of a graph being read, with the thread it holds from the
+ * budget. If a fetch errors out, the solver is freed along with the memory
+ * context it was created in.
+ */
+typedef struct {
+    MemoryContextCallback callback;
+    pcst_frontier_t *solver;
+} pcst_frontier_handle;
+
+static void free_frontier_handle(void *arg) {
+    pcst_frontier_handle *handle = (pcst_frontier_handle *) arg;
+
+    pcst_frontier_free(handle->solver);
+    handle->solver = NULL;
+}
+
+/*
+ * Solve a frontier graph, reading the edges of every batch of nodes the
+ * solver reaches until growth ends. Reading counts as load time.
+ */
+static pcst_result_t *solve_frontier_within_budget(pcst_frontier_graph *frontier,
+                                                   int num_clusters, int pruning_method,
+                                                   int verbosity, const pcst_options_t *options) {
+    pcst_graph *graph = &frontier->graph;
+    pcst_frontier_handle *handle;
+    pcst_result_t *result;
+    int num_nodes = 0;           // Nodes and edges handed to the solver so far
+    int num_edges = 0;
+    int threads;
+
+    handle = (pcst_frontier_handle *) palloc0(sizeof(pcst_frontier_handle));
+    handle->solver = pcst_frontier_create(frontier->root, num_clusters, pruning_method,
+                                          verbosity, options);
+    if (!handle->solver)
+        ereport(ERROR, (errcode(ERRCODE_OUT_OF_MEMORY),
+                        errmsg("out of memory creating the frontier solver")));
+    handle->callback.func = free_frontier_handle;
+    handle->callback.arg = handle;
+    MemoryContextRegisterResetCallback(CurrentMemoryContext, &handle->callback);
+
+    threads = pcst_threads_acquire(1, pcst_max_total_threads);
+    for (;;) {
+        const int *nodes;
+        int num_expand;
+
+        if (!pcst_frontier_add_nodes(handle->solver, graph->node_prizes + num_nodes,
+                                     graph->num_nodes - num_nodes)
+            || !pcst_frontier_add_edges(handle->solver, graph->edge_sources + num_edges,
+                                        graph->edge_targets + num_edges,
+                                        graph->edge_costs + num_edges,
+                                        graph->num_edges - num_edges)) {
+            pcst_threads_release(threads);
+            ereport(ERROR, (errcode(ERRCODE_OUT_OF_MEMORY),
+                            errmsg("out of memory building the solver input")));
+        }
+        num_nodes = graph->num_nodes;
+        num_edges = graph->num_edges;
+
+        num_expand = pcst_frontier_continue(handle->solver, &nodes);
+        if (num_expand == 0)
+            break;
+        pcst_perf_begin(options->perf, PCST_PHASE_LOAD);
+        pcst_expand_frontier(frontier, nodes, num_expand, verbosity);
+        pcst_perf_end(options->perf);
+    }
+    result = pcst_frontier_result(handle->solver);
+    free_frontier_handle(handle);
+    pcst_threads_release(threads);
+
+    if (verbosity > 0)
+        elog(INFO, "pgr_pcst_fast_frontier: %d fetches read %lld rows, %d nodes and %d edges",
+             frontier->num_fetches, (long long) frontier->num_fetched_rows,
+             graph->num_nodes, graph->num_edges);
+    return raise_if_interrupted(result, options);
+}
+
+/*
+ * pgr_pcst_fast reading only the part of the graph growth reaches: edges_sql
+ * is run with the IDs of the nodes to expand as $1, starting from the prize
+ * nodes and the root.
+ */
+Datum pcst_fast_pgr_frontier(PG_FUNCTION_ARGS) {
+    FuncCallContext *funcctx;
+    TupleDesc tupdesc;
+
+    if (SRF_IS_FIRSTCALL()) {
+        text *edges_sql = PG_GETARG_TEXT_P(0);
+        text *nodes_sql = PG_GETARG_TEXT_P(1);
+        text *root_id = PG_ARGISNULL(2) ? NULL : PG_GETARG_TEXT_P(2);
+        int num_clusters = PG_ARGISNULL(3) ? 1 : PG_GETARG_INT32(3);
+        text *pruning_text = PG_ARGISNULL(4) ? NULL : PG_GETARG_TEXT_P(4);
+        int verbosity = PG_ARGISNULL(5) ? 0 : PG_GETARG_INT32(5);
+        MemoryContext oldcontext;
+        pcst_frontier_graph frontier;
+        pcst_frontier_rows *rows;
+        pcst_options_t options;
+        pcst_slow_log slow_log;
+        pcst_result_t *result;
+        int ret;
+
+        funcctx = SRF_FIRSTCALL_INIT();
+        oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+        if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+            ereport(ERROR,
+                    (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                     errmsg("function returning record called in context "
+                            "that cannot accept a set")));
+        funcctx->tuple_desc = BlessTupleDesc(tupdesc);
+
+        if ((ret = SPI_connect()) != SPI_OK_CONNECT)
+            ereport(ERROR,
+                    (errcode(ERRCODE_INTERNAL_ERROR),
+                     errmsg("SPI_connect failed: %d", ret)));
+
+        int pruning_method = pcst_parse_pruning(pruning_text);
+        init_solve_options(&options);
+        slow_log_begin(&slow_log, &options);
+
+        pcst_perf_begin(options.perf, PCST_PHASE_LOAD);
+        pcst_load_frontier(&frontier, text_to_cstring(edges_sql), text_to_cstring(nodes_sql),
+                           root_id, verbosity);
+        pcst_perf_end(options.perf);
+
+        result = solve_frontier_within_budget(&frontier, frontier.root >= 0 ? 0 : num_clusters,
+                                              pruning_method, verbosity, &options);
+        if (!result || !result->success) {
+            // The message has to outlive SPI_finish
+            MemoryContext spicontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+            char *error_msg = pstrdup(result ? result->error_message : "Unknown error");
+            MemoryContextSwitchTo(spicontext);
+            pcst_free_result(result);
+            SPI_finish();
+            ereport(ERROR, (errcode(ERRCODE_EXTERNAL_ROUTINE_EXCEPTION),
+                           errmsg("PCST algorithm failed: %s", error_msg)));
+        }
+        slow_log_end(&slow_log, "pgr_pcst_fast_frontier", root_id, frontier.graph.num_nodes,
+                     frontier.graph.num_edges, num_clusters, pruning_method, &options, result);
+
+        // SPI_connect switched to the SPI procedure context; the rows must outlive SPI_finish
+        MemoryContext spicontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+        pcst_graph *graph = &frontier.graph;
+        rows = (pcst_frontier_rows *) palloc(sizeof(pcst_frontier_rows));
+        rows->edge_ids = (text **) palloc((result->num_edges + 1) * sizeof(text *));
+        rows->sources = (text **) palloc((result->num_edges + 1) * sizeof(text *));
+        rows->targets = (text **) palloc((result->num_edges + 1) * sizeof(text *));
+        rows->costs = (double *) palloc((result->num_edges + 1) * sizeof(double));
+        rows->num_rows = result->num_edges;
+        for (int r = 0; r < result->num_edges; r++) {
+            int i = result->result_edges[r];
+            rows->edge_ids[r] = pcst_edge_id_text(graph, i);
+            rows->sources[r] = pcst_node_id_text(graph, graph->edge_sources[i]);
+            rows->targets[r] = pcst_node_id_text(graph, graph->edge_targets[i]);
+            rows->costs[r] = graph->edge_costs[i];
+        }
+        pcst_free_result(result);
+        MemoryContextSwitchTo(spicontext);
+
+        SPI_finish();
+
+        funcctx->user_fctx = rows;
+        funcctx->max_calls = rows->num_rows;
+        MemoryContextSwitchTo(oldcontext);
+    }
+
+    funcctx = SRF_PERCALL_SETUP();
+
+    if (funcctx->call_cntr < funcctx->max_calls) {
+        pcst_frontier_rows *rows = (pcst_frontier_rows *) funcctx->user_fctx;
+        int row = funcctx->call_cntr;
+        Datum values[5];
+        bool nulls[5] = {false, false, false, false, false};
+        HeapTuple tuple;
+
+        values[0] = Int32GetDatum(row + 1);
+        values[1] = PointerGetDatum(rows->edge_ids[row]);
+        values[2] = PointerGetDatum(rows->sources[row]);
+        values[3] = PointerGetDatum(rows->targets[row]);
+        values[4] = Float8GetDatum(rows->costs[row]);
+
+        tuple = heap_form_tuple(funcctx->tuple_desc, values, nulls);
+        SRF_RETURN_NEXT(funcctx, HeapTupleGetDatum(tuple));
+    } else {
+        SRF_RETURN_DONE(funcctx);
+    }
+}
+
+/*
+ * Repair the result tree_ids after failed_ids failed, on a loaded graph.
+ * Result edges the graph does not hold are lost like failed ones. For a
+ * frontier graph, expanded tells which nodes had their edges read: when the
+ * search read the edges of a node that was not expanded, the nodes it
+ * reached that were not are returned in *to_expand, and the caller reads
+ * their edges and repairs again.
+ */
+static pcst_result_t *repair_within_budget(pcst_graph *graph, ArrayType *tree_ids,
+                                           ArrayType *failed_ids, int root, bool one_tree,
+                                           const bool *expanded, int **to_expand,
+                                           int *num_to_expand, const pcst_options_t *options) {
+    text **unmatched = NULL;
+    int num_unmatched = 0;
+    pcst_repairer_t *repairer;
+    pcst_result_t *result;
+
+    // Edges of the result and failed edges, by internal edge
+    bool *in_tree = (bool *) palloc0((graph->num_edges + 1) * sizeof(bool));
+    bool *failed = (bool *) palloc0((graph->num_edges + 1) * sizeof(bool));
+    if (tree_ids)
+        pcst_match_edge_ids(graph, tree_ids, in_tree, &unmatched, &num_unmatched);
+    if (failed_ids)
+        pcst_match_edge_ids(graph, failed_ids, failed, &unmatched, &num_unmatched);
+    int *tree_edges = (int *) palloc((graph->num_edges + 1) * sizeof(int));
+    int *failed_edges = (int *) palloc((graph->num_edges + 1) * sizeof(int));
+    int num_tree_edges = 0;
+    int num_failed_edges = 0;
+    for (int i = 0; i < graph->num_edges; i++) {
+        if (in_tree[i])
+            tree_edges[num_tree_edges++] = i;
+        if (failed[i])
+            failed_edges[num_failed_edges++] = i;
+    }
+
+    pcst_perf_begin(options->perf, PCST_PHASE_CONSTRUCT);
+    repairer = pcst_repairer_create(graph->edge_sources, graph->edge_targets, graph->edge_costs,
+                                    graph->num_edges, graph->node_prizes, graph->num_nodes);
+    pcst_perf_end(options->perf);
+    if (!repairer)
+        ereport(ERROR, (errcode(ERRCODE_OUT_OF_MEMORY),
+                        errmsg("out of memory building the solver input")));
+    int threads = pcst_threads_acquire(1, pcst_max_total_threads);
+    result = pcst_repairer_run(repairer, tree_edges, num_tree_edges, failed_edges,
+                               num_failed_edges, root, one_tree ? 1 : 0, options);
+    pcst_threads_release(threads);
+
+    *num_to_expand = 0;
+    if (expanded && result && result->success) {
+        const int *scanned;
+        const int *reached;
+        int num_scanned;
+        int num_reached;
+        bool complete = true;
+
+        pcst_repairer_searched_nodes(repairer, &scanned, &num_scanned, &reached, &num_reached);
+        for (int i = 0; i < num_scanned && complete; i++)
+            complete = expanded[scanned[i]];
+        if (!complete) {
+            *to_expand = (int *) palloc(num_reached * sizeof(int));
+            for (int i = 0; i < num_reached; i++) {
+                if (!expanded[reached[i]])
+                    (*to_expand)[(*num_to_expand)++] = reached[i];
+            }
+        }
+    }
+    pcst_repairer_free(repairer);
+    pfree(in_tree);
+    pfree(failed);
+    pfree(tree_edges);
+    pfree(failed_edges);
+    return result;
+}
+
+/* Rows of a repair result, allocated in the current memory context */
+static pcst_frontier_rows *repair_rows(pcst_graph *graph, pcst_result_t *result) {
+    pcst_frontier_rows *rows = (pcst_frontier_rows *) palloc(sizeof(pcst_frontier_rows));
+
+    rows->edge_ids = (text **) palloc((result->num_edges + 1) * sizeof(text *));
+    rows->sources = (text **) palloc((result->num_edges + 1) * sizeof(text *));
+    rows->targets = (text **) palloc((result->num_edges + 1) * sizeof(text *));
+    rows->costs = (double *) palloc((result->num_edges + 1) * sizeof(double));
+    rows->num_rows = result->num_edges;
+    for (int r = 0; r < result->num_edges; r++) {
+        int i = result->result_edges[r];
+        rows->edge_ids[r] = pcst_edge_id_text(graph, i);
+        rows->sources[r] = pcst_node_id_text(graph, graph->edge_sources[i]);
+        rows->targets[r] = pcst_node_id_text(graph, graph->edge_targets[i]);
+        rows->costs[r] = graph->edge_costs[i];
+    }
+    return rows;
+}
+
+/* Raise the error of a failed repair, after SPI_finish */
+static void raise_if_repair_failed(pcst_result_t *result, MemoryContext error_context) {
+    if (result && result->success)
+        return;
+
+    // The message has to outlive SPI_finish
+    MemoryContext spicontext = MemoryContextSwitchTo(error_context);
+    char *error_msg = pstrdup(result ? result->error_message : "Unknown error");
+    MemoryContextSwitchTo(spicontext);
+    pcst_free_result(result);
+    SPI_finish();
+    ereport(ERROR, (errcode(ERRCODE_EXTERNAL_ROUTINE_EXCEPTION),
+                    errmsg("PCST repair failed: %s", error_msg)));
+}
+
+/* Next row of pgr_pcst_fast_repair or pgr_pcst_fast_repair_frontier */
+static Datum repair_next_row(FunctionCallInfo fcinfo) {
+    FuncCallContext *funcctx = SRF_PERCALL_SETUP();
+
+    if (funcctx->call_cntr < funcctx->max_calls) {
+        pcst_frontier_rows *rows = (pcst_frontier_rows *) funcctx->user_fctx;
+        int row = funcctx->call_cntr;
+        Datum values[5];
+        bool nulls[5] = {false, false, false, false, false};
+        HeapTuple tuple;
+
+        values[0] = Int32GetDatum(row + 1);
+        values[1] = PointerGetDatum(rows->edge_ids[row]);
+        values[2] = PointerGetDatum(rows->sources[row]);
+        values[3] = PointerGetDatum(rows->targets[row]);
+        values[4] = Float8GetDatum(rows->costs[row]);
+
+        tuple = heap_form_tuple(funcctx->tuple_desc, values, nulls);
+        SRF_RETURN_NEXT(funcctx, HeapTupleGetDatum(tuple));
+    } else {
+        SRF_RETURN_DONE(funcctx);
+    }
+}
+
+/*
+ * A previous result repaired after some of its edges failed: the pieces left
+ * are reconnected along the cheapest paths around the failures where their
+ * prizes pay for it, without solving again. A result of several clusters
+ * is repaired tree by tree.
+ */
+Datum pcst_fast_pgr_repair(PG_FUNCTION_ARGS) {
+    FuncCallContext *funcctx;
+    TupleDesc tupdesc;
+
+    if (SRF_IS_FIRSTCALL()) {
+        text *edges_sql = PG_GETARG_TEXT_P(0);
+        text *nodes_sql = PG_GETARG_TEXT_P(1);
+        ArrayType *tree_ids = PG_ARGISNULL(2) ? NULL : PG_GETARG_ARRAYTYPE_P(2);
+        ArrayType *failed_ids = PG_ARGISNULL(3) ? NULL : PG_GETARG_ARRAYTYPE_P(3);
+        text *root_id = PG_ARGISNULL(4) ? NULL : PG_GETARG_TEXT_P(4);
+        int num_clusters = PG_ARGISNULL(5) ? 1 : PG_GETARG_INT32(5);
+        MemoryContext oldcontext;
+        pcst_graph graph;
+        pcst_options_t options;
+        pcst_slow_log slow_log;
+        pcst_result_t *result;
+        int *to_expand;
+        int num_to_expand;
+        int ret;
+
+        funcctx = SRF_FIRSTCALL_INIT();
+        oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+        if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+            ereport(ERROR,
+                    (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                     errmsg("function returning record called in context "
+                            "that cannot accept a set")));
+        funcctx->tuple_desc = BlessTupleDesc(tupdesc);
+
+        if ((ret = SPI_connect()) != SPI_OK_CONNECT)
+            ereport(ERROR,
+                    (errcode(ERRCODE_INTERNAL_ERROR),
+                     errmsg("SPI_connect failed: %d", ret)));
+
+        init_solve_options(&options);
+        slow_log_begin(&slow_log, &options);
+        pcst_perf_begin(options.perf, PCST_PHASE_LOAD);
+        pcst_load_graph(&graph, text_to_cstring(edges_sql), text_to_cstring(nodes_sql), 0);
+        pcst_perf_end(options.perf);
+        int root_index = pcst_resolve_root(&graph, root_id, 0);
+
+        // A result of one tree is repaired as one even where edges the edges
+        // query no longer returns split it already; the trees of a result of
+        // several clusters are told apart by the edges that remain
+        result = repair_within_budget(&graph, tree_ids, failed_ids, root_index,
+                                      root_index >= 0 || num_clusters <= 1, NULL,
+                                      &to_expand, &num_to_expand, &options);
+        raise_if_repair_failed(result, funcctx->multi_call_memory_ctx);
+        slow_log_end(&slow_log, "pgr_pcst_fast_repair", root_id, graph.num_nodes, graph.num_edges,
+                     num_clusters, 3, &options, result);
+
+        // SPI_connect switched to the SPI procedure context; the rows must outlive SPI_finish
+        MemoryContext spicontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+        pcst_frontier_rows *rows = repair_rows(&graph, result);
+        pcst_free_result(result);
+        MemoryContextSwitchTo(spicontext);
+
+        SPI_finish();
+
+        funcctx->user_fctx = rows;
+        funcctx->max_calls = rows->num_rows;
+        MemoryContextSwitchTo(oldcontext);
+    }
+
+    return repair_next_row(fcinfo);
+}
+
+/*
+ * pgr_pcst_fast_repair reading only the part of the graph the repair
+ * searches: edges_sql is run with node IDs as $1, first for the nodes of
+ * the result read from tree_sql and the root, then for the nodes the search
+ * reaches, repairing again until it had the edges of every node it went
+ * through.
+ */
+Datum pcst_fast_pgr_repair_frontier(PG_FUNCTION_ARGS) {
+    FuncCallContext *funcctx;
+    TupleDesc tupdesc;
+
+    if (SRF_IS_FIRSTCALL()) {
+        text *edges_sql = PG_GETARG_TEXT_P(0);
+        text *nodes_sql = PG_GETARG_TEXT_P(1);
+        text *tree_sql = PG_GETARG_TEXT_P(2);
+        ArrayType *failed_ids = PG_ARGISNULL(3) ? NULL : PG_GETARG_ARRAYTYPE_P(3);
+        text *root_id = PG_ARGISNULL(4) ? NULL : PG_GETARG_TEXT_P(4);
+        int num_clusters = PG_ARGISNULL(5) ? 1 : PG_GETARG_INT32(5);
+        MemoryContext oldcontext;
+        pcst_frontier_graph frontier;
+        pcst_frontier_rows *rows;
+        pcst_options_t options;
+        pcst_slow_log slow_log;
+        pcst_result_t *result;
+        int *to_expand;
+        int num_to_expand;
+        int ret;
+
+        funcctx = SRF_FIRSTCALL_INIT();
+        oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+        if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+            ereport(ERROR,
+                    (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                     errmsg("function returning record called in context "
+                            "that cannot accept a set")));
+        funcctx->tuple_desc = BlessTupleDesc(tupdesc);
+
+        if ((ret = SPI_connect()) != SPI_OK_CONNECT)
+            ereport(ERROR,
+                    (errcode(ERRCODE_INTERNAL_ERROR),
+                     errmsg("SPI_connect failed: %d", ret)));
+
+        init_solve_options(&options);
+        slow_log_begin(&slow_log, &options);
+        pcst_perf_begin(options.perf, PCST_PHASE_LOAD);
+
+        // The edges of the result and their ends, which are read first
+        ret = SPI_execute(text_to_cstring(tree_sql), true, 0);
+        if (ret != SPI_OK_SELECT)
+            ereport(ERROR,
+                    (errcode(ERRCODE_INTERNAL_ERROR),
+                     errmsg("tree query failed: %s", SPI_result_code_string(ret))));
+        if (SPI_tuptable->tupdesc->natts < 3)
+            ereport(ERROR,
+                    (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                     errmsg("tree query must return at least 3 columns: id, source, target")));
+        SPITupleTable *tree = SPI_tuptable;
+        int num_tree_rows = (int) SPI_processed;
+        Datum *tree_id_datums = (Datum *) palloc((num_tree_rows + 1) * sizeof(Datum));
+        text **tree_nodes = (text **) palloc((2 * num_tree_rows + 1) * sizeof(text *));
+        int num_tree_ids = 0;
+        int num_tree_nodes = 0;
+        for (int r = 0; r < num_tree_rows; r++) {
+            bool id_null;
+            Datum id_datum = SPI_getbinval(tree->vals[r], tree->tupdesc, 1, &id_null);
+
+            if (!id_null)
+                tree_id_datums[num_tree_ids++] = id_datum;
+            for (int column = 2; column <= 3; column++) {
+                char *node_id = SPI_getvalue(tree->vals[r], tree->tupdesc, column);
+                if (node_id != NULL)
+                    tree_nodes[num_tree_nodes++] = cstring_to_text(node_id);
+            }
+        }
+        Oid tree_id_type = SPI_gettypeid(tree->tupdesc, 1);
+        int16 tree_id_typlen;
+        bool tree_id_typbyval;
+        char tree_id_typalign;
+        get_typlenbyvalalign(tree_id_type, &tree_id_typlen, &tree_id_typbyval, &tree_id_typalign);
+        ArrayType *tree_ids = construct_array(tree_id_datums, num_tree_ids, tree_id_type,
+                                              tree_id_typlen, tree_id_typbyval, tree_id_typalign);
+        SPI_freetuptable(tree);
+
+        if (num_tree_nodes == 0 && root_id == NULL) {
+            // Nothing to repair
+            pcst_perf_end(options.perf);
+            SPI_finish();
+            funcctx->max_calls = 0;
+            MemoryContextSwitchTo(oldcontext);
+            return repair_next_row(fcinfo);
+        }
+        pcst_load_frontier_around(&frontier, text_to_cstring(edges_sql),
+                                  text_to_cstring(nodes_sql), tree_nodes, num_tree_nodes,
+                                  root_id, 0);
+        pcst_perf_end(options.perf);
+
+        for (;;) {
+            result = repair_within_budget(&frontier.graph, tree_ids, failed_ids, frontier.root,
+                                          frontier.root >= 0 || num_clusters <= 1,
+                                          frontier.expanded, &to_expand, &num_to_expand,
+                                          &options);
+            if (num_to_expand == 0)
+                break;
+            pcst_free_result(result);
+            pcst_perf_begin(options.perf, PCST_PHASE_LOAD);
+            pcst_expand_frontier(&frontier, to_expand, num_to_expand, 0);
+            pcst_perf_end(options.perf);
+            pfree(to_expand);
+        }
+        raise_if_repair_failed(result, funcctx->multi_call_memory_ctx);
+        slow_log_end(&slow_log, "pgr_pcst_fast_repair_frontier", root_id,
+                     frontier.graph.num_nodes, frontier.graph.num_edges, num_clusters, 3,
+                     &options, result);
+
+        // SPI_connect switched to the SPI procedure context; the rows must outlive SPI_finish
+        MemoryContext spicontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+        rows = repair_rows(&frontier.graph, result);
+        pcst_free_result(result);
+        MemoryContextSwitchTo(spicontext);
+
+        SPI_finish();
+
+        funcctx->user_fctx = rows;
+        funcctx->max_calls = rows->num_rows;
+        MemoryContextSwitchTo(oldcontext);
+    }
+
+    return repair_next_row(fcinfo);
+}
+
+/* Totals of the solver thread budget, one row */
+Datum pcst_fast_thread_budget(PG_FUNCTION_ARGS) {
+    TupleDesc tupdesc;
+    pcst_thread_budget_info info;
+    Datum values[6];
+    bool nulls[6] = {false, false, false, false, false, false};
+
+    if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+        ereport(ERROR,
+                (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                 errmsg("function returning record called in context "
+                        "that cannot accept type record")));
+    tupdesc = BlessTupleDesc(tupdesc);
+
+    pcst_threads_get_info(&info, pcst_max_total_threads);
+    values[0] = Int32GetDatum(info.max_total_threads);
+    values[1] = Int32GetDatum(info.threads_in_use);
+    values[2] = Int32GetDatum(info.peak_threads_in_use);
+    values[3] = Int64GetDatum(info.num_grants);
+    values[4] = Int64GetDatum(info.num_reduced_grants);
+    values[5] = BoolGetDatum(info.shared);
+
+    PG_RETURN_DATUM(HeapTupleGetDatum(heap_form_tuple(tupdesc, values, nulls)));
+}
+
+/* (pid, threads_requested, threads_granted) per backend holding solver threads */
+Datum pcst_fast_thread_holders(PG_FUNCTION_ARGS) {
+    FuncCallContext *funcctx;
+    pcst_thread_holder *holders;
+
+    if (SRF_IS_FIRSTCALL()) {
+        MemoryContext oldcontext;
+        TupleDesc tupdesc;
+        int num_holders;
+
+        funcctx = SRF_FIRSTCALL_INIT();
+        oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+        if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+            ereport(ERROR,
+                    (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                     errmsg("function returning record called in context "
+                            "that cannot accept a set")));
+        funcctx->tuple_desc = BlessTupleDesc(tupdesc);
+
+        // Snapshot once so the rows are consistent across calls
+        funcctx->user_fctx = pcst_threads_get_holders(&num_holders);
+        funcctx->max_calls = num_holders;
+        MemoryContextSwitchTo(oldcontext);
+    }
+
+    funcctx = SRF_PERCALL_SETUP();
+    holders = (pcst_thread_holder *) funcctx->user_fctx;
+
+    if (funcctx->call_cntr < funcctx->max_calls) {
+        pcst_thread_holder *holder = &holders[funcctx->call_cntr];
+        Datum values[3];
+        bool nulls[3] = {false, false, false};
+        HeapTuple tuple;
+
+        values[0] = Int32GetDatum(holder->pid);
+        values[1] = Int32GetDatum(holder->requested);
+        values[2] = Int32GetDatum(holder->granted);
+
+        tuple = heap_form_tuple(funcctx->tuple_desc, values, nulls);
+        SRF_RETURN_NEXT(funcctx, HeapTupleGetDatum(tuple));
+    } else {
+        SRF_RETURN_DONE(funcctx);
+    }
+}
@@ -0,0 +1,2008 @@
+#include "postgres.h"
+#include "fmgr.h"
+#include "access/htup_details.h"
+#include "catalog/pg_type.h"
+#include "utils/array.h"
+#include "utils/builtins.h"
+#include "lib/stringinfo.h"
+#include "utils/lsyscache.h"
+#include "executor/spi.h"
+#include "utils/hsearch.h"
+#include "utils/uuid.h"
+#include "pcst_loader.h"
+#include "pcst_fast_c_wrapper.h"
+
+const char *const pcst_mem_entry_names[PCST_MEM_NUM_ENTRIES] = {
+    "loader.edge_tuptable",
+    "loader.node_tuptable",
+    "loader.node_ids",
+    "loader.edge_ids",
+    "loader.node_map",
+    "loader.graph_arrays"
+};
+
+void pcst_mem_set(pcst_mem_tracker *tracker, pcst_mem_entry entry, Size bytes) {
+    tracker->current_bytes[entry] = bytes;
+    if (bytes > tracker->peak_bytes[entry])
+        tracker->peak_bytes[entry] = bytes;
+}
+
+void pcst_mem_add(pcst_mem_tracker *tracker, pcst_mem_entry entry, Size bytes) {
+    pcst_mem_set(tracker, entry, tracker->current_bytes[entry] + bytes);
+}
+
+/* Bytes held by an SPI result: the tuple pointer array plus the tuples */
+static Size tuptable_bytes(SPITupleTable *tuptable, uint64 ntuples) {
+    Size bytes = ntuples * sizeof(HeapTuple);
+    for (uint64 i = 0; i < ntuples; i++)
+        bytes += HEAPTUPLESIZE + tuptable->vals[i]->t_len;
+    return bytes;
+}
+
+/* Hash table entry structure for node ID mapping (using text pointer keys) */
+typedef struct {
+    text *node_id;  // Key (pointer to text)
+    int index;      // Value
+} node_map_entry;
+
+/* Approximate size of the node map: one element header + entry per node */
+static Size node_map_bytes(HTAB *node_map) {
+    return hash_get_num_entries(node_map)
+           * (MAXALIGN(sizeof(HASHELEMENT)) + MAXALIGN(sizeof(node_map_entry)));
+}
+
+/* Forward declaration */
+static int text_cmp(const text *t1, const text *t2);
+
+/* Hash function for text pointer keys - hashes the text content */
+static uint32 node_id_hash(const void *key, Size keysize) {
+    const text **tkey_ptr = (const text **) key;
+    const text *tkey = *tkey_ptr;
+    // Simple hash function: djb2 algorithm
+    const unsigned char *data = (const unsigned char *) VARDATA(tkey);
+    int len = VARSIZE(tkey) - VARHDRSZ;
+    uint32 hash = 5381;
+    for (int i = 0; i < len; i++) {
+        hash = ((hash << 5) + hash) + data[i]; /* hash * 33 + c */
+    }
+    return hash;
+}
+
+/* Match function for text pointer keys - compares text content */
+static int node_id_match(const void *key1, const void *key2, Size keysize) {
+    const text **k1_ptr = (const text **) key1;
+    const text **k2_ptr = (const text **) key2;
+    const text *k1 = *k1_ptr;
+    const text *k2 = *k2_ptr;
+    return (text_cmp(k1, k2) == 0) ? 0 : 1;
+}
+
+/* Helper function to compare two text values */
+static int text_cmp(const text *t1, const text *t2) {
+    int len1 = VARSIZE(t1) - VARHDRSZ;
+    int len2 = VARSIZE(t2) - VARHDRSZ;
+    int minlen = (len1 < len2) ? len1 : len2;
+    int cmp = memcmp(VARDATA(t1), VARDATA(t2), minlen);
+    if (cmp != 0)
+        return cmp;
+    return len1 - len2;
+}
+
+/* Helper function to convert any Datum to text */
+/* Always returns a text value allocated in the current memory context */
+static text *datum_to_text(Datum value, Oid type) {
+    if (type == TEXTOID) {
+        // For text type, we need to make a copy to ensure it's in the current memory context
+        text *input_text = DatumGetTextP(value);
+        int len = VARSIZE(input_text);
+        text *result = (text *) palloc(len);
+        memcpy(result, input_text, len);
+        return result;
+    } else {
+        // Use the type's output function to get a string, then convert to text
+        Oid output_func;
+        bool isvarlena;
+        getTypeOutputInfo(type, &output_func, &isvarlena);
+        char *str = OidOutputFunctionCall(output_func, value);
+        text *result = cstring_to_text(str);
+        pfree(str);
+        return result;
+    }
+}
+
+/* Helper function to find or add node ID to mapping using hash table */
+static int get_node_index(pcst_graph *graph, text *node_id, int verbosity) {
+    bool found;
+    node_map_entry *entry;
+    int node_id_len = VARSIZE(node_id);
+
+    // Make a copy of the node_id text for storage
+    text *node_id_copy = (text *) palloc(node_id_len);
+    memcpy(node_id_copy, node_id, node_id_len);
+
+    // Search for existing entry using the text pointer as key
+    entry = (node_map_entry *) hash_search(graph->node_map, &node_id_copy, HASH_ENTER, &found);
+
+    if (!found) {
+        // New entry - set the index
+        int new_index = graph->num_nodes++;
+        entry->node_id = node_id_copy;  // Store the copy
+        entry->index = new_index;
+
+        // Reallocate index_to_node_id array if needed
+        graph->index_to_node_id = (text **) repalloc(graph->index_to_node_id,
+                                                     graph->num_nodes * sizeof(text *));
+        graph->index_to_node_id[new_index] = node_id_copy;
+        pcst_mem_add(&graph->mem, PCST_MEM_NODE_IDS, sizeof(text *) + node_id_len);
+
+        if (verbosity > 1) {
+            char *node_id_str = text_to_cstring(node_id_copy);
+            elog(INFO, "get_node_index: NEW node_id=%s -> index=%d", node_id_str, new_index);
+            pfree(node_id_str);
+        }
+    } else {
+        // Entry already exists, free the copy we made
+        pfree(node_id_copy);
+        if (verbosity > 1) {
+            char *node_id_str = text_to_cstring(entry->node_id);
+            elog(INFO, "get_node_index: FOUND node_id=%s -> index=%d", node_id_str, entry->index);
+            pfree(node_id_str);
+        }
+    }
+
+    return entry->index;
+}
+
+static const char hex_digits[] = "0123456789abcdef";
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    return -1;  // Upper case would not round-trip, so it is not accepted
+}
+
+/* Parse 32 lowercase hex digits, optionally with uuid dashes, into a key */
+static bool parse_hex_digits(const char *str, int len, bool dashed, pcst_node_key *key) {
+    int pos = 0;
+
+    if (len != (dashed ? 36 : 32))
+        return false;
+    for (int i = 0; i < 16; i++) {
+        if (dashed && (pos == 8 || pos == 13 || pos == 18 || pos == 23)) {
+            if (str[pos] != '-')
+                return false;
+            pos++;
+        }
+        int hi = hex_value(str[pos]);
+        int lo = hex_value(str[pos + 1]);
+        if (hi < 0 || lo < 0)
+            return false;
+        key->data[i] = (uint8) ((hi << 4) | lo);
+        pos += 2;
+    }
+    return true;
+}
+
+/* Render a key exactly as the original ID was spelled; buf needs 37 bytes */
+static void format_node_key(pcst_node_key_kind kind, const pcst_node_key *key, char *buf) {
+    char *out = buf;
+    for (int i = 0; i < 16; i++) {
+        if (kind == PCST_NODE_KEY_UUID && (i == 4 || i == 6 || i == 8 || i == 10))
+            *out++ = '-';
+        *out++ = hex_digits[key->data[i] >> 4];
+        *out++ = hex_digits[key->data[i] & 0x0f];
+    }
+    *out = '\0';
+}
+
+/* Convert an ID datum into a binary key of the given kind; false if it does not fit */
+static bool datum_to_node_key(pcst_node_key_kind kind, Datum value, Oid type, pcst_node_key *key) {
+    bool ok;
+
+    if (type == UUIDOID) {
+        if (kind != PCST_NODE_KEY_UUID)
+            return false;
+        memcpy(key->data, DatumGetUUIDP(value)->data, UUID_LEN);
+        return true;
+    }
+    if (type == TEXTOID || type == VARCHAROID) {
+        // Parse straight from the (possibly short-header) varlena, no copy
+        text *t = DatumGetTextPP(value);
+        ok = parse_hex_digits(VARDATA_ANY(t), VARSIZE_ANY_EXHDR(t),
+                              kind == PCST_NODE_KEY_UUID, key);
+        if ((Pointer) t != DatumGetPointer(value))
+            pfree(t);
+        return ok;
+    }
+    if (kind == PCST_NODE_KEY_TEXT)
+        return false;
+
+    // Other types (e.g. an integer prize ID against uuid edges): compare the text form
+    Oid output_func;
+    bool isvarlena;
+    getTypeOutputInfo(type, &output_func, &isvarlena);
+    char *str = OidOutputFunctionCall(output_func, value);
+    ok = parse_hex_digits(str, strlen(str), kind == PCST_NODE_KEY_UUID, key);
+    pfree(str);
+    return ok;
+}
+
+/* Pick the key kind from the first node ID of the edges query */
+static pcst_node_key_kind detect_node_key_kind(Datum value, Oid type) {
+    pcst_node_key key;
+
+    if (type == UUIDOID)
+        return PCST_NODE_KEY_UUID;
+    if (type != TEXTOID && type != VARCHAROID)
+        return PCST_NODE_KEY_TEXT;
+    if (datum_to_node_key(PCST_NODE_KEY_HEX, value, type, &key))
+        return PCST_NODE_KEY_HEX;
+    if (datum_to_node_key(PCST_NODE_KEY_UUID, value, type, &key))
+        return PCST_NODE_KEY_UUID;
+    return PCST_NODE_KEY_TEXT;
+}
+
+/* 64-bit mix of both key halves; hex IDs often share long prefixes */
+static uint32 node_key_hash(const pcst_node_key *key) {
+    uint64 lo, hi;
+    memcpy(&lo, key->data, sizeof(uint64));
+    memcpy(&hi, key->data + 8, sizeof(uint64));
+    uint64 h = lo ^ (hi * UINT64CONST(0x9E3779B97F4A7C15));
+    h ^= h >> 33;
+    h *= UINT64CONST(0xFF51AFD7ED558CCD);
+    h ^= h >> 33;
+    h *= UINT64CONST(0xC4CEB9FE1A85EC53);
+    h ^= h >> 33;
+    return (uint32) h;
+}
+
+/* Slot holding key, or the empty slot where it would go */
+static int find_key_slot(const pcst_graph *graph, const pcst_node_key *key) {
+    uint32 mask = graph->num_key_slots - 1;
+    uint32 slot = node_key_hash(key) & mask;
+    while (graph->key_slots[slot] >= 0
+           && memcmp(graph->node_keys[graph->key_slots[slot]].data, key->data, 16) != 0)
+        slot = (slot + 1) & mask;
+    return slot;
+}
+
+static void resize_key_slots(pcst_graph *graph, int num_slots) {
+    if (graph->key_slots)
+        pfree(graph->key_slots);
+    graph->num_key_slots = num_slots;
+    graph->key_slots = (int *) palloc(num_slots * sizeof(int));
+    memset(graph->key_slots, 0xff, num_slots * sizeof(int));  // all -1
+    for (int i = 0; i < graph->num_nodes; i++)
+        graph->key_slots[find_key_slot(graph, &graph->node_keys[i])] = i;
+    pcst_mem_set(&graph->mem, PCST_MEM_NODE_MAP, num_slots * sizeof(int));
+}
+
+/* Find or add a binary node key */
+static int get_node_key_index(pcst_graph *graph, const pcst_node_key *key, int verbosity) {
+    if (2 * (graph->num_nodes + 1) > graph->num_key_slots)
+        resize_key_slots(graph, 2 * graph->num_key_slots);
+
+    int slot = find_key_slot(graph, key);
+    int index = graph->key_slots[slot];
+    bool found = (index >= 0);
+
+    if (!found) {
+        if (graph->num_nodes == graph->node_keys_capacity) {
+            graph->node_keys_capacity *= 2;
+            graph->node_keys = (pcst_node_key *) repalloc(graph->node_keys,
+                                                          graph->node_keys_capacity * sizeof(pcst_node_key));
+            pcst_mem_set(&graph->mem, PCST_MEM_NODE_IDS,
+                         graph->node_keys_capacity * sizeof(pcst_node_key));
+        }
+        index = graph->num_nodes++;
+        graph->node_keys[index] = *key;
+        graph->key_slots[slot] = index;
+    }
+
+    if (verbosity > 1) {
+        char buf[37];
+        format_node_key(graph->key_kind, key, buf);
+        elog(INFO, "get_node_index: %s node_id=%s -> index=%d", found ? "FOUND" : "NEW", buf, index);
+    }
+    return index;
+}
+
+/*
+ * An ID did not fit the binary key kind: re-key every node seen so far as
+ * text, keeping the internal indices, and continue with the text hash map.
+ */
+static void switch_to_text_keys(pcst_graph *graph, int verbosity) {
+    HASHCTL hash_ctl;
+    int num_nodes = graph->num_nodes;
+
+    if (verbosity > 0)
+        elog(INFO, "pcst_loader: node IDs are not uniformly uuid/hex, switching to text keys after %d nodes",
+             num_nodes);
+
+    memset(&hash_ctl, 0, sizeof(hash_ctl));
+    hash_ctl.keysize = sizeof(text *);  // Key is a pointer to text
+    hash_ctl.entrysize = sizeof(node_map_entry);  // Entry contains node_id (text*) and index
+    hash_ctl.hash = node_id_hash;
+    hash_ctl.match = node_id_match;
+    hash_ctl.hcxt = CurrentMemoryContext;
+    graph->node_map = hash_create("node_id_map", Max(1024, num_nodes), &hash_ctl,
+                                  HASH_ELEM | HASH_FUNCTION | HASH_COMPARE | HASH_CONTEXT);
+    graph->index_to_node_id = (text **) palloc(Max(1024, num_nodes) * sizeof(text *));
+
+    pcst_node_key_kind kind = graph->key_kind;
+    graph->key_kind = PCST_NODE_KEY_TEXT;
+    graph->num_nodes = 0;
+    pcst_mem_set(&graph->mem, PCST_MEM_NODE_IDS, 0);
+    for (int i = 0; i < num_nodes; i++) {
+        char buf[37];
+        format_node_key(kind, &graph->node_keys[i], buf);
+        text *node_id = cstring_to_text(buf);
+        get_node_index(graph, node_id, 0);
+        pfree(node_id);
+    }
+
+    if (graph->node_keys)
+        pfree(graph->node_keys);
+    if (graph->key_slots)
+        pfree(graph->key_slots);
+    graph->node_keys = NULL;
+    graph->key_slots = NULL;
+    graph->num_key_slots = 0;
+    graph->node_keys_capacity = 0;
+}
+
+/* Find the map entry of a node ID, or NULL if the ID does not occur in the edges */
+static node_map_entry *lookup_node_entry(HTAB *node_map, text *node_id) {
+    bool found = false;
+    node_map_entry *entry = NULL;
+    bool hash_seq_initialized = false;
+    HASH_SEQ_STATUS hash_seq;
+
+    // Initialize hash_seq to avoid uninitialized variable issues
+    MemSet(&hash_seq, 0, sizeof(HASH_SEQ_STATUS));
+
+    // First try: use hash_search with the text pointer
+    text *node_id_key = node_id;
+    entry = (node_map_entry *) hash_search(node_map, &node_id_key, HASH_FIND, &found);
+
+    // Fallback: if hash_search fails, manually iterate through hash table
+    // This is slower but more reliable if there's a hash function issue
+    // Use PG_TRY/PG_CATCH to ensure we always terminate the sequence scan
+    if (!found || entry == NULL) {
+        PG_TRY();
+        {
+            node_map_entry *hentry;
+            bool broke_early = false;
+
+            hash_seq_init(&hash_seq, node_map);
+            hash_seq_initialized = true;
+            while ((hentry = (node_map_entry *) hash_seq_search(&hash_seq)) != NULL) {
+                if (hentry->node_id != NULL && text_cmp(hentry->node_id, node_id) == 0) {
+                    entry = hentry;
+                    found = true;
+                    broke_early = true;
+                    break;
+                }
+            }
+            // Only terminate if we broke early - if loop completed normally (returned NULL),
+            // the scan is already terminated by PostgreSQL
+            if (hash_seq_initialized && broke_early) {
+                hash_seq_term(&hash_seq);
+                hash_seq_initialized = false;
+            } else if (hash_seq_initialized) {
+                // Loop completed normally, scan already terminated, just reset flag
+                hash_seq_initialized = false;
+            }
+        }
+        PG_CATCH();
+        {
+            // Always terminate hash sequence scan if we initialized it, even on error
+            if (hash_seq_initialized) {
+                hash_seq_term(&hash_seq);
+                hash_seq_initialized = false;
+            }
+            PG_RE_THROW();
+        }
+        PG_END_TRY();
+    }
+
+    return (found && entry != NULL) ? entry : NULL;
+}
+
+/* Find or add the node with the given ID datum */
+static int intern_node(pcst_graph *graph, Datum value, Oid type, int verbosity) {
+    if (graph->key_kind != PCST_NODE_KEY_TEXT) {
+        pcst_node_key key;
+        if (datum_to_node_key(graph->key_kind, value, type, &key))
+            return get_node_key_index(graph, &key, verbosity);
+        switch_to_text_keys(graph, verbosity);
+    }
+
+    text *node_id_text = datum_to_text(value, type);
+    int index = get_node_index(graph, node_id_text, verbosity);
+    pfree(node_id_text);
+    return index;
+}
+
+/* Internal index of the node with the given ID datum, or -1 if it does not occur in the edges */
+static int find_node(pcst_graph *graph, Datum value, Oid type) {
+    if (graph->key_kind != PCST_NODE_KEY_TEXT) {
+        pcst_node_key key;
+        if (!datum_to_node_key(graph->key_kind, value, type, &key))
+            return -1;  // Every node ID has this kind, so a mismatch cannot be in the graph
+        return graph->key_slots[find_key_slot(graph, &key)];
+    }
+
+    text *node_id_text = datum_to_text(value, type);
+    node_map_entry *entry = lookup_node_entry(graph->node_map, node_id_text);
+    pfree(node_id_text);
+    return entry ? entry->index : -1;
+}
+
+text *pcst_edge_id_text(pcst_graph *graph, int index) {
+    switch (graph->edge_id_kind) {
+        case PCST_EDGE_ID_INT: {
+            char buf[MAXINT8LEN + 1];
+            snprintf(buf, sizeof(buf), INT64_FORMAT, graph->edge_id_ints[index]);
+            return cstring_to_text(buf);
+        }
+        case PCST_EDGE_ID_KEY: {
+            char buf[37];
+            format_node_key(graph->edge_id_key_kind, &graph->edge_id_keys[index], buf);
+            return cstring_to_text(buf);
+        }
+        case PCST_EDGE_ID_TEXT: {
+            text *edge_id = graph->edge_id_texts[index];
+            text *copy = (text *) palloc(VARSIZE(edge_id));
+            memcpy(copy, edge_id, VARSIZE(edge_id));
+            return copy;
+        }
+        default: {
+            bool isnull;
+            int row = graph->edge_rows ? graph->edge_rows[index] : index;
+            Datum id = SPI_getbinval(graph->edge_tuptable->vals[row],
+                                     graph->edge_tuptable->tupdesc, graph->edge_id_column,
+                                     &isnull);
+            return isnull ? NULL : datum_to_text(id, graph->edge_id_type);
+        }
+    }
+}
+
+text *pcst_node_id_text(pcst_graph *graph, int index) {
+    if (graph->sub_edge_parent && index >= graph->num_original_nodes)
+        return NULL;
+    if (graph->key_kind != PCST_NODE_KEY_TEXT) {
+        char buf[37];
+        format_node_key(graph->key_kind, &graph->node_keys[index], buf);
+        return cstring_to_text(buf);
+    }
+    text *node_id = graph->index_to_node_id[index];
+    text *copy = (text *) palloc(VARSIZE(node_id));
+    memcpy(copy, node_id, VARSIZE(node_id));
+    return copy;
+}
+
+/* Original ID of a node as a C string, for log messages */
+static char *node_id_cstring(pcst_graph *graph, int index) {
+    text *node_id = pcst_node_id_text(graph, index);
+    char *str = text_to_cstring(node_id);
+    pfree(node_id);
+    return str;
+}
+
+/* Hand edges [first, end) to the builder, if any */
+static void add_builder_batch(pcst_graph *graph, pcst_builder_t *builder, int first, int end) {
+    if (!builder || end <= first)
+        return;
+    if (!pcst_builder_add_edges(builder, graph->edge_sources + first, graph->edge_targets + first,
+                                graph->edge_costs + first, end - first))
+        ereport(ERROR,
+                (errcode(ERRCODE_OUT_OF_MEMORY),
+                 errmsg("out of memory building the solver input")));
+}
+
+/*
+ * Pick the node key kind from the source ID in column source_column of
+ * tuple and set up an empty node map for it.
+ */
+static void init_node_keys(pcst_graph *graph, HeapTuple tuple, TupleDesc tupdesc,
+                           int source_column, int verbosity) {
+    bool isnull;
+    Datum first_source = SPI_getbinval(tuple, tupdesc, source_column, &isnull);
+
+    graph->key_kind = isnull ? PCST_NODE_KEY_TEXT
+                             : detect_node_key_kind(first_source,
+                                                    SPI_gettypeid(tupdesc, source_column));
+    if (graph->key_kind == PCST_NODE_KEY_TEXT) {
+        switch_to_text_keys(graph, 0);
+    } else {
+        graph->node_keys_capacity = 1024;
+        graph->node_keys = (pcst_node_key *) palloc(graph->node_keys_capacity * sizeof(pcst_node_key));
+        pcst_mem_set(&graph->mem, PCST_MEM_NODE_IDS, graph->node_keys_capacity * sizeof(pcst_node_key));
+        resize_key_slots(graph, 2048);
+    }
+    if (verbosity > 0)
+        elog(INFO, "pcst_loader: interning node IDs as %s keys",
+             graph->key_kind == PCST_NODE_KEY_UUID ? "16-byte uuid" :
+             graph->key_kind == PCST_NODE_KEY_HEX ? "16-byte hex" : "text");
+}
+
+/*
+ * Set up graph for the edges in rows[0..num_edges) of tuptable, or its first
+ * num_edges rows when rows is NULL, with the ID, source, target and cost
+ * columns starting at first_column, and map every endpoint to an internal
+ * node index. The key kinds are picked from the first of these rows.
+ */
+static void load_edge_rows(pcst_graph *graph, SPITupleTable *tuptable, const int *rows,
+                           int num_edges, int first_column, int verbosity,
+                           pcst_builder_t *builder) {
+    TupleDesc edges_tupdesc = tuptable->tupdesc;
+    int first_row = rows ? rows[0] : 0;
+
+    // Allocate arrays
+    graph->num_edges = num_edges;
+    if (builder)
+        pcst_builder_reserve(builder, 0, num_edges);
+    graph->edge_sources = (int *) palloc(num_edges * sizeof(int));  // Internal indices
+    graph->edge_targets = (int *) palloc(num_edges * sizeof(int));   // Internal indices
+    graph->edge_costs = (double *) palloc(num_edges * sizeof(double));
+    pcst_mem_add(&graph->mem, PCST_MEM_GRAPH_ARRAYS,
+                 num_edges * (2 * sizeof(int) + sizeof(double)));
+
+    // Node IDs are interned by key kind; edge IDs are only materialized for
+    // the selected edges, see pcst_edge_id_text
+    Oid edge_id_type = SPI_gettypeid(edges_tupdesc, first_column);
+    Oid source_id_type = SPI_gettypeid(edges_tupdesc, first_column + 1);
+    Oid target_id_type = SPI_gettypeid(edges_tupdesc, first_column + 2);
+
+    graph->edge_id_type = edge_id_type;
+    graph->edge_id_column = first_column;
+    if (edge_id_type == INT2OID || edge_id_type == INT4OID || edge_id_type == INT8OID) {
+        graph->edge_id_kind = PCST_EDGE_ID_INT;
+        graph->edge_id_ints = (int64 *) palloc(num_edges * sizeof(int64));
+        pcst_mem_set(&graph->mem, PCST_MEM_EDGE_IDS, num_edges * sizeof(int64));
+    } else {
+        bool isnull;
+        Datum first_id = SPI_getbinval(tuptable->vals[first_row], edges_tupdesc, first_column,
+                                       &isnull);
+        graph->edge_id_key_kind = isnull ? PCST_NODE_KEY_TEXT
+                                         : detect_node_key_kind(first_id, edge_id_type);
+        if (graph->edge_id_key_kind != PCST_NODE_KEY_TEXT) {
+            graph->edge_id_kind = PCST_EDGE_ID_KEY;
+            graph->edge_id_keys = (pcst_node_key *) palloc(num_edges * sizeof(pcst_node_key));
+            pcst_mem_set(&graph->mem, PCST_MEM_EDGE_IDS, num_edges * sizeof(pcst_node_key));
+        } else {
+            graph->edge_id_kind = PCST_EDGE_ID_ROW;
+        }
+    }
+
+    init_node_keys(graph, tuptable->vals[first_row], edges_tupdesc, first_column + 1, verbosity);
+
+    for (int i = 0; i < num_edges; i++) {
+        HeapTuple tuple = tuptable->vals[rows ? rows[i] : i];
+        bool isnull;
+        Datum edge_id_datum = SPI_getbinval(tuple, edges_tupdesc, first_column, &isnull);
+        Datum source_datum = SPI_getbinval(tuple, edges_tupdesc, first_column + 1, &isnull);
+        Datum target_datum = SPI_getbinval(tuple, edges_tupdesc, first_column + 2, &isnull);
+        Datum cost_datum = SPI_getbinval(tuple, edges_tupdesc, first_column + 3, &isnull);
+
+        if (isnull)
+            ereport(ERROR,
+                    (errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED),
+                     errmsg("edges query cannot return NULL values")));
+
+        double cost = DatumGetFloat8(cost_datum);
+
+        // Keep the edge ID in compact form; row IDs stay in the tuptable
+        if (graph->edge_id_kind == PCST_EDGE_ID_INT) {
+            graph->edge_id_ints[i] = (edge_id_type == INT8OID) ? DatumGetInt64(edge_id_datum) :
+                                     (edge_id_type == INT4OID) ? DatumGetInt32(edge_id_datum) :
+                                     DatumGetInt16(edge_id_datum);
+        } else if (graph->edge_id_kind == PCST_EDGE_ID_KEY
+                   && !datum_to_node_key(graph->edge_id_key_kind, edge_id_datum, edge_id_type,
+                                         &graph->edge_id_keys[i])) {
+            // Not uniformly uuid/hex after all: fall back to the retained rows
+            pfree(graph->edge_id_keys);
+            graph->edge_id_keys = NULL;
+            graph->edge_id_kind = PCST_EDGE_ID_ROW;
+            pcst_mem_set(&graph->mem, PCST_MEM_EDGE_IDS, 0);
+        }
+
+        graph->edge_sources[i] = intern_node(graph, source_datum, source_id_type, verbosity);
+        graph->edge_targets[i] = intern_node(graph, target_datum, target_id_type, verbosity);
+        graph->edge_costs[i] = cost;
+        if ((i + 1) % PCST_BUILDER_BATCH_SIZE == 0)
+            add_builder_batch(graph, builder, i + 1 - PCST_BUILDER_BATCH_SIZE, i + 1);
+
+        // Debug: verify edge ID storage
+        if (verbosity > 1) {
+            text *edge_id_text = datum_to_text(edge_id_datum, edge_id_type);
+            char *edge_id_str = text_to_cstring(edge_id_text);
+            elog(INFO, "pgr_pcst_fast: Loaded edge[%d] id: '%s' (%s)",
+                 i, edge_id_str,
+                 graph->edge_id_kind == PCST_EDGE_ID_INT ? "integer" :
+                 graph->edge_id_kind == PCST_EDGE_ID_KEY ? "16-byte key" : "row");
+            pfree(edge_id_str);
+            pfree(edge_id_text);
+        }
+    }
+
+    add_builder_batch(graph, builder, num_edges - num_edges % PCST_BUILDER_BATCH_SIZE, num_edges);
+
+    if (graph->key_kind == PCST_NODE_KEY_TEXT)
+        pcst_mem_set(&graph->mem, PCST_MEM_NODE_MAP, node_map_bytes(graph->node_map));
+
+    if (graph->edge_id_kind == PCST_EDGE_ID_ROW) {
+        graph->edge_tuptable = tuptable;
+        if (rows) {
+            graph->edge_rows = (int *) palloc(num_edges * sizeof(int));
+            memcpy(graph->edge_rows, rows, num_edges * sizeof(int));
+            pcst_mem_set(&graph->mem, PCST_MEM_EDGE_IDS, num_edges * sizeof(int));
+        }
+    }
+}
+
+/* Run edges_sql and map every endpoint to an internal node index */
+static void load_edges(pcst_graph *graph, const char *edges_sql, int verbosity,
+                       pcst_builder_t *builder) {
+    int ret;
+
+    ret = SPI_execute(edges_sql, true, 0);
+    if (ret != SPI_OK_SELECT)
+        ereport(ERROR,
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                 errmsg("edges query failed: %s", SPI_result_code_string(ret))));
+
+    if (SPI_tuptable == NULL || SPI_processed == 0)
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("edges query returned no rows")));
+
+    // Check tuple descriptor for edges (expect: id, source, target, cost)
+    if (SPI_tuptable->tupdesc->natts < 4)
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("edges query must return at least 4 columns: id, source, target, cost")));
+
+    pcst_mem_set(&graph->mem, PCST_MEM_EDGE_TUPTABLE, tuptable_bytes(SPI_tuptable, SPI_processed));
+
+    load_edge_rows(graph, SPI_tuptable, NULL, SPI_processed, 1, verbosity, builder);
+
+    // With compact edge IDs nothing refers to the result rows any more
+    if (graph->edge_id_kind != PCST_EDGE_ID_ROW) {
+        SPI_freetuptable(SPI_tuptable);
+        pcst_mem_set(&graph->mem, PCST_MEM_EDGE_TUPTABLE, 0);
+    }
+}
+
+/* Run nodes_sql and set the prize of every node that occurs in the edges */
+static void load_prizes(pcst_graph *graph, const char *nodes_sql, int verbosity) {
+    int ret;
+    int num_nodes = graph->num_nodes;
+
+    // Allocate node prizes array (zero-initialized)
+    // All nodes that appear in edges will have prize 0 by default
+    graph->node_prizes = (double *) palloc0(num_nodes * sizeof(double));
+    pcst_mem_add(&graph->mem, PCST_MEM_GRAPH_ARRAYS, num_nodes * sizeof(double));
+
+    // Execute nodes query
+    ret = SPI_execute(nodes_sql, true, 0);
+    if (ret != SPI_OK_SELECT)
+        ereport(ERROR,
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                 errmsg("nodes query failed: %s", SPI_result_code_string(ret))));
+
+    if (SPI_tuptable == NULL || SPI_processed == 0) {
+        // No nodes query results - all prizes remain 0
+        if (verbosity > 0) {
+            elog(WARNING, "pgr_pcst_fast: nodes query returned no results, all node prizes are 0");
+        }
+        return;
+    }
+
+    TupleDesc nodes_tupdesc = SPI_tuptable->tupdesc;
+    if (nodes_tupdesc->natts < 2)
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("nodes query must return at least 2 columns: id, prize")));
+
+    pcst_mem_set(&graph->mem, PCST_MEM_NODE_TUPTABLE, tuptable_bytes(SPI_tuptable, SPI_processed));
+
+    // Process nodes and set prizes
+    // Note: nodes that appear in edges but not in nodes query will have prize 0
+    Oid node_id_type = SPI_gettypeid(nodes_tupdesc, 1);
+
+    if (verbosity > 0) {
+        elog(INFO, "pgr_pcst_fast: Processing %lu nodes from nodes query", (unsigned long) SPI_processed);
+    }
+
+    int nodes_matched = 0;
+    int nodes_not_found = 0;
+
+    for (unsigned long i = 0; i < SPI_processed; i++) {
+        HeapTuple tuple = SPI_tuptable->vals[i];
+        bool isnull;
+        Datum node_id_datum = SPI_getbinval(tuple, nodes_tupdesc, 1, &isnull);
+        Datum prize_datum = SPI_getbinval(tuple, nodes_tupdesc, 2, &isnull);
+
+        if (isnull)
+            continue;  // Skip NULL values
+
+        // The text form is only needed for log messages
+        text *node_id_text = (verbosity > 0) ? datum_to_text(node_id_datum, node_id_type) : NULL;
+        double prize = DatumGetFloat8(prize_datum);
+
+        // Debug: log the node ID we're looking for (first few only)
+        if (verbosity > 0 && i < 5) {
+            char *node_id_str = text_to_cstring(node_id_text);
+            elog(INFO, "pgr_pcst_fast: Looking up node_id='%s' (len=%d, prize=%.2f)",
+                 node_id_str, (int) (VARSIZE(node_id_text) - VARHDRSZ), prize);
+            pfree(node_id_str);
+        }
+
+        // Find node index using the node map
+        int node_index = find_node(graph, node_id_datum, node_id_type);
+
+        // Debug: log lookup result (first few only)
+        if (verbosity > 0 && i < 5) {
+            char *node_id_str = text_to_cstring(node_id_text);
+            if (node_index >= 0) {
+                char *stored_id_str = node_id_cstring(graph, node_index);
+                elog(INFO, "pgr_pcst_fast: Hash lookup FOUND: looking_for='%s', stored='%s', index=%d",
+                     node_id_str, stored_id_str, node_index);
+                pfree(stored_id_str);
+            } else {
+                elog(INFO, "pgr_pcst_fast: Hash lookup NOT FOUND: node_id='%s'", node_id_str);
+            }
+            pfree(node_id_str);
+        }
+
+        if (node_index >= 0) {
+            if (node_index >= 0 && node_index < num_nodes) {
+                graph->node_prizes[node_index] = prize;
+                nodes_matched++;
+                if (verbosity > 0 && i < 10) {  // Only log first 10 for large datasets
+                    char *node_id_str = text_to_cstring(node_id_text);
+                    elog(INFO, "pgr_pcst_fast: Setting prize for node_id=%s (index=%d) to %.2f",
+                         node_id_str, node_index, prize);
+                    pfree(node_id_str);
+                }
+            } else {
+                if (verbosity > 0) {
+                    char *node_id_str = text_to_cstring(node_id_text);
+                    elog(WARNING, "pgr_pcst_fast: node_id=%s mapped to invalid index %d (num_nodes=%d)",
+                         node_id_str, node_index, num_nodes);
+                    pfree(node_id_str);
+                }
+            }
+        } else {
+            // Node in nodes query but not in edges
+            nodes_not_found++;
+
+            // Store up to 10 missing node IDs to avoid excessive log output
+            if (nodes_not_found <= 10) {
+                if (verbosity > 0) {
+                    char *node_id_str = text_to_cstring(node_id_text);
+                    elog(WARNING, "pgr_pcst_fast: Prize node '%s' (prize=%.2f) not found in edges query - will be skipped",
+                         node_id_str, prize);
+                    pfree(node_id_str);
+                }
+            } else if (nodes_not_found == 11) {
+                if (verbosity > 0) {
+                    elog(WARNING, "pgr_pcst_fast: Additional prize nodes not found in edges (suppressing further warnings)");
+                }
+            }
+        }
+
+        // Free the temporary node_id_text (it was created by datum_to_text)
+        if (node_id_text)
+            pfree(node_id_text);
+    }
+
+    // Prizes are copied out, the rows are no longer needed during the solve
+    SPI_freetuptable(SPI_tuptable);
+    pcst_mem_set(&graph->mem, PCST_MEM_NODE_TUPTABLE, 0);
+
+    // Summary of node matching (only if verbosity > 0)
+    if (verbosity > 0) {
+        elog(INFO, "pgr_pcst_fast: Nodes query summary: %lu rows processed, %d matched, %d not found in edges",
+             (unsigned long) SPI_processed, nodes_matched, nodes_not_found);
+        if (nodes_not_found > 0) {
+            elog(WARNING, "pgr_pcst_fast: %d prize node(s) from nodes query were not found in edges query and will be ignored",
+                 nodes_not_found);
+        }
+    }
+
+    // Debug: Log node prizes with better visibility
+    if (verbosity > 0) {
+        elog(INFO, "pgr_pcst_fast: Total nodes processed: %d", num_nodes);
+
+        // Count nodes with prizes > 0
+        int nodes_with_prizes = 0;
+        double total_prize_sum = 0.0;
+        double max_prize = 0.0;
+        int max_prize_index = -1;
+
+        for (int i = 0; i < num_nodes; i++) {
+            if (graph->node_prizes[i] > 0.0) {
+                nodes_with_prizes++;
+                total_prize_sum += graph->node_prizes[i];
+                if (graph->node_prizes[i] > max_prize) {
+                    max_prize = graph->node_prizes[i];
+                    max_prize_index = i;
+                }
+            }
+        }
+
+        elog(INFO, "pgr_pcst_fast: Prize statistics: %d nodes with prizes > 0, total prize sum=%.2f, max prize=%.2f",
+             nodes_with_prizes, total_prize_sum, max_prize);
+
+        // Show first 10 nodes (always)
+        elog(INFO, "pgr_pcst_fast: First 10 nodes:");
+        for (int i = 0; i < num_nodes && i < 10; i++) {
+            char *node_id_str = node_id_cstring(graph, i);
+            elog(INFO, "pgr_pcst_fast:   node[%d] (id=%s) prize=%.2f",
+                 i, node_id_str, graph->node_prizes[i]);
+            pfree(node_id_str);
+        }
+
+        // Show nodes with prizes > 0 (up to 20)
+        if (nodes_with_prizes > 0) {
+            elog(INFO, "pgr_pcst_fast: Nodes with prizes > 0 (showing up to 20):");
+            int shown = 0;
+            for (int i = 0; i < num_nodes && shown < 20; i++) {
+                if (graph->node_prizes[i] > 0.0) {
+                    char *node_id_str = node_id_cstring(graph, i);
+                    elog(INFO, "pgr_pcst_fast:   node[%d] (id=%s) prize=%.2f",
+                         i, node_id_str, graph->node_prizes[i]);
+                    pfree(node_id_str);
+                    shown++;
+                }
+            }
+            if (nodes_with_prizes > 20) {
+                elog(INFO, "pgr_pcst_fast:   ... and %d more nodes with prizes > 0", nodes_with_prizes - 20);
+            }
+        } else {
+            elog(WARNING, "pgr_pcst_fast: WARNING - No nodes have prizes > 0! All prizes are 0.00");
+        }
+
+        // Show the node with maximum prize
+        if (max_prize_index >= 0) {
+            char *max_prize_id_str = node_id_cstring(graph, max_prize_index);
+            elog(INFO, "pgr_pcst_fast: Node with maximum prize: node[%d] (id=%s) prize=%.2f",
+                 max_prize_index, max_prize_id_str, max_prize);
+            pfree(max_prize_id_str);
+        }
+    }
+}
+
+void pcst_load_graph(pcst_graph *graph, const char *edges_sql,
+                     const char *nodes_sql, int verbosity) {
+    pcst_load_graph_with_builder(graph, edges_sql, nodes_sql, verbosity, NULL);
+}
+
+/*
+ * Internal index of the node with the given ID datum, or -1, like find_node
+ * but without an allocation per call: text keys are assembled in key_buf,
+ * integers formatted the way their output functions do, and a miss in the
+ * hash table is final.
+ */
+static int probe_node(pcst_graph *graph, Datum value, Oid type, StringInfo key_buf) {
+    if (graph->key_kind != PCST_NODE_KEY_TEXT) {
+        pcst_node_key key;
+        if (!datum_to_node_key(graph->key_kind, value, type, &key))
+            return -1;
+        return graph->key_slots[find_key_slot(graph, &key)];
+    }
+
+    resetStringInfo(key_buf);
+    appendStringInfoSpaces(key_buf, VARHDRSZ);
+    if (type == INT2OID || type == INT4OID || type == INT8OID) {
+        char buf[MAXINT8LEN + 1];
+        int64 id = (type == INT8OID) ? DatumGetInt64(value) :
+                   (type == INT4OID) ? DatumGetInt32(value) : DatumGetInt16(value);
+        pg_lltoa(id, buf);
+        appendStringInfoString(key_buf, buf);
+    } else if (type == TEXTOID || type == VARCHAROID) {
+        text *t = DatumGetTextPP(value);
+        appendBinaryStringInfo(key_buf, VARDATA_ANY(t), VARSIZE_ANY_EXHDR(t));
+        if ((Pointer) t != DatumGetPointer(value))
+            pfree(t);
+    } else {
+        text *t = datum_to_text(value, type);
+        appendBinaryStringInfo(key_buf, VARDATA(t), VARSIZE(t) - VARHDRSZ);
+        pfree(t);
+    }
+    SET_VARSIZE(key_buf->data, key_buf->len);
+
+    text *key = (text *) key_buf->data;
+    bool found;
+    node_map_entry *entry = (node_map_entry *) hash_search(graph->node_map, &key, HASH_FIND, &found);
+    return found ? entry->index : -1;
+}
+
+/* Set the prize of every node of node_ids that occurs in the edges, in one pass over the arrays */
+static void load_prize_arrays(pcst_graph *graph, ArrayType *node_ids, ArrayType *prizes,
+                              int verbosity) {
+    int num_nodes = graph->num_nodes;
+
+    graph->node_prizes = (double *) palloc0(num_nodes * sizeof(double));
+    pcst_mem_add(&graph->mem, PCST_MEM_GRAPH_ARRAYS, num_nodes * sizeof(double));
+
+    if (node_ids == NULL || prizes == NULL) {
+        if (verbosity > 0)
+            elog(WARNING, "pgr_pcst_fast: no node_ids or prizes given, all node prizes are 0");
+        return;
+    }
+    if (ARR_NDIM(node_ids) > 1 || ARR_NDIM(prizes) > 1)
+        ereport(ERROR,
+                (errcode(ERRCODE_ARRAY_SUBSCRIPT_ERROR),
+                 errmsg("node_ids and prizes must be one-dimensional arrays")));
+
+    Oid id_type = ARR_ELEMTYPE(node_ids);
+    int16 id_typlen;
+    bool id_typbyval;
+    char id_typalign;
+    Datum *ids;
+    bool *id_nulls;
+    Datum *prize_values;
+    bool *prize_nulls;
+    int num_ids;
+    int num_prizes;
+
+    get_typlenbyvalalign(id_type, &id_typlen, &id_typbyval, &id_typalign);
+    deconstruct_array(node_ids, id_type, id_typlen, id_typbyval, id_typalign,
+                      &ids, &id_nulls, &num_ids);
+    deconstruct_array(prizes, FLOAT8OID, sizeof(float8), FLOAT8PASSBYVAL, TYPALIGN_DOUBLE,
+                      &prize_values, &prize_nulls, &num_prizes);
+    if (num_ids != num_prizes)
+        ereport(ERROR,
+                (errcode(ERRCODE_ARRAY_SUBSCRIPT_ERROR),
+                 errmsg("node_ids and prizes must have the same length, got %d and %d",
+                        num_ids, num_prizes)));
+
+    StringInfoData key_buf;
+    int nodes_not_found = 0;
+    initStringInfo(&key_buf);
+    for (int i = 0; i < num_ids; i++) {
+        if (id_nulls[i] || prize_nulls[i])
+            continue;  // Skip NULL values
+        int node_index = probe_node(graph, ids[i], id_type, &key_buf);
+        if (node_index >= 0)
+            graph->node_prizes[node_index] = DatumGetFloat8(prize_values[i]);
+        else
+            nodes_not_found++;
+    }
+    pfree(key_buf.data);
+    pfree(ids);
+    pfree(id_nulls);
+    pfree(prize_values);
+    pfree(prize_nulls);
+
+    if (verbosity > 0) {
+        elog(INFO, "pgr_pcst_fast: Prize arrays summary: %d entries, %d not found in edges",
+             num_ids, nodes_not_found);
+        if (nodes_not_found > 0)
+            elog(WARNING, "pgr_pcst_fast: %d node ID(s) from node_ids were not found in edges query and will be ignored",
+                 nodes_not_found);
+    }
+}
+
+/* Common end of loading: mark the graph as unsplit and hand the prizes to the builder */
+static void finish_loading(pcst_graph *graph, pcst_builder_t *builder) {
+    graph->num_original_nodes = graph->num_nodes;
+    graph->num_original_edges = graph->num_edges;
+
+    if (builder && !pcst_builder_set_prizes(builder, graph->node_prizes, graph->num_nodes))
+        ereport(ERROR,
+                (errcode(ERRCODE_OUT_OF_MEMORY),
+                 errmsg("out of memory building the solver input")));
+}
+
+void pcst_load_graph_with_builder(pcst_graph *graph, const char *edges_sql,
+                                  const char *nodes_sql, int verbosity,
+                                  pcst_builder_t *builder) {
+    memset(graph, 0, sizeof(pcst_graph));
+
+    // The node map is set up by load_edges once the ID kind is known
+    load_edges(graph, edges_sql, verbosity, builder);
+    load_prizes(graph, nodes_sql, verbosity);
+    finish_loading(graph, builder);
+}
+
+void pcst_load_graph_with_prize_arrays(pcst_graph *graph, const char *edges_sql,
+                                       ArrayType *node_ids, ArrayType *prizes,
+                                       int verbosity, pcst_builder_t *builder) {
+    memset(graph, 0, sizeof(pcst_graph));
+
+    load_edges(graph, edges_sql, verbosity, builder);
+    load_prize_arrays(graph, node_ids, prizes, verbosity);
+    finish_loading(graph, builder);
+}
+
+/* Index of a group ID, adding the group when add is set; -1 if absent */
+static int find_group(HTAB *group_map, pcst_graph_groups *groups, int *max_groups,
+                      Datum value, Oid type, bool add) {
+    text *group_id = datum_to_text(value, type);
+    bool found;
+    node_map_entry *entry = (node_map_entry *) hash_search(group_map, &group_id,
+                                                           add ? HASH_ENTER : HASH_FIND, &found);
+
+    if (found || !add) {
+        pfree(group_id);
+        return found ? entry->index : -1;
+    }
+    if (groups->num_groups == *max_groups) {
+        *max_groups *= 2;
+        groups->group_ids = (text **) repalloc(groups->group_ids, *max_groups * sizeof(text *));
+    }
+    entry->node_id = group_id;
+    entry->index = groups->num_groups;
+    groups->group_ids[groups->num_groups++] = group_id;
+    return entry->index;
+}
+
+void pcst_load_graph_groups(pcst_graph_groups *groups, const char *edges_sql,
+                            const char *nodes_sql, int verbosity) {
+    HASHCTL hash_ctl;
+    HTAB *group_map;
+    int max_groups = 64;
+    bool keep_rows = false;
+    int ret;
+
+    memset(groups, 0, sizeof(pcst_graph_groups));
+
+    ret = SPI_execute(edges_sql, true, 0);
+    if (ret != SPI_OK_SELECT)
+        ereport(ERROR,
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                 errmsg("edges query failed: %s", SPI_result_code_string(ret))));
+    if (SPI_tuptable == NULL || SPI_processed == 0)
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("edges query returned no rows")));
+    if (SPI_tuptable->tupdesc->natts < 5)
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("edges query must return at least 5 columns: group_id, id, source, target, cost")));
+
+    SPITupleTable *edge_tuptable = SPI_tuptable;
+    TupleDesc edges_tupdesc = edge_tuptable->tupdesc;
+    int num_rows = SPI_processed;
+    Oid group_id_type = SPI_gettypeid(edges_tupdesc, 1);
+
+    MemSet(&hash_ctl, 0, sizeof(hash_ctl));
+    hash_ctl.keysize = sizeof(text *);
+    hash_ctl.entrysize = sizeof(node_map_entry);
+    hash_ctl.hash = node_id_hash;
+    hash_ctl.match = node_id_match;
+    hash_ctl.hcxt = CurrentMemoryContext;
+    group_map = hash_create("group_id_map", max_groups, &hash_ctl,
+                            HASH_ELEM | HASH_FUNCTION | HASH_COMPARE | HASH_CONTEXT);
+    groups->group_ids = (text **) palloc(max_groups * sizeof(text *));
+
+    // Partition the rows by group, keeping their order within each group
+    int *row_groups = (int *) palloc(num_rows * sizeof(int));
+    for (int i = 0; i < num_rows; i++) {
+        bool isnull;
+        Datum group_datum = SPI_getbinval(edge_tuptable->vals[i], edges_tupdesc, 1, &isnull);
+        if (isnull)
+            ereport(ERROR,
+                    (errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED),
+                     errmsg("edges query cannot return NULL values")));
+        row_groups[i] = find_group(group_map, groups, &max_groups, group_datum, group_id_type, true);
+    }
+
+    int num_groups = groups->num_groups;
+    int *group_starts = (int *) palloc0((num_groups + 1) * sizeof(int));
+    int *group_ends = (int *) palloc(num_groups * sizeof(int));
+    int *group_rows = (int *) palloc(num_rows * sizeof(int));
+    for (int i = 0; i < num_rows; i++)
+        group_starts[row_groups[i] + 1]++;
+    for (int g = 0; g < num_groups; g++)
+        group_starts[g + 1] += group_starts[g];
+    memcpy(group_ends, group_starts, num_groups * sizeof(int));
+    for (int i = 0; i < num_rows; i++)
+        group_rows[group_ends[row_groups[i]]++] = i;
+
+    groups->graphs = (pcst_graph *) palloc0(num_groups * sizeof(pcst_graph));
+    for (int g = 0; g < num_groups; g++) {
+        pcst_graph *graph = &groups->graphs[g];
+        load_edge_rows(graph, edge_tuptable, group_rows + group_starts[g],
+                       group_starts[g + 1] - group_starts[g], 2, verbosity, NULL);
+        graph->node_prizes = (double *) palloc0(graph->num_nodes * sizeof(double));
+        pcst_mem_add(&graph->mem, PCST_MEM_GRAPH_ARRAYS, graph->num_nodes * sizeof(double));
+        graph->num_original_nodes = graph->num_nodes;
+        graph->num_original_edges = graph->num_edges;
+        keep_rows |= graph->edge_id_kind == PCST_EDGE_ID_ROW;
+    }
+    if (!keep_rows)
+        SPI_freetuptable(edge_tuptable);
+    pfree(row_groups);
+    pfree(group_starts);
+    pfree(group_ends);
+    pfree(group_rows);
+
+    if (verbosity > 0)
+        elog(INFO, "pgr_pcst_fast_grouped: %d edges in %d groups", num_rows, num_groups);
+
+    ret = SPI_execute(nodes_sql, true, 0);
+    if (ret != SPI_OK_SELECT)
+        ereport(ERROR,
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                 errmsg("nodes query failed: %s", SPI_result_code_string(ret))));
+    if (SPI_tuptable == NULL || SPI_processed == 0) {
+        if (verbosity > 0)
+            elog(WARNING, "pgr_pcst_fast_grouped: nodes query returned no results, all node prizes are 0");
+        hash_destroy(group_map);
+        return;
+    }
+    if (SPI_tuptable->tupdesc->natts < 3)
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("nodes query must return at least 3 columns: group_id, id, prize")));
+
+    TupleDesc nodes_tupdesc = SPI_tuptable->tupdesc;
+    Oid node_group_type = SPI_gettypeid(nodes_tupdesc, 1);
+    Oid node_id_type = SPI_gettypeid(nodes_tupdesc, 2);
+    int nodes_not_found = 0;
+
+    for (uint64 i = 0; i < SPI_processed; i++) {
+        HeapTuple tuple = SPI_tuptable->vals[i];
+        bool isnull[3];
+        Datum group_datum = SPI_getbinval(tuple, nodes_tupdesc, 1, &isnull[0]);
+        Datum node_id_datum = SPI_getbinval(tuple, nodes_tupdesc, 2, &isnull[1]);
+        Datum prize_datum = SPI_getbinval(tuple, nodes_tupdesc, 3, &isnull[2]);
+
+        if (isnull[0] || isnull[1] || isnull[2])
+            continue;  // Skip NULL values
+
+        int g = find_group(group_map, groups, &max_groups, group_datum, node_group_type, false);
+        int node_index = (g >= 0) ? find_node(&groups->graphs[g], node_id_datum, node_id_type) : -1;
+        if (node_index >= 0)
+            groups->graphs[g].node_prizes[node_index] = DatumGetFloat8(prize_datum);
+        else
+            nodes_not_found++;
+    }
+
+    SPI_freetuptable(SPI_tuptable);
+    hash_destroy(group_map);
+
+    if (verbosity > 0 && nodes_not_found > 0)
+        elog(WARNING, "pgr_pcst_fast_grouped: %d prize node(s) from nodes query were not found in the edges of their group and will be ignored",
+             nodes_not_found);
+}
+
+/* Prize of a node not read yet, by ID text, for pcst_load_frontier_around */
+typedef struct {
+    text *node_id;  // Key (pointer to text)
+    double prize;
+} frontier_prize_entry;
+
+/* Grow the node arrays of a frontier graph to cover every interned node */
+static void reserve_frontier_nodes(pcst_frontier_graph *frontier) {
+    pcst_graph *graph = &frontier->graph;
+    int old_capacity = frontier->nodes_capacity;
+    int capacity = old_capacity;
+
+    if (graph->num_nodes <= capacity)
+        return;
+    while (capacity < graph->num_nodes)
+        capacity = capacity > 0 ? 2 * capacity : 1024;
+    if (old_capacity == 0) {
+        graph->node_prizes = (double *) palloc0(capacity * sizeof(double));
+        frontier->expanded = (bool *) palloc0(capacity * sizeof(bool));
+    } else {
+        graph->node_prizes = (double *) repalloc(graph->node_prizes, capacity * sizeof(double));
+        frontier->expanded = (bool *) repalloc(frontier->expanded, capacity * sizeof(bool));
+        memset(graph->node_prizes + old_capacity, 0, (capacity - old_capacity) * sizeof(double));
+        memset(frontier->expanded + old_capacity, 0, (capacity - old_capacity) * sizeof(bool));
+    }
+    frontier->nodes_capacity = capacity;
+    pcst_mem_add(&graph->mem, PCST_MEM_GRAPH_ARRAYS,
+                 (capacity - old_capacity) * (sizeof(double) + sizeof(bool)));
+}
+
+/* Make room for one more edge of a frontier graph */
+static void reserve_frontier_edge(pcst_frontier_graph *frontier) {
+    pcst_graph *graph = &frontier->graph;
+    int old_capacity = frontier->edges_capacity;
+    int capacity;
+
+    if (graph->num_edges < old_capacity)
+        return;
+    capacity = old_capacity > 0 ? 2 * old_capacity : 1024;
+    if (old_capacity == 0) {
+        graph->edge_sources = (int *) palloc(capacity * sizeof(int));
+        graph->edge_targets = (int *) palloc(capacity * sizeof(int));
+        graph->edge_costs = (double *) palloc(capacity * sizeof(double));
+    } else {
+        graph->edge_sources = (int *) repalloc(graph->edge_sources, capacity * sizeof(int));
+        graph->edge_targets = (int *) repalloc(graph->edge_targets, capacity * sizeof(int));
+        graph->edge_costs = (double *) repalloc(graph->edge_costs, capacity * sizeof(double));
+    }
+    pcst_mem_add(&graph->mem, PCST_MEM_GRAPH_ARRAYS,
+                 (capacity - old_capacity) * (2 * sizeof(int) + sizeof(double)));
+
+    if (graph->edge_id_kind == PCST_EDGE_ID_INT) {
+        graph->edge_id_ints = (int64 *) (old_capacity == 0
+                                         ? palloc(capacity * sizeof(int64))
+                                         : repalloc(graph->edge_id_ints, capacity * sizeof(int64)));
+        pcst_mem_add(&graph->mem, PCST_MEM_EDGE_IDS, (capacity - old_capacity) * sizeof(int64));
+    } else {
+        graph->edge_id_texts = (text **) (old_capacity == 0
+                                          ? palloc(capacity * sizeof(text *))
+                                          : repalloc(graph->edge_id_texts, capacity * sizeof(text *)));
+        pcst_mem_add(&graph->mem, PCST_MEM_EDGE_IDS, (capacity - old_capacity) * sizeof(text *));
+    }
+    frontier->edges_capacity = capacity;
+}
+
+/*
+ * Run edges_sql for the node IDs ids[0..num_ids) and append the edges read
+ * for the first time. An edge at a node expanded before this run was read
+ * from that node already; nodes interned by this run cannot have been. The
+ * caller marks the nodes as expanded afterwards.
+ */
+static void fetch_frontier_edges(pcst_frontier_graph *frontier, Datum *ids, int num_ids,
+                                 int verbosity) {
+    pcst_graph *graph = &frontier->graph;
+    int num_known_nodes = graph->num_nodes;
+    int num_known_edges = graph->num_edges;
+    ArrayType *id_array;
+    Datum values[1];
+    int ret;
+
+    id_array = construct_array(ids, num_ids, frontier->node_id_type, frontier->node_id_typlen,
+                               frontier->node_id_typbyval, frontier->node_id_typalign);
+    values[0] = PointerGetDatum(id_array);
+    ret = SPI_execute_plan(frontier->edges_plan, values, NULL, true, 0);
+    pfree(id_array);
+    if (ret != SPI_OK_SELECT)
+        ereport(ERROR,
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                 errmsg("edges query failed: %s", SPI_result_code_string(ret))));
+    frontier->num_fetches++;
+    if (SPI_tuptable == NULL)
+        return;
+
+    SPITupleTable *tuptable = SPI_tuptable;
+    uint64 num_rows = SPI_processed;
+    TupleDesc tupdesc = tuptable->tupdesc;
+
+    if (tupdesc->natts < 4)
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("edges query must return at least 4 columns: id, source, target, cost")));
+    if (num_rows == 0) {
+        SPI_freetuptable(tuptable);
+        return;
+    }
+    pcst_mem_set(&graph->mem, PCST_MEM_EDGE_TUPTABLE, tuptable_bytes(tuptable, num_rows));
+    frontier->num_fetched_rows += num_rows;
+
+    Oid edge_id_type = SPI_gettypeid(tupdesc, 1);
+    Oid source_id_type = SPI_gettypeid(tupdesc, 2);
+    Oid target_id_type = SPI_gettypeid(tupdesc, 3);
+
+    // The ID kinds are picked from the first rows; later queries cannot keep
+    // rows around, so other edge IDs are copied out as text
+    if (graph->edge_sources == NULL) {
+        graph->edge_id_type = edge_id_type;
+        graph->edge_id_column = 1;
+        graph->edge_id_kind = (edge_id_type == INT2OID || edge_id_type == INT4OID
+                               || edge_id_type == INT8OID) ? PCST_EDGE_ID_INT : PCST_EDGE_ID_TEXT;
+        init_node_keys(graph, tuptable->vals[0], tupdesc, 2, verbosity);
+    }
+
+    for (uint64 r = 0; r < num_rows; r++) {
+        HeapTuple tuple = tuptable->vals[r];
+        bool id_null, source_null, target_null, cost_null;
+        Datum edge_id_datum = SPI_getbinval(tuple, tupdesc, 1, &id_null);
+        Datum source_datum = SPI_getbinval(tuple, tupdesc, 2, &source_null);
+        Datum target_datum = SPI_getbinval(tuple, tupdesc, 3, &target_null);
+        Datum cost_datum = SPI_getbinval(tuple, tupdesc, 4, &cost_null);
+
+        if (id_null || source_null || target_null || cost_null)
+            ereport(ERROR,
+                    (errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED),
+                     errmsg("edges query cannot return NULL values")));
+
+        int source = intern_node(graph, source_datum, source_id_type, verbosity);
+        int target = intern_node(graph, target_datum, target_id_type, verbosity);
+        if ((source < num_known_nodes && frontier->expanded[source])
+            || (target < num_known_nodes && frontier->expanded[target]))
+            continue;
+
+        reserve_frontier_edge(frontier);
+        int i = graph->num_edges++;
+        graph->edge_sources[i] = source;
+        graph->edge_targets[i] = target;
+        graph->edge_costs[i] = DatumGetFloat8(cost_datum);
+        if (graph->edge_id_kind == PCST_EDGE_ID_INT) {
+            graph->edge_id_ints[i] = (edge_id_type == INT8OID) ? DatumGetInt64(edge_id_datum) :
+                                     (edge_id_type == INT4OID) ? DatumGetInt32(edge_id_datum) :
+                                     DatumGetInt16(edge_id_datum);
+        } else {
+            graph->edge_id_texts[i] = datum_to_text(edge_id_datum, edge_id_type);
+            pcst_mem_add(&graph->mem, PCST_MEM_EDGE_IDS, VARSIZE(graph->edge_id_texts[i]));
+        }
+    }
+    reserve_frontier_nodes(frontier);
+    if (frontier->prize_map != NULL) {
+        for (int i = num_known_nodes; i < graph->num_nodes; i++) {
+            text *node_id = pcst_node_id_text(graph, i);
+            frontier_prize_entry *entry = (frontier_prize_entry *)
+                hash_search(frontier->prize_map, &node_id, HASH_FIND, NULL);
+            if (entry != NULL)
+                graph->node_prizes[i] = entry->prize;
+            pfree(node_id);
+        }
+    }
+
+    SPI_freetuptable(tuptable);
+    pcst_mem_set(&graph->mem, PCST_MEM_EDGE_TUPTABLE, 0);
+    if (graph->key_kind == PCST_NODE_KEY_TEXT)
+        pcst_mem_set(&graph->mem, PCST_MEM_NODE_MAP, node_map_bytes(graph->node_map));
+
+    if (verbosity > 1)
+        elog(INFO, "pcst_loader: frontier fetch %d read %lu rows, %d new nodes, %d new edges",
+             frontier->num_fetches, (unsigned long) num_rows,
+             graph->num_nodes - num_known_nodes, graph->num_edges - num_known_edges);
+}
+
+/* A node ID given as text, converted to the nodes query's ID type */
+static Datum frontier_id_datum(pcst_frontier_graph *frontier, text *node_id) {
+    Oid input_func;
+    Oid ioparam;
+
+    if (frontier->node_id_type == TEXTOID)
+        return PointerGetDatum(node_id);
+    getTypeInputInfo(frontier->node_id_type, &input_func, &ioparam);
+    char *str = text_to_cstring(node_id);
+    Datum value = OidInputFunctionCall(input_func, str, ioparam, -1);
+    pfree(str);
+    return value;
+}
+
+/*
+ * Reset frontier, run nodes_sql and prepare edges_sql for arrays of its ID
+ * type. The caller frees the nodes tuptable returned, of *num_node_rows rows.
+ */
+static SPITupleTable *prepare_frontier(pcst_frontier_graph *frontier, const char *edges_sql,
+                                       const char *nodes_sql, uint64 *num_node_rows) {
+    pcst_graph *graph = &frontier->graph;
+    int ret;
+
+    memset(frontier, 0, sizeof(pcst_frontier_graph));
+    frontier->root = -1;
+
+    ret = SPI_execute(nodes_sql, true, 0);
+    if (ret != SPI_OK_SELECT)
+        ereport(ERROR,
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                 errmsg("nodes query failed: %s", SPI_result_code_string(ret))));
+    if (SPI_tuptable->tupdesc->natts < 2)
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("nodes query must return at least 2 columns: id, prize")));
+
+    SPITupleTable *nodes = SPI_tuptable;
+    TupleDesc nodes_tupdesc = nodes->tupdesc;
+    *num_node_rows = SPI_processed;
+    pcst_mem_set(&graph->mem, PCST_MEM_NODE_TUPTABLE, tuptable_bytes(nodes, *num_node_rows));
+
+    // $1 of edges_sql is an array of the nodes query's ID type
+    frontier->node_id_type = SPI_gettypeid(nodes_tupdesc, 1);
+    get_typlenbyvalalign(frontier->node_id_type, &frontier->node_id_typlen,
+                         &frontier->node_id_typbyval, &frontier->node_id_typalign);
+    Oid id_array_type = get_array_type(frontier->node_id_type);
+    if (!OidIsValid(id_array_type))
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("node ID type %s has no array type",
+                        format_type_be(frontier->node_id_type))));
+    frontier->edges_plan = SPI_prepare_cursor(edges_sql, 1, &id_array_type,
+                                              CURSOR_OPT_GENERIC_PLAN);
+    if (frontier->edges_plan == NULL)
+        ereport(ERROR,
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                 errmsg("edges query failed: %s", SPI_result_code_string(SPI_result))));
+    return nodes;
+}
+
+/* Whether a root ID names a node; NULL and '-1' do not */
+static bool has_root_id(text *root_id) {
+    bool rooted = root_id != NULL;
+
+    if (rooted) {
+        char *root_id_str = text_to_cstring(root_id);
+        rooted = strcmp(root_id_str, "-1") != 0;
+        pfree(root_id_str);
+    }
+    return rooted;
+}
+
+void pcst_load_frontier(pcst_frontier_graph *frontier, const char *edges_sql,
+                        const char *nodes_sql, text *root_id, int verbosity) {
+    pcst_graph *graph = &frontier->graph;
+    uint64 num_node_rows;
+    SPITupleTable *nodes = prepare_frontier(frontier, edges_sql, nodes_sql, &num_node_rows);
+    TupleDesc nodes_tupdesc = nodes->tupdesc;
+
+    // Growth starts at the prize nodes and the root, so their edges come first
+    bool rooted = has_root_id(root_id);
+    Datum *seeds = (Datum *) palloc((num_node_rows + 1) * sizeof(Datum));
+    int num_seeds = 0;
+    for (uint64 i = 0; i < num_node_rows; i++) {
+        bool id_null, prize_null;
+        Datum node_id_datum = SPI_getbinval(nodes->vals[i], nodes_tupdesc, 1, &id_null);
+        Datum prize_datum = SPI_getbinval(nodes->vals[i], nodes_tupdesc, 2, &prize_null);
+
+        if (!id_null && !prize_null && DatumGetFloat8(prize_datum) != 0.0)
+            seeds[num_seeds++] = node_id_datum;
+    }
+    if (rooted)
+        seeds[num_seeds++] = frontier_id_datum(frontier, root_id);
+    if (num_seeds == 0)
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("nodes query returned no node with a nonzero prize and no root was given")));
+
+    for (int first = 0; first < num_seeds; first += PCST_FRONTIER_BATCH_SIZE) {
+        int end = Min(first + PCST_FRONTIER_BATCH_SIZE, num_seeds);
+
+        fetch_frontier_edges(frontier, seeds + first, end - first, verbosity);
+        if (graph->num_nodes == 0)
+            continue;  // No node map before the first edge
+        for (int i = first; i < end; i++) {
+            int node_index = find_node(graph, seeds[i], frontier->node_id_type);
+            if (node_index >= 0)
+                frontier->expanded[node_index] = true;
+        }
+    }
+    pfree(seeds);
+    if (graph->num_edges == 0)
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("edges query returned no rows for the prize nodes and the root")));
+
+    // Every node with a prize was a seed, the others keep prize 0
+    int nodes_not_found = 0;
+    for (uint64 i = 0; i < num_node_rows; i++) {
+        bool id_null, prize_null;
+        Datum node_id_datum = SPI_getbinval(nodes->vals[i], nodes_tupdesc, 1, &id_null);
+        Datum prize_datum = SPI_getbinval(nodes->vals[i], nodes_tupdesc, 2, &prize_null);
+
+        if (id_null || prize_null || DatumGetFloat8(prize_datum) == 0.0)
+            continue;
+        int node_index = find_node(graph, node_id_datum, frontier->node_id_type);
+        if (node_index >= 0) {
+            graph->node_prizes[node_index] = DatumGetFloat8(prize_datum);
+        } else {
+            nodes_not_found++;
+        }
+    }
+    SPI_freetuptable(nodes);
+    pcst_mem_set(&graph->mem, PCST_MEM_NODE_TUPTABLE, 0);
+
+    frontier->root = pcst_resolve_root(graph, root_id, verbosity);
+    graph->num_original_nodes = graph->num_nodes;
+    graph->num_original_edges = graph->num_edges;
+
+    if (verbosity > 0) {
+        elog(INFO, "pgr_pcst_fast_frontier: %d seed node(s) read %d nodes and %d edges",
+             num_seeds, graph->num_nodes, graph->num_edges);
+        if (nodes_not_found > 0)
+            elog(WARNING, "pgr_pcst_fast_frontier: %d prize node(s) from nodes query have no edges and will be ignored",
+                 nodes_not_found);
+    }
+}
+
+void pcst_load_frontier_around(pcst_frontier_graph *frontier, const char *edges_sql,
+                               const char *nodes_sql, text **seed_ids, int num_seeds,
+                               text *root_id, int verbosity) {
+    pcst_graph *graph = &frontier->graph;
+    uint64 num_node_rows;
+    SPITupleTable *nodes = prepare_frontier(frontier, edges_sql, nodes_sql, &num_node_rows);
+    TupleDesc nodes_tupdesc = nodes->tupdesc;
+    HASHCTL hash_ctl;
+
+    // Prizes by ID text, handed out by fetch_frontier_edges as nodes are read
+    MemSet(&hash_ctl, 0, sizeof(hash_ctl));
+    hash_ctl.keysize = sizeof(text *);
+    hash_ctl.entrysize = sizeof(frontier_prize_entry);
+    hash_ctl.hash = node_id_hash;
+    hash_ctl.match = node_id_match;
+    hash_ctl.hcxt = CurrentMemoryContext;
+    frontier->prize_map = hash_create("frontier_prize_map", Max(64, num_node_rows), &hash_ctl,
+                                      HASH_ELEM | HASH_FUNCTION | HASH_COMPARE | HASH_CONTEXT);
+    for (uint64 i = 0; i < num_node_rows; i++) {
+        bool id_null, prize_null, found;
+        Datum node_id_datum = SPI_getbinval(nodes->vals[i], nodes_tupdesc, 1, &id_null);
+        Datum prize_datum = SPI_getbinval(nodes->vals[i], nodes_tupdesc, 2, &prize_null);
+
+        if (id_null || prize_null || DatumGetFloat8(prize_datum) == 0.0)
+            continue;
+        text *node_id = datum_to_text(node_id_datum, frontier->node_id_type);
+        frontier_prize_entry *entry = (frontier_prize_entry *)
+            hash_search(frontier->prize_map, &node_id, HASH_ENTER, &found);
+        if (found)
+            pfree(node_id);
+        else
+            entry->node_id = node_id;
+        entry->prize = DatumGetFloat8(prize_datum);
+    }
+    SPI_freetuptable(nodes);
+    pcst_mem_set(&graph->mem, PCST_MEM_NODE_TUPTABLE, 0);
+
+    bool rooted = has_root_id(root_id);
+    int num_ids = num_seeds + (rooted ? 1 : 0);
+    if (num_ids == 0)
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("no seed node and no root was given")));
+    Datum *ids = (Datum *) palloc(num_ids * sizeof(Datum));
+    for (int i = 0; i < num_seeds; i++)
+        ids[i] = frontier_id_datum(frontier, seed_ids[i]);
+    if (rooted)
+        ids[num_seeds] = frontier_id_datum(frontier, root_id);
+
+    for (int first = 0; first < num_ids; first += PCST_FRONTIER_BATCH_SIZE) {
+        int end = Min(first + PCST_FRONTIER_BATCH_SIZE, num_ids);
+
+        fetch_frontier_edges(frontier, ids + first, end - first, verbosity);
+        if (graph->num_nodes == 0)
+            continue;  // No node map before the first edge
+        for (int i = first; i < end; i++) {
+            int node_index = find_node(graph, ids[i], frontier->node_id_type);
+            if (node_index >= 0)
+                frontier->expanded[node_index] = true;
+        }
+    }
+    pfree(ids);
+    if (graph->num_edges == 0)
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("edges query returned no rows for the seed nodes and the root")));
+
+    frontier->root = pcst_resolve_root(graph, root_id, verbosity);
+    graph->num_original_nodes = graph->num_nodes;
+    graph->num_original_edges = graph->num_edges;
+
+    if (verbosity > 0)
+        elog(INFO, "pcst_loader: %d seed node(s) read %d nodes and %d edges",
+             num_ids, graph->num_nodes, graph->num_edges);
+}
+
+void pcst_expand_frontier(pcst_frontier_graph *frontier, const int *nodes, int num_nodes,
+                          int verbosity) {
+    pcst_graph *graph = &frontier->graph;
+    Datum *ids = (Datum *) palloc(Min(num_nodes, PCST_FRONTIER_BATCH_SIZE) * sizeof(Datum));
+
+    for (int first = 0; first < num_nodes; first += PCST_FRONTIER_BATCH_SIZE) {
+        int end = Min(first + PCST_FRONTIER_BATCH_SIZE, num_nodes);
+
+        for (int i = first; i < end; i++) {
+            text *node_id = pcst_node_id_text(graph, nodes[i]);
+            ids[i - first] = frontier_id_datum(frontier, node_id);
+            if (frontier->node_id_type != TEXTOID)
+                pfree(node_id);
+        }
+        fetch_frontier_edges(frontier, ids, end - first, verbosity);
+        for (int i = first; i < end; i++) {
+            if (!frontier->node_id_typbyval)
+                pfree(DatumGetPointer(ids[i - first]));
+            frontier->expanded[nodes[i]] = true;
+        }
+    }
+    pfree(ids);
+    graph->num_original_nodes = graph->num_nodes;
+    graph->num_original_edges = graph->num_edges;
+}
+
+/* A point snapped onto an original edge */
+typedef struct {
+    int edge;
+    double fraction;
+    double prize;
+} pcst_point;
+
+/* Order points by edge, then by position along the edge */
+static int point_cmp(const void *a, const void *b) {
+    const pcst_point *p1 = (const pcst_point *) a;
+    const pcst_point *p2 = (const pcst_point *) b;
+    if (p1->edge != p2->edge)
+        return (p1->edge < p2->edge) ? -1 : 1;
+    if (p1->fraction != p2->fraction)
+        return (p1->fraction < p2->fraction) ? -1 : 1;
+    return 0;
+}
+
+/* Points refer to edges by ID: edge ID text -> original edge index */
+typedef struct {
+    text *edge_id;  // Key (pointer to text)
+    int index;      // Original edge index, -1 until resolved
+} point_edge_entry;
+
+void pcst_load_points(pcst_graph *graph, const char *points_sql, int verbosity) {
+    int ret;
+    HASHCTL hash_ctl;
+    HTAB *point_edges;
+    int num_unresolved = 0;
+
+    ret = SPI_execute(points_sql, true, 0);
+    if (ret != SPI_OK_SELECT)
+        ereport(ERROR,
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                 errmsg("points query failed: %s", SPI_result_code_string(ret))));
+    if (SPI_tuptable == NULL || SPI_processed == 0) {
+        SPI_freetuptable(SPI_tuptable);
+        return;
+    }
+
+    TupleDesc points_tupdesc = SPI_tuptable->tupdesc;
+    if (points_tupdesc->natts < 4)
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("points query must return at least 4 columns: point_id, edge_id, fraction, prize")));
+
+    SPITupleTable *points_tuptable = SPI_tuptable;
+    int num_points = SPI_processed;
+    Oid edge_id_type = SPI_gettypeid(points_tupdesc, 2);
+    pcst_point *points = (pcst_point *) palloc(num_points * sizeof(pcst_point));
+    point_edge_entry **point_entries = (point_edge_entry **) palloc(num_points * sizeof(point_edge_entry *));
+
+    MemSet(&hash_ctl, 0, sizeof(hash_ctl));
+    hash_ctl.keysize = sizeof(text *);
+    hash_ctl.entrysize = sizeof(point_edge_entry);
+    hash_ctl.hash = node_id_hash;
+    hash_ctl.match = node_id_match;
+    hash_ctl.hcxt = CurrentMemoryContext;
+    point_edges = hash_create("point_edge_map", Max(64, num_points), &hash_ctl,
+                              HASH_ELEM | HASH_FUNCTION | HASH_COMPARE | HASH_CONTEXT);
+
+    for (int i = 0; i < num_points; i++) {
+        HeapTuple tuple = points_tuptable->vals[i];
+        bool isnull[3];
+        Datum edge_id_datum = SPI_getbinval(tuple, points_tupdesc, 2, &isnull[0]);
+        Datum fraction_datum = SPI_getbinval(tuple, points_tupdesc, 3, &isnull[1]);
+        Datum prize_datum = SPI_getbinval(tuple, points_tupdesc, 4, &isnull[2]);
+        bool found;
+
+        if (isnull[0] || isnull[1] || isnull[2])
+            ereport(ERROR,
+                    (errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED),
+                     errmsg("points query cannot return NULL edge_id, fraction or prize")));
+
+        points[i].fraction = DatumGetFloat8(fraction_datum);
+        points[i].prize = DatumGetFloat8(prize_datum);
+        if (!(points[i].fraction >= 0.0 && points[i].fraction <= 1.0))
+            ereport(ERROR,
+                    (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                     errmsg("point fraction %g is outside [0, 1]", points[i].fraction)));
+        if (points[i].prize < 0.0)
+            ereport(ERROR,
+                    (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                     errmsg("point prize %g is negative", points[i].prize)));
+
+        text *edge_id = datum_to_text(edge_id_datum, edge_id_type);
+        point_entries[i] = (point_edge_entry *) hash_search(point_edges, &edge_id, HASH_ENTER, &found);
+        if (found) {
+            pfree(edge_id);
+        } else {
+            point_entries[i]->edge_id = edge_id;
+            point_entries[i]->index = -1;
+            num_unresolved++;
+        }
+    }
+    SPI_freetuptable(points_tuptable);
+
+    // One pass over the edge IDs resolves every referenced edge
+    for (int i = 0; i < graph->num_edges && num_unresolved > 0; i++) {
+        text *edge_id = pcst_edge_id_text(graph, i);
+        if (edge_id == NULL)
+            continue;
+        bool found;
+        point_edge_entry *entry = (point_edge_entry *) hash_search(point_edges, &edge_id, HASH_FIND, &found);
+        if (found && entry->index < 0) {
+            entry->index = i;
+            num_unresolved--;
+        }
+        pfree(edge_id);
+    }
+    for (int i = 0; i < num_points; i++) {
+        if (point_entries[i]->index < 0)
+            ereport(ERROR,
+                    (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                     errmsg("points query references edge '%s' not found in edges query",
+                            text_to_cstring(point_entries[i]->edge_id))));
+        points[i].edge = point_entries[i]->index;
+    }
+    hash_destroy(point_edges);
+    pfree(point_entries);
+
+    qsort(points, num_points, sizeof(pcst_point), point_cmp);
+
+    // Every distinct interior position becomes a node and adds one sub-edge
+    int num_splits = 0;
+    for (int i = 0; i < num_points; i++) {
+        double f = points[i].fraction;
+        if (f > 0.0 && f < 1.0
+            && (i == 0 || points[i - 1].edge != points[i].edge || points[i - 1].fraction != f))
+            num_splits++;
+    }
+
+    int num_edges = graph->num_edges + num_splits;
+    int num_nodes = graph->num_nodes + num_splits;
+    graph->edge_sources = (int *) repalloc(graph->edge_sources, num_edges * sizeof(int));
+    graph->edge_targets = (int *) repalloc(graph->edge_targets, num_edges * sizeof(int));
+    graph->edge_costs = (double *) repalloc(graph->edge_costs, num_edges * sizeof(double));
+    graph->node_prizes = (double *) repalloc(graph->node_prizes, num_nodes * sizeof(double));
+    graph->sub_edge_parent = (int *) palloc(num_edges * sizeof(int));
+    graph->sub_edge_start = (double *) palloc(num_edges * sizeof(double));
+    graph->sub_edge_end = (double *) palloc(num_edges * sizeof(double));
+    graph->original_targets = (int *) palloc(graph->num_edges * sizeof(int));
+    memcpy(graph->original_targets, graph->edge_targets, graph->num_edges * sizeof(int));
+    pcst_mem_add(&graph->mem, PCST_MEM_GRAPH_ARRAYS,
+                 num_splits * (2 * sizeof(int) + 2 * sizeof(double))
+                 + num_edges * (sizeof(int) + 2 * sizeof(double))
+                 + graph->num_edges * sizeof(int));
+    for (int i = 0; i < graph->num_edges; i++) {
+        graph->sub_edge_parent[i] = i;
+        graph->sub_edge_start[i] = 0.0;
+        graph->sub_edge_end[i] = 1.0;
+    }
+
+    // Walk each split edge from source to target. The original slot keeps
+    // the first piece, later pieces are appended.
+    int next_edge = graph->num_edges;
+    int next_node = graph->num_nodes;
+    for (int i = 0; i < num_points;) {
+        int edge = points[i].edge;
+        int source = graph->edge_sources[edge];
+        int target = graph->original_targets[edge];
+        double cost = graph->edge_costs[edge];
+        int piece = edge;           // Sub-edge that currently ends at target
+        int piece_start_node = source;
+        double piece_start = 0.0;
+
+        for (; i < num_points && points[i].edge == edge; i++) {
+            double f = points[i].fraction;
+            if (f == 0.0) {
+                graph->node_prizes[source] += points[i].prize;
+                continue;
+            }
+            if (f == 1.0) {
+                graph->node_prizes[target] += points[i].prize;
+                continue;
+            }
+            if (f == piece_start) {
+                // Same position as the previous point: same node
+                graph->node_prizes[next_node - 1] += points[i].prize;
+                continue;
+            }
+
+            // Close the current piece at the new point node
+            int point_node = next_node++;
+            graph->node_prizes[point_node] = points[i].prize;
+            graph->edge_sources[piece] = piece_start_node;
+            graph->edge_targets[piece] = point_node;
+            graph->edge_costs[piece] = cost * (f - piece_start);
+            graph->sub_edge_parent[piece] = edge;
+            graph->sub_edge_start[piece] = piece_start;
+            graph->sub_edge_end[piece] = f;
+
+            piece = next_edge++;
+            piece_start_node = point_node;
+            piece_start = f;
+        }
+
+        graph->edge_sources[piece] = piece_start_node;
+        graph->edge_targets[piece] = target;
+        graph->edge_costs[piece] = cost * (1.0 - piece_start);
+        graph->sub_edge_parent[piece] = edge;
+        graph->sub_edge_start[piece] = piece_start;
+        graph->sub_edge_end[piece] = 1.0;
+    }
+    Assert(next_edge == num_edges && next_node == num_nodes);
+
+    if (verbosity > 0)
+        elog(INFO, "pcst_loader: %d points on %d edges, %d point nodes and sub-edges added",
+             num_points, graph->num_original_edges, num_splits);
+
+    graph->num_edges = num_edges;
+    graph->num_nodes = num_nodes;
+    pfree(points);
+}
+
+/* One distinct ID of a pcst_match_edge_ids array, in array order */
+typedef struct {
+    text *edge_id;  // Key (pointer to text)
+    bool matched;
+} matched_edge_entry;
+
+/* Integer ID of a pcst_match_edge_ids array, sorted for binary search */
+typedef struct {
+    int64 value;
+    bool matched;
+} matched_edge_int;
+
+static int matched_edge_int_cmp(const void *a, const void *b) {
+    int64 v1 = ((const matched_edge_int *) a)->value;
+    int64 v2 = ((const matched_edge_int *) b)->value;
+    return (v1 < v2) ? -1 : (v1 > v2) ? 1 : 0;
+}
+
+void pcst_match_edge_ids(pcst_graph *graph, ArrayType *edge_ids, bool *selected,
+                         text ***unmatched, int *num_unmatched) {
+    Oid elem_type = ARR_ELEMTYPE(edge_ids);
+    int16 elem_len;
+    bool elem_byval;
+    char elem_align;
+    Datum *elems;
+    bool *elem_nulls;
+    int num_elems;
+
+    memset(selected, 0, graph->num_edges * sizeof(bool));
+    *unmatched = NULL;
+    *num_unmatched = 0;
+
+    get_typlenbyvalalign(elem_type, &elem_len, &elem_byval, &elem_align);
+    deconstruct_array(edge_ids, elem_type, elem_len, elem_byval, elem_align,
+                      &elems, &elem_nulls, &num_elems);
+    *unmatched = (text **) palloc((num_elems + 1) * sizeof(text *));
+
+    // Integer IDs against an integer array: binary search, no text at all
+    if (graph->edge_id_kind == PCST_EDGE_ID_INT
+        && (elem_type == INT2OID || elem_type == INT4OID || elem_type == INT8OID)) {
+        matched_edge_int *ids = (matched_edge_int *) palloc((num_elems + 1) * sizeof(matched_edge_int));
+        int num_ids = 0;
+        for (int i = 0; i < num_elems; i++) {
+            if (elem_nulls[i])
+                continue;
+            ids[num_ids].value = (elem_type == INT8OID) ? DatumGetInt64(elems[i]) :
+                                 (elem_type == INT4OID) ? DatumGetInt32(elems[i]) :
+                                 DatumGetInt16(elems[i]);
+            ids[num_ids++].matched = false;
+        }
+        qsort(ids, num_ids, sizeof(matched_edge_int), matched_edge_int_cmp);
+
+        for (int i = 0; i < graph->num_edges && num_ids > 0; i++) {
+            matched_edge_int key = {graph->edge_id_ints[i], false};
+            matched_edge_int *found = (matched_edge_int *) bsearch(&key, ids, num_ids,
+                                                                   sizeof(matched_edge_int),
+                                                                   matched_edge_int_cmp);
+            if (found) {
+                selected[i] = true;
+                found->matched = true;
+            }
+        }
+        for (int i = 0; i < num_ids; i++) {
+            if (!ids[i].matched && (i == 0 || ids[i].value != ids[i - 1].value)) {
+                char buf[MAXINT8LEN + 1];
+                snprintf(buf, sizeof(buf), INT64_FORMAT, ids[i].value);
+                (*unmatched)[(*num_unmatched)++] = cstring_to_text(buf);
+            }
+        }
+        pfree(ids);
+    } else {
+        // Anything else is compared as text, like the edge IDs of points
+        HASHCTL hash_ctl;
+        HTAB *id_map;
+        matched_edge_entry **entries = (matched_edge_entry **) palloc((num_elems + 1) * sizeof(matched_edge_entry *));
+        int num_entries = 0;
+
+        MemSet(&hash_ctl, 0, sizeof(hash_ctl));
+        hash_ctl.keysize = sizeof(text *);
+        hash_ctl.entrysize = sizeof(matched_edge_entry);
+        hash_ctl.hash = node_id_hash;
+        hash_ctl.match = node_id_match;
+        hash_ctl.hcxt = CurrentMemoryContext;
+        id_map = hash_create("matched_edge_map", Max(64, num_elems), &hash_ctl,
+                             HASH_ELEM | HASH_FUNCTION | HASH_COMPARE | HASH_CONTEXT);
+
+        for (int i = 0; i < num_elems; i++) {
+            bool found;
+            if (elem_nulls[i])
+                continue;
+            text *edge_id = datum_to_text(elems[i], elem_type);
+            matched_edge_entry *entry = (matched_edge_entry *) hash_search(id_map, &edge_id, HASH_ENTER, &found);
+            if (found) {
+                pfree(edge_id);
+            } else {
+                entry->edge_id = edge_id;
+                entry->matched = false;
+                entries[num_entries++] = entry;
+            }
+        }
+
+        for (int i = 0; i < graph->num_edges && num_entries > 0; i++) {
+            text *edge_id = pcst_edge_id_text(graph, i);
+            if (edge_id == NULL)
+                continue;
+            bool found;
+            matched_edge_entry *entry = (matched_edge_entry *) hash_search(id_map, &edge_id, HASH_FIND, &found);
+            if (found) {
+                selected[i] = true;
+                entry->matched = true;
+            }
+            pfree(edge_id);
+        }
+        for (int i = 0; i < num_entries; i++) {
+            if (!entries[i]->matched)
+                (*unmatched)[(*num_unmatched)++] = entries[i]->edge_id;
+        }
+        hash_destroy(id_map);
+        pfree(entries);
+    }
+    pfree(elems);
+    pfree(elem_nulls);
+}
+
+int pcst_resolve_root(pcst_graph *graph, text *root_id, int verbosity) {
+    int root_index;
+
+    // Handle special case: -1 or '-1' means auto-select (no root)
+    if (root_id == NULL)
+        return -1;
+
+    char *root_id_str = text_to_cstring(root_id);
+    // Check if root_id is -1 or '-1' (auto-select)
+    if (strcmp(root_id_str, "-1") == 0) {
+        pfree(root_id_str);
+        return -1;  // Auto-select
+    }
+
+    root_index = find_node(graph, PointerGetDatum(root_id), TEXTOID);
+    if (root_index < 0) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("root node ID '%s' not found in edges", root_id_str)));
+    }
+
+    // Validate root_index is in valid range (should always be true if node is in hash table)
+    if (root_index < 0 || root_index >= graph->num_nodes) {
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("root node ID '%s' maps to invalid index %d (valid range: 0-%d)",
+                        root_id_str, root_index, graph->num_nodes - 1)));
+    }
+
+    // Log root node mapping for debugging (only if verbosity > 0)
+    if (verbosity > 0) {
+        elog(INFO, "pgr_pcst_fast: Root node ID '%s' mapped to index %d (num_nodes=%d)",
+             root_id_str, root_index, graph->num_nodes);
+    }
+
+    pfree(root_id_str);
+    return root_index;
+}
+
+int pcst_parse_pruning(text *pruning_text) {
+    char *pruning_str;
+    int pruning_method;
+
+    // Convert pruning string to enum
+    if (pruning_text == NULL) {
+        pruning_str = "simple";  // Default
+    } else {
+        pruning_str = text_to_cstring(pruning_text);
+    }
+    if (strcmp(pruning_str, "none") == 0)
+        pruning_method = 0;
+    else if (strcmp(pruning_str, "simple") == 0)
+        pruning_method = 1;
+    else if (strcmp(pruning_str, "gw") == 0)
+        pruning_method = 2;
+    else if (strcmp(pruning_str, "strong") == 0)
+        pruning_method = 3;
+    else if (strcmp(pruning_str, "auto") == 0)
+        pruning_method = PCST_PRUNING_AUTO;
+    else
+        pruning_method = 1; // default to simple
+
+    return pruning_method;
+}
@@ -0,0 +1,230 @@
+#ifndef PCST_LOADER_H
+#define PCST_LOADER_H
+
+#include "postgres.h"
+#include "executor/spi.h"
+#include "utils/array.h"
+#include "utils/hsearch.h"
+
+#include "pcst_fast_c_wrapper.h"
+
+/* Loader-side structures whose footprint is tracked */
+typedef enum {
+    PCST_MEM_EDGE_TUPTABLE = 0,  // SPI result of edges_sql
+    PCST_MEM_NODE_TUPTABLE,      // SPI result of nodes_sql
+    PCST_MEM_NODE_IDS,           // index -> original node ID (text or 16-byte key)
+    PCST_MEM_EDGE_IDS,           // index -> original edge ID (compact forms only)
+    PCST_MEM_NODE_MAP,           // node ID hash table / key slot table
+    PCST_MEM_GRAPH_ARRAYS,       // numeric sources/targets/costs/prizes
+    PCST_MEM_NUM_ENTRIES
+} pcst_mem_entry;
+
+/* Current and peak bytes per loader structure */
+typedef struct {
+    Size current_bytes[PCST_MEM_NUM_ENTRIES];
+    Size peak_bytes[PCST_MEM_NUM_ENTRIES];
+} pcst_mem_tracker;
+
+extern const char *const pcst_mem_entry_names[PCST_MEM_NUM_ENTRIES];
+
+/*
+ * How node IDs are interned. UUIDs and 32-character hex strings are stored
+ * as 16-byte binary keys; anything else falls back to text keys.
+ */
+typedef enum {
+    PCST_NODE_KEY_TEXT = 0,      // arbitrary IDs, one text varlena per node
+    PCST_NODE_KEY_UUID,          // uuid columns or canonical lowercase uuid text
+    PCST_NODE_KEY_HEX            // 32-character lowercase hex text
+} pcst_node_key_kind;
+
+typedef struct {
+    uint8 data[16];
+} pcst_node_key;
+
+/*
+ * How edge IDs are kept until the selected edges are labelled. Integer and
+ * uuid/hex IDs are stored compactly and the edges tuptable is released right
+ * after loading; any other ID is read back from the retained tuptable, where
+ * row i is edge i.
+ */
+typedef enum {
+    PCST_EDGE_ID_ROW = 0,        // edge_tuptable row ordinal
+    PCST_EDGE_ID_INT,            // int2/int4/int8 IDs widened to int64
+    PCST_EDGE_ID_KEY,            // 16-byte keys of kind edge_id_key_kind
+    PCST_EDGE_ID_TEXT            // other IDs read over several queries, as text
+} pcst_edge_id_kind;
+
+/* Graph loaded from edges_sql / nodes_sql, mapped to internal indices */
+typedef struct {
+    pcst_node_key_kind key_kind;
+    HTAB *node_map;              // Text keys: original node ID -> internal index
+    text **index_to_node_id;     // Text keys: internal index -> original node ID (text)
+    pcst_node_key *node_keys;    // Binary keys: internal index -> 16-byte ID
+    int *key_slots;              // Binary keys: open addressing table of node indices, -1 = empty
+    int num_key_slots;           // Power of two, at least twice num_nodes
+    int node_keys_capacity;
+    pcst_edge_id_kind edge_id_kind;
+    Oid edge_id_type;
+    SPITupleTable *edge_tuptable;  // Row IDs: edges query result, valid until SPI_finish
+    int edge_id_column;          // Row IDs: column of the edge ID, 2 behind a group_id
+    int *edge_rows;              // Row IDs of a group: internal edge index -> row, else NULL
+    int64 *edge_id_ints;         // Integer IDs: internal edge index -> ID
+    pcst_node_key *edge_id_keys; // Key IDs: internal edge index -> 16-byte ID
+    text **edge_id_texts;        // Text IDs: internal edge index -> original edge ID
+    pcst_node_key_kind edge_id_key_kind;
+    int *edge_sources;           // Internal indices
+    int *edge_targets;           // Internal indices
+    double *edge_costs;
+    double *node_prizes;         // Zero for nodes not returned by nodes_sql
+    int num_nodes;
+    int num_edges;
+    // Virtual edge splits from pcst_load_points; without points the arrays
+    // are NULL and every edge is an original edge
+    int num_original_nodes;      // Nodes from edges_sql; point nodes follow
+    int num_original_edges;      // Edges from edges_sql; extra sub-edges follow
+    int *sub_edge_parent;        // Internal edge index -> original edge index
+    double *sub_edge_start;      // Fraction of the original edge where the sub-edge starts
+    double *sub_edge_end;        // ... and where it ends
+    int *original_targets;       // Original edge index -> target node before splitting
+    pcst_mem_tracker mem;
+} pcst_graph;
+
+extern void pcst_mem_set(pcst_mem_tracker *tracker, pcst_mem_entry entry, Size bytes);
+extern void pcst_mem_add(pcst_mem_tracker *tracker, pcst_mem_entry entry, Size bytes);
+
+/*
+ * Load edges and prizes through SPI. Must be called between SPI_connect and
+ * SPI_finish; everything is allocated in the current memory context.
+ */
+extern void pcst_load_graph(pcst_graph *graph, const char *edges_sql,
+                            const char *nodes_sql, int verbosity);
+
+/*
+ * pcst_load_graph that also hands the edges to a solver input builder in
+ * batches of PCST_BUILDER_BATCH_SIZE while they are read, and the prizes at
+ * the end. builder may be NULL.
+ */
+#define PCST_BUILDER_BATCH_SIZE 65536
+
+extern void pcst_load_graph_with_builder(pcst_graph *graph, const char *edges_sql,
+                                         const char *nodes_sql, int verbosity,
+                                         pcst_builder_t *builder);
+
+/*
+ * pcst_load_graph_with_builder taking the prizes from parallel node_ids (any
+ * type) and prizes arrays instead of a nodes query, so no SPI round trip is
+ * spent on them. Either array may be NULL for no prizes; NULL elements are
+ * skipped and IDs that do not occur in the edges are ignored.
+ */
+extern void pcst_load_graph_with_prize_arrays(pcst_graph *graph, const char *edges_sql,
+                                              ArrayType *node_ids, ArrayType *prizes,
+                                              int verbosity, pcst_builder_t *builder);
+
+/* One graph per group_id of a grouped edges query */
+typedef struct {
+    int num_groups;
+    text **group_ids;            // Group IDs as text, in order of their first edge
+    pcst_graph *graphs;
+} pcst_graph_groups;
+
+/*
+ * Load edges_sql (group_id, id, source, target, cost) and nodes_sql
+ * (group_id, id, prize) into one graph per group, each interning its own
+ * node IDs, reading each query once. Node rows of groups without edges are
+ * skipped like nodes missing from the edges. Same calling rules as
+ * pcst_load_graph.
+ */
+extern void pcst_load_graph_groups(pcst_graph_groups *groups, const char *edges_sql,
+                                   const char *nodes_sql, int verbosity);
+
+/*
+ * Split edges at the points returned by points_sql (point_id, edge_id,
+ * fraction, prize), like pgRouting's withPoints. Every distinct interior
+ * fraction of an edge becomes a point node carrying the summed prizes, and
+ * only the edges that have points are replaced by sub-edges. Points at
+ * fraction 0 or 1 add their prize to the edge's source or target. Must be
+ * called after pcst_load_graph, before SPI_finish.
+ */
+extern void pcst_load_points(pcst_graph *graph, const char *points_sql, int verbosity);
+
+/* Original ID of a node as text, allocated in the current memory context.
+ * Point nodes created by pcst_load_points have no ID and return NULL. */
+extern text *pcst_node_id_text(pcst_graph *graph, int index);
+
+/*
+ * Original ID of an edge as text, allocated in the current memory context.
+ * Must be called before SPI_finish, as row IDs are read from the tuptable.
+ */
+extern text *pcst_edge_id_text(pcst_graph *graph, int index);
+
+/*
+ * Mark the edges whose original ID appears in edge_ids (an array of any
+ * type) in selected[num_edges]. Integer IDs are matched by value when the
+ * array holds integers, anything else by text. IDs that match no edge are
+ * returned as text in *unmatched, in array order and without duplicates.
+ * Must be called before SPI_finish.
+ */
+extern void pcst_match_edge_ids(pcst_graph *graph, ArrayType *edge_ids, bool *selected,
+                                text ***unmatched, int *num_unmatched);
+
+/*
+ * Graph read as growth reaches it. edges_sql takes the IDs of the nodes to
+ * expand as $1, an array of the type of the nodes query's ID column, and
+ * returns (id, source, target, cost) for every edge touching one of them,
+ * each edge once. It is run first for the nodes with a nonzero prize and
+ * the root, then for every batch of nodes the solver asks for. Edges at
+ * nodes expanded earlier were already read and are skipped.
+ */
+typedef struct {
+    pcst_graph graph;            // Nodes and edges read so far, with the prizes
+    int root;                    // Internal index of the root, -1 when unrooted
+    SPIPlanPtr edges_plan;       // Prepared edges_sql
+    Oid node_id_type;            // Element type of $1
+    int16 node_id_typlen;
+    bool node_id_typbyval;
+    char node_id_typalign;
+    bool *expanded;              // Internal index -> edges have been read
+    HTAB *prize_map;             // Around loads: node ID text -> prize of the nodes read later
+    int nodes_capacity;          // Allocated length of node_prizes and expanded
+    int edges_capacity;          // ... and of the edge arrays
+    int num_fetches;             // Runs of edges_sql
+    int64 num_fetched_rows;      // Rows they returned, skipped edges included
+} pcst_frontier_graph;
+
+/*
+ * Node IDs per run of edges_sql. Short arrays keep = ANY($1) on index
+ * scans; larger batches are split over several runs.
+ */
+#define PCST_FRONTIER_BATCH_SIZE 1024
+
+/*
+ * Prepare edges_sql, read the prizes from nodes_sql and the edges of the
+ * prize nodes and the root. Same calling rules as pcst_load_graph.
+ */
+extern void pcst_load_frontier(pcst_frontier_graph *frontier, const char *edges_sql,
+                               const char *nodes_sql, text *root_id, int verbosity);
+
+/*
+ * pcst_load_frontier reading the edges of the nodes seed_ids[0..num_seeds)
+ * (IDs as text) and the root only. The prizes are kept aside, and every
+ * node read afterwards takes its prize from them, so prize nodes far from
+ * the seeds are never read.
+ */
+extern void pcst_load_frontier_around(pcst_frontier_graph *frontier, const char *edges_sql,
+                                      const char *nodes_sql, text **seed_ids, int num_seeds,
+                                      text *root_id, int verbosity);
+
+/*
+ * Read the edges of nodes[0..num_nodes), appending new nodes with prize 0,
+ * or their prize after pcst_load_frontier_around
+ */
+extern void pcst_expand_frontier(pcst_frontier_graph *frontier, const int *nodes,
+                                 int num_nodes, int verbosity);
+
+/* Map a root ID to its internal index; NULL or '-1' means no root (-1) */
+extern int pcst_resolve_root(pcst_graph *graph, text *root_id, int verbosity);
+
+/* Map a pruning method name to the C wrapper's pruning code */
+extern int pcst_parse_pruning(text *pruning_text);
+
+#endif
@@ -0,0 +1,164 @@
+#include "pcst_perf.h"
+
+#include <string.h>
+#include <time.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+static const char* const phase_names[PCST_NUM_PHASES] = {
+    "load",
+    "construct",
+    "growth",
+    "simple_pruning",
+    "gw_pruning",
+    "strong_pruning",
+    "exact",
+    "repair"
+};
+
+static const char* const counter_names[PCST_NUM_COUNTERS] = {
+    "cycles",
+    "instructions",
+    "llc_misses",
+    "branch_misses"
+};
+
+static double monotonic_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+#ifdef __linux__
+
+static int open_counter(pcst_counter_t counter) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    switch (counter) {
+        case PCST_COUNTER_CYCLES: attr.config = PERF_COUNT_HW_CPU_CYCLES; break;
+        case PCST_COUNTER_INSTRUCTIONS: attr.config = PERF_COUNT_HW_INSTRUCTIONS; break;
+        case PCST_COUNTER_LLC_MISSES: attr.config = PERF_COUNT_HW_CACHE_MISSES; break;
+        case PCST_COUNTER_BRANCH_MISSES: attr.config = PERF_COUNT_HW_BRANCH_MISSES; break;
+        default: return -1;
+    }
+    // Count user space only so the counters also open with perf_event_paranoid=2
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    // Calling thread, any CPU, no group: each counter is independent so one
+    // unsupported event does not take the others down with it
+    return (int) syscall(__NR_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC);
+}
+
+// Read a counter, scaled up when the kernel had to multiplex it
+static long long read_counter(int fd) {
+    unsigned long long buf[3];  // value, time_enabled, time_running
+    if (read(fd, buf, sizeof(buf)) != (ssize_t) sizeof(buf)) {
+        return 0;
+    }
+    if (buf[2] == 0) {
+        return 0;
+    }
+    if (buf[2] < buf[1]) {
+        return (long long) ((double) buf[0] * buf[1] / buf[2]);
+    }
+    return (long long) buf[0];
+}
+
+static void close_counter(int fd) {
+    close(fd);
+}
+
+#else
+
+static int open_counter(pcst_counter_t counter) {
+    (void) counter;
+    return -1;
+}
+
+static long long read_counter(int fd) {
+    (void) fd;
+    return 0;
+}
+
+static void close_counter(int fd) {
+    (void) fd;
+}
+
+#endif
+
+void pcst_perf_open(pcst_perf_session_t* session, int collect_counters) {
+    memset(session, 0, sizeof(*session));
+    session->current_phase = -1;
+    for (int i = 0; i < PCST_NUM_COUNTERS; i++) {
+        session->fds[i] = collect_counters ? open_counter((pcst_counter_t) i) : -1;
+        if (session->fds[i] >= 0) {
+            session->num_available_counters++;
+        }
+    }
+}
+
+void pcst_perf_close(pcst_perf_session_t* session) {
+    pcst_perf_end(session);
+    for (int i = 0; i < PCST_NUM_COUNTERS; i++) {
+        if (session->fds[i] >= 0) {
+            close_counter(session->fds[i]);
+            session->fds[i] = -1;
+        }
+    }
+}
+
+void pcst_perf_begin(pcst_perf_session_t* session, pcst_phase_t phase) {
+    if (!session) {
+        return;
+    }
+    pcst_perf_end(session);
+
+    session->current_phase = phase;
+    for (int i = 0; i < PCST_NUM_COUNTERS; i++) {
+        if (session->fds[i] >= 0) {
+            session->phase_start_counters[i] = read_counter(session->fds[i]);
+        }
+    }
+    // Take the clock last so the counter reads are not charged to the phase
+    session->phase_start_time = monotonic_seconds();
+}
+
+void pcst_perf_end(pcst_perf_session_t* session) {
+    if (!session || session->current_phase < 0) {
+        return;
+    }
+    double now = monotonic_seconds();
+    pcst_phase_sample_t* sample = &session->phases[session->current_phase];
+
+    sample->num_samples++;
+    sample->wall_seconds += now - session->phase_start_time;
+    for (int i = 0; i < PCST_NUM_COUNTERS; i++) {
+        if (session->fds[i] >= 0) {
+            sample->counters[i] += read_counter(session->fds[i])
+                                   - session->phase_start_counters[i];
+        }
+    }
+    session->current_phase = -1;
+}
+
+int pcst_perf_counter_available(const pcst_perf_session_t* session,
+                                pcst_counter_t counter) {
+    return session->fds[counter] >= 0;
+}
+
+const char* pcst_perf_phase_name(pcst_phase_t phase) {
+    return phase_names[phase];
+}
+
+const char* pcst_perf_counter_name(pcst_counter_t counter) {
+    return counter_names[counter];
+}
@@ -0,0 +1,71 @@
+#ifndef PCST_PERF_H
+#define PCST_PERF_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Solver phases that are timed and, optionally, sampled with hardware counters
+typedef enum {
+    PCST_PHASE_LOAD = 0,          // reading edges and prizes
+    PCST_PHASE_CONSTRUCT,         // building edge parts, heaps and queues
+    PCST_PHASE_GROWTH,            // GW moat growth loop
+    PCST_PHASE_SIMPLE_PRUNING,    // marking good nodes, dropping inactive edges
+    PCST_PHASE_GW_PRUNING,        // reverse-delete over the phase 2 forest
+    PCST_PHASE_STRONG_PRUNING,    // dynamic programming over the phase 2 forest
+    PCST_PHASE_EXACT,             // branch and bound over small components
+    PCST_PHASE_REPAIR,            // reconnecting a result after edges failed
+    PCST_NUM_PHASES
+} pcst_phase_t;
+
+// Hardware counters read through perf_event_open
+typedef enum {
+    PCST_COUNTER_CYCLES = 0,
+    PCST_COUNTER_INSTRUCTIONS,
+    PCST_COUNTER_LLC_MISSES,
+    PCST_COUNTER_BRANCH_MISSES,
+    PCST_NUM_COUNTERS
+} pcst_counter_t;
+
+// Accumulated totals for one phase
+typedef struct {
+    int num_samples;              // how often the phase was entered
+    double wall_seconds;
+    long long counters[PCST_NUM_COUNTERS];
+} pcst_phase_sample_t;
+
+// One measurement session, usually covering a single solve.
+// Counters that cannot be opened (no kernel support, perf_event_paranoid,
+// container seccomp profile, ...) are skipped; wall-clock timing always works.
+typedef struct {
+    int fds[PCST_NUM_COUNTERS];   // -1 when the counter is unavailable
+    int num_available_counters;
+    int current_phase;            // -1 when no phase is open
+    double phase_start_time;
+    long long phase_start_counters[PCST_NUM_COUNTERS];
+    pcst_phase_sample_t phases[PCST_NUM_PHASES];
+} pcst_perf_session_t;
+
+// Start a session. With collect_counters == 0 only wall-clock time is taken.
+void pcst_perf_open(pcst_perf_session_t* session, int collect_counters);
+
+// Close the counter file descriptors; the samples stay readable
+void pcst_perf_close(pcst_perf_session_t* session);
+
+// Begin a phase, ending the currently open one first. NULL session is a no-op.
+void pcst_perf_begin(pcst_perf_session_t* session, pcst_phase_t phase);
+
+// End the currently open phase, if any. NULL session is a no-op.
+void pcst_perf_end(pcst_perf_session_t* session);
+
+int pcst_perf_counter_available(const pcst_perf_session_t* session,
+                                pcst_counter_t counter);
+
+const char* pcst_perf_phase_name(pcst_phase_t phase);
+const char* pcst_perf_counter_name(pcst_counter_t counter);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
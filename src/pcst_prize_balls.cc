@@ -0,0 +1,175 @@
+#include "pcst_prize_balls.h"
+
+#include <functional>
+#include <limits>
+#include <queue>
+#include <vector>
+
+using cluster_approx::PrizeBalls;
+using std::make_pair;
+using std::pair;
+using std::vector;
+
+
+// Relative slack on the radii against rounding differences
+static const double kRadiusSlack = 1e-9;
+
+
+// Union-find root with path halving
+static int find_component(vector<int>& parent, int node) {
+  while (parent[node] != node) {
+    parent[node] = parent[parent[node]];
+    node = parent[node];
+  }
+  return node;
+}
+
+
+PrizeBalls::PrizeBalls(const vector<pair<int, int> >& edges,
+                       const vector<double>& prizes,
+                       const vector<double>& costs,
+                       double max_growth_time)
+    : num_removed(0) {
+  int num_nodes = static_cast<int>(prizes.size());
+  int num_edges = static_cast<int>(edges.size());
+
+  // Radius and edge cost sum of every component
+  vector<int> component(num_nodes);
+  for (int ii = 0; ii < num_nodes; ++ii) {
+    component[ii] = ii;
+  }
+  for (int ii = 0; ii < num_edges; ++ii) {
+    int uu = find_component(component, edges[ii].first);
+    int vv = find_component(component, edges[ii].second);
+    if (uu != vv) {
+      component[uu] = vv;
+    }
+  }
+  vector<double> radius(num_nodes, 0.0);
+  vector<double> total_cost(num_nodes, 0.0);
+  double total_prize = 0.0;
+  for (int ii = 0; ii < num_nodes; ++ii) {
+    component[ii] = find_component(component, ii);
+    if (prizes[ii] > 0.0) {
+      radius[component[ii]] += prizes[ii];
+      total_prize += prizes[ii];
+    }
+  }
+  double max_radius = total_prize / 2.0;
+  if (max_growth_time >= 0.0 && max_growth_time < max_radius) {
+    max_radius = max_growth_time;
+  }
+  for (int ii = 0; ii < num_nodes; ++ii) {
+    if (radius[ii] > max_radius) {
+      radius[ii] = max_radius;
+    }
+    // Distances and growth times are summed in different orders
+    radius[ii] *= 1.0 + kRadiusSlack;
+  }
+  for (int ii = 0; ii < num_edges; ++ii) {
+    total_cost[component[edges[ii].first]] += costs[ii];
+  }
+
+  // Components whose radius covers all of their edge costs are within reach
+  // everywhere; only the others are searched
+  vector<bool> kept(num_nodes, false);
+  vector<int> sources;
+  for (int ii = 0; ii < num_nodes; ++ii) {
+    double cur_radius = radius[component[ii]];
+    if (cur_radius > 0.0 && cur_radius >= total_cost[component[ii]]) {
+      kept[ii] = true;
+    } else if (prizes[ii] > 0.0) {
+      sources.push_back(ii);
+    }
+  }
+
+  if (!sources.empty()) {
+    // Incidence lists in CSR form
+    vector<int> adjacency_start(num_nodes + 1, 0);
+    for (int ii = 0; ii < num_edges; ++ii) {
+      adjacency_start[edges[ii].first + 1] += 1;
+      adjacency_start[edges[ii].second + 1] += 1;
+    }
+    for (int ii = 0; ii < num_nodes; ++ii) {
+      adjacency_start[ii + 1] += adjacency_start[ii];
+    }
+    vector<int> adjacency_edge(2 * num_edges);
+    vector<int> fill(adjacency_start.begin(), adjacency_start.end() - 1);
+    for (int ii = 0; ii < num_edges; ++ii) {
+      adjacency_edge[fill[edges[ii].first]++] = ii;
+      adjacency_edge[fill[edges[ii].second]++] = ii;
+    }
+
+    // Multi-source Dijkstra from the prize nodes, bounded by the radius of
+    // their component
+    const double kInfinity = std::numeric_limits<double>::infinity();
+    vector<double> distance(num_nodes, kInfinity);
+    typedef pair<double, int> QueueEntry;
+    std::priority_queue<QueueEntry, vector<QueueEntry>,
+                        std::greater<QueueEntry> > queue;
+    for (size_t ii = 0; ii < sources.size(); ++ii) {
+      distance[sources[ii]] = 0.0;
+      queue.push(make_pair(0.0, sources[ii]));
+    }
+    while (!queue.empty()) {
+      QueueEntry cur = queue.top();
+      queue.pop();
+      int cur_node = cur.second;
+      if (kept[cur_node] || cur.first > distance[cur_node]) {
+        continue;
+      }
+      kept[cur_node] = true;
+      double cur_radius = radius[component[cur_node]];
+      for (int ii = adjacency_start[cur_node];
+           ii < adjacency_start[cur_node + 1]; ++ii) {
+        int cur_edge = adjacency_edge[ii];
+        int next_node = edges[cur_edge].first == cur_node
+                        ? edges[cur_edge].second : edges[cur_edge].first;
+        double next_distance = cur.first + costs[cur_edge];
+        if (next_distance <= cur_radius && next_distance < distance[next_node]) {
+          distance[next_node] = next_distance;
+          queue.push(make_pair(next_distance, next_node));
+        }
+      }
+    }
+  }
+
+  vector<int> kept_index(num_nodes, -1);
+  for (int ii = 0; ii < num_nodes; ++ii) {
+    if (kept[ii]) {
+      kept_index[ii] = static_cast<int>(node_map.size());
+      node_map.push_back(ii);
+      kept_prizes.push_back(prizes[ii]);
+    } else {
+      num_removed += 1;
+    }
+  }
+  for (int ii = 0; ii < num_edges; ++ii) {
+    int uu = kept_index[edges[ii].first];
+    int vv = kept_index[edges[ii].second];
+    if (uu >= 0 && vv >= 0) {
+      edge_map.push_back(ii);
+      kept_edges.push_back(make_pair(uu, vv));
+      kept_costs.push_back(costs[ii]);
+    }
+  }
+}
+
+
+void PrizeBalls::restore(vector<int>* nodes, vector<int>* edges) const {
+  for (size_t ii = 0; ii < nodes->size(); ++ii) {
+    (*nodes)[ii] = node_map[(*nodes)[ii]];
+  }
+  for (size_t ii = 0; ii < edges->size(); ++ii) {
+    (*edges)[ii] = edge_map[(*edges)[ii]];
+  }
+}
+
+
+size_t PrizeBalls::memory_bytes() const {
+  return kept_edges.capacity() * sizeof(kept_edges[0])
+         + kept_prizes.capacity() * sizeof(double)
+         + kept_costs.capacity() * sizeof(double)
+         + node_map.capacity() * sizeof(int)
+         + edge_map.capacity() * sizeof(int);
+}
@@ -0,0 +1,59 @@
+#ifndef __PCST_PRIZE_BALLS_H__
+#define __PCST_PRIZE_BALLS_H__
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace cluster_approx {
+
+// Drops the nodes that unrooted GW growth can never reach. Moats cover
+// distance at most as fast as growth time passes, so every node GW grows to
+// lies within the final growth time of some positive-prize node. That time
+// is bounded three ways: growth towards one tree keeps at least two clusters
+// active, and the moats of all clusters together grow by at most the total
+// prize, so it ends by half the total prize; the moats of one component grow
+// by at most the component's prize sum; and max_growth_time caps it
+// outright. A multi-source Dijkstra from all prize nodes, bounded by the
+// smallest of these radii, finds the nodes to keep. Components without
+// prizes are dropped entirely, and components whose radius covers all of
+// their edge costs are kept whole without searching.
+//
+// Exact for unrooted solves that want one tree. With more trees GW also
+// returns single zero-prize nodes, which may lie outside the balls.
+class PrizeBalls {
+ public:
+  // max_growth_time < 0 means growth is not capped
+  PrizeBalls(const std::vector<std::pair<int, int> >& edges,
+             const std::vector<double>& prizes,
+             const std::vector<double>& costs,
+             double max_growth_time);
+
+  int num_removed_nodes() const { return num_removed; }
+
+  // The kept subgraph. Kept node ii is original node node_map[ii]; kept
+  // edge jj is original edge edge_map[jj].
+  const std::vector<std::pair<int, int> >& get_edges() const {
+    return kept_edges;
+  }
+  const std::vector<double>& get_prizes() const { return kept_prizes; }
+  const std::vector<double>& get_costs() const { return kept_costs; }
+  int original_node(int node) const { return node_map[node]; }
+
+  // Map a solution of the kept subgraph back to original indices, in place
+  void restore(std::vector<int>* nodes, std::vector<int>* edges) const;
+
+  size_t memory_bytes() const;
+
+ private:
+  int num_removed;
+  std::vector<std::pair<int, int> > kept_edges;
+  std::vector<double> kept_prizes;
+  std::vector<double> kept_costs;
+  std::vector<int> node_map;
+  std::vector<int> edge_map;
+};
+
+}  // namespace cluster_approx
+
+#endif
@@ -0,0 +1,473 @@
+#include "pcst_repair.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <vector>
+
+using cluster_approx::TreeRepair;
+using std::make_pair;
+using std::pair;
+using std::vector;
+
+
+// Region of nodes the search has not reached, and of the nodes of trees
+// that lost no edge, which paths must not pass
+static const int kUnreached = -1;
+static const int kBlocked = -2;
+
+
+// Union-find root with path halving
+static int find_component(vector<int>& parent, int node) {
+  while (parent[node] != node) {
+    parent[node] = parent[parent[node]];
+    node = parent[node];
+  }
+  return node;
+}
+
+
+TreeRepair::TreeRepair(const vector<pair<int, int> >& edges_,
+                       const vector<double>& prizes_,
+                       const vector<double>& costs_)
+    : edges(edges_), prizes(prizes_), costs(costs_), fragments(0),
+      reconnections(0), settled_nodes(0) {
+  int num_nodes = static_cast<int>(prizes.size());
+  int num_edges = static_cast<int>(edges.size());
+
+  adjacency_begin.assign(num_nodes + 1, 0);
+  for (int ii = 0; ii < num_edges; ++ii) {
+    adjacency_begin[edges[ii].first + 1] += 1;
+    adjacency_begin[edges[ii].second + 1] += 1;
+  }
+  for (int ii = 0; ii < num_nodes; ++ii) {
+    adjacency_begin[ii + 1] += adjacency_begin[ii];
+  }
+  adjacency.resize(2 * num_edges);
+  vector<int> fill(adjacency_begin.begin(), adjacency_begin.end() - 1);
+  for (int ii = 0; ii < num_edges; ++ii) {
+    adjacency[fill[edges[ii].first]++] = ii;
+    adjacency[fill[edges[ii].second]++] = ii;
+  }
+
+  local_index.assign(num_nodes, -1);
+  distance.assign(num_nodes, std::numeric_limits<double>::infinity());
+  region.assign(num_nodes, kUnreached);
+  pred_edge.assign(num_nodes, -1);
+  settled.assign(num_nodes, 0);
+  failed.assign(num_edges, 0);
+}
+
+
+int TreeRepair::touch(int node) {
+  if (local_index[node] < 0) {
+    local_index[node] = static_cast<int>(touched.size());
+    touched.push_back(node);
+  }
+  return local_index[node];
+}
+
+
+void TreeRepair::repair(const vector<int>& solution_edges,
+                        const vector<int>& failed_edges,
+                        int root,
+                        bool one_tree,
+                        vector<int>* result_nodes,
+                        vector<int>* result_edges) {
+  result_nodes->clear();
+  result_edges->clear();
+  fragments = 0;
+  reconnections = 0;
+  settled_nodes = 0;
+  scanned.clear();
+  const double kInfinity = std::numeric_limits<double>::infinity();
+
+  for (size_t ii = 0; ii < failed_edges.size(); ++ii) {
+    failed[failed_edges[ii]] = 1;
+  }
+  vector<int> tree_edges(solution_edges);
+  std::sort(tree_edges.begin(), tree_edges.end());
+  tree_edges.erase(std::unique(tree_edges.begin(), tree_edges.end()),
+                   tree_edges.end());
+
+  // The nodes of the solution come first in touched
+  for (size_t ii = 0; ii < tree_edges.size(); ++ii) {
+    touch(edges[tree_edges[ii]].first);
+    touch(edges[tree_edges[ii]].second);
+  }
+  if (root >= 0) {
+    touch(root);
+  }
+  int num_tree_nodes = static_cast<int>(touched.size());
+
+  // Trees of the solution, and their fragments without the failed edges
+  vector<int> tree(num_tree_nodes);
+  vector<int> fragment(num_tree_nodes);
+  for (int ii = 0; ii < num_tree_nodes; ++ii) {
+    tree[ii] = ii;
+    fragment[ii] = ii;
+  }
+  for (size_t ii = 0; ii < tree_edges.size(); ++ii) {
+    int uu = local_index[edges[tree_edges[ii]].first];
+    int vv = local_index[edges[tree_edges[ii]].second];
+    tree[find_component(tree, uu)] = find_component(tree, vv);
+    if (!failed[tree_edges[ii]]) {
+      fragment[find_component(fragment, uu)] = find_component(fragment, vv);
+    }
+  }
+  vector<char> broken(num_tree_nodes, 0);
+  for (size_t ii = 0; ii < tree_edges.size(); ++ii) {
+    if (failed[tree_edges[ii]]) {
+      broken[find_component(tree, local_index[edges[tree_edges[ii]].first])] = 1;
+    }
+  }
+  if (one_tree && num_tree_nodes > 0) {
+    int num_pieces = 0;
+    for (int ii = 0; ii < num_tree_nodes; ++ii) {
+      tree[ii] = 0;
+      num_pieces += fragment[ii] == ii;
+    }
+    broken[0] = num_pieces > 1;
+  }
+
+  // Fragments of the broken trees are the sources of the search, and the
+  // nodes of the other trees block it
+  vector<int> fragment_index(num_tree_nodes, -1);
+  vector<int> fragment_tree;
+  vector<double> fragment_value;
+  for (int ii = 0; ii < num_tree_nodes; ++ii) {
+    int cur_tree = find_component(tree, ii);
+    if (!broken[cur_tree]) {
+      region[touched[ii]] = kBlocked;
+      continue;
+    }
+    int cur_fragment = find_component(fragment, ii);
+    if (fragment_index[cur_fragment] < 0) {
+      fragment_index[cur_fragment] = static_cast<int>(fragment_tree.size());
+      fragment_tree.push_back(cur_tree);
+      fragment_value.push_back(0.0);
+    }
+    region[touched[ii]] = fragment_index[cur_fragment];
+    distance[touched[ii]] = 0.0;
+    fragment_value[fragment_index[cur_fragment]] += prizes[touched[ii]];
+  }
+  for (size_t ii = 0; ii < tree_edges.size(); ++ii) {
+    int cur_region = region[edges[tree_edges[ii]].first];
+    if (!failed[tree_edges[ii]] && cur_region >= 0) {
+      fragment_value[cur_region] -= costs[tree_edges[ii]];
+    }
+  }
+  fragments = static_cast<int>(fragment_tree.size());
+
+  // Every broken tree keeps the fragment of the root, or else its most
+  // valuable one. Joining the others gains at most their positive net
+  // prizes, so no path worth taking is longer, and a tree whose fragments
+  // are all joined needs no more search.
+  vector<int> anchor(num_tree_nodes, -1);
+  vector<int> num_unjoined(num_tree_nodes, 0);
+  vector<double> limit(num_tree_nodes, 0.0);
+  for (int ii = 0; ii < fragments; ++ii) {
+    int cur_tree = fragment_tree[ii];
+    num_unjoined[cur_tree] += 1;
+    if (anchor[cur_tree] < 0
+        || fragment_value[ii] > fragment_value[anchor[cur_tree]]) {
+      anchor[cur_tree] = ii;
+    }
+  }
+  if (root >= 0 && region[root] >= 0) {
+    anchor[fragment_tree[region[root]]] = region[root];
+  }
+  for (int ii = 0; ii < fragments; ++ii) {
+    if (ii != anchor[fragment_tree[ii]]) {
+      limit[fragment_tree[ii]] += std::max(0.0, fragment_value[ii]);
+    }
+  }
+  vector<char> open(num_tree_nodes, 0);
+  int num_open = 0;
+  for (int ii = 0; ii < num_tree_nodes; ++ii) {
+    if (anchor[ii] >= 0 && num_unjoined[ii] > 1 && limit[ii] > 0.0) {
+      open[ii] = 1;
+      num_open += 1;
+    }
+  }
+
+  // Multi-source Dijkstra from the fragments of the open trees. An edge
+  // between two settled regions of the same tree is a path between their
+  // fragments; any path not found yet is longer than the current distance,
+  // so paths up to it are joined in order of length (Kruskal on the
+  // fragments). The fragments are settled up front, without the queue, so
+  // the queue only holds the nodes around them. The anchor does not grow a
+  // region: every other fragment searches until it meets it, so a large
+  // tree losing a small piece only searches around the piece.
+  Queue queue;
+  Queue paths;
+  vector<int> joined(fragments);
+  for (int ii = 0; ii < fragments; ++ii) {
+    joined[ii] = ii;
+  }
+  vector<int> path_edges;
+  for (int ii = 0; ii < num_tree_nodes && num_open > 0; ++ii) {
+    int cur_region = region[touched[ii]];
+    if (cur_region >= 0 && open[fragment_tree[cur_region]]) {
+      settled[touched[ii]] = 1;
+    }
+  }
+  for (int ii = 0; ii < num_tree_nodes && num_open > 0; ++ii) {
+    int cur_node = touched[ii];
+    if (settled[cur_node]
+        && region[cur_node] != anchor[fragment_tree[region[cur_node]]]) {
+      scan(cur_node, 0.0, fragment_tree, limit, &queue, &paths);
+    }
+  }
+  double joined_length = -1.0;
+  while (true) {
+    double next_length = queue.empty() ? kInfinity : queue.top().first;
+    if (next_length > joined_length) {
+      while (!paths.empty() && paths.top().first <= next_length
+             && num_open > 0) {
+        double length = paths.top().first;
+        int cur_edge = paths.top().second;
+        paths.pop();
+        int aa = region[edges[cur_edge].first];
+        int bb = region[edges[cur_edge].second];
+        int cur_tree = fragment_tree[aa];
+        int root_a = find_component(joined, aa);
+        int root_b = find_component(joined, bb);
+        if (!open[cur_tree] || length > limit[cur_tree] || root_a == root_b) {
+          continue;
+        }
+        joined[root_a] = root_b;
+        path_edges.push_back(cur_edge);
+        num_unjoined[cur_tree] -= 1;
+        if (num_unjoined[cur_tree] == 1) {
+          open[cur_tree] = 0;
+          num_open -= 1;
+        }
+      }
+      joined_length = next_length;
+    }
+    if (queue.empty() || num_open == 0) {
+      break;
+    }
+    pair<double, int> cur = queue.top();
+    queue.pop();
+    int cur_node = cur.second;
+    if (settled[cur_node] || cur.first > distance[cur_node]) {
+      continue;
+    }
+    if (!open[fragment_tree[region[cur_node]]]) {
+      continue;
+    }
+    settled[cur_node] = 1;
+    settled_nodes += 1;
+    scan(cur_node, cur.first, fragment_tree, limit, &queue, &paths);
+  }
+  reconnections = static_cast<int>(path_edges.size());
+
+  // The fragments with the paths between them form a forest: the paths
+  // from one region run through its shortest path tree, and the paths
+  // joined connect different fragments.
+  int num_touched = static_cast<int>(touched.size());
+  vector<char> kept(num_touched, 0);
+  vector<int> forest_edges;
+  for (int ii = 0; ii < num_tree_nodes; ++ii) {
+    kept[ii] = region[touched[ii]] >= 0;
+  }
+  for (size_t ii = 0; ii < tree_edges.size(); ++ii) {
+    if (!failed[tree_edges[ii]] && region[edges[tree_edges[ii]].first] >= 0) {
+      forest_edges.push_back(tree_edges[ii]);
+    }
+  }
+  for (size_t ii = 0; ii < path_edges.size(); ++ii) {
+    forest_edges.push_back(path_edges[ii]);
+    int ends[2] = {edges[path_edges[ii]].first, edges[path_edges[ii]].second};
+    for (int jj = 0; jj < 2; ++jj) {
+      int cur_node = ends[jj];
+      while (!kept[local_index[cur_node]]) {
+        kept[local_index[cur_node]] = 1;
+        int path_edge = pred_edge[cur_node];
+        forest_edges.push_back(path_edge);
+        cur_node = edges[path_edge].first == cur_node
+                   ? edges[path_edge].second : edges[path_edge].first;
+      }
+    }
+  }
+  vector<int> forest_begin(num_touched + 1, 0);
+  for (size_t ii = 0; ii < forest_edges.size(); ++ii) {
+    forest_begin[local_index[edges[forest_edges[ii]].first] + 1] += 1;
+    forest_begin[local_index[edges[forest_edges[ii]].second] + 1] += 1;
+  }
+  for (int ii = 0; ii < num_touched; ++ii) {
+    forest_begin[ii + 1] += forest_begin[ii];
+  }
+  vector<int> forest(2 * forest_edges.size());
+  vector<int> fill(forest_begin.begin(), forest_begin.end() - 1);
+  for (size_t ii = 0; ii < forest_edges.size(); ++ii) {
+    forest[fill[local_index[edges[forest_edges[ii]].first]]++] =
+        forest_edges[ii];
+    forest[fill[local_index[edges[forest_edges[ii]].second]]++] =
+        forest_edges[ii];
+  }
+
+  // Strong pruning of every tree of the forest by dynamic programming from
+  // its leaves: a subtree stays when its net prize pays for the edge to it.
+  // The best tree within a tree of the forest hangs from the node of largest
+  // net prize. A broken tree keeps the forest tree of its root, pruned from
+  // the root, or else the best one.
+  int root_tree = root >= 0 && region[root] >= 0
+                  ? fragment_tree[region[root]] : -1;
+  vector<int> order;
+  vector<int> parent_edge(num_touched, -1);
+  vector<char> visited(num_touched, 0);
+  vector<double> value(num_touched, 0.0);
+  vector<int> best_top(num_tree_nodes, -1);
+  for (int ii = -1; ii < num_touched; ++ii) {
+    int start = ii < 0 ? (root_tree >= 0 ? local_index[root] : -1) : ii;
+    if (start < 0 || !kept[start] || visited[start]) {
+      continue;
+    }
+    int cur_tree = fragment_tree[region[touched[start]]];
+    order.clear();
+    order.push_back(start);
+    visited[start] = 1;
+    for (size_t jj = 0; jj < order.size(); ++jj) {
+      int cur = order[jj];
+      for (int kk = forest_begin[cur]; kk < forest_begin[cur + 1]; ++kk) {
+        int cur_edge = forest[kk];
+        int next = local_index[edges[cur_edge].first] == cur
+                   ? local_index[edges[cur_edge].second]
+                   : local_index[edges[cur_edge].first];
+        if (!visited[next]) {
+          visited[next] = 1;
+          parent_edge[next] = cur_edge;
+          order.push_back(next);
+        }
+      }
+    }
+    for (size_t jj = order.size(); jj-- > 0; ) {
+      int cur = order[jj];
+      value[cur] += prizes[touched[cur]];
+      if (jj > 0) {
+        int cur_edge = parent_edge[cur];
+        int parent = local_index[edges[cur_edge].first] == cur
+                     ? local_index[edges[cur_edge].second]
+                     : local_index[edges[cur_edge].first];
+        value[parent] += std::max(0.0, value[cur] - costs[cur_edge]);
+      }
+    }
+    if (cur_tree == root_tree) {
+      if (ii < 0) {
+        best_top[cur_tree] = start;
+      }
+      continue;
+    }
+    for (size_t jj = 0; jj < order.size(); ++jj) {
+      if (best_top[cur_tree] < 0 || value[order[jj]] > value[best_top[cur_tree]]) {
+        best_top[cur_tree] = order[jj];
+      }
+    }
+  }
+
+  // Trees that lost no edge as they were
+  for (int ii = 0; ii < num_tree_nodes; ++ii) {
+    if (region[touched[ii]] == kBlocked) {
+      result_nodes->push_back(touched[ii]);
+    }
+  }
+  for (size_t ii = 0; ii < tree_edges.size(); ++ii) {
+    if (region[edges[tree_edges[ii]].first] == kBlocked) {
+      result_edges->push_back(tree_edges[ii]);
+    }
+  }
+  for (int ii = 0; ii < num_tree_nodes; ++ii) {
+    if (best_top[ii] < 0) {
+      continue;
+    }
+    order.clear();
+    order.push_back(best_top[ii]);
+    for (size_t jj = 0; jj < order.size(); ++jj) {
+      int cur = order[jj];
+      result_nodes->push_back(touched[cur]);
+      for (int kk = forest_begin[cur]; kk < forest_begin[cur + 1]; ++kk) {
+        int cur_edge = forest[kk];
+        int next = local_index[edges[cur_edge].first] == cur
+                   ? local_index[edges[cur_edge].second]
+                   : local_index[edges[cur_edge].first];
+        if (cur_edge != parent_edge[cur] && parent_edge[next] == cur_edge
+            && value[next] - costs[cur_edge] > 0.0) {
+          result_edges->push_back(cur_edge);
+          order.push_back(next);
+        }
+      }
+    }
+  }
+  std::sort(result_nodes->begin(), result_nodes->end());
+  std::sort(result_edges->begin(), result_edges->end());
+
+  reached.assign(touched.begin(), touched.end());
+  for (size_t ii = 0; ii < touched.size(); ++ii) {
+    int cur_node = touched[ii];
+    local_index[cur_node] = -1;
+    distance[cur_node] = kInfinity;
+    region[cur_node] = kUnreached;
+    pred_edge[cur_node] = -1;
+    settled[cur_node] = 0;
+  }
+  touched.clear();
+  for (size_t ii = 0; ii < failed_edges.size(); ++ii) {
+    failed[failed_edges[ii]] = 0;
+  }
+}
+
+
+void TreeRepair::scan(int node, double node_distance,
+                      const vector<int>& fragment_tree,
+                      const vector<double>& limit, Queue* queue,
+                      Queue* paths) {
+  int cur_tree = fragment_tree[region[node]];
+  scanned.push_back(node);
+  for (int ii = adjacency_begin[node]; ii < adjacency_begin[node + 1]; ++ii) {
+    int cur_edge = adjacency[ii];
+    if (failed[cur_edge]) {
+      continue;
+    }
+    int next_node = edges[cur_edge].first == node
+                    ? edges[cur_edge].second : edges[cur_edge].first;
+    if (region[next_node] == kBlocked) {
+      continue;
+    }
+    if (settled[next_node]) {
+      if (region[next_node] != region[node]
+          && fragment_tree[region[next_node]] == cur_tree) {
+        paths->push(make_pair(
+            node_distance + costs[cur_edge] + distance[next_node], cur_edge));
+      }
+      continue;
+    }
+    double next_distance = node_distance + costs[cur_edge];
+    if (next_distance <= limit[cur_tree]
+        && next_distance < distance[next_node]) {
+      touch(next_node);
+      distance[next_node] = next_distance;
+      region[next_node] = region[node];
+      pred_edge[next_node] = cur_edge;
+      queue->push(make_pair(next_distance, next_node));
+    }
+  }
+}
+
+
+size_t TreeRepair::memory_bytes() const {
+  return adjacency_begin.capacity() * sizeof(int)
+         + adjacency.capacity() * sizeof(int)
+         + local_index.capacity() * sizeof(int)
+         + distance.capacity() * sizeof(double)
+         + region.capacity() * sizeof(int)
+         + pred_edge.capacity() * sizeof(int)
+         + settled.capacity() * sizeof(char)
+         + failed.capacity() * sizeof(char)
+         + touched.capacity() * sizeof(int)
+         + scanned.capacity() * sizeof(int)
+         + reached.capacity() * sizeof(int);
+}
@@ -0,0 +1,111 @@
+#ifndef __PCST_REPAIR_H__
+#define __PCST_REPAIR_H__
+
+#include <cstddef>
+#include <functional>
+#include <queue>
+#include <utility>
+#include <vector>
+
+namespace cluster_approx {
+
+// Repairs a solution after some of its edges failed, without solving again.
+//
+// The failed edges cut the trees of the solution into fragments. Every
+// broken tree keeps an anchor, the fragment of the root or else its most
+// valuable one. One multi-source Dijkstra from the other fragments,
+// avoiding failed edges and the nodes of trees that lost none, splits their
+// surroundings into Voronoi regions, and the edges between two regions of
+// the same tree, or a region and its anchor, give the cheapest paths
+// between fragments (Mehlhorn's construction, as in DistanceNetwork). Paths
+// are taken in order of cost as long as they join fragments not joined
+// yet. The fragments and the paths form a forest, and strong pruning of it
+// decides which fragments are worth reconnecting: a fragment only stays
+// when its net prize pays for the path to it. A tree without a root keeps
+// its best piece.
+//
+// The search stops once all fragments of every tree are joined, and never
+// goes farther from a fragment than the net prize of the fragments that
+// could still be joined. So a repair looks at the neighbourhood of the
+// fragments cut off the anchors, and otherwise only goes over the edges of
+// the broken trees. Only the constructor, which builds the incidence lists,
+// touches the whole graph; keep one TreeRepair per graph for repeated
+// repairs.
+class TreeRepair {
+ public:
+  TreeRepair(const std::vector<std::pair<int, int> >& edges,
+             const std::vector<double>& prizes,
+             const std::vector<double>& costs);
+
+  // tree_edges is the solution, a tree or forest of the graph, and
+  // failed_edges the edges that can no longer be used, in the solution or
+  // not. With one_tree, all of tree_edges count as one tree, also where
+  // edges missing from them split it already. A tree containing root
+  // (-1 for none) keeps it; with one_tree, root joins the tree if it is not
+  // in it. Trees that lost no edge come back as they were.
+  void repair(const std::vector<int>& tree_edges,
+              const std::vector<int>& failed_edges,
+              int root,
+              bool one_tree,
+              std::vector<int>* result_nodes,
+              std::vector<int>* result_edges);
+
+  // After repair(): fragments of the broken trees, paths added between
+  // them, and nodes the search settled outside the fragments
+  int num_fragments() const { return fragments; }
+  int num_reconnections() const { return reconnections; }
+  long long num_settled_nodes() const { return settled_nodes; }
+
+  // After repair(): nodes whose edges the search read, and all nodes it
+  // reached, those and the nodes of the solution included. A caller that
+  // reads the graph as the search gets to it has the exact repair once it
+  // had the edges of every scanned node, and else reads the edges of the
+  // reached nodes and repairs again.
+  const std::vector<int>& get_scanned_nodes() const { return scanned; }
+  const std::vector<int>& get_reached_nodes() const { return reached; }
+
+  size_t memory_bytes() const;
+
+ private:
+  const std::vector<std::pair<int, int> >& edges;
+  const std::vector<double>& prizes;
+  const std::vector<double>& costs;
+
+  // Incidence lists: the edges of node ii are
+  // adjacency[adjacency_begin[ii]] to adjacency[adjacency_begin[ii + 1] - 1]
+  std::vector<int> adjacency_begin;
+  std::vector<int> adjacency;
+
+  // Per node and per edge, back to their initial values after every repair
+  std::vector<int> local_index;      // index in touched, -1 when untouched
+  std::vector<double> distance;      // from the nearest fragment
+  std::vector<int> region;           // fragment of that Voronoi region,
+                                     // kUnreached or kBlocked
+  std::vector<int> pred_edge;        // next edge towards the fragment
+  std::vector<char> settled;
+  std::vector<char> failed;          // per edge
+  std::vector<int> touched;
+  std::vector<int> scanned;
+  std::vector<int> reached;
+
+  int fragments;
+  int reconnections;
+  long long settled_nodes;
+
+  typedef std::priority_queue<std::pair<double, int>,
+                              std::vector<std::pair<double, int> >,
+                              std::greater<std::pair<double, int> > > Queue;
+
+  int touch(int node);
+
+  // Relax the edges of a settled node into queue, and push the edges to
+  // settled nodes of other regions of its tree into paths with the length
+  // of the path through them
+  void scan(int node, double node_distance,
+            const std::vector<int>& fragment_tree,
+            const std::vector<double>& limit, Queue* queue, Queue* paths);
+};
+
+}  // namespace cluster_approx
+
+#endif
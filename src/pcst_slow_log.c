@@ -0,0 +1,245 @@
+#include "pcst_slow_log.h"
+
+#include "lib/stringinfo.h"
+#include "utils/json.h"
+
+/* Flat key=value pairs or one JSON object, written by the same calls */
+typedef struct {
+    StringInfo buf;
+    pcst_log_format format;
+    const char *group;           // prefix of text keys, NULL at the top level
+    bool first;                  // nothing written at this level yet
+} log_writer;
+
+static const char *const pruning_names[] = {"none", "simple", "gw", "strong", "auto"};
+
+static void add_key(log_writer *w, const char *name) {
+    if (w->format == PCST_LOG_FORMAT_JSON) {
+        if (!w->first)
+            appendStringInfoString(w->buf, ", ");
+        escape_json(w->buf, name);
+        appendStringInfoString(w->buf, ": ");
+    } else {
+        if (!w->first)
+            appendStringInfoChar(w->buf, ' ');
+        if (w->group)
+            appendStringInfo(w->buf, "%s.", w->group);
+        appendStringInfo(w->buf, "%s=", name);
+    }
+    w->first = false;
+}
+
+static void begin_group(log_writer *w, const char *name) {
+    if (w->format == PCST_LOG_FORMAT_JSON) {
+        add_key(w, name);
+        appendStringInfoChar(w->buf, '{');
+        w->first = true;
+    }
+    w->group = name;
+}
+
+static void end_group(log_writer *w) {
+    if (w->format == PCST_LOG_FORMAT_JSON) {
+        appendStringInfoChar(w->buf, '}');
+        w->first = false;
+    }
+    w->group = NULL;
+}
+
+static void add_int(log_writer *w, const char *name, long long value) {
+    add_key(w, name);
+    appendStringInfo(w->buf, "%lld", value);
+}
+
+static void add_bool(log_writer *w, const char *name, bool value) {
+    add_key(w, name);
+    appendStringInfoString(w->buf, value ? "true" : "false");
+}
+
+/* Milliseconds and other measured values */
+static void add_double(log_writer *w, const char *name, double value) {
+    add_key(w, name);
+    appendStringInfo(w->buf, "%.3f", value);
+}
+
+/* Parameters given as numbers; NULL in JSON when absent */
+static void add_setting(log_writer *w, const char *name, double value, bool absent) {
+    add_key(w, name);
+    if (absent)
+        appendStringInfoString(w->buf, w->format == PCST_LOG_FORMAT_JSON ? "null" : "none");
+    else
+        appendStringInfo(w->buf, "%g", value);
+}
+
+/* Quoted and escaped in both formats, so that a value given by the caller
+ * (such as root_id) cannot break up the text line */
+static void add_string(log_writer *w, const char *name, const char *value) {
+    add_key(w, name);
+    if (value)
+        escape_json(w->buf, value);
+    else
+        appendStringInfoString(w->buf, w->format == PCST_LOG_FORMAT_JSON ? "null" : "none");
+}
+
+void pcst_slow_log_begin(pcst_slow_log *log, int log_min_duration, pcst_options_t *options) {
+    log->active = log_min_duration >= 0;
+    log->phases = NULL;
+    if (!log->active)
+        return;
+    INSTR_TIME_SET_CURRENT(log->start);
+    if (options && !options->perf) {
+        pcst_perf_open(&log->perf, 0);
+        options->perf = &log->perf;
+    }
+    if (options)
+        log->phases = options->perf;
+}
+
+void pcst_slow_log_end(pcst_slow_log *log, int log_min_duration, pcst_log_format format,
+                       const pcst_slow_log_call *call, const pcst_options_t *options,
+                       pcst_result_t *const *results, int num_results) {
+    instr_time duration;
+    pcst_stats_t total;
+    pcst_memory_usage_t peaks[PCST_MAX_MEMORY_ENTRIES];
+    int num_peaks = 0;
+    long long result_nodes = 0;
+    long long result_edges = 0;
+    StringInfoData buf;
+    log_writer w;
+
+    if (!log->active)
+        return;
+    INSTR_TIME_SET_CURRENT(duration);
+    INSTR_TIME_SUBTRACT(duration, log->start);
+    if (log->phases == &log->perf)
+        pcst_perf_close(&log->perf);
+    if (log_min_duration < 0 || INSTR_TIME_GET_MILLISEC(duration) < log_min_duration)
+        return;
+
+    memset(&total, 0, sizeof(total));
+    for (int i = 0; i < num_results; i++) {
+        const pcst_stats_t *s = &results[i]->stats;
+
+        total.total_num_edge_events += s->total_num_edge_events;
+        total.num_deleted_edge_events += s->num_deleted_edge_events;
+        total.num_merged_edge_events += s->num_merged_edge_events;
+        total.total_num_merge_events += s->total_num_merge_events;
+        total.total_num_edge_growth_events += s->total_num_edge_growth_events;
+        total.num_cluster_events += s->num_cluster_events;
+        total.num_uninserted_edges += s->num_uninserted_edges;
+        total.num_event_buckets += s->num_event_buckets;
+        total.num_expanded_nodes += s->num_expanded_nodes;
+        total.final_growth_time = Max(total.final_growth_time, s->final_growth_time);
+        total.growth_time_capped |= s->growth_time_capped;
+        result_nodes += results[i]->num_nodes;
+        result_edges += results[i]->num_edges;
+
+        for (int m = 0; m < s->num_memory_entries; m++) {
+            int p = 0;
+
+            while (p < num_peaks && strcmp(peaks[p].name, s->memory[m].name) != 0)
+                p++;
+            if (p == num_peaks) {
+                if (num_peaks == PCST_MAX_MEMORY_ENTRIES)
+                    continue;
+                peaks[num_peaks] = s->memory[m];
+                num_peaks++;
+            }
+            peaks[p].peak_bytes = Max(peaks[p].peak_bytes, s->memory[m].peak_bytes);
+        }
+    }
+
+    initStringInfo(&buf);
+    w.buf = &buf;
+    w.format = format;
+    w.group = NULL;
+    w.first = true;
+    if (format == PCST_LOG_FORMAT_JSON)
+        appendStringInfoChar(&buf, '{');
+
+    add_string(&w, "function", call->function);
+    add_double(&w, "duration_ms", INSTR_TIME_GET_MILLISEC(duration));
+
+    begin_group(&w, "graph");
+    add_int(&w, "nodes", call->num_nodes);
+    add_int(&w, "edges", call->num_edges);
+    if (call->num_groups > 0)
+        add_int(&w, "groups", call->num_groups);
+    end_group(&w);
+
+    begin_group(&w, "parameters");
+    add_string(&w, "root", call->root_id);
+    add_int(&w, "num_clusters", call->num_clusters);
+    add_string(&w, "pruning", call->pruning_method >= 0 && call->pruning_method <= PCST_PRUNING_AUTO
+                              ? pruning_names[call->pruning_method] : NULL);
+    add_setting(&w, "max_growth_time", options->max_growth_time, options->max_growth_time < 0.0);
+    add_bool(&w, "lazy_edges", options->lazy_edges);
+    add_setting(&w, "event_bucket_epsilon", options->event_bucket_epsilon, false);
+    add_string(&w, "distance_network", options->distance_network < 0 ? "auto"
+                                       : options->distance_network ? "on" : "off");
+    end_group(&w);
+
+    // Groups may each get their own plan
+    if (num_results == 1) {
+        const pcst_plan_t *plan = &results[0]->plan;
+
+        begin_group(&w, "plan");
+        add_bool(&w, "automatic", plan->automatic);
+        add_string(&w, "pruning", plan->pruning_method >= 0 && plan->pruning_method <= 3
+                                  ? pruning_names[plan->pruning_method] : NULL);
+        add_bool(&w, "tree_dp", plan->tree_dp);
+        add_bool(&w, "peel_tails", plan->peel_tails);
+        add_bool(&w, "prize_balls", plan->prize_balls);
+        add_bool(&w, "distance_network", plan->distance_network);
+        add_bool(&w, "lazy_edges", plan->lazy_edges);
+        add_bool(&w, "exact", plan->exact);
+        end_group(&w);
+    }
+
+    if (log->phases) {
+        begin_group(&w, "phases_ms");
+        for (int p = 0; p < PCST_NUM_PHASES; p++) {
+            const pcst_phase_sample_t *sample = &log->phases->phases[p];
+
+            if (sample->num_samples > 0)
+                add_double(&w, pcst_perf_phase_name((pcst_phase_t) p),
+                           1000.0 * sample->wall_seconds);
+        }
+        end_group(&w);
+    }
+
+    begin_group(&w, "events");
+    add_int(&w, "edge_events", total.total_num_edge_events);
+    add_int(&w, "deleted_edge_events", total.num_deleted_edge_events);
+    add_int(&w, "merged_edge_events", total.num_merged_edge_events);
+    add_int(&w, "merge_events", total.total_num_merge_events);
+    add_int(&w, "edge_growth_events", total.total_num_edge_growth_events);
+    add_int(&w, "cluster_events", total.num_cluster_events);
+    add_int(&w, "uninserted_edges", total.num_uninserted_edges);
+    add_int(&w, "event_buckets", total.num_event_buckets);
+    add_int(&w, "expanded_nodes", total.num_expanded_nodes);
+    end_group(&w);
+
+    begin_group(&w, "growth");
+    add_double(&w, "final_time", total.final_growth_time);
+    add_bool(&w, "time_capped", total.growth_time_capped);
+    end_group(&w);
+
+    begin_group(&w, "memory_peak_bytes");
+    for (int p = 0; p < num_peaks; p++)
+        add_int(&w, peaks[p].name, (long long) peaks[p].peak_bytes);
+    end_group(&w);
+
+    begin_group(&w, "result");
+    add_int(&w, "nodes", result_nodes);
+    add_int(&w, "edges", result_edges);
+    if (num_results == 1)
+        add_bool(&w, "optimal", results[0]->stats.optimal);
+    end_group(&w);
+
+    if (format == PCST_LOG_FORMAT_JSON)
+        appendStringInfoChar(&buf, '}');
+
+    ereport(LOG, (errmsg("pcst_fast slow call: %s", buf.data)));
+    pfree(buf.data);
+}
@@ -0,0 +1,64 @@
+#ifndef PCST_SLOW_LOG_H
+#define PCST_SLOW_LOG_H
+
+#include "postgres.h"
+#include "portability/instr_time.h"
+
+#include "pcst_fast_c_wrapper.h"
+#include "pcst_perf.h"
+
+/*
+ * One log line per slow call, in the spirit of auto_explain.
+ *
+ * A call is timed from before its queries are read until its results are
+ * ready. When it took at least pcst_fast.log_min_duration, a single LOG
+ * message describes it: graph size, parameters, the plan, wall time per
+ * solver phase, event counters, memory peaks and the result size. Calls
+ * under the threshold pay for a clock read per phase and nothing else.
+ */
+
+/* pcst_fast.log_format */
+typedef enum {
+    PCST_LOG_FORMAT_TEXT = 0,
+    PCST_LOG_FORMAT_JSON
+} pcst_log_format;
+
+/* What was asked of the call being logged */
+typedef struct {
+    const char *function;        // SQL function name
+    const char *root_id;         // original root node ID, NULL when unrooted
+    int num_nodes;               // summed over the graphs of grouped calls
+    int num_edges;
+    int num_groups;              // graphs solved, 0 for single-graph calls
+    int num_clusters;
+    int pruning_method;          // as requested, PCST_PRUNING_AUTO included
+} pcst_slow_log_call;
+
+/* A call being timed */
+typedef struct {
+    bool active;                 // log_min_duration was not -1 at the start
+    instr_time start;
+    pcst_perf_session_t perf;    // wall-clock phases, unless the caller has a session
+    const pcst_perf_session_t *phases;  // session the phases are taken from, or NULL
+} pcst_slow_log;
+
+/*
+ * Start timing a call; nothing is timed when log_min_duration is -1. If
+ * options->perf is NULL it is pointed at a wall-clock session, so that the
+ * solver phases get timed. Pass NULL options when the solver runs on
+ * several threads, which must not share a session.
+ */
+extern void pcst_slow_log_begin(pcst_slow_log *log, int log_min_duration,
+                                pcst_options_t *options);
+
+/*
+ * Finish timing the call and log it if it took at least log_min_duration
+ * milliseconds. Counters of several results are summed, memory peaks are
+ * the largest of any result.
+ */
+extern void pcst_slow_log_end(pcst_slow_log *log, int log_min_duration,
+                              pcst_log_format format, const pcst_slow_log_call *call,
+                              const pcst_options_t *options,
+                              pcst_result_t *const *results, int num_results);
+
+#endif
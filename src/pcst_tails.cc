@@ -0,0 +1,173 @@
+#include "pcst_tails.h"
+
+#include <vector>
+
+using cluster_approx::TailPeeling;
+using std::make_pair;
+using std::vector;
+
+
+TailPeeling::TailPeeling(const vector<std::pair<int, int> >& edges,
+                         const vector<double>& prizes,
+                         const vector<double>& costs_,
+                         int root)
+    : costs(costs_), best_tail_node(-1), best_tail_value(0.0),
+      core_root(-1) {
+  int num_nodes = static_cast<int>(prizes.size());
+  int num_edges = static_cast<int>(edges.size());
+
+  // Incidence lists in CSR form
+  vector<int> adjacency_start(num_nodes + 1, 0);
+  for (int ii = 0; ii < num_edges; ++ii) {
+    adjacency_start[edges[ii].first + 1] += 1;
+    adjacency_start[edges[ii].second + 1] += 1;
+  }
+  for (int ii = 0; ii < num_nodes; ++ii) {
+    adjacency_start[ii + 1] += adjacency_start[ii];
+  }
+  vector<int> adjacency_edge(2 * num_edges);
+  vector<int> fill(adjacency_start.begin(), adjacency_start.end() - 1);
+  for (int ii = 0; ii < num_edges; ++ii) {
+    adjacency_edge[fill[edges[ii].first]++] = ii;
+    adjacency_edge[fill[edges[ii].second]++] = ii;
+  }
+
+  // Peel nodes with at most one unpeeled neighbor until only the 2-core (and
+  // the root) is left. Self-loops count twice and are never peeled.
+  vector<int> degree(num_nodes);
+  vector<bool> queued(num_nodes, false);
+  vector<int> stack;
+  for (int ii = 0; ii < num_nodes; ++ii) {
+    degree[ii] = adjacency_start[ii + 1] - adjacency_start[ii];
+    if (ii != root && degree[ii] <= 1) {
+      queued[ii] = true;
+      stack.push_back(ii);
+    }
+  }
+
+  parent.assign(num_nodes, -1);
+  parent_edge.assign(num_nodes, -1);
+  vector<bool> peeled(num_nodes, false);
+  while (!stack.empty()) {
+    int cur_node = stack.back();
+    stack.pop_back();
+    peeled[cur_node] = true;
+    peel_order.push_back(cur_node);
+
+    for (int ii = adjacency_start[cur_node];
+         ii < adjacency_start[cur_node + 1]; ++ii) {
+      int cur_edge = adjacency_edge[ii];
+      int next_node = edges[cur_edge].first == cur_node
+                      ? edges[cur_edge].second : edges[cur_edge].first;
+      if (peeled[next_node]) {
+        continue;
+      }
+      parent[cur_node] = next_node;
+      parent_edge[cur_node] = cur_edge;
+      degree[next_node] -= 1;
+      if (next_node != root && degree[next_node] <= 1 && !queued[next_node]) {
+        queued[next_node] = true;
+        stack.push_back(next_node);
+      }
+      break;
+    }
+  }
+
+  // Tail DP: children are peeled before their parent, so every value is
+  // final by the time it is passed up
+  value = prizes;
+  keep.assign(num_nodes, false);
+  for (size_t ii = 0; ii < peel_order.size(); ++ii) {
+    int cur_node = peel_order[ii];
+    if (best_tail_node < 0 || value[cur_node] > best_tail_value) {
+      best_tail_node = cur_node;
+      best_tail_value = value[cur_node];
+    }
+    if (parent[cur_node] >= 0) {
+      double gain = value[cur_node] - costs[parent_edge[cur_node]];
+      if (gain > 0.0) {
+        keep[cur_node] = true;
+        value[parent[cur_node]] += gain;
+      }
+    }
+  }
+
+  vector<int> core_index(num_nodes, -1);
+  for (int ii = 0; ii < num_nodes; ++ii) {
+    if (!peeled[ii]) {
+      core_index[ii] = static_cast<int>(core_node_map.size());
+      core_node_map.push_back(ii);
+      core_prizes.push_back(value[ii]);
+    }
+  }
+  for (int ii = 0; ii < num_edges; ++ii) {
+    int uu = core_index[edges[ii].first];
+    int vv = core_index[edges[ii].second];
+    if (uu >= 0 && vv >= 0) {
+      core_edge_map.push_back(ii);
+      core_edges.push_back(make_pair(uu, vv));
+      core_costs.push_back(costs[ii]);
+    }
+  }
+  if (root >= 0) {
+    core_root = core_index[root];
+  }
+}
+
+
+void TailPeeling::expand(const vector<int>& core_result_nodes,
+                         const vector<int>& core_result_edges,
+                         bool allow_standalone,
+                         vector<int>* result_nodes,
+                         vector<int>* result_edges) const {
+  result_nodes->clear();
+  result_edges->clear();
+  vector<bool> selected(value.size(), false);
+
+  double core_value = 0.0;
+  for (size_t ii = 0; ii < core_result_nodes.size(); ++ii) {
+    core_value += core_prizes[core_result_nodes[ii]];
+  }
+  for (size_t ii = 0; ii < core_result_edges.size(); ++ii) {
+    core_value -= core_costs[core_result_edges[ii]];
+  }
+
+  if (allow_standalone && best_tail_node >= 0
+      && best_tail_value > core_value) {
+    selected[best_tail_node] = true;
+    result_nodes->push_back(best_tail_node);
+  } else {
+    for (size_t ii = 0; ii < core_result_nodes.size(); ++ii) {
+      int node = core_node_map[core_result_nodes[ii]];
+      selected[node] = true;
+      result_nodes->push_back(node);
+    }
+    for (size_t ii = 0; ii < core_result_edges.size(); ++ii) {
+      result_edges->push_back(core_edge_map[core_result_edges[ii]]);
+    }
+  }
+
+  // Parents come after their children in peel_order
+  for (int ii = static_cast<int>(peel_order.size()) - 1; ii >= 0; --ii) {
+    int cur_node = peel_order[ii];
+    if (keep[cur_node] && selected[parent[cur_node]]) {
+      selected[cur_node] = true;
+      result_nodes->push_back(cur_node);
+      result_edges->push_back(parent_edge[cur_node]);
+    }
+  }
+}
+
+
+size_t TailPeeling::memory_bytes() const {
+  return peel_order.capacity() * sizeof(int)
+         + parent.capacity() * sizeof(int)
+         + parent_edge.capacity() * sizeof(int)
+         + value.capacity() * sizeof(double)
+         + keep.capacity() / 8
+         + core_edges.capacity() * sizeof(core_edges[0])
+         + core_prizes.capacity() * sizeof(double)
+         + core_costs.capacity() * sizeof(double)
+         + core_node_map.capacity() * sizeof(int)
+         + core_edge_map.capacity() * sizeof(int);
+}
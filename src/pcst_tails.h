@@ -0,0 +1,76 @@
+#ifndef __PCST_TAILS_H__
+#define __PCST_TAILS_H__
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace cluster_approx {
+
+// Splits a graph into its 2-core and the trees hanging off it (the pendant
+// tree-shaped blocks of the block-cut tree). Tails are solved exactly by
+// dynamic programming: each tail's best net value (prizes minus costs) is
+// folded into the prize of the core node it hangs from, so GW only runs on
+// the core. The root, if any, is never peeled.
+//
+// Folding is exact for every solution that contains the attachment node.
+// Trees lying entirely inside a tail are covered by expand() for the
+// unrooted one-tree case.
+class TailPeeling {
+ public:
+  TailPeeling(const std::vector<std::pair<int, int> >& edges,
+              const std::vector<double>& prizes,
+              const std::vector<double>& costs,
+              int root);
+
+  int num_peeled_nodes() const { return static_cast<int>(peel_order.size()); }
+
+  // The core, with tail values folded into its prizes. Core node ii is
+  // original node core_node_map[ii]; core edge jj is original edge
+  // core_edge_map[jj]. core_root is -1 without a root.
+  const std::vector<std::pair<int, int> >& get_core_edges() const {
+    return core_edges;
+  }
+  const std::vector<double>& get_core_prizes() const { return core_prizes; }
+  const std::vector<double>& get_core_costs() const { return core_costs; }
+  int get_core_root() const { return core_root; }
+
+  // Net value of the best tree inside a single tail, 0 without tails
+  double get_best_tail_value() const {
+    return best_tail_node >= 0 ? best_tail_value : 0.0;
+  }
+
+  // Map a solution of the core back to the original graph and add the parts
+  // of the tails worth keeping. With allow_standalone, the best tree inside
+  // a single tail replaces the core solution when it is worth more.
+  void expand(const std::vector<int>& core_result_nodes,
+              const std::vector<int>& core_result_edges,
+              bool allow_standalone,
+              std::vector<int>* result_nodes,
+              std::vector<int>* result_edges) const;
+
+  size_t memory_bytes() const;
+
+ private:
+  const std::vector<double>& costs;
+
+  // Peeled nodes, leaves first: every node comes after all of its children
+  std::vector<int> peel_order;
+  std::vector<int> parent;        // next node towards the core, -1 if none
+  std::vector<int> parent_edge;
+  std::vector<double> value;      // best net value of the subtree topped here
+  std::vector<bool> keep;         // subtree is worth its edge to the parent
+  int best_tail_node;             // top of the best tree inside a tail
+  double best_tail_value;
+
+  std::vector<std::pair<int, int> > core_edges;
+  std::vector<double> core_prizes;
+  std::vector<double> core_costs;
+  std::vector<int> core_node_map;
+  std::vector<int> core_edge_map;
+  int core_root;
+};
+
+}  // namespace cluster_approx
+
+#endif
@@ -0,0 +1,278 @@
+#include "pcst_threads.h"
+
+#include <limits.h>
+#include <unistd.h>
+
+#include "miscadmin.h"
+#include "access/xact.h"
+#include "storage/ipc.h"
+#include "storage/lwlock.h"
+#include "storage/shmem.h"
+
+/* Budget totals, in shared memory or backend-local */
+typedef struct {
+    int threads_in_use;
+    int peak_threads_in_use;
+    int64 num_grants;
+    int64 num_reduced_grants;
+} pcst_thread_counters;
+
+typedef struct {
+    LWLock *lock;
+    pcst_thread_counters counters;
+    int num_slots;               // one per possible backend
+    pcst_thread_holder holders[FLEXIBLE_ARRAY_MEMBER];  // pid 0: free slot
+} pcst_thread_shared;
+
+static pcst_thread_shared *shared_budget = NULL;   // NULL unless preloaded
+static pcst_thread_counters local_counters;        // used without shared memory
+static pcst_thread_holder my_holding;              // threads this backend holds
+static int my_slot = -1;
+static bool cleanup_registered = false;
+
+/*
+ * Threads this backend holds, by the subtransaction that took them, so that
+ * an error caught by a savepoint or an exception block returns them. Grants
+ * beyond the last record are added to it, and are then returned with it.
+ */
+#define PCST_MAX_GRANT_RECORDS 32
+
+typedef struct {
+    SubTransactionId subxid;
+    int granted;
+} pcst_thread_grant;
+
+static pcst_thread_grant my_grants[PCST_MAX_GRANT_RECORDS];
+static int num_my_grants = 0;
+
+static shmem_request_hook_type prev_shmem_request_hook = NULL;
+static shmem_startup_hook_type prev_shmem_startup_hook = NULL;
+
+static Size shared_budget_size(void) {
+    return add_size(offsetof(pcst_thread_shared, holders),
+                    mul_size(MaxBackends, sizeof(pcst_thread_holder)));
+}
+
+static void threads_shmem_request(void) {
+    if (prev_shmem_request_hook)
+        prev_shmem_request_hook();
+    RequestAddinShmemSpace(shared_budget_size());
+    RequestNamedLWLockTranche("pcst_fast", 1);
+}
+
+static void threads_shmem_startup(void) {
+    bool found;
+
+    if (prev_shmem_startup_hook)
+        prev_shmem_startup_hook();
+
+    LWLockAcquire(AddinShmemInitLock, LW_EXCLUSIVE);
+    shared_budget = ShmemInitStruct("pcst_fast thread budget", shared_budget_size(), &found);
+    if (!found) {
+        memset(shared_budget, 0, shared_budget_size());
+        shared_budget->lock = &(GetNamedLWLockTranche("pcst_fast"))->lock;
+        shared_budget->num_slots = MaxBackends;
+    }
+    LWLockRelease(AddinShmemInitLock);
+}
+
+void pcst_threads_shmem_init(void) {
+    if (!process_shared_preload_libraries_in_progress)
+        return;
+    prev_shmem_request_hook = shmem_request_hook;
+    shmem_request_hook = threads_shmem_request;
+    prev_shmem_startup_hook = shmem_startup_hook;
+    shmem_startup_hook = threads_shmem_startup;
+}
+
+/* 0 means one thread per online CPU */
+static int resolve_limit(int max_total_threads) {
+    if (max_total_threads > 0)
+        return max_total_threads;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return cpus > 0 ? (int) cpus : 1;
+}
+
+static pcst_thread_counters *lock_counters(LWLockMode mode) {
+    if (!shared_budget)
+        return &local_counters;
+    LWLockAcquire(shared_budget->lock, mode);
+    return &shared_budget->counters;
+}
+
+static void unlock_counters(void) {
+    if (shared_budget)
+        LWLockRelease(shared_budget->lock);
+}
+
+/* Publish this backend's holding in its slot; the budget lock must be held */
+static void publish_holding(void) {
+    if (!shared_budget)
+        return;
+    if (my_slot < 0) {
+        for (int i = 0; i < shared_budget->num_slots; i++) {
+            if (shared_budget->holders[i].pid == 0) {
+                my_slot = i;
+                break;
+            }
+        }
+        if (my_slot < 0)
+            return;
+    }
+    if (my_holding.granted > 0) {
+        shared_budget->holders[my_slot] = my_holding;
+    } else {
+        shared_budget->holders[my_slot].pid = 0;
+        my_slot = -1;
+    }
+}
+
+/* Give threads back to the budget */
+static void give_back(int granted) {
+    pcst_thread_counters *counters;
+
+    granted = Min(granted, my_holding.granted);
+    if (granted <= 0)
+        return;
+
+    counters = lock_counters(LW_EXCLUSIVE);
+    counters->threads_in_use -= granted;
+    my_holding.granted -= granted;
+    if (my_holding.granted == 0)
+        my_holding.requested = 0;
+    publish_holding();
+    unlock_counters();
+}
+
+/*
+ * Take up to `granted` threads off the records of subtransaction subxid and
+ * the ones started after it, latest first. Returns how many were taken.
+ */
+static int take_grants(SubTransactionId subxid, int granted) {
+    int taken = 0;
+    int kept = 0;
+
+    for (int i = num_my_grants - 1; i >= 0 && taken < granted; i--) {
+        if (my_grants[i].subxid < subxid)
+            continue;
+        int cur = Min(my_grants[i].granted, granted - taken);
+        my_grants[i].granted -= cur;
+        taken += cur;
+    }
+    for (int i = 0; i < num_my_grants; i++) {
+        if (my_grants[i].granted > 0)
+            my_grants[kept++] = my_grants[i];
+    }
+    num_my_grants = kept;
+    return taken;
+}
+
+static void release_all(void) {
+    num_my_grants = 0;
+    give_back(my_holding.granted);
+}
+
+/* Whatever a transaction still holds when it ends was lost to an error */
+static void threads_xact_callback(XactEvent event, void *arg) {
+    switch (event) {
+        case XACT_EVENT_ABORT:
+        case XACT_EVENT_PARALLEL_ABORT:
+        case XACT_EVENT_COMMIT:
+        case XACT_EVENT_PARALLEL_COMMIT:
+        case XACT_EVENT_PREPARE:
+            release_all();
+            break;
+        default:
+            break;
+    }
+}
+
+/* Threads taken in an aborted subtransaction, or its children, go back */
+static void threads_subxact_callback(SubXactEvent event, SubTransactionId mySubid,
+                                     SubTransactionId parentSubid, void *arg) {
+    if (event == SUBXACT_EVENT_ABORT_SUB)
+        give_back(take_grants(mySubid, INT_MAX));
+}
+
+static void threads_exit_callback(int code, Datum arg) {
+    release_all();
+}
+
+int pcst_threads_acquire(int requested, int max_total_threads) {
+    int limit = resolve_limit(max_total_threads);
+    pcst_thread_counters *counters;
+    int granted;
+
+    if (!cleanup_registered) {
+        RegisterXactCallback(threads_xact_callback, NULL);
+        RegisterSubXactCallback(threads_subxact_callback, NULL);
+        before_shmem_exit(threads_exit_callback, (Datum) 0);
+        cleanup_registered = true;
+    }
+    if (requested < 1)
+        requested = 1;
+
+    counters = lock_counters(LW_EXCLUSIVE);
+    granted = Min(requested, Max(limit - counters->threads_in_use, 1));
+    counters->threads_in_use += granted;
+    counters->peak_threads_in_use = Max(counters->peak_threads_in_use, counters->threads_in_use);
+    counters->num_grants++;
+    if (granted < requested)
+        counters->num_reduced_grants++;
+
+    my_holding.pid = MyProcPid;
+    my_holding.requested += requested;
+    my_holding.granted += granted;
+    publish_holding();
+    unlock_counters();
+
+    SubTransactionId subxid = GetCurrentSubTransactionId();
+    if (num_my_grants > 0 && (my_grants[num_my_grants - 1].subxid == subxid
+                              || num_my_grants == PCST_MAX_GRANT_RECORDS)) {
+        my_grants[num_my_grants - 1].granted += granted;
+    } else {
+        my_grants[num_my_grants].subxid = subxid;
+        my_grants[num_my_grants].granted = granted;
+        num_my_grants++;
+    }
+    return granted;
+}
+
+void pcst_threads_release(int granted) {
+    // Grants of an aborted subtransaction were returned already; a builder
+    // or solver freed afterwards along with its memory context finds none
+    give_back(take_grants(GetCurrentSubTransactionId(), granted));
+}
+
+void pcst_threads_get_info(pcst_thread_budget_info *info, int max_total_threads) {
+    pcst_thread_counters *counters = lock_counters(LW_SHARED);
+
+    info->max_total_threads = resolve_limit(max_total_threads);
+    info->threads_in_use = counters->threads_in_use;
+    info->peak_threads_in_use = counters->peak_threads_in_use;
+    info->num_grants = counters->num_grants;
+    info->num_reduced_grants = counters->num_reduced_grants;
+    info->shared = shared_budget != NULL;
+    unlock_counters();
+}
+
+pcst_thread_holder *pcst_threads_get_holders(int *num_holders) {
+    pcst_thread_holder *holders;
+
+    *num_holders = 0;
+    if (!shared_budget) {
+        holders = (pcst_thread_holder *) palloc(sizeof(pcst_thread_holder));
+        if (my_holding.granted > 0)
+            holders[(*num_holders)++] = my_holding;
+        return holders;
+    }
+
+    holders = (pcst_thread_holder *) palloc(shared_budget->num_slots * sizeof(pcst_thread_holder));
+    LWLockAcquire(shared_budget->lock, LW_SHARED);
+    for (int i = 0; i < shared_budget->num_slots; i++) {
+        if (shared_budget->holders[i].pid != 0)
+            holders[(*num_holders)++] = shared_budget->holders[i];
+    }
+    LWLockRelease(shared_budget->lock);
+    return holders;
+}
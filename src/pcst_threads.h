@@ -0,0 +1,62 @@
+#ifndef PCST_THREADS_H
+#define PCST_THREADS_H
+
+#include "postgres.h"
+
+/*
+ * Server-wide budget of solver threads, shared by all backends.
+ *
+ * Every solve takes threads from the budget before it starts and returns
+ * them when it is done. A solve always gets at least one thread (the
+ * backend's own), so the budget only limits parallelism beyond that. The
+ * budget lives in shared memory when the library is in
+ * shared_preload_libraries; otherwise each backend keeps its own and only
+ * its own solves are bounded.
+ */
+
+/* Threads held by one backend */
+typedef struct {
+    int pid;
+    int requested;
+    int granted;
+} pcst_thread_holder;
+
+/* Snapshot of the budget */
+typedef struct {
+    int max_total_threads;       // resolved limit (0 in the GUC means CPUs)
+    int threads_in_use;
+    int peak_threads_in_use;
+    int64 num_grants;
+    int64 num_reduced_grants;    // grants that got fewer threads than requested
+    bool shared;                 // budget is in shared memory
+} pcst_thread_budget_info;
+
+/* Install the shared memory hooks; call from _PG_init */
+extern void pcst_threads_shmem_init(void);
+
+/*
+ * Take up to `requested` threads from the budget, bounded by
+ * max_total_threads (0: number of CPUs). Returns the number granted, at
+ * least 1. Held threads are returned by pcst_threads_release, or
+ * automatically when the subtransaction that took them aborts, when the
+ * transaction ends and on backend exit.
+ */
+extern int pcst_threads_acquire(int requested, int max_total_threads);
+
+/*
+ * Return `granted` threads taken by pcst_threads_acquire in the current
+ * subtransaction or one it started. Threads already returned by an abort are
+ * not returned twice, so this is safe in cleanup after an error.
+ */
+extern void pcst_threads_release(int granted);
+
+/* Current totals of the budget */
+extern void pcst_threads_get_info(pcst_thread_budget_info *info, int max_total_threads);
+
+/*
+ * Backends currently holding threads, palloc'd in the current memory
+ * context. Without shared memory only this backend is reported.
+ */
+extern pcst_thread_holder *pcst_threads_get_holders(int *num_holders);
+
+#endif
@@ -1,6 +1,8 @@
 #ifndef __PRIORITY_QUEUE_H__
 #define __PRIORITY_QUEUE_H__
 
+#include <climits>
+#include <cmath>
 #include <map>
 #include <set>
 #include <vector>
@@ -10,13 +12,43 @@ namespace cluster_approx {
 template <typename ValueType, typename IndexType>
 class PriorityQueue {
  public:
-  PriorityQueue() {}
+  PriorityQueue()
+      : bucket_epsilon(0.0), log_bucket_base(0.0), bucket_bytes(0) {}
+
+  // With epsilon > 0, values are rounded up to the next power of
+  // (1 + epsilon) (values <= 0 to 0) and elements with the same rounded value
+  // share a bucket. get_min and delete_min return the rounded value and take
+  // the elements of the lowest bucket in no particular order, so insertion
+  // and deletion cost a lookup among the buckets, not among the elements.
+  // 0 restores exact ordering. Elements already queued are moved over.
+  void set_bucket_epsilon(double epsilon) {
+    std::vector<std::pair<ValueType, IndexType> > elements;
+    while (!is_empty()) {
+      ValueType value;
+      IndexType index;
+      delete_min(&value, &index);
+      elements.push_back(std::make_pair(value, index));
+    }
+    bucket_epsilon = epsilon > 0.0 ? epsilon : 0.0;
+    log_bucket_base = std::log1p(bucket_epsilon);
+    for (size_t ii = 0; ii < elements.size(); ++ii) {
+      insert(elements[ii].first, elements[ii].second);
+    }
+  }
 
   bool is_empty() {
-    return sorted_set.empty();
+    return bucket_epsilon > 0.0 ? buckets.empty() : sorted_set.empty();
   }
 
   bool get_min(ValueType* value, IndexType* index) {
+    if (bucket_epsilon > 0.0) {
+      if (buckets.empty()) {
+        return false;
+      }
+      *value = buckets.begin()->second.value;
+      *index = buckets.begin()->second.members.back();
+      return true;
+    }
     if (sorted_set.empty()) {
       return false;
     }
@@ -26,16 +58,25 @@ class PriorityQueue {
   }
 
   bool delete_min(ValueType* value, IndexType* index) {
-    if (sorted_set.empty()) {
+    if (!get_min(value, index)) {
       return false;
     }
-    *value = sorted_set.begin()->first;
-    *index = sorted_set.begin()->second;
-    sorted_set.erase(sorted_set.begin());
+    if (bucket_epsilon > 0.0) {
+      delete_element(*index);
+    } else {
+      sorted_set.erase(sorted_set.begin());
+    }
     return true;
   }
 
   void insert(ValueType value, IndexType index) {
+    if (bucket_epsilon > 0.0) {
+      if (index >= static_cast<int>(index_to_bucket.size())) {
+        index_to_bucket.resize(index + 1);
+      }
+      insert_into_bucket(value, index);
+      return;
+    }
     if (index >= static_cast<int>(index_to_iterator.size())) {
       index_to_iterator.resize(index + 1);
     }
@@ -44,19 +85,109 @@ class PriorityQueue {
   }
 
   void decrease_key(ValueType new_value, IndexType index) {
-    sorted_set.erase(index_to_iterator[index]);
-    index_to_iterator[index] =
-        sorted_set.insert(std::make_pair(new_value, index)).first;
+    delete_element(index);
+    insert(new_value, index);
   }
 
   void delete_element(IndexType index) {
+    if (bucket_epsilon > 0.0) {
+      // Swap with the last member so the bucket stays dense
+      BucketIterator bucket = index_to_bucket[index].first;
+      std::vector<IndexType>& members = bucket->second.members;
+      size_t position = index_to_bucket[index].second;
+      members[position] = members.back();
+      index_to_bucket[members[position]].second = position;
+      members.pop_back();
+      if (members.empty()) {
+        bucket_bytes -= sizeof(std::pair<long long, Bucket>) + kSetNodeOverhead
+                        + members.capacity() * sizeof(IndexType);
+        buckets.erase(bucket);
+      }
+      return;
+    }
     sorted_set.erase(index_to_iterator[index]);
   }
+
+  size_t size() {
+    if (bucket_epsilon > 0.0) {
+      size_t result = 0;
+      for (BucketIterator it = buckets.begin(); it != buckets.end(); ++it) {
+        result += it->second.members.size();
+      }
+      return result;
+    }
+    return sorted_set.size();
+  }
+
+  // Remove all elements; the index table keeps its capacity.
+  void clear() {
+    sorted_set.clear();
+    buckets.clear();
+    bucket_bytes = 0;
+  }
+
+  // Approximate number of bytes held by the queue: one red-black tree node
+  // per element (per bucket in bucket mode) plus the index tables. Constant
+  // time, so it can be taken after every event.
+  size_t memory_usage() {
+    return sorted_set.size() * (sizeof(std::pair<ValueType, IndexType>)
+                                + kSetNodeOverhead)
+           + bucket_bytes
+           + index_to_iterator.capacity() * sizeof(SetIterator)
+           + index_to_bucket.capacity() * sizeof(index_to_bucket[0]);
+  }
  
  private:
+  typedef typename std::set<std::pair<ValueType, IndexType> >::iterator
+      SetIterator;
+
+  struct Bucket {
+    ValueType value;                  // upper end of the bucket
+    std::vector<IndexType> members;
+  };
+  typedef typename std::map<long long, Bucket>::iterator BucketIterator;
+
+  // color + parent/left/right pointers of a std::set node
+  const static size_t kSetNodeOverhead = 4 * sizeof(void*);
+
+  void insert_into_bucket(ValueType value, IndexType index) {
+    long long key = LLONG_MIN;
+    ValueType rounded = 0;
+    if (value > 0 && std::isfinite(static_cast<double>(value))) {
+      key = static_cast<long long>(
+          std::ceil(std::log(static_cast<double>(value)) / log_bucket_base));
+      rounded = std::exp(key * log_bucket_base);
+      // Undo rounding errors of log / exp in either direction
+      while (rounded < value) {
+        key += 1;
+        rounded = std::exp(key * log_bucket_base);
+      }
+    } else if (value > 0) {
+      key = LLONG_MAX;
+      rounded = value;
+    }
+    std::pair<BucketIterator, bool> inserted =
+        buckets.insert(std::make_pair(key, Bucket()));
+    Bucket& bucket = inserted.first->second;
+    if (inserted.second) {
+      bucket.value = rounded;
+      bucket_bytes += sizeof(std::pair<long long, Bucket>) + kSetNodeOverhead;
+    }
+    index_to_bucket[index] = std::make_pair(inserted.first,
+                                            bucket.members.size());
+    size_t capacity = bucket.members.capacity();
+    bucket.members.push_back(index);
+    bucket_bytes += (bucket.members.capacity() - capacity) * sizeof(IndexType);
+  }
+
   std::set<std::pair<ValueType, IndexType> > sorted_set;
-  std::vector<typename std::set<std::pair<ValueType, IndexType> >::iterator>
-      index_to_iterator;
+  std::vector<SetIterator> index_to_iterator;
+
+  double bucket_epsilon;
+  double log_bucket_base;
+  std::map<long long, Bucket> buckets;
+  size_t bucket_bytes;                // tree nodes and members of buckets
+  std::vector<std::pair<BucketIterator, size_t> > index_to_bucket;
 };
 
 }  // namespace cluster_approx
@@ -0,0 +1,112 @@
+-- pgTAP tests for the exact step after GW (pcst_fast.exact_max_nodes)
+
+BEGIN;
+
+SELECT plan(9);
+
+-- GW with strong pruning gets 12 on this graph; the best tree, edges 2, 4,
+-- 5, 7 and 8, spans all nodes and is worth 13. Node 3 has no prize.
+CREATE TEMP TABLE exact_edges (id INTEGER, source INTEGER, target INTEGER, cost FLOAT8);
+CREATE TEMP TABLE exact_nodes (id INTEGER, prize FLOAT8);
+
+INSERT INTO exact_edges (id, source, target, cost) VALUES
+    (1, 1, 2, 4.0),
+    (2, 1, 3, 2.0),
+    (3, 2, 3, 3.0),
+    (4, 2, 4, 3.0),
+    (5, 2, 6, 1.0),
+    (6, 3, 4, 3.0),
+    (7, 3, 5, 4.0),
+    (8, 3, 6, 2.0),
+    (9, 4, 6, 4.0);
+
+INSERT INTO exact_nodes (id, prize) VALUES
+    (1, 4.0), (2, 4.0), (3, 0.0), (4, 6.0), (5, 5.0), (6, 6.0);
+
+CREATE TEMP VIEW exact_stats AS
+SELECT stat, value FROM pgr_pcst_fast_stats(
+    'SELECT id, source, target, cost FROM exact_edges',
+    'SELECT id, prize FROM exact_nodes',
+    NULL, 1, 'strong'
+);
+
+-- Test 1: Off by default
+SELECT is(
+    (SELECT value FROM exact_stats WHERE stat = 'plan.exact'),
+    0::float8,
+    'The exact step should be off by default'
+);
+
+-- Test 2: Without it GW is not known to be optimal here
+SELECT is(
+    (SELECT value FROM exact_stats WHERE stat = 'result.optimal'),
+    0::float8,
+    'A GW result should not be reported optimal'
+);
+
+SET LOCAL pcst_fast.exact_max_nodes = 10;
+
+-- Test 3: The exact step finds the best tree
+SELECT is(
+    (SELECT value FROM exact_stats WHERE stat = 'result.objective'),
+    13::float8,
+    'The exact step should find the best tree'
+);
+
+-- Test 4: ... and says so
+SELECT is(
+    (SELECT string_agg(stat || '=' || value, ',' ORDER BY stat) FROM exact_stats
+     WHERE stat IN ('plan.exact', 'plan.num_exact_components', 'result.optimal')),
+    'plan.exact=1,plan.num_exact_components=1,result.optimal=1',
+    'The result should be reported optimal'
+);
+
+-- Test 5: Its bound is the objective once the search has finished
+SELECT ok(
+    (SELECT value FROM exact_stats WHERE stat = 'result.objective_bound')
+        BETWEEN 13 - 1e-9 AND 13 + 1e-9,
+    'The objective bound should meet the objective'
+);
+
+-- Test 6: pgr_pcst_fast returns the same tree
+SELECT is(
+    (SELECT string_agg(edge, ',' ORDER BY edge::int)
+     FROM pgr_pcst_fast(
+        'SELECT id, source, target, cost FROM exact_edges',
+        'SELECT id, prize FROM exact_nodes',
+        NULL, 1, 'strong'
+    )),
+    '2,4,5,7,8',
+    'pgr_pcst_fast should return the best tree'
+);
+
+-- Test 7: Rooted solves keep the root
+SELECT ok(
+    (SELECT bool_or('3' IN (source, target))
+     FROM pgr_pcst_fast(
+        'SELECT id, source, target, cost FROM exact_edges',
+        'SELECT id, prize FROM exact_nodes',
+        '3', 1, 'strong'
+    )),
+    'A rooted exact solve should contain the root'
+);
+
+-- Test 8: Components above the limit are not searched
+SET LOCAL pcst_fast.exact_max_nodes = 5;
+SELECT is(
+    (SELECT string_agg(stat || '=' || value, ',' ORDER BY stat) FROM exact_stats
+     WHERE stat IN ('plan.exact', 'plan.num_exact_components')),
+    'plan.exact=1,plan.num_exact_components=0',
+    'A component above the limit should not be searched'
+);
+
+-- Test 9: The setting cannot be negative
+SELECT throws_ok(
+    $$SET LOCAL pcst_fast.exact_max_nodes = -1$$,
+    '22023',
+    NULL,
+    'A negative limit should be rejected'
+);
+
+SELECT finish();
+ROLLBACK;
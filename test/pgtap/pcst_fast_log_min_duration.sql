@@ -0,0 +1,110 @@
+-- pgTAP tests for slow call logging (pcst_fast.log_min_duration, pcst_fast.log_format)
+
+BEGIN;
+
+SELECT plan(9);
+
+CREATE TEMP TABLE log_edges (id INTEGER, source INTEGER, target INTEGER, cost FLOAT8);
+CREATE TEMP TABLE log_nodes (id INTEGER, prize FLOAT8);
+
+INSERT INTO log_edges (id, source, target, cost) VALUES
+    (1, 100, 101, 5.0),
+    (2, 101, 102, 8.0),
+    (3, 102, 103, 90.0);
+
+INSERT INTO log_nodes (id, prize) VALUES
+    (100, 50.0),
+    (101, 10.0),
+    (102, 15.0);
+
+-- Test 1: A call without logging, which also loads the library and its settings
+SELECT is(
+    (SELECT string_agg(edge::text, ',' ORDER BY seq) FROM pgr_pcst_fast(
+        'SELECT id, source, target, cost FROM log_edges',
+        'SELECT id, prize FROM log_nodes',
+        NULL, 1, 'strong', 0
+    )),
+    '1,2',
+    'A call should be solved with logging off'
+);
+
+-- Test 2: Logging is off by default
+SELECT is(
+    current_setting('pcst_fast.log_min_duration'),
+    '-1',
+    'pcst_fast.log_min_duration should default to -1'
+);
+
+-- Test 3: Text is the default format
+SELECT is(
+    current_setting('pcst_fast.log_format'),
+    'text',
+    'pcst_fast.log_format should default to text'
+);
+
+-- The log lines themselves go to the server log only
+SET LOCAL client_min_messages = warning;
+SET LOCAL pcst_fast.log_min_duration = 0;
+
+-- Test 4: Every call is logged in text
+SELECT is(
+    (SELECT string_agg(edge::text, ',' ORDER BY seq) FROM pgr_pcst_fast(
+        'SELECT id, source, target, cost FROM log_edges',
+        'SELECT id, prize FROM log_nodes',
+        NULL, 1, 'strong', 0
+    )),
+    '1,2',
+    'A logged call should return its usual result'
+);
+
+-- Test 5: A root id with spaces, quotes and '=' is quoted in the text line
+SELECT is(
+    (SELECT string_agg(edge::text, ',' ORDER BY seq) FROM pgr_pcst_fast(
+        $$SELECT 1 AS id, 'a b="c"' AS source, 'd' AS target, 1.0::float8 AS cost$$,
+        $$SELECT 'd' AS id, 5.0::float8 AS prize$$,
+        'a b="c"', 0, 'strong', 0
+    )),
+    '1',
+    'A call with a quoted root id should be logged'
+);
+
+SET LOCAL pcst_fast.log_format = json;
+
+-- Test 6: Every call is logged in JSON
+SELECT is(
+    (SELECT string_agg(edge::text, ',' ORDER BY seq) FROM pgr_pcst_fast(
+        'SELECT id, source, target, cost FROM log_edges',
+        'SELECT id, prize FROM log_nodes',
+        '100', 0, 'auto', 0
+    )),
+    '1,2',
+    'A call logged as JSON should return its usual result'
+);
+
+-- Test 7: Grouped calls are logged once, over all groups
+SELECT is(
+    (SELECT count(*) FROM pgr_pcst_fast_grouped(
+        'SELECT id % 2, id, source, target, cost FROM log_edges',
+        'SELECT g, id, prize FROM log_nodes, (VALUES (0), (1)) v(g)',
+        1, 'strong'
+    )),
+    2::bigint,
+    'A grouped call should be logged without changing its rows'
+);
+
+-- Test 8: Functions without a load phase are logged too
+SELECT lives_ok(
+    $$SELECT * FROM pcst_fast(ARRAY[[0,1],[1,2]], ARRAY[10,10,10]::float8[], ARRAY[1,1]::float8[], 0, 0, 'gw', 0)$$,
+    'The array-based function should be logged'
+);
+
+-- Test 9: Unknown formats are rejected
+SELECT throws_ok(
+    $$SET pcst_fast.log_format = xml$$,
+    '22023',
+    NULL,
+    'pcst_fast.log_format should only accept text and json'
+);
+
+SELECT finish();
+ROLLBACK;
@@ -0,0 +1,126 @@
+-- pgTAP tests for the solver thread budget (pcst_fast_thread_budget, pcst_fast_thread_usage)
+
+BEGIN;
+
+SELECT plan(10);
+
+-- Test 1: Functions exist
+SELECT has_function(
+    'public',
+    'pcst_fast_thread_budget',
+    ARRAY[]::text[],
+    'Function pcst_fast_thread_budget should exist'
+);
+
+SELECT has_function(
+    'public',
+    'pcst_fast_thread_holders',
+    ARRAY[]::text[],
+    'Function pcst_fast_thread_holders should exist'
+);
+
+-- Test 3: The budget resolves to at least one thread (0 means one per CPU)
+SELECT ok(
+    (SELECT max_total_threads >= 1 FROM pcst_fast_thread_budget()),
+    'max_total_threads should resolve to at least one thread'
+);
+
+CREATE TEMP TABLE budget_edges (id INTEGER, source INTEGER, target INTEGER, cost FLOAT8);
+CREATE TEMP TABLE budget_nodes (id INTEGER, prize FLOAT8);
+
+INSERT INTO budget_edges (id, source, target, cost) VALUES
+    (1, 100, 101, 5.0),
+    (2, 101, 102, 8.0);
+
+INSERT INTO budget_nodes (id, prize) VALUES
+    (100, 50.0),
+    (101, 10.0),
+    (102, 15.0);
+
+CREATE TEMP TABLE budget_before AS SELECT * FROM pcst_fast_thread_budget();
+
+SELECT COUNT(*) FROM pgr_pcst_fast(
+    'SELECT id, source, target, cost FROM budget_edges',
+    'SELECT id, prize FROM budget_nodes',
+    NULL, 1, 'strong', 0
+);
+
+-- Test 4: A solve takes threads from the budget
+SELECT ok(
+    (SELECT b.grants > o.grants AND b.peak_threads_in_use >= 1
+     FROM pcst_fast_thread_budget() b, budget_before o),
+    'A solve should be counted as a grant'
+);
+
+-- Test 5: Threads are returned when the solve finishes
+SELECT ok(
+    NOT EXISTS (SELECT 1 FROM pcst_fast_thread_usage WHERE pid = pg_backend_pid()),
+    'This backend should hold no threads after its solve finished'
+);
+
+-- Test 6: The usage view is queryable
+SELECT lives_ok(
+    'SELECT pid, usename, threads_requested, threads_granted, max_total_threads, query FROM pcst_fast_thread_usage',
+    'pcst_fast_thread_usage should be queryable'
+);
+
+-- Test 7: An edges query failing while the builder thread holds two threads,
+-- caught by an exception block, gives them back
+SET pcst_fast.builder_thread = on;
+DO $$
+BEGIN
+    PERFORM * FROM pgr_pcst_fast(
+        'SELECT id, source, target, cost / (id - 2) FROM budget_edges',
+        'SELECT id, prize FROM budget_nodes',
+        NULL, 1, 'strong', 0
+    );
+EXCEPTION WHEN division_by_zero THEN
+    NULL;
+END
+$$;
+RESET pcst_fast.builder_thread;
+
+SELECT is(
+    (SELECT threads_in_use FROM pcst_fast_thread_budget()),
+    0,
+    'Threads of a load caught by an exception block should be returned'
+);
+
+-- Test 8: The same for a frontier solve failing on a later fetch: the edges
+-- of node 103, reached from 102, have a NULL cost
+INSERT INTO budget_edges (id, source, target, cost) VALUES (3, 102, 103, 1.0), (4, 103, 104, 1.0);
+DO $$
+BEGIN
+    PERFORM * FROM pgr_pcst_fast_frontier(
+        'SELECT id, source, target, CASE WHEN id = 4 THEN NULL ELSE cost END
+         FROM budget_edges WHERE source = ANY($1) OR target = ANY($1)',
+        'SELECT id, prize FROM budget_nodes'
+    );
+EXCEPTION WHEN OTHERS THEN
+    NULL;
+END
+$$;
+
+SELECT is(
+    (SELECT threads_in_use FROM pcst_fast_thread_budget()),
+    0,
+    'Threads of a frontier solve caught by an exception block should be returned'
+);
+
+-- Test 9: Nor does this backend show up as a holder
+SELECT ok(
+    NOT EXISTS (SELECT 1 FROM pcst_fast_thread_usage WHERE pid = pg_backend_pid()),
+    'This backend should hold no threads after the caught errors'
+);
+
+-- Test 10: The budget is server-wide and cannot be changed per session
+SELECT throws_ok(
+    'SET pcst_fast.max_total_threads = 4',
+    '55P02',
+    NULL,
+    'pcst_fast.max_total_threads should only be settable in the server configuration'
+);
+
+SELECT finish();
+
+ROLLBACK;
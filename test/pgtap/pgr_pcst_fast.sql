@@ -4,7 +4,7 @@
 BEGIN;
 
 -- Load pgTAP
-SELECT plan(30);
+SELECT plan(47);
 
 -- Test 1: Extension is installed
 SELECT has_extension('pcst_fast', 'Extension pcst_fast should be installed');
@@ -535,6 +535,270 @@ BEGIN
 END;
 $test30$;
 
+-- Test 31: uuid node IDs are returned exactly as uuid::text
+SELECT is(
+    (SELECT string_agg(source || '>' || target, ',' ORDER BY edge) FROM pgr_pcst_fast(
+        'SELECT id::text, md5(source::text)::uuid AS source, md5(target::text)::uuid AS target, cost FROM test_edges',
+        'SELECT md5(id::text)::uuid AS id, prize FROM test_nodes',
+        NULL, 1, 'strong', 0
+    )),
+    (SELECT string_agg(md5(e.source::text)::uuid::text || '>' || md5(e.target::text)::uuid::text, ',' ORDER BY r.edge)
+     FROM pgr_pcst_fast(
+        'SELECT id::text, source::text, target::text, cost FROM test_edges',
+        'SELECT id::text, prize FROM test_nodes',
+        NULL, 1, 'strong', 0
+     ) r JOIN test_edges e ON e.id::text = r.edge),
+    'uuid node IDs should give the same solution and come back as uuid text'
+);
+
+-- Test 32: 32-character hex node IDs round-trip unchanged
+SELECT is(
+    (SELECT string_agg(source || '>' || target, ',' ORDER BY edge) FROM pgr_pcst_fast(
+        'SELECT id::text, md5(source::text) AS source, md5(target::text) AS target, cost FROM test_edges',
+        'SELECT md5(id::text) AS id, prize FROM test_nodes',
+        md5('102'), 0, 'gw', 0
+    )),
+    (SELECT string_agg(md5(e.source::text) || '>' || md5(e.target::text), ',' ORDER BY r.edge)
+     FROM pgr_pcst_fast(
+        'SELECT id::text, source::text, target::text, cost FROM test_edges',
+        'SELECT id::text, prize FROM test_nodes',
+        '102', 0, 'gw', 0
+     ) r JOIN test_edges e ON e.id::text = r.edge),
+    'hex node IDs should give the same solution and root lookup as plain IDs'
+);
+
+-- Test 33: IDs that only start out looking like hex fall back to text keys
+CREATE TEMP TABLE test_mixed_ids AS
+SELECT n AS id,
+       CASE WHEN n = (SELECT MAX(target) FROM test_edges) THEN 'node-' || n ELSE md5(n::text) END AS ext_id
+FROM (SELECT source AS n FROM test_edges UNION SELECT target FROM test_edges) ids;
+
+SELECT is(
+    (SELECT COUNT(*)::integer FROM pgr_pcst_fast(
+        $$SELECT e.id::text, s.ext_id AS source, t.ext_id AS target, e.cost
+          FROM test_edges e
+          JOIN test_mixed_ids s ON s.id = e.source
+          JOIN test_mixed_ids t ON t.id = e.target
+          ORDER BY t.ext_id LIKE 'node-%', e.id$$,
+        $$SELECT m.ext_id AS id, n.prize FROM test_nodes n JOIN test_mixed_ids m ON m.id = n.id$$,
+        NULL, 1, 'gw', 0
+    )),
+    (SELECT COUNT(*)::integer FROM pgr_pcst_fast(
+        'SELECT id::text, source::text, target::text, cost FROM test_edges',
+        'SELECT id::text, prize FROM test_nodes',
+        NULL, 1, 'gw', 0
+    )),
+    'Mixed hex and non-hex node IDs should still map consistently'
+);
+
+-- Test 34: Upper-case hex is a different ID and is not matched to lower-case keys
+SELECT throws_ok(
+    $$SELECT * FROM pgr_pcst_fast(
+        'SELECT id::text, md5(source::text) AS source, md5(target::text) AS target, cost FROM test_edges',
+        'SELECT md5(id::text) AS id, prize FROM test_nodes',
+        upper(md5('102')), 0, 'gw', 0
+    )$$,
+    NULL,
+    NULL,
+    'Root lookup on hex keys should stay case sensitive like text IDs'
+);
+
+-- Test 35: Edge IDs come back the same whether kept as integers, 16-byte keys or rows
+SELECT is(
+    (SELECT string_agg(edge, ',' ORDER BY edge) FROM pgr_pcst_fast(
+        'SELECT md5(id::text)::uuid AS id, source, target, cost FROM test_edges',
+        'SELECT id, prize FROM test_nodes',
+        NULL, 1, 'strong', 0
+    )),
+    (SELECT string_agg(md5(edge)::uuid::text, ',' ORDER BY md5(edge)::uuid::text) FROM pgr_pcst_fast(
+        'SELECT id, source, target, cost FROM test_edges',
+        'SELECT id, prize FROM test_nodes',
+        NULL, 1, 'strong', 0
+    )),
+    'uuid edge IDs should match the integer edge IDs of the same solution'
+);
+
+-- Test 36: Edge IDs that stop looking like hex fall back to the retained rows
+SELECT is(
+    (SELECT string_agg(edge, ',' ORDER BY edge) FROM pgr_pcst_fast(
+        $$SELECT CASE WHEN id = (SELECT MAX(id) FROM test_edges) THEN 'edge-' || id ELSE md5(id::text) END AS id,
+                 source, target, cost
+          FROM test_edges ORDER BY id$$,
+        'SELECT id, prize FROM test_nodes',
+        NULL, 1, 'strong', 0
+    )),
+    (SELECT string_agg(CASE WHEN edge::integer = (SELECT MAX(id) FROM test_edges) THEN 'edge-' || edge ELSE md5(edge) END,
+                       ',' ORDER BY CASE WHEN edge::integer = (SELECT MAX(id) FROM test_edges) THEN 'edge-' || edge ELSE md5(edge) END)
+     FROM pgr_pcst_fast(
+        'SELECT id, source, target, cost FROM test_edges',
+        'SELECT id, prize FROM test_nodes',
+        NULL, 1, 'strong', 0
+    )),
+    'Mixed hex and non-hex edge IDs should be returned unchanged'
+);
+
+-- Test 37: A time horizon before the first merge leaves no edges
+-- (101 and 102 meet at time 4, 102 and 103 at time 6)
+SET LOCAL pcst_fast.max_growth_time = 3;
+SELECT is(
+    (SELECT COUNT(*)::integer FROM pgr_pcst_fast(
+        'SELECT id, source, target, cost FROM test_edges',
+        'SELECT id, prize FROM test_nodes',
+        NULL, 1, 'strong', 0
+    )),
+    0,
+    'No edges should be selected when growth stops before the first merge'
+);
+
+-- Test 38: Growth frozen between the two merges keeps only the first edge
+SET LOCAL pcst_fast.max_growth_time = 4.5;
+SELECT is(
+    (SELECT string_agg(edge, ',' ORDER BY edge) FROM pgr_pcst_fast(
+        'SELECT id, source, target, cost FROM test_edges',
+        'SELECT id, prize FROM test_nodes',
+        NULL, 1, 'strong', 0
+    )),
+    '2',
+    'Only edges tight before max_growth_time should be selected'
+);
+
+-- Test 39: A horizon beyond the last event does not change the solution
+SET LOCAL pcst_fast.max_growth_time = 1000;
+SELECT is(
+    (SELECT string_agg(edge, ',' ORDER BY edge) FROM pgr_pcst_fast(
+        'SELECT id, source, target, cost FROM test_edges',
+        'SELECT id, prize FROM test_nodes',
+        NULL, 1, 'strong', 0
+    )),
+    (SELECT string_agg(edge, ',' ORDER BY edge) FROM pgr_pcst_fast(
+        'SELECT id, source, target, cost FROM test_edges',
+        'SELECT id, prize FROM test_nodes',
+        NULL, 1, 'strong', 0
+    )),
+    'A horizon past the last event should give the uncapped solution'
+);
+RESET pcst_fast.max_growth_time;
+
+-- Test 40: 'auto' is accepted and matches strong pruning
+SELECT is(
+    (SELECT string_agg(edge, ',' ORDER BY edge) FROM pgr_pcst_fast(
+        'SELECT id, source, target, cost FROM test_edges',
+        'SELECT id, prize FROM test_nodes',
+        NULL, 1, 'auto', 0
+    )),
+    (SELECT string_agg(edge, ',' ORDER BY edge) FROM pgr_pcst_fast(
+        'SELECT id, source, target, cost FROM test_edges',
+        'SELECT id, prize FROM test_nodes',
+        NULL, 1, 'strong', 0
+    )),
+    'auto should give the strong pruning solution'
+);
+
+-- Test 41: Rooted 'auto' on a tree (solved without growth) matches strong pruning
+SELECT is(
+    (SELECT string_agg(edge, ',' ORDER BY edge) FROM pgr_pcst_fast(
+        'SELECT id, source, target, cost FROM test_edges WHERE id < 4',
+        'SELECT id, prize FROM test_nodes',
+        '101', 1, 'auto', 0
+    )),
+    (SELECT string_agg(edge, ',' ORDER BY edge) FROM pgr_pcst_fast(
+        'SELECT id, source, target, cost FROM test_edges WHERE id < 4',
+        'SELECT id, prize FROM test_nodes',
+        '101', 1, 'strong', 0
+    )),
+    'Rooted auto on a tree should give the strong pruning solution'
+);
+
+-- Tests 42-43: Input built while the edges are read gives the same solutions
+CREATE TEMP TABLE builder_reference AS
+SELECT 'auto' AS solve, string_agg(edge, ',' ORDER BY edge) AS edges FROM pgr_pcst_fast(
+    'SELECT id, source, target, cost FROM test_edges',
+    'SELECT id, prize FROM test_nodes',
+    NULL, 1, 'auto', 0
+)
+UNION ALL
+SELECT 'rooted', string_agg(edge, ',' ORDER BY edge) FROM pgr_pcst_fast(
+    'SELECT id, source, target, cost FROM test_edges',
+    'SELECT id, prize FROM test_nodes',
+    '101', 1, 'strong', 0
+);
+
+SET LOCAL pcst_fast.builder_thread = on;
+
+SELECT is(
+    (SELECT string_agg(edge, ',' ORDER BY edge) FROM pgr_pcst_fast(
+        'SELECT id, source, target, cost FROM test_edges',
+        'SELECT id, prize FROM test_nodes',
+        NULL, 1, 'auto', 0
+    )),
+    (SELECT edges FROM builder_reference WHERE solve = 'auto'),
+    'Unrooted auto with pcst_fast.builder_thread should give the same solution'
+);
+
+SELECT is(
+    (SELECT string_agg(edge, ',' ORDER BY edge) FROM pgr_pcst_fast(
+        'SELECT id, source, target, cost FROM test_edges',
+        'SELECT id, prize FROM test_nodes',
+        '101', 1, 'strong', 0
+    )),
+    (SELECT edges FROM builder_reference WHERE solve = 'rooted'),
+    'Rooted strong with pcst_fast.builder_thread should give the same solution'
+);
+
+RESET pcst_fast.builder_thread;
+DROP TABLE builder_reference;
+
+-- Test 44: Array overload exists
+SELECT has_function(
+    'public',
+    'pgr_pcst_fast',
+    ARRAY['text', 'anyarray', 'double precision[]', 'text', 'integer', 'text', 'integer'],
+    'pgr_pcst_fast with node_ids and prizes arrays should exist'
+);
+
+-- Test 45: Prize arrays give the same solution as the nodes query
+SELECT is(
+    (SELECT string_agg(edge, ',' ORDER BY edge) FROM pgr_pcst_fast(
+        'SELECT id, source, target, cost FROM test_edges',
+        (SELECT array_agg(id) FROM test_nodes),
+        (SELECT array_agg(prize) FROM test_nodes),
+        NULL, 1, 'strong', 0
+    )),
+    (SELECT string_agg(edge, ',' ORDER BY edge) FROM pgr_pcst_fast(
+        'SELECT id, source, target, cost FROM test_edges',
+        'SELECT id, prize FROM test_nodes',
+        NULL, 1, 'strong', 0
+    )),
+    'Prize arrays should give the same solution as nodes_sql'
+);
+
+-- Test 46: Text IDs, unknown IDs and NULL entries in the arrays
+SELECT is(
+    (SELECT string_agg(edge, ',' ORDER BY edge) FROM pgr_pcst_fast(
+        'SELECT id, source, target, cost FROM test_edges',
+        ARRAY['101', '102', '103', '999', NULL],
+        ARRAY[10.0, 15.0, 40.0, 1000.0, 1000.0],
+        '101', 1, 'strong', 0
+    )),
+    (SELECT string_agg(edge, ',' ORDER BY edge) FROM pgr_pcst_fast(
+        'SELECT id, source, target, cost FROM test_edges',
+        'SELECT id, prize FROM test_nodes',
+        '101', 1, 'strong', 0
+    )),
+    'Text node IDs should match integer node IDs; unknown IDs and NULLs are ignored'
+);
+
+-- Test 47: Arrays of different lengths are rejected
+SELECT throws_ok(
+    $$SELECT * FROM pgr_pcst_fast(
+        'SELECT id, source, target, cost FROM test_edges',
+        ARRAY[101, 102], ARRAY[10.0]
+    )$$,
+    '2202E',
+    'node_ids and prizes must have the same length, got 2 and 1',
+    'node_ids and prizes of different lengths should be rejected'
+);
+
 -- Clean up
 DROP TABLE IF EXISTS test_edges;
 DROP TABLE IF EXISTS test_nodes;
@@ -0,0 +1,100 @@
+-- pgTAP tests for pgr_pcst_fast_delta function
+
+BEGIN;
+
+SELECT plan(7);
+
+-- Test 1: Function exists
+SELECT has_function(
+    'public',
+    'pgr_pcst_fast_delta',
+    ARRAY['text', 'text', 'anyarray', 'text', 'integer', 'text'],
+    'Function pgr_pcst_fast_delta should exist'
+);
+
+-- Path 1 - 2 - 3 - 4 is worth buying, the expensive edge to 5 is not
+CREATE TEMP TABLE delta_edges (id INTEGER, source INTEGER, target INTEGER, cost FLOAT8);
+CREATE TEMP TABLE delta_nodes (id INTEGER, prize FLOAT8);
+
+INSERT INTO delta_edges (id, source, target, cost) VALUES
+    (10, 1, 2, 1.0),
+    (20, 2, 3, 1.0),
+    (30, 3, 4, 1.0),
+    (40, 4, 5, 100.0);
+
+INSERT INTO delta_nodes (id, prize) VALUES
+    (1, 10.0), (2, 10.0), (3, 10.0), (4, 10.0);
+
+-- Test 2: Without a previous result every selected edge is added
+SELECT is(
+    (SELECT string_agg(change || ':' || edge || ':' || source || '-' || target, ',' ORDER BY seq)
+     FROM pgr_pcst_fast_delta(
+        'SELECT id, source, target, cost FROM delta_edges',
+        'SELECT id, prize FROM delta_nodes',
+        '{}'::integer[], NULL, 1, 'strong'
+    )),
+    'added:10:1-2,added:20:2-3,added:30:3-4',
+    'An empty previous result should report the whole tree as added'
+);
+
+-- Test 3: Objective deltas from nothing sum to the objective of the tree
+SELECT is(
+    (SELECT sum(objective_delta) FROM pgr_pcst_fast_delta(
+        'SELECT id, source, target, cost FROM delta_edges',
+        'SELECT id, prize FROM delta_nodes',
+        NULL::integer[], NULL, 1, 'strong'
+    )),
+    37.0::float8,
+    'Objective deltas should sum to prizes minus costs of the new tree'
+);
+
+-- Test 4: An unchanged result gives no rows
+SELECT is(
+    (SELECT count(*) FROM pgr_pcst_fast_delta(
+        'SELECT id, source, target, cost FROM delta_edges',
+        'SELECT id, prize FROM delta_nodes',
+        ARRAY[30, 10, 20], NULL, 1, 'strong'
+    )),
+    0::bigint,
+    'The same edges as before should give an empty delta'
+);
+
+-- Test 5: Removed edges come first; prizes only count for nodes that change
+SELECT is(
+    (SELECT string_agg(change || ':' || edge || ':' || objective_delta, ',' ORDER BY seq)
+     FROM pgr_pcst_fast_delta(
+        'SELECT id, source, target, cost FROM delta_edges',
+        'SELECT id, prize FROM delta_nodes',
+        ARRAY[10, 20, 40]::bigint[], NULL, 1, 'strong'
+    )),
+    'removed:40:100,added:30:-1',
+    'Swapping an edge should report one removal and one addition'
+);
+
+-- Test 6: Previous edges missing from the graph are removed without a cost
+SELECT is(
+    (SELECT string_agg(change || ':' || edge || ':' || coalesce(cost::text, 'null'), ',' ORDER BY seq)
+     FROM pgr_pcst_fast_delta(
+        'SELECT id, source, target, cost FROM delta_edges',
+        'SELECT id, prize FROM delta_nodes',
+        ARRAY[10, 20, 30, 99], NULL, 1, 'strong'
+    )),
+    'removed:99:null',
+    'An unknown previous edge ID should be reported as removed'
+);
+
+-- Test 7: Previous IDs of another type are matched as text
+SELECT is(
+    (SELECT string_agg(change || ':' || edge, ',' ORDER BY seq)
+     FROM pgr_pcst_fast_delta(
+        'SELECT id, source, target, cost FROM delta_edges',
+        'SELECT id, prize FROM delta_nodes',
+        ARRAY['10', '20'], NULL, 1, 'strong'
+    )),
+    'added:30',
+    'Text previous IDs should match integer edge IDs'
+);
+
+SELECT finish();
+
+ROLLBACK;
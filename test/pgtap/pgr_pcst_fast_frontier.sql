@@ -0,0 +1,131 @@
+-- pgTAP tests for pgr_pcst_fast_frontier function
+
+BEGIN;
+
+SELECT plan(8);
+
+-- Test 1: Function exists
+SELECT has_function(
+    'public',
+    'pgr_pcst_fast_frontier',
+    ARRAY['text', 'text', 'text', 'integer', 'text', 'integer'],
+    'Function pgr_pcst_fast_frontier should exist'
+);
+
+-- Prizes at 1, 2 and 5; the expensive edge 3 - 9 leads away from them.
+-- Costs are distinct, so no ties decide the result.
+CREATE TEMP TABLE frontier_edges (id INTEGER, source INTEGER, target INTEGER, cost FLOAT8);
+CREATE TEMP TABLE frontier_nodes (id INTEGER, prize FLOAT8);
+
+INSERT INTO frontier_edges (id, source, target, cost) VALUES
+    (1, 1, 2, 1.0),
+    (2, 2, 3, 2.5),
+    (3, 3, 4, 1.5),
+    (4, 4, 5, 2.0),
+    (5, 3, 9, 40.0),
+    (6, 9, 10, 1.25),
+    (7, 1, 6, 3.75);
+
+INSERT INTO frontier_nodes (id, prize) VALUES
+    (1, 10.0), (2, 10.0), (5, 10.0), (6, 0.0);
+
+-- Test 2: Same rows as pgr_pcst_fast on the whole graph
+SELECT is(
+    (SELECT string_agg(edge || ':' || source || '-' || target || ':' || cost, ',' ORDER BY edge::int)
+     FROM pgr_pcst_fast_frontier(
+        'SELECT id, source, target, cost FROM frontier_edges WHERE source = ANY($1) OR target = ANY($1)',
+        'SELECT id, prize FROM frontier_nodes',
+        NULL, 1, 'strong'
+    )),
+    (SELECT string_agg(edge || ':' || source || '-' || target || ':' || cost, ',' ORDER BY edge::int)
+     FROM pgr_pcst_fast(
+        'SELECT id, source, target, cost FROM frontier_edges',
+        'SELECT id, prize FROM frontier_nodes',
+        NULL, 1, 'strong'
+    )),
+    'An unrooted frontier solve should match pgr_pcst_fast'
+);
+
+-- Test 3: Rooted solves match too, also at a root without a prize
+SELECT is(
+    (SELECT string_agg(edge, ',' ORDER BY edge::int)
+     FROM pgr_pcst_fast_frontier(
+        'SELECT id, source, target, cost FROM frontier_edges WHERE source = ANY($1) OR target = ANY($1)',
+        'SELECT id, prize FROM frontier_nodes',
+        '4', 1, 'gw'
+    )),
+    (SELECT string_agg(edge, ',' ORDER BY edge::int)
+     FROM pgr_pcst_fast(
+        'SELECT id, source, target, cost FROM frontier_edges',
+        'SELECT id, prize FROM frontier_nodes',
+        '4', 1, 'gw'
+    )),
+    'A rooted frontier solve should match pgr_pcst_fast'
+);
+
+-- Test 4: Edges of nodes growth never reaches are not read; reading the
+-- edges of node 9 would fail on the NULL cost
+SELECT lives_ok(
+    $$SELECT * FROM pgr_pcst_fast_frontier(
+        'SELECT id, source, target, CASE WHEN 9 IN (source, target) AND id <> 5 THEN NULL ELSE cost END
+         FROM frontier_edges WHERE source = ANY($1) OR target = ANY($1)',
+        'SELECT id, prize FROM frontier_nodes',
+        NULL, 1, 'strong'
+    )$$,
+    'Nodes beyond the reach of growth should not be expanded'
+);
+
+-- Test 5: Text node IDs are passed to the edges query as text[]
+SELECT is(
+    (SELECT string_agg(source || '-' || target, ',' ORDER BY edge::int)
+     FROM pgr_pcst_fast_frontier(
+        'SELECT id, ''n'' || source, ''n'' || target, cost FROM frontier_edges
+         WHERE ''n'' || source = ANY($1) OR ''n'' || target = ANY($1)',
+        'SELECT ''n'' || id, prize FROM frontier_nodes',
+        NULL, 1, 'strong'
+    )),
+    (SELECT string_agg('n' || source || '-n' || target, ',' ORDER BY edge::int)
+     FROM pgr_pcst_fast(
+        'SELECT id, source, target, cost FROM frontier_edges',
+        'SELECT id, prize FROM frontier_nodes',
+        NULL, 1, 'strong'
+    )),
+    'Text node IDs should work'
+);
+
+-- Test 6: Growth needs somewhere to start
+SELECT throws_ok(
+    $$SELECT * FROM pgr_pcst_fast_frontier(
+        'SELECT id, source, target, cost FROM frontier_edges WHERE source = ANY($1) OR target = ANY($1)',
+        'SELECT id, prize FROM frontier_nodes WHERE prize = 0'
+    )$$,
+    '22023',
+    'nodes query returned no node with a nonzero prize and no root was given',
+    'A call without prize nodes or root should be rejected'
+);
+
+-- Test 7: Prize nodes without edges
+SELECT throws_ok(
+    $$SELECT * FROM pgr_pcst_fast_frontier(
+        'SELECT id, source, target, cost FROM frontier_edges WHERE source = ANY($1) AND false',
+        'SELECT id, prize FROM frontier_nodes'
+    )$$,
+    '22023',
+    'edges query returned no rows for the prize nodes and the root',
+    'Prize nodes without edges should be rejected'
+);
+
+-- Test 8: An unknown root is reported like in pgr_pcst_fast
+SELECT throws_ok(
+    $$SELECT * FROM pgr_pcst_fast_frontier(
+        'SELECT id, source, target, cost FROM frontier_edges WHERE source = ANY($1) OR target = ANY($1)',
+        'SELECT id, prize FROM frontier_nodes',
+        '99'
+    )$$,
+    '22023',
+    'root node ID ''99'' not found in edges',
+    'A root without edges should be rejected'
+);
+
+SELECT finish();
+ROLLBACK;
@@ -0,0 +1,118 @@
+-- pgTAP tests for pgr_pcst_fast_grouped function
+
+BEGIN;
+
+SELECT plan(8);
+
+-- Test 1: Function exists
+SELECT has_function(
+    'public',
+    'pgr_pcst_fast_grouped',
+    ARRAY['text', 'text', 'integer', 'text', 'integer'],
+    'Function pgr_pcst_fast_grouped should exist'
+);
+
+-- Two districts reusing the same node and edge IDs: in 'north' the path
+-- 1 - 2 - 3 pays off, in 'south' only the cheap edge 1 - 2 does
+CREATE TEMP TABLE grouped_edges (district TEXT, id INTEGER, source INTEGER, target INTEGER, cost FLOAT8);
+CREATE TEMP TABLE grouped_nodes (district TEXT, id INTEGER, prize FLOAT8);
+
+INSERT INTO grouped_edges (district, id, source, target, cost) VALUES
+    ('south', 10, 1, 2, 1.0),
+    ('north', 10, 1, 2, 1.0),
+    ('south', 20, 2, 3, 50.0),
+    ('north', 20, 2, 3, 1.0),
+    ('north', 30, 3, 4, 80.0);
+
+INSERT INTO grouped_nodes (district, id, prize) VALUES
+    ('north', 1, 10.0), ('north', 2, 10.0), ('north', 3, 10.0),
+    ('south', 1, 10.0), ('south', 2, 10.0), ('south', 3, 10.0),
+    ('west', 1, 1000.0);
+
+-- Test 2: Groups come in order of their first edge, seq restarts per group
+SELECT is(
+    (SELECT string_agg(group_id || ':' || seq || ':' || edge, ',' ORDER BY group_id DESC, seq)
+     FROM pgr_pcst_fast_grouped(
+        'SELECT district, id, source, target, cost FROM grouped_edges',
+        'SELECT district, id, prize FROM grouped_nodes',
+        1, 'strong'
+    )),
+    'south:1:10,north:1:10,north:2:20',
+    'Each group should be solved on its own edges and prizes'
+);
+
+-- Test 3: Rows of a group match pgr_pcst_fast on that group alone
+SELECT is(
+    (SELECT string_agg(seq || ':' || edge || ':' || source || '-' || target || ':' || cost, ',' ORDER BY seq)
+     FROM pgr_pcst_fast_grouped(
+        'SELECT district, id, source, target, cost FROM grouped_edges',
+        'SELECT district, id, prize FROM grouped_nodes',
+        1, 'strong'
+    ) WHERE group_id = 'north'),
+    (SELECT string_agg(seq || ':' || edge || ':' || source || '-' || target || ':' || cost, ',' ORDER BY seq)
+     FROM pgr_pcst_fast(
+        'SELECT id, source, target, cost FROM grouped_edges WHERE district = ''north''',
+        'SELECT id, prize FROM grouped_nodes WHERE district = ''north''',
+        NULL, 1, 'strong'
+    )),
+    'A group should get the same rows as a separate pgr_pcst_fast call'
+);
+
+-- Test 4: Groups are returned in the order of their first edge
+SELECT is(
+    (SELECT string_agg(DISTINCT group_id, ',')
+     FROM (SELECT group_id FROM pgr_pcst_fast_grouped(
+        'SELECT district, id, source, target, cost FROM grouped_edges',
+        'SELECT district, id, prize FROM grouped_nodes',
+        1, 'strong'
+    ) LIMIT 1) first_row),
+    'south',
+    'The group of the first edge row should come first'
+);
+
+-- Test 5: Integer group IDs are returned as text, prize rows matched across types
+SELECT is(
+    (SELECT string_agg(group_id || ':' || edge, ',' ORDER BY group_id, seq)
+     FROM pgr_pcst_fast_grouped(
+        'SELECT CASE district WHEN ''north'' THEN 1 ELSE 2 END, id, source, target, cost FROM grouped_edges',
+        'SELECT CASE district WHEN ''north'' THEN ''1'' ELSE ''2'' END, id, prize FROM grouped_nodes WHERE district <> ''west''',
+        1, 'strong'
+    )),
+    '1:10,1:20,2:10',
+    'Integer group IDs should work and match text group IDs in the nodes query'
+);
+
+-- Test 6: Prizes of groups without edges are ignored
+SELECT is(
+    (SELECT count(*) FROM pgr_pcst_fast_grouped(
+        'SELECT district, id, source, target, cost FROM grouped_edges WHERE district = ''south''',
+        'SELECT district, id, prize FROM grouped_nodes',
+        1, 'strong'
+    )),
+    1::bigint,
+    'Node rows of a group without edges should not affect other groups'
+);
+
+-- Test 7: Without pruning every group keeps its GW forest
+SELECT ok(
+    (SELECT count(*) FROM pgr_pcst_fast_grouped(
+        'SELECT district, id, source, target, cost FROM grouped_edges',
+        'SELECT district, id, prize FROM grouped_nodes',
+        1, 'none'
+    )) >= 3,
+    'Pruning should be passed on to every group'
+);
+
+-- Test 8: The group_id column is required
+SELECT throws_ok(
+    $$SELECT * FROM pgr_pcst_fast_grouped(
+        'SELECT id, source, target, cost FROM grouped_edges',
+        'SELECT district, id, prize FROM grouped_nodes'
+    )$$,
+    '22023',
+    'edges query must return at least 5 columns: group_id, id, source, target, cost',
+    'An edges query without group_id should be rejected'
+);
+
+SELECT finish();
+ROLLBACK;
@@ -0,0 +1,132 @@
+-- pgTAP tests for pgr_pcst_fast_repair function
+
+BEGIN;
+
+SELECT plan(9);
+
+-- Test 1: Function exists
+SELECT has_function(
+    'public',
+    'pgr_pcst_fast_repair',
+    ARRAY['text', 'text', 'anyarray', 'anyarray', 'text', 'integer'],
+    'Function pgr_pcst_fast_repair should exist'
+);
+
+-- The tree 1 - 2 - 3 - 4 - 6 (edges 1, 2, 3, 6); edges 4 and 5 are a
+-- detour around edge 2 through node 5. Losing edge 2 leaves the pieces
+-- {1, 2}, worth 10 + 5 - 1 = 14, and {3, 4, 6}, worth 30 - 2 = 28.
+-- Edge 7 is a second tree 7 - 8 of a result of two clusters.
+CREATE TEMP TABLE repair_edges (id INTEGER, source INTEGER, target INTEGER, cost FLOAT8);
+CREATE TEMP TABLE repair_nodes (id INTEGER, prize FLOAT8);
+
+INSERT INTO repair_edges (id, source, target, cost) VALUES
+    (1, 1, 2, 1.0),
+    (2, 2, 3, 1.0),
+    (3, 3, 4, 1.0),
+    (4, 2, 5, 3.0),
+    (5, 5, 3, 3.0),
+    (6, 4, 6, 1.0),
+    (7, 7, 8, 1.0);
+
+INSERT INTO repair_nodes (id, prize) VALUES
+    (1, 10.0), (2, 5.0), (3, 10.0), (4, 10.0), (6, 10.0), (7, 10.0), (8, 10.0);
+
+-- Test 2: The detour of cost 6 is worth the piece {1, 2}
+SELECT is(
+    (SELECT string_agg(edge, ',' ORDER BY edge::int)
+     FROM pgr_pcst_fast_repair(
+        'SELECT id, source, target, cost FROM repair_edges',
+        'SELECT id, prize FROM repair_nodes',
+        ARRAY[1, 2, 3, 6], ARRAY[2]
+    )),
+    '1,3,4,5,6',
+    'A failed edge should be replaced by the path around it'
+);
+
+-- Test 3: At cost 40 the detour is not worth the smaller piece
+SELECT is(
+    (SELECT string_agg(edge, ',' ORDER BY edge::int)
+     FROM pgr_pcst_fast_repair(
+        'SELECT id, source, target, CASE WHEN id IN (4, 5) THEN 20.0 ELSE cost END FROM repair_edges',
+        'SELECT id, prize FROM repair_nodes',
+        ARRAY[1, 2, 3, 6], ARRAY[2]
+    )),
+    '3,6',
+    'A piece not worth its reconnection should be dropped'
+);
+
+-- Test 4: With a root, its piece stays even when it is the smaller one
+SELECT is(
+    (SELECT string_agg(edge, ',' ORDER BY edge::int)
+     FROM pgr_pcst_fast_repair(
+        'SELECT id, source, target, CASE WHEN id IN (4, 5) THEN 20.0 ELSE cost END FROM repair_edges',
+        'SELECT id, prize FROM repair_nodes',
+        ARRAY[1, 2, 3, 6], ARRAY[2], '1'
+    )),
+    '1',
+    'A rooted repair should keep the piece of the root'
+);
+
+-- Test 5: Without failures the tree comes back as it was
+SELECT is(
+    (SELECT string_agg(edge, ',' ORDER BY edge::int)
+     FROM pgr_pcst_fast_repair(
+        'SELECT id, source, target, cost FROM repair_edges',
+        'SELECT id, prize FROM repair_nodes',
+        ARRAY[1, 2, 3, 6], NULL::int[]
+    )),
+    '1,2,3,6',
+    'A tree without failed edges should be returned unchanged'
+);
+
+-- Test 6: Failed edges outside the tree change nothing
+SELECT is(
+    (SELECT string_agg(edge, ',' ORDER BY edge::int)
+     FROM pgr_pcst_fast_repair(
+        'SELECT id, source, target, cost FROM repair_edges',
+        'SELECT id, prize FROM repair_nodes',
+        ARRAY[1, 2, 3, 6], ARRAY[4]
+    )),
+    '1,2,3,6',
+    'Failed edges outside the tree should not change it'
+);
+
+-- Test 7: A tree edge the edges query no longer returns counts as failed
+SELECT is(
+    (SELECT string_agg(edge, ',' ORDER BY edge::int)
+     FROM pgr_pcst_fast_repair(
+        'SELECT id, source, target, cost FROM repair_edges WHERE id <> 2',
+        'SELECT id, prize FROM repair_nodes',
+        ARRAY[1, 2, 3, 6], NULL::int[]
+    )),
+    '1,3,4,5,6',
+    'Tree edges missing from the edges query should count as failed'
+);
+
+-- Test 8: The trees of a result of two clusters are repaired one by one,
+-- and the tree that lost no edge stays
+SELECT is(
+    (SELECT string_agg(edge, ',' ORDER BY edge::int)
+     FROM pgr_pcst_fast_repair(
+        'SELECT id, source, target, cost FROM repair_edges',
+        'SELECT id, prize FROM repair_nodes',
+        ARRAY[1, 2, 3, 6, 7], ARRAY[2], NULL, 2
+    )),
+    '1,3,4,5,6,7',
+    'Every tree of a result of several clusters should be kept'
+);
+
+-- Test 9: A root makes the result one tree, whatever num_clusters says
+SELECT is(
+    (SELECT string_agg(edge, ',' ORDER BY edge::int)
+     FROM pgr_pcst_fast_repair(
+        'SELECT id, source, target, cost FROM repair_edges',
+        'SELECT id, prize FROM repair_nodes',
+        ARRAY[1, 2, 3, 6], ARRAY[2], '1', 2
+    )),
+    '1,3,4,5,6',
+    'A rooted repair should ignore num_clusters'
+);
+
+SELECT finish();
+ROLLBACK;
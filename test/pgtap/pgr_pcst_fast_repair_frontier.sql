@@ -0,0 +1,136 @@
+-- pgTAP tests for pgr_pcst_fast_repair_frontier function
+
+BEGIN;
+
+SELECT plan(8);
+
+-- Test 1: Function exists
+SELECT has_function(
+    'public',
+    'pgr_pcst_fast_repair_frontier',
+    ARRAY['text', 'text', 'text', 'anyarray', 'text', 'integer'],
+    'Function pgr_pcst_fast_repair_frontier should exist'
+);
+
+-- The graph of the pgr_pcst_fast_repair tests: the tree 1 - 2 - 3 - 4 - 6
+-- (edges 1, 2, 3, 6), the detour 2 - 5 - 3 (edges 4, 5) around edge 2,
+-- and the second tree 7 - 8 (edge 7). Node 5 leads on to 9 and 10 over
+-- an edge no repair can afford.
+CREATE TEMP TABLE repair_edges (id INTEGER, source INTEGER, target INTEGER, cost FLOAT8);
+CREATE TEMP TABLE repair_nodes (id INTEGER, prize FLOAT8);
+
+INSERT INTO repair_edges (id, source, target, cost) VALUES
+    (1, 1, 2, 1.0),
+    (2, 2, 3, 1.0),
+    (3, 3, 4, 1.0),
+    (4, 2, 5, 3.0),
+    (5, 5, 3, 3.0),
+    (6, 4, 6, 1.0),
+    (7, 7, 8, 1.0),
+    (8, 5, 9, 100.0),
+    (9, 9, 10, 1.0);
+
+INSERT INTO repair_nodes (id, prize) VALUES
+    (1, 10.0), (2, 5.0), (3, 10.0), (4, 10.0), (6, 10.0), (7, 10.0), (8, 10.0),
+    (10, 50.0);
+
+-- Test 2: Same repair as pgr_pcst_fast_repair
+SELECT is(
+    (SELECT string_agg(edge || ':' || source || '-' || target || ':' || cost, ',' ORDER BY edge::int)
+     FROM pgr_pcst_fast_repair_frontier(
+        'SELECT id, source, target, cost FROM repair_edges WHERE source = ANY($1) OR target = ANY($1)',
+        'SELECT id, prize FROM repair_nodes',
+        'SELECT id, source, target FROM repair_edges WHERE id IN (1, 2, 3, 6)',
+        ARRAY[2]
+    )),
+    (SELECT string_agg(edge || ':' || source || '-' || target || ':' || cost, ',' ORDER BY edge::int)
+     FROM pgr_pcst_fast_repair(
+        'SELECT id, source, target, cost FROM repair_edges',
+        'SELECT id, prize FROM repair_nodes',
+        ARRAY[1, 2, 3, 6], ARRAY[2]
+    )),
+    'A frontier repair should match pgr_pcst_fast_repair'
+);
+
+-- Test 3: Edges beyond the reach of the search are not read; reading the
+-- edges of node 9 would fail on the NULL cost
+SELECT lives_ok(
+    $$SELECT * FROM pgr_pcst_fast_repair_frontier(
+        'SELECT id, source, target, CASE WHEN id = 9 THEN NULL ELSE cost END
+         FROM repair_edges WHERE source = ANY($1) OR target = ANY($1)',
+        'SELECT id, prize FROM repair_nodes',
+        'SELECT id, source, target FROM repair_edges WHERE id IN (1, 2, 3, 6)',
+        ARRAY[2]
+    )$$,
+    'Nodes beyond the reach of the search should not be expanded'
+);
+
+-- Test 4: The trees of a result of two clusters are repaired one by one
+SELECT is(
+    (SELECT string_agg(edge, ',' ORDER BY edge::int)
+     FROM pgr_pcst_fast_repair_frontier(
+        'SELECT id, source, target, cost FROM repair_edges WHERE source = ANY($1) OR target = ANY($1)',
+        'SELECT id, prize FROM repair_nodes',
+        'SELECT id, source, target FROM repair_edges WHERE id IN (1, 2, 3, 6, 7)',
+        ARRAY[2], NULL, 2
+    )),
+    '1,3,4,5,6,7',
+    'Every tree of a result of several clusters should be kept'
+);
+
+-- Test 5: With a root, its piece stays even when it is the smaller one
+SELECT is(
+    (SELECT string_agg(edge, ',' ORDER BY edge::int)
+     FROM pgr_pcst_fast_repair_frontier(
+        'SELECT id, source, target, CASE WHEN id IN (4, 5) THEN 20.0 ELSE cost END
+         FROM repair_edges WHERE source = ANY($1) OR target = ANY($1)',
+        'SELECT id, prize FROM repair_nodes',
+        'SELECT id, source, target FROM repair_edges WHERE id IN (1, 2, 3, 6)',
+        ARRAY[2], '1'
+    )),
+    '1',
+    'A rooted repair should keep the piece of the root'
+);
+
+-- Test 6: A tree edge the edges query no longer returns counts as failed
+SELECT is(
+    (SELECT string_agg(edge, ',' ORDER BY edge::int)
+     FROM pgr_pcst_fast_repair_frontier(
+        'SELECT id, source, target, cost FROM repair_edges
+         WHERE (source = ANY($1) OR target = ANY($1)) AND id <> 2',
+        'SELECT id, prize FROM repair_nodes',
+        'SELECT id, source, target FROM repair_edges WHERE id IN (1, 2, 3, 6)',
+        NULL::int[]
+    )),
+    '1,3,4,5,6',
+    'Tree edges missing from the edges query should count as failed'
+);
+
+-- Test 7: An empty result stays empty
+SELECT is(
+    (SELECT count(*)::int
+     FROM pgr_pcst_fast_repair_frontier(
+        'SELECT id, source, target, cost FROM repair_edges WHERE source = ANY($1) OR target = ANY($1)',
+        'SELECT id, prize FROM repair_nodes',
+        'SELECT id, source, target FROM repair_edges WHERE false',
+        ARRAY[2]
+    )),
+    0,
+    'An empty result should repair to an empty result'
+);
+
+-- Test 8: The tree query needs the ends of the edges
+SELECT throws_ok(
+    $$SELECT * FROM pgr_pcst_fast_repair_frontier(
+        'SELECT id, source, target, cost FROM repair_edges WHERE source = ANY($1) OR target = ANY($1)',
+        'SELECT id, prize FROM repair_nodes',
+        'SELECT id FROM repair_edges',
+        ARRAY[2]
+    )$$,
+    '22023',
+    'tree query must return at least 3 columns: id, source, target',
+    'A tree query without source and target should be rejected'
+);
+
+SELECT finish();
+ROLLBACK;
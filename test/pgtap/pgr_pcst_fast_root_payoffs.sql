@@ -0,0 +1,90 @@
+-- pgTAP tests for pgr_pcst_fast_root_payoffs function
+
+BEGIN;
+
+SELECT plan(6);
+
+-- Test 1: Function exists
+SELECT has_function(
+    'public',
+    'pgr_pcst_fast_root_payoffs',
+    ARRAY['text', 'text', 'text', 'integer'],
+    'Function pgr_pcst_fast_root_payoffs should exist'
+);
+
+-- Star around a zero-prize hub: every leaf edge is worth keeping, so strong
+-- pruning keeps the whole star and the rerooted payoffs are easy to check
+CREATE TEMP TABLE payoff_edges (id INTEGER, source TEXT, target TEXT, cost FLOAT8);
+CREATE TEMP TABLE payoff_nodes (id TEXT, prize FLOAT8);
+
+INSERT INTO payoff_edges (id, source, target, cost) VALUES
+    (1, 'hub', 'a', 2.0),
+    (2, 'hub', 'b', 3.0),
+    (3, 'hub', 'c', 4.0);
+
+INSERT INTO payoff_nodes (id, prize) VALUES
+    ('hub', 0.0),
+    ('a', 20.0),
+    ('b', 30.0),
+    ('c', 40.0);
+
+-- Test 2: Function executes
+SELECT lives_ok(
+    $$SELECT * FROM pgr_pcst_fast_root_payoffs(
+        'SELECT id, source, target, cost FROM payoff_edges',
+        'SELECT id, prize FROM payoff_nodes'
+    )$$,
+    'pgr_pcst_fast_root_payoffs should execute without error'
+);
+
+-- Test 3: One row per forest node
+SELECT is(
+    (SELECT string_agg(node, ',' ORDER BY node) FROM pgr_pcst_fast_root_payoffs(
+        'SELECT id, source, target, cost FROM payoff_edges',
+        'SELECT id, prize FROM payoff_nodes'
+    )),
+    'a,b,c,hub',
+    'Every node of the pruned forest should get a rooted payoff'
+);
+
+-- Test 4: The whole star survives from any root, so every payoff is 90 - 9
+SELECT ok(
+    (SELECT bool_and(abs(rooted_payoff - 81.0) < 1e-9) FROM pgr_pcst_fast_root_payoffs(
+        'SELECT id, source, target, cost FROM payoff_edges',
+        'SELECT id, prize FROM payoff_nodes'
+    )),
+    'Rooted payoffs should equal the prize of the star minus its cost'
+);
+
+-- Test 5: A leaf that does not pay for its edge counts only as a root
+INSERT INTO payoff_edges (id, source, target, cost) VALUES (4, 'c', 'd', 6.0);
+INSERT INTO payoff_nodes (id, prize) VALUES ('d', 5.0);
+
+SELECT is(
+    (SELECT string_agg(node || '=' || round(rooted_payoff::numeric, 6), ','
+                       ORDER BY rooted_payoff DESC, node)
+     FROM pgr_pcst_fast_root_payoffs(
+        'SELECT id, source, target, cost FROM payoff_edges',
+        'SELECT id, prize FROM payoff_nodes'
+    )),
+    'a=81.000000,b=81.000000,c=81.000000,hub=81.000000,d=80.000000',
+    'Rooting at a leaf forces its edge into the tree'
+);
+
+-- Test 6: The best rooted payoff matches the strong pruning objective
+SELECT is(
+    (SELECT max(rooted_payoff) FROM pgr_pcst_fast_root_payoffs(
+        'SELECT id, source, target, cost FROM payoff_edges',
+        'SELECT id, prize FROM payoff_nodes'
+    )),
+    (SELECT value FROM pgr_pcst_fast_stats(
+        'SELECT id, source, target, cost FROM payoff_edges',
+        'SELECT id, prize FROM payoff_nodes',
+        NULL, 1, 'strong'
+    ) WHERE stat = 'result.objective'),
+    'The best rooted payoff should equal the strong pruning objective'
+);
+
+SELECT finish();
+
+ROLLBACK;
@@ -0,0 +1,212 @@
+-- pgTAP tests for pgr_pcst_fast_stats function
+
+BEGIN;
+
+SELECT plan(15);
+
+-- Test 1: Function exists
+SELECT has_function(
+    'public',
+    'pgr_pcst_fast_stats',
+    ARRAY['text', 'text', 'text', 'integer', 'text'],
+    'Function pgr_pcst_fast_stats should exist'
+);
+
+CREATE TEMP TABLE stats_edges (id INTEGER, source INTEGER, target INTEGER, cost FLOAT8);
+CREATE TEMP TABLE stats_nodes (id INTEGER, prize FLOAT8);
+
+INSERT INTO stats_edges (id, source, target, cost) VALUES
+    (1, 100, 101, 5.0),
+    (2, 101, 102, 8.0),
+    (3, 102, 103, 12.0),
+    (4, 100, 102, 20.0);
+
+INSERT INTO stats_nodes (id, prize) VALUES
+    (100, 50.0),
+    (101, 10.0),
+    (102, 15.0),
+    (103, 40.0);
+
+-- Test 2: Function executes
+SELECT lives_ok(
+    $$SELECT * FROM pgr_pcst_fast_stats(
+        'SELECT id, source, target, cost FROM stats_edges',
+        'SELECT id, prize FROM stats_nodes',
+        NULL, 1, 'strong'
+    )$$,
+    'pgr_pcst_fast_stats should execute without error'
+);
+
+-- Test 3: Result size matches pgr_pcst_fast
+SELECT is(
+    (SELECT value::integer FROM pgr_pcst_fast_stats(
+        'SELECT id, source, target, cost FROM stats_edges',
+        'SELECT id, prize FROM stats_nodes',
+        NULL, 1, 'strong'
+    ) WHERE stat = 'result.num_edges'),
+    (SELECT COUNT(*)::integer FROM pgr_pcst_fast(
+        'SELECT id, source, target, cost FROM stats_edges',
+        'SELECT id, prize FROM stats_nodes',
+        NULL, 1, 'strong', 0
+    )),
+    'result.num_edges should match the number of edges returned by pgr_pcst_fast'
+);
+
+-- Test 4: Memory is reported for loader and solver structures
+SELECT ok(
+    (SELECT COUNT(*) FROM pgr_pcst_fast_stats(
+        'SELECT id, source, target, cost FROM stats_edges',
+        'SELECT id, prize FROM stats_nodes'
+    ) WHERE stat IN ('memory.loader.edge_tuptable.peak_bytes',
+                     'memory.solver.edge_parts.peak_bytes',
+                     'memory.solver.heap_nodes.peak_bytes') AND value > 0) = 3,
+    'Loader and solver memory peaks should be reported'
+);
+
+-- Test 5: Peak never below current
+SELECT ok(
+    NOT EXISTS (
+        SELECT 1
+        FROM pgr_pcst_fast_stats(
+            'SELECT id, source, target, cost FROM stats_edges',
+            'SELECT id, prize FROM stats_nodes'
+        ) cur
+        JOIN pgr_pcst_fast_stats(
+            'SELECT id, source, target, cost FROM stats_edges',
+            'SELECT id, prize FROM stats_nodes'
+        ) peak
+          ON peak.stat = replace(cur.stat, '.current_bytes', '.peak_bytes')
+        WHERE cur.stat LIKE 'memory.%.current_bytes' AND peak.value < cur.value
+    ),
+    'Memory peak_bytes should never be below current_bytes'
+);
+
+-- Test 6: Every solver phase that ran reports wall time
+SELECT ok(
+    (SELECT COUNT(*) FROM pgr_pcst_fast_stats(
+        'SELECT id, source, target, cost FROM stats_edges',
+        'SELECT id, prize FROM stats_nodes',
+        NULL, 1, 'strong'
+    ) WHERE stat IN ('perf.load.wall_seconds',
+                     'perf.construct.wall_seconds',
+                     'perf.growth.wall_seconds',
+                     'perf.simple_pruning.wall_seconds',
+                     'perf.strong_pruning.wall_seconds') AND value >= 0) = 5,
+    'Phase wall times should be reported for load, construction, growth and pruning'
+);
+
+-- Test 7: Requesting hardware counters works whether or not perf events are available
+SET LOCAL pcst_fast.perf_counters = on;
+SELECT lives_ok(
+    $$SELECT * FROM pgr_pcst_fast_stats(
+        'SELECT id, source, target, cost FROM stats_edges',
+        'SELECT id, prize FROM stats_nodes'
+    )$$,
+    'pgr_pcst_fast_stats should degrade gracefully when perf counters are unavailable'
+);
+
+RESET pcst_fast.perf_counters;
+
+-- Test 8: 'auto' profiles the graph (one cycle through 100, 101, 102) and picks GW with strong pruning
+SELECT is(
+    (SELECT string_agg(stat || '=' || value, ',' ORDER BY stat) FROM pgr_pcst_fast_stats(
+        'SELECT id, source, target, cost FROM stats_edges',
+        'SELECT id, prize FROM stats_nodes',
+        NULL, 1, 'auto'
+    ) WHERE stat IN ('plan.automatic', 'plan.pruning_method', 'plan.tree_dp',
+                     'profile.num_components', 'profile.cycle_rank', 'profile.max_degree')),
+    'plan.automatic=1,plan.pruning_method=3,plan.tree_dp=0,profile.cycle_rank=1,profile.max_degree=3,profile.num_components=1',
+    'auto should report the profile and choose GW growth with strong pruning on a cyclic graph'
+);
+
+-- Test 9: A single tree is solved without moat growth
+SELECT is(
+    (SELECT string_agg(stat || '=' || value, ',' ORDER BY stat) FROM pgr_pcst_fast_stats(
+        'SELECT id, source, target, cost FROM stats_edges WHERE id < 4',
+        'SELECT id, prize FROM stats_nodes',
+        NULL, 1, 'auto'
+    ) WHERE stat IN ('plan.tree_dp', 'events.total_num_edge_events')),
+    'events.total_num_edge_events=0,plan.tree_dp=1',
+    'auto should prune a tree directly instead of growing moats'
+);
+
+-- Test 10: An explicit pruning method overrides the planner
+SELECT is(
+    (SELECT string_agg(stat || '=' || value, ',' ORDER BY stat) FROM pgr_pcst_fast_stats(
+        'SELECT id, source, target, cost FROM stats_edges WHERE id < 4',
+        'SELECT id, prize FROM stats_nodes',
+        NULL, 1, 'gw'
+    ) WHERE stat LIKE 'plan.%' OR stat LIKE 'profile.%'),
+    'plan.automatic=0,plan.distance_network=0,plan.exact=0,plan.lazy_edges=0,plan.num_distant_nodes=0,plan.num_exact_components=0,plan.num_exact_subproblems=0,plan.num_peeled_nodes=0,plan.num_terminals=0,plan.peel_tails=0,plan.prize_balls=0,plan.pruning_method=2,plan.tree_dp=0',
+    'An explicit pruning method should be used as given'
+);
+
+-- Test 11: The pendant edge 102-103 is peeled off and solved outside GW
+SELECT is(
+    (SELECT string_agg(stat || '=' || value, ',' ORDER BY stat) FROM pgr_pcst_fast_stats(
+        'SELECT id, source, target, cost FROM stats_edges',
+        'SELECT id, prize FROM stats_nodes',
+        NULL, 1, 'auto'
+    ) WHERE stat IN ('plan.peel_tails', 'plan.num_peeled_nodes', 'profile.num_leaves', 'graph.num_nodes')),
+    'graph.num_nodes=4,plan.num_peeled_nodes=1,plan.peel_tails=1,profile.num_leaves=1',
+    'auto should peel tree-shaped tails off the core'
+);
+
+-- Test 12: Nodes farther from every prize than half the prize total (57.5)
+-- cannot be reached by growth and are dropped before solving
+SELECT is(
+    (SELECT string_agg(stat || '=' || value, ',' ORDER BY stat) FROM pgr_pcst_fast_stats(
+        'SELECT id, source, target, cost FROM stats_edges
+         UNION ALL VALUES (5, 103, 104, 100.0::float8), (6, 104, 105, 100.0::float8)',
+        'SELECT id, prize FROM stats_nodes',
+        NULL, 1, 'auto'
+    ) WHERE stat IN ('plan.prize_balls', 'plan.num_distant_nodes', 'result.num_edges')),
+    'plan.num_distant_nodes=2,plan.prize_balls=1,result.num_edges=3',
+    'auto should drop nodes out of reach of every prize'
+);
+
+-- Test 13: With prizes only on 100 and 103 the distance network has two
+-- nodes, joined by the path 100 - 101 - 102 - 103 (cost 25)
+SET LOCAL pcst_fast.distance_network = 'on';
+SELECT is(
+    (SELECT string_agg(stat || '=' || value, ',' ORDER BY stat) FROM pgr_pcst_fast_stats(
+        'SELECT id, source, target, cost FROM stats_edges',
+        'SELECT id, prize FROM stats_nodes WHERE id IN (100, 103)',
+        NULL, 1, 'strong'
+    ) WHERE stat IN ('plan.distance_network', 'plan.num_terminals', 'result.num_edges', 'result.objective')),
+    'plan.distance_network=1,plan.num_terminals=2,result.num_edges=3,result.objective=65',
+    'The distance network should connect the prize nodes along shortest paths'
+);
+RESET pcst_fast.distance_network;
+
+-- Test 14: Growth ends at time 6 when 103 joins, before it reaches the edge
+-- 100 - 102 (cost 20), which lies inside the cluster by then anyway
+SET LOCAL pcst_fast.lazy_edges = on;
+SELECT is(
+    (SELECT string_agg(stat || '=' || value, ',' ORDER BY stat) FROM pgr_pcst_fast_stats(
+        'SELECT id, source, target, cost FROM stats_edges',
+        'SELECT id, prize FROM stats_nodes',
+        NULL, 1, 'strong'
+    ) WHERE stat IN ('plan.lazy_edges', 'events.num_uninserted_edges', 'result.num_edges')),
+    'events.num_uninserted_edges=1,plan.lazy_edges=1,result.num_edges=3',
+    'Lazy insertion should leave out the edge growth never reaches'
+);
+RESET pcst_fast.lazy_edges;
+
+-- Test 15: The merges at times 2.5, 4 and 6 fall into three buckets of width
+-- 1.5 and happen at their ends, 1.5^3, 1.5^4 and 1.5^5 = 7.59375
+SET LOCAL pcst_fast.event_bucket_epsilon = 0.5;
+SELECT is(
+    (SELECT string_agg(stat || '=' || round(value::numeric, 5), ',' ORDER BY stat) FROM pgr_pcst_fast_stats(
+        'SELECT id, source, target, cost FROM stats_edges',
+        'SELECT id, prize FROM stats_nodes',
+        NULL, 1, 'strong'
+    ) WHERE stat IN ('events.num_event_buckets', 'growth.final_time', 'result.objective')),
+    'events.num_event_buckets=3.00000,growth.final_time=7.59375,result.objective=90.00000',
+    'Bucketed events should happen at the end of their (1 + epsilon) bucket'
+);
+RESET pcst_fast.event_bucket_epsilon;
+
+SELECT finish();
+
+ROLLBACK;
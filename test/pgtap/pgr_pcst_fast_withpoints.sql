@@ -0,0 +1,111 @@
+-- pgTAP tests for pgr_pcst_fast_withpoints function
+
+BEGIN;
+
+SELECT plan(7);
+
+-- Test 1: Function exists
+SELECT has_function(
+    'public',
+    'pgr_pcst_fast_withpoints',
+    ARRAY['text', 'text', 'text', 'text', 'integer', 'text', 'integer'],
+    'Function pgr_pcst_fast_withpoints should exist'
+);
+
+-- Path 1 -> 2 -> 3 without node prizes; all prizes sit on points
+CREATE TEMP TABLE wp_edges (id INTEGER, source INTEGER, target INTEGER, cost FLOAT8);
+CREATE TEMP TABLE wp_nodes (id INTEGER, prize FLOAT8);
+CREATE TEMP TABLE wp_points (pid INTEGER, edge_id INTEGER, fraction FLOAT8, prize FLOAT8);
+
+INSERT INTO wp_edges (id, source, target, cost) VALUES
+    (10, 1, 2, 10.0),
+    (20, 2, 3, 2.0);
+
+INSERT INTO wp_points (pid, edge_id, fraction, prize) VALUES
+    (1, 10, 0.3, 8.0),
+    (2, 10, 0.6, 8.0);
+
+-- Test 2: Function executes
+SELECT lives_ok(
+    $$SELECT * FROM pgr_pcst_fast_withpoints(
+        'SELECT id, source, target, cost FROM wp_edges',
+        'SELECT id, prize FROM wp_nodes',
+        'SELECT pid, edge_id, fraction, prize FROM wp_points'
+    )$$,
+    'pgr_pcst_fast_withpoints should execute without error'
+);
+
+-- Test 3: Only the stretch between the two points is worth buying
+SELECT is(
+    (SELECT string_agg(edge || ':' || source || '-' || target || ':' || fraction_start || '-'
+                       || fraction_end || ':' || round(cost::numeric, 6), ',' ORDER BY seq)
+     FROM pgr_pcst_fast_withpoints(
+        'SELECT id, source, target, cost FROM wp_edges',
+        'SELECT id, prize FROM wp_nodes',
+        'SELECT pid, edge_id, fraction, prize FROM wp_points',
+        NULL, 1, 'strong'
+    )),
+    '10:1-2:0.3-0.6:3.000000',
+    'Result should be the original edge ID with the selected fraction range'
+);
+
+-- Test 4: Adjacent sub-edges merge back into one row per stretch, and a
+-- point at fraction 1 adds its prize to the target node
+INSERT INTO wp_points (pid, edge_id, fraction, prize) VALUES (3, 20, 1.0, 30.0);
+SELECT is(
+    (SELECT string_agg(edge || ':' || fraction_start || '-' || fraction_end || ':'
+                       || round(cost::numeric, 6), ',' ORDER BY edge)
+     FROM pgr_pcst_fast_withpoints(
+        'SELECT id, source, target, cost FROM wp_edges',
+        'SELECT id, prize FROM wp_nodes',
+        'SELECT pid, edge_id, fraction, prize FROM wp_points',
+        NULL, 1, 'strong'
+    )),
+    '10:0.3-1:7.000000,20:0-1:2.000000',
+    'Contiguous sub-edges should be reported as one stretch of the original edge'
+);
+
+-- Test 5: Points on unknown edges are rejected
+SELECT throws_ok(
+    $$SELECT * FROM pgr_pcst_fast_withpoints(
+        'SELECT id, source, target, cost FROM wp_edges',
+        'SELECT id, prize FROM wp_nodes',
+        'SELECT 1, 99, 0.5::float8, 1.0::float8'
+    )$$,
+    NULL,
+    NULL,
+    'Points referencing a missing edge should raise an error'
+);
+
+-- Test 6: Fractions outside [0, 1] are rejected
+SELECT throws_ok(
+    $$SELECT * FROM pgr_pcst_fast_withpoints(
+        'SELECT id, source, target, cost FROM wp_edges',
+        'SELECT id, prize FROM wp_nodes',
+        'SELECT 1, 10, 1.5::float8, 1.0::float8'
+    )$$,
+    NULL,
+    NULL,
+    'Point fractions outside [0, 1] should raise an error'
+);
+
+-- Test 7: Without points the result matches pgr_pcst_fast
+INSERT INTO wp_nodes (id, prize) VALUES (1, 20.0), (2, 20.0);
+SELECT is(
+    (SELECT string_agg(edge, ',' ORDER BY edge) FROM pgr_pcst_fast_withpoints(
+        'SELECT id, source, target, cost FROM wp_edges',
+        'SELECT id, prize FROM wp_nodes',
+        'SELECT pid, edge_id, fraction, prize FROM wp_points WHERE false',
+        NULL, 1, 'strong'
+    )),
+    (SELECT string_agg(edge, ',' ORDER BY edge) FROM pgr_pcst_fast(
+        'SELECT id, source, target, cost FROM wp_edges',
+        'SELECT id, prize FROM wp_nodes',
+        NULL, 1, 'strong', 0
+    )),
+    'An empty points query should give the pgr_pcst_fast result'
+);
+
+SELECT finish();
+
+ROLLBACK;
@@ -0,0 +1,338 @@
+#include "graph_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace pcst_tools {
+
+namespace {
+
+const char kSortedEdgeMagic[8] = {'P', 'C', 'S', 'T', 'E', 'D', 'G', 'E'};
+
+struct SortedEdgeHeader {
+  char magic[8];
+  int32_t num_nodes;
+  int32_t unused;
+  int64_t num_edges;
+};
+
+// Records read between giving the pages behind them back
+const long long kReleaseRecords = 1 << 20;
+
+// Reads the next number, skipping '#' comment lines.
+bool read_number(FILE* file, double* value) {
+  while (true) {
+    int c = fgetc(file);
+    if (c == EOF) {
+      return false;
+    }
+    if (c == '#') {
+      while (c != '\n' && c != EOF) {
+        c = fgetc(file);
+      }
+    } else if (!isspace(c)) {
+      ungetc(c, file);
+      return fscanf(file, "%lf", value) == 1;
+    }
+  }
+}
+
+void split_csv_line(const std::string& line, std::vector<std::string>* fields) {
+  fields->clear();
+  std::stringstream stream(line);
+  std::string field;
+  while (std::getline(stream, field, ',')) {
+    size_t begin = field.find_first_not_of(" \t\r");
+    size_t end = field.find_last_not_of(" \t\r");
+    fields->push_back(begin == std::string::npos
+                      ? std::string()
+                      : field.substr(begin, end - begin + 1));
+  }
+}
+
+bool parse_double(const std::string& text, double* value) {
+  char* end = NULL;
+  *value = strtod(text.c_str(), &end);
+  return !text.empty() && *end == '\0';
+}
+
+// Calls row() for every data line of a CSV file. A first line whose numeric
+// column does not parse is taken as the header.
+template <typename RowFunction>
+bool for_each_csv_row(const std::string& path, size_t num_fields,
+                      size_t numeric_field, RowFunction row,
+                      std::string* error) {
+  std::ifstream file(path.c_str());
+  if (!file) {
+    *error = "cannot open " + path;
+    return false;
+  }
+  std::string line;
+  std::vector<std::string> fields;
+  double value;
+  for (int line_number = 1; std::getline(file, line); ++line_number) {
+    if (line.empty() || line[0] == '#' || line == "\r") {
+      continue;
+    }
+    split_csv_line(line, &fields);
+    bool numeric = fields.size() >= num_fields
+                   && parse_double(fields[numeric_field], &value);
+    if (line_number == 1 && !numeric) {
+      continue;
+    }
+    if (!numeric || !row(fields)) {
+      std::ostringstream message;
+      message << path << ":" << line_number << ": malformed row";
+      *error = message.str();
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+
+bool read_graph_file(const std::string& path, Graph* graph,
+                     std::string* error) {
+  return read_graph_file(path, graph, error, 0,
+                         std::function<void(int, int)>());
+}
+
+
+bool read_graph_file(const std::string& path, Graph* graph,
+                     std::string* error, int batch_size,
+                     const std::function<void(int, int)>& edges_read) {
+  FILE* file = fopen(path.c_str(), "r");
+  if (file == NULL) {
+    *error = "cannot open " + path;
+    return false;
+  }
+
+  double num_nodes, num_edges;
+  bool ok = read_number(file, &num_nodes) && read_number(file, &num_edges);
+  for (int ii = 0; ok && ii < static_cast<int>(num_nodes); ++ii) {
+    double prize;
+    ok = read_number(file, &prize);
+    graph->prizes.push_back(prize);
+  }
+  int batch_start = 0;
+  for (int ii = 0; ok && ii < static_cast<int>(num_edges); ++ii) {
+    double uu, vv, cost;
+    ok = read_number(file, &uu) && read_number(file, &vv)
+         && read_number(file, &cost);
+    graph->sources.push_back(static_cast<int>(uu));
+    graph->targets.push_back(static_cast<int>(vv));
+    graph->costs.push_back(cost);
+    if (ok && edges_read && ii + 1 - batch_start == batch_size) {
+      edges_read(batch_start, batch_size);
+      batch_start = ii + 1;
+    }
+  }
+  fclose(file);
+
+  if (!ok) {
+    *error = "malformed graph file " + path;
+  } else if (edges_read
+             && batch_start < static_cast<int>(graph->costs.size())) {
+    edges_read(batch_start, static_cast<int>(graph->costs.size()) - batch_start);
+  }
+  return ok;
+}
+
+
+bool read_graph_csv(const std::string& edges_path,
+                    const std::string& nodes_path, Graph* graph,
+                    std::string* error) {
+  std::unordered_map<std::string, int> node_index;
+  bool ok = for_each_csv_row(nodes_path, 2, 1,
+      [&](const std::vector<std::string>& fields) {
+        double prize = strtod(fields[1].c_str(), NULL);
+        if (!node_index.emplace(fields[0], graph->prizes.size()).second) {
+          return false;
+        }
+        graph->prizes.push_back(prize);
+        return true;
+      }, error);
+  if (!ok) {
+    return false;
+  }
+
+  return for_each_csv_row(edges_path, 4, 3,
+      [&](const std::vector<std::string>& fields) {
+        auto source = node_index.find(fields[1]);
+        auto target = node_index.find(fields[2]);
+        if (source == node_index.end() || target == node_index.end()) {
+          return false;
+        }
+        graph->sources.push_back(source->second);
+        graph->targets.push_back(target->second);
+        graph->costs.push_back(strtod(fields[3].c_str(), NULL));
+        return true;
+      }, error);
+}
+
+
+
+bool write_sorted_edge_file(const std::string& path, const Graph& graph,
+                            std::string* error) {
+  std::vector<int> order(graph.costs.size());
+  for (size_t ii = 0; ii < order.size(); ++ii) {
+    order[ii] = static_cast<int>(ii);
+  }
+  std::stable_sort(order.begin(), order.end(), [&graph](int aa, int bb) {
+    return graph.costs[aa] < graph.costs[bb];
+  });
+
+  FILE* file = fopen(path.c_str(), "wb");
+  if (file == NULL) {
+    *error = "cannot create " + path;
+    return false;
+  }
+  SortedEdgeHeader header;
+  memcpy(header.magic, kSortedEdgeMagic, sizeof(header.magic));
+  header.num_nodes = static_cast<int32_t>(graph.prizes.size());
+  header.unused = 0;
+  header.num_edges = static_cast<int64_t>(order.size());
+  bool ok = fwrite(&header, sizeof(header), 1, file) == 1
+            && fwrite(graph.prizes.data(), sizeof(double),
+                      graph.prizes.size(), file) == graph.prizes.size();
+  for (size_t ii = 0; ok && ii < order.size(); ++ii) {
+    int edge = order[ii];
+    double cost = graph.costs[edge];
+    int32_t fields[4] = {graph.sources[edge], graph.targets[edge], edge, 0};
+    ok = fwrite(&cost, sizeof(cost), 1, file) == 1
+         && fwrite(fields, sizeof(fields), 1, file) == 1;
+  }
+  ok = fclose(file) == 0 && ok;
+  if (!ok) {
+    *error = "cannot write " + path;
+  }
+  return ok;
+}
+
+
+SortedEdgeFile::SortedEdgeFile()
+    : mapping(NULL), mapping_size(0), records(NULL), num_records(0),
+      next_record(0), released_records(0) {}
+
+
+SortedEdgeFile::~SortedEdgeFile() {
+  if (mapping != NULL) {
+    munmap(mapping, mapping_size);
+  }
+}
+
+
+bool SortedEdgeFile::open(const std::string& path, std::string* error) {
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    *error = "cannot open " + path;
+    return false;
+  }
+  struct stat file_stat;
+  SortedEdgeHeader header;
+  bool ok = fstat(fd, &file_stat) == 0
+            && read(fd, &header, sizeof(header)) == sizeof(header)
+            && memcmp(header.magic, kSortedEdgeMagic, sizeof(header.magic)) == 0
+            && header.num_nodes >= 0 && header.num_edges >= 0;
+  size_t prizes_offset = sizeof(header);
+  size_t records_offset = 0;
+  if (ok) {
+    records_offset = prizes_offset + header.num_nodes * sizeof(double);
+    ok = static_cast<size_t>(file_stat.st_size)
+         == records_offset + header.num_edges * sizeof(Record);
+  }
+  if (ok) {
+    mapping_size = file_stat.st_size;
+    mapping = mmap(NULL, mapping_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping == MAP_FAILED) {
+      mapping = NULL;
+      ok = false;
+    }
+  }
+  close(fd);
+  if (!ok) {
+    *error = "malformed sorted edge file " + path;
+    return false;
+  }
+
+  madvise(mapping, mapping_size, MADV_SEQUENTIAL);
+  const char* bytes = static_cast<const char*>(mapping);
+  const double* file_prizes =
+      reinterpret_cast<const double*>(bytes + prizes_offset);
+  prizes.assign(file_prizes, file_prizes + header.num_nodes);
+  records = reinterpret_cast<const Record*>(bytes + records_offset);
+  num_records = header.num_edges;
+  rewind();
+  return true;
+}
+
+
+bool SortedEdgeFile::next(double max_cost, int* source, int* target,
+                          double* cost, int* id) {
+  if (next_record >= num_records || records[next_record].cost > max_cost) {
+    return false;
+  }
+  const Record& record = records[next_record];
+  if (next_record > 0 && record.cost < records[next_record - 1].cost) {
+    throw std::invalid_argument("Edge file not sorted by cost.");
+  }
+  *source = record.source;
+  *target = record.target;
+  *cost = record.cost;
+  *id = record.id;
+  next_record += 1;
+
+  if (next_record - released_records >= kReleaseRecords) {
+    long page_size = sysconf(_SC_PAGESIZE);
+    char* begin = static_cast<char*>(mapping);
+    size_t release = reinterpret_cast<const char*>(records + next_record)
+                     - begin;
+    release -= release % page_size;
+    madvise(begin, release, MADV_DONTNEED);
+    released_records = next_record;
+  }
+  return true;
+}
+
+
+void SortedEdgeFile::rewind() {
+  next_record = 0;
+  released_records = 0;
+}
+
+
+void SortedEdgeFile::get_costs(const std::vector<int>& ids,
+                               std::vector<double>* costs) const {
+  std::vector<std::pair<int, size_t> > wanted(ids.size());
+  for (size_t ii = 0; ii < ids.size(); ++ii) {
+    wanted[ii] = std::make_pair(ids[ii], ii);
+  }
+  std::sort(wanted.begin(), wanted.end());
+  costs->assign(ids.size(), 0.0);
+  for (long long ii = 0; ii < num_records; ++ii) {
+    auto match = std::lower_bound(wanted.begin(), wanted.end(),
+                                  std::make_pair(records[ii].id,
+                                                 static_cast<size_t>(0)));
+    for (; match != wanted.end() && match->first == records[ii].id;
+         ++match) {
+      (*costs)[match->second] = records[ii].cost;
+    }
+  }
+}
+
+}  // namespace pcst_tools
@@ -0,0 +1,104 @@
+// Graph files shared by the standalone tools.
+//
+// Text format (whitespace separated, '#' starts a comment line):
+//   <num_nodes> <num_edges>
+//   <prize of node 0> ... <prize of node num_nodes-1>
+//   <source> <target> <cost>        (num_edges lines, 0-based node indices)
+//
+// CSV format, two files with an optional header line each:
+//   nodes: <id>,<prize>               row order defines the node indices
+//   edges: <id>,<source>,<target>,<cost>
+//                                     row order defines the edge indices,
+//                                     source/target refer to node ids
+//
+// Sorted edge file, binary in native byte order, for solves that read the
+// edges from disk as growth reaches them:
+//   "PCSTEDGE", int32 num_nodes, int32 0, int64 num_edges
+//   double prizes[num_nodes]
+//   num_edges records {double cost; int32 source, target, id, 0} in order
+//   of nondecreasing cost; id is the edge's index in the graph written
+
+#ifndef PCST_TOOLS_GRAPH_FILE_H
+#define PCST_TOOLS_GRAPH_FILE_H
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "pcst_edge_source.h"
+
+namespace pcst_tools {
+
+struct Graph {
+  std::vector<int> sources;
+  std::vector<int> targets;
+  std::vector<double> costs;
+  std::vector<double> prizes;
+};
+
+// Both return false and set *error when the file cannot be read or parsed.
+bool read_graph_file(const std::string& path, Graph* graph,
+                     std::string* error);
+
+// read_graph_file that calls edges_read(first_edge, num_edges) whenever
+// another batch_size edges have been appended to graph, and once more for
+// the rest, so they can be processed while the file is still being read.
+bool read_graph_file(const std::string& path, Graph* graph,
+                     std::string* error, int batch_size,
+                     const std::function<void(int, int)>& edges_read);
+
+bool read_graph_csv(const std::string& edges_path,
+                    const std::string& nodes_path, Graph* graph,
+                    std::string* error);
+
+// Sorts the edges in memory; larger edge lists can be brought into the
+// record order by an external sort.
+bool write_sorted_edge_file(const std::string& path, const Graph& graph,
+                            std::string* error);
+
+// A sorted edge file mapped into memory and read front to back. Pages
+// behind the read position are given back as it moves on, so only the
+// edges near the growth horizon stay resident.
+class SortedEdgeFile : public cluster_approx::EdgeSource {
+ public:
+  SortedEdgeFile();
+  ~SortedEdgeFile();
+
+  bool open(const std::string& path, std::string* error);
+
+  const std::vector<double>& get_prizes() const { return prizes; }
+
+  // Throws std::invalid_argument on a record cheaper than the one before
+  bool next(double max_cost, int* source, int* target, double* cost,
+            int* id);
+  void rewind();
+  long long num_edges() const { return num_records; }
+
+  long long num_read_edges() const { return next_record; }
+
+  // Cost of every edge named in ids, in one pass over the file
+  void get_costs(const std::vector<int>& ids,
+                 std::vector<double>* costs) const;
+
+ private:
+  struct Record {
+    double cost;
+    int source;
+    int target;
+    int id;
+    int unused;
+  };
+
+  void* mapping;
+  size_t mapping_size;
+  const Record* records;
+  long long num_records;
+  long long next_record;
+  long long released_records;   // pages before these were given back
+  std::vector<double> prizes;
+};
+
+}  // namespace pcst_tools
+
+#endif
@@ -0,0 +1,657 @@
+// Standalone benchmark for the PCST solver, independent of PostgreSQL.
+//
+// Runs the same C wrapper entry point the extension uses and reports wall
+// time per solver phase, plus hardware counters (cycles, instructions, LLC
+// misses, branch misses) when --perf is given and perf_event_open works.
+// Graph files use the text format described in graph_file.h. A sorted edge
+// file (--write-edge-file) is solved with the edges read from disk as growth
+// reaches them, through the solver directly.
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "graph_file.h"
+#include "pcst_fast.h"
+#include "pcst_fast_c_wrapper.h"
+#include "pcst_perf.h"
+
+using cluster_approx::PCSTFast;
+using pcst_tools::Graph;
+
+namespace {
+
+struct Options {
+  std::string graph_file;
+  std::string edge_file;
+  std::string write_edge_file;
+  int random_nodes = 0;
+  int random_edges = 0;
+  unsigned int seed = 1;
+  int root = -1;
+  int num_clusters = 1;
+  int pruning = 3;
+  int repeat = 1;
+  double max_growth_time = -1.0;
+  int distance_network = -1;
+  bool lazy_edges = false;
+  double bucket_epsilon = 0.0;
+  int exact_max_nodes = 0;
+  int repair_failures = 0;
+  int builder = 0;          // 1: incremental builder, 2: with helper thread
+  bool perf = false;
+};
+
+// Edges per batch handed to the builder while the graph file is read
+const int kBuilderBatchSize = 65536;
+
+void usage(const char* program) {
+  fprintf(stderr,
+      "Usage: %s [options] <graph file>\n"
+      "       %s [options] --random <nodes> <edges>\n"
+      "       %s [options] --edge-file <sorted edge file>\n"
+      "\n"
+      "Options:\n"
+      "  --seed <n>         seed for --random (default 1)\n"
+      "  --root <n>         root node index, -1 for unrooted (default -1)\n"
+      "  --clusters <n>     target number of clusters (default 1)\n"
+      "  --pruning <name>   none, simple, gw, strong or auto (default strong)\n"
+      "  --repeat <n>       number of solves (default 1)\n"
+      "  --max-growth-time <t>  stop moat growth at time t (default: no cap)\n"
+      "  --distance-network <mode>  on, off or auto: solve on the distance\n"
+      "                     network of the prize nodes (default auto)\n"
+      "  --lazy-edges       insert edges into the GW heaps in cost order as\n"
+      "                     growth reaches them\n"
+      "  --bucket-epsilon <e>  round event times up to powers of (1 + e) and\n"
+      "                     compare objective and time with exact growth\n"
+      "  --exact <n>        solve components of at most n nodes exactly and\n"
+      "                     report whether the result is optimal\n"
+      "  --repair <k>       fail k random edges of the result, repair it and\n"
+      "                     compare objective and time with a new solve; with\n"
+      "                     --repeat, the first repair builds the incidence\n"
+      "                     lists and the others are timed\n"
+      "  --builder          hand edges to the solver input in batches while\n"
+      "                     the file is read, instead of after loading\n"
+      "  --builder-thread   same, processing the batches on a helper thread\n"
+      "  --write-edge-file <path>  write the graph as a sorted edge file and\n"
+      "                     exit\n"
+      "  --perf             collect hardware performance counters\n",
+      program, program, program);
+}
+
+int parse_pruning(const char* name) {
+  if (strcmp(name, "none") == 0) return 0;
+  if (strcmp(name, "simple") == 0) return 1;
+  if (strcmp(name, "gw") == 0) return 2;
+  if (strcmp(name, "strong") == 0) return 3;
+  if (strcmp(name, "auto") == 0) return PCST_PRUNING_AUTO;
+  return -1;
+}
+
+bool parse_options(int argc, char** argv, Options* options) {
+  for (int ii = 1; ii < argc; ++ii) {
+    std::string arg = argv[ii];
+    bool has_value = ii + 1 < argc;
+    if (arg == "--random" && ii + 2 < argc) {
+      options->random_nodes = atoi(argv[++ii]);
+      options->random_edges = atoi(argv[++ii]);
+    } else if (arg == "--seed" && has_value) {
+      options->seed = strtoul(argv[++ii], NULL, 10);
+    } else if (arg == "--root" && has_value) {
+      options->root = atoi(argv[++ii]);
+    } else if (arg == "--clusters" && has_value) {
+      options->num_clusters = atoi(argv[++ii]);
+    } else if (arg == "--pruning" && has_value) {
+      options->pruning = parse_pruning(argv[++ii]);
+      if (options->pruning < 0) {
+        fprintf(stderr, "Unknown pruning method: %s\n", argv[ii]);
+        return false;
+      }
+    } else if (arg == "--repeat" && has_value) {
+      options->repeat = atoi(argv[++ii]);
+    } else if (arg == "--max-growth-time" && has_value) {
+      options->max_growth_time = atof(argv[++ii]);
+    } else if (arg == "--distance-network" && has_value) {
+      std::string mode = argv[++ii];
+      if (mode == "on") {
+        options->distance_network = 1;
+      } else if (mode == "off") {
+        options->distance_network = 0;
+      } else if (mode == "auto") {
+        options->distance_network = -1;
+      } else {
+        fprintf(stderr, "Unknown distance network mode: %s\n", argv[ii]);
+        return false;
+      }
+    } else if (arg == "--lazy-edges") {
+      options->lazy_edges = true;
+    } else if (arg == "--bucket-epsilon" && has_value) {
+      options->bucket_epsilon = atof(argv[++ii]);
+    } else if (arg == "--exact" && has_value) {
+      options->exact_max_nodes = atoi(argv[++ii]);
+    } else if (arg == "--repair" && has_value) {
+      options->repair_failures = atoi(argv[++ii]);
+    } else if (arg == "--builder") {
+      options->builder = 1;
+    } else if (arg == "--builder-thread") {
+      options->builder = 2;
+    } else if (arg == "--perf") {
+      options->perf = true;
+    } else if (arg == "--edge-file" && has_value) {
+      options->edge_file = argv[++ii];
+    } else if (arg == "--write-edge-file" && has_value) {
+      options->write_edge_file = argv[++ii];
+    } else if (arg[0] != '-' && options->graph_file.empty()) {
+      options->graph_file = arg;
+    } else {
+      return false;
+    }
+  }
+  int num_inputs = !options->graph_file.empty() + (options->random_nodes > 0)
+                   + !options->edge_file.empty();
+  if (num_inputs != 1) {
+    return false;
+  }
+  if (!options->edge_file.empty()
+      && (options->pruning == PCST_PRUNING_AUTO || options->builder
+          || !options->write_edge_file.empty())) {
+    fprintf(stderr, "--edge-file takes no 'auto' pruning, --builder or "
+            "--write-edge-file\n");
+    return false;
+  }
+  return options->repeat > 0;
+}
+
+// Random connected graph: a random spanning tree plus extra random edges.
+// About a fifth of the nodes carry a prize.
+void generate_graph(int num_nodes, int num_edges, unsigned int seed,
+                    Graph* graph) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<double> cost_dist(1.0, 10.0);
+  std::uniform_real_distribution<double> prize_dist(0.0, 50.0);
+  std::uniform_int_distribution<int> terminal_dist(0, 4);
+
+  graph->prizes.resize(num_nodes);
+  for (int ii = 0; ii < num_nodes; ++ii) {
+    graph->prizes[ii] = terminal_dist(rng) == 0 ? prize_dist(rng) : 0.0;
+  }
+  for (int ii = 0; ii < num_edges; ++ii) {
+    int uu, vv;
+    if (ii + 1 < num_nodes) {
+      vv = ii + 1;
+      uu = std::uniform_int_distribution<int>(0, ii)(rng);
+    } else {
+      uu = std::uniform_int_distribution<int>(0, num_nodes - 1)(rng);
+      vv = std::uniform_int_distribution<int>(0, num_nodes - 1)(rng);
+      if (uu == vv) {
+        vv = (vv + 1) % num_nodes;
+      }
+    }
+    graph->sources.push_back(uu);
+    graph->targets.push_back(vv);
+    graph->costs.push_back(cost_dist(rng));
+  }
+}
+
+double objective(const Graph& graph, const pcst_result_t* result) {
+  double value = 0.0;
+  for (int ii = 0; ii < result->num_nodes; ++ii) {
+    value += graph.prizes[result->result_nodes[ii]];
+  }
+  for (int ii = 0; ii < result->num_edges; ++ii) {
+    value -= graph.costs[result->result_edges[ii]];
+  }
+  return value;
+}
+
+void print_report(const pcst_perf_session_t& perf, bool requested_counters) {
+  printf("\n%-16s %8s %12s", "phase", "calls", "avg_ms");
+  for (int cc = 0; cc < PCST_NUM_COUNTERS; ++cc) {
+    if (pcst_perf_counter_available(&perf, static_cast<pcst_counter_t>(cc))) {
+      printf(" %15s",
+             pcst_perf_counter_name(static_cast<pcst_counter_t>(cc)));
+    }
+  }
+  bool have_ipc =
+      pcst_perf_counter_available(&perf, PCST_COUNTER_CYCLES)
+      && pcst_perf_counter_available(&perf, PCST_COUNTER_INSTRUCTIONS);
+  if (have_ipc) {
+    printf(" %6s", "ipc");
+  }
+  printf("\n");
+
+  for (int pp = 0; pp < PCST_NUM_PHASES; ++pp) {
+    const pcst_phase_sample_t& sample = perf.phases[pp];
+    if (sample.num_samples == 0) {
+      continue;
+    }
+    printf("%-16s %8d %12.3f",
+           pcst_perf_phase_name(static_cast<pcst_phase_t>(pp)),
+           sample.num_samples,
+           1000.0 * sample.wall_seconds / sample.num_samples);
+    for (int cc = 0; cc < PCST_NUM_COUNTERS; ++cc) {
+      if (pcst_perf_counter_available(&perf,
+                                      static_cast<pcst_counter_t>(cc))) {
+        printf(" %15lld", sample.counters[cc] / sample.num_samples);
+      }
+    }
+    if (have_ipc) {
+      long long cycles = sample.counters[PCST_COUNTER_CYCLES];
+      printf(" %6.2f", cycles > 0
+          ? static_cast<double>(sample.counters[PCST_COUNTER_INSTRUCTIONS])
+              / cycles
+          : 0.0);
+    }
+    printf("\n");
+  }
+
+  if (requested_counters && perf.num_available_counters < PCST_NUM_COUNTERS) {
+    printf("\n%d of %d hardware counters unavailable "
+           "(check kernel.perf_event_paranoid or container seccomp)\n",
+           PCST_NUM_COUNTERS - perf.num_available_counters, PCST_NUM_COUNTERS);
+  }
+}
+
+void print_solver_output(const char* text) {
+  fputs(text, stderr);
+}
+
+// Plain GW over a sorted edge file. The file is read only as far as growth
+// gets; the objective is computed afterwards in one more pass.
+int solve_edge_file(const Options& options, pcst_perf_session_t* perf) {
+  pcst_tools::SortedEdgeFile file;
+  std::string error;
+  if (!file.open(options.edge_file, &error)) {
+    fprintf(stderr, "%s\n", error.c_str());
+    return 1;
+  }
+  const std::vector<double>& prizes = file.get_prizes();
+  printf("graph: %zu nodes, %lld edges (sorted edge file)\n", prizes.size(),
+         file.num_edges());
+
+  int root = options.root >= 0 ? options.root : PCSTFast::kNoRoot;
+  int num_clusters = options.root >= 0 ? 0 : options.num_clusters;
+  PCSTFast::PruningMethod pruning =
+      static_cast<PCSTFast::PruningMethod>(options.pruning);
+  PCSTFast solver(&file, prizes, root, num_clusters, pruning, 0,
+                  print_solver_output);
+  solver.set_perf_session(perf);
+  if (options.max_growth_time >= 0.0) {
+    solver.set_max_growth_time(options.max_growth_time);
+  }
+  if (options.bucket_epsilon > 0.0) {
+    solver.set_event_bucket_epsilon(options.bucket_epsilon);
+  }
+
+  std::vector<int> result_nodes;
+  std::vector<int> result_edges;
+  auto start = std::chrono::steady_clock::now();
+  for (int run = 0; run < options.repeat; ++run) {
+    if (run > 0) {
+      solver.reset(root, num_clusters, pruning);
+    }
+    bool success;
+    try {
+      success = solver.run(&result_nodes, &result_edges);
+    } catch (const std::exception& e) {
+      fprintf(stderr, "Solve failed: %s\n", e.what());
+      return 1;
+    }
+    if (!success) {
+      fprintf(stderr, "Solve failed\n");
+      return 1;
+    }
+  }
+  std::chrono::duration<double> seconds =
+      std::chrono::steady_clock::now() - start;
+
+  std::vector<double> result_costs;
+  file.get_costs(result_edges, &result_costs);
+  double value = 0.0;
+  for (size_t ii = 0; ii < result_nodes.size(); ++ii) {
+    value += prizes[result_nodes[ii]];
+  }
+  for (size_t ii = 0; ii < result_costs.size(); ++ii) {
+    value -= result_costs[ii];
+  }
+
+  PCSTFast::Statistics stats;
+  solver.get_statistics(&stats);
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  printf("result: %zu nodes, %zu edges, objective %.6f\n",
+         result_nodes.size(), result_edges.size(), value);
+  printf("edge events: %lld\n", stats.total_num_edge_events);
+  printf("edges read from the file: %lld, never inserted: %lld\n",
+         file.num_read_edges(), stats.num_uninserted_edges);
+  printf("growth stopped at %.6f%s\n", stats.final_growth_time,
+         stats.growth_time_capped ? " (max growth time)" : "");
+  printf("memory %-24s peak %12zu bytes\n", "solver.edge_parts",
+         stats.edge_parts_memory.peak_bytes);
+  printf("memory %-24s peak %12zu bytes\n", "solver.heap_nodes",
+         stats.heap_node_memory.peak_bytes);
+  printf("peak resident set %ld kB\n", usage.ru_maxrss);
+  printf("avg solve %.3f ms\n", 1000.0 * seconds.count() / options.repeat);
+  return 0;
+}
+
+}  // namespace
+
+
+int main(int argc, char** argv) {
+  Options options;
+  if (!parse_options(argc, argv, &options)) {
+    usage(argv[0]);
+    return 2;
+  }
+
+  pcst_perf_session_t perf;
+  pcst_perf_open(&perf, options.perf);
+
+  if (!options.edge_file.empty()) {
+    int status = solve_edge_file(options, &perf);
+    pcst_perf_close(&perf);
+    if (status == 0) {
+      print_report(perf, options.perf);
+    }
+    return status;
+  }
+
+  Graph graph;
+  pcst_builder_t* builder = NULL;
+  if (options.builder) {
+    builder = pcst_builder_create(options.builder == 2,
+                                  options.pruning == PCST_PRUNING_AUTO);
+  }
+  auto add_edges = [&](int first_edge, int num_edges) {
+    pcst_builder_add_edges(builder, graph.sources.data() + first_edge,
+                           graph.targets.data() + first_edge,
+                           graph.costs.data() + first_edge, num_edges);
+  };
+  pcst_perf_begin(&perf, PCST_PHASE_LOAD);
+  if (options.graph_file.empty()) {
+    generate_graph(options.random_nodes, options.random_edges, options.seed,
+                   &graph);
+    if (builder) {
+      add_edges(0, static_cast<int>(graph.costs.size()));
+    }
+  } else {
+    std::string error;
+    bool ok = builder
+              ? pcst_tools::read_graph_file(options.graph_file, &graph, &error,
+                                            kBuilderBatchSize, add_edges)
+              : pcst_tools::read_graph_file(options.graph_file, &graph, &error);
+    if (!ok) {
+      fprintf(stderr, "%s\n", error.c_str());
+      pcst_builder_free(builder);
+      pcst_perf_close(&perf);
+      return 1;
+    }
+  }
+  if (builder) {
+    pcst_builder_set_prizes(builder, graph.prizes.data(),
+                            static_cast<int>(graph.prizes.size()));
+  }
+  pcst_perf_end(&perf);
+
+  if (!options.write_edge_file.empty()) {
+    std::string error;
+    bool ok = pcst_tools::write_sorted_edge_file(options.write_edge_file,
+                                                 graph, &error);
+    if (!ok) {
+      fprintf(stderr, "%s\n", error.c_str());
+    } else {
+      printf("wrote %zu edges sorted by cost to %s\n", graph.costs.size(),
+             options.write_edge_file.c_str());
+    }
+    pcst_builder_free(builder);
+    pcst_perf_close(&perf);
+    return ok ? 0 : 1;
+  }
+
+  pcst_options_t solve_options;
+  pcst_init_options(&solve_options);
+  solve_options.perf = &perf;
+  solve_options.max_growth_time = options.max_growth_time;
+  solve_options.distance_network = options.distance_network;
+  solve_options.lazy_edges = options.lazy_edges;
+  solve_options.event_bucket_epsilon = options.bucket_epsilon;
+  solve_options.exact_max_nodes = options.exact_max_nodes;
+
+  printf("graph: %zu nodes, %zu edges\n", graph.prizes.size(),
+         graph.costs.size());
+
+  int num_clusters = options.root >= 0 ? 0 : options.num_clusters;
+  auto solve = [&](const pcst_options_t* run_options) {
+    return builder
+        ? pcst_solve_builder(builder, options.root, num_clusters,
+                             options.pruning, 0, run_options)
+        : pcst_solve_with_options(
+              graph.sources.data(), graph.targets.data(), graph.costs.data(),
+              static_cast<int>(graph.costs.size()), graph.prizes.data(),
+              static_cast<int>(graph.prizes.size()), options.root,
+              num_clusters, options.pruning, 0, run_options);
+  };
+
+  double bucketed_objective = 0.0;
+  long long bucketed_edge_events = 0;
+  std::vector<int> solution_edges;
+  auto start = std::chrono::steady_clock::now();
+  for (int run = 0; run < options.repeat; ++run) {
+    pcst_result_t* result = solve(&solve_options);
+
+    if (result == NULL || !result->success) {
+      fprintf(stderr, "Solve failed: %s\n",
+              result ? result->error_message : "out of memory");
+      pcst_free_result(result);
+      pcst_builder_free(builder);
+      pcst_perf_close(&perf);
+      return 1;
+    }
+
+    if (run == 0) {
+      bucketed_objective = objective(graph, result);
+      bucketed_edge_events = result->stats.total_num_edge_events;
+      solution_edges.assign(result->result_edges,
+                            result->result_edges + result->num_edges);
+      printf("result: %d nodes, %d edges, objective %.6f\n",
+             result->num_nodes, result->num_edges, bucketed_objective);
+      if (result->plan.automatic) {
+        printf("plan: pruning %d, tree dp %d, peeled %d nodes, dropped %d distant nodes "
+               "(components %d, cycle rank %lld, leaves %d)\n",
+               result->plan.pruning_method, result->plan.tree_dp,
+               result->stats.num_peeled_nodes, result->stats.num_distant_nodes,
+               result->profile.num_components,
+               result->profile.cycle_rank, result->profile.num_leaves);
+      }
+      if (result->plan.distance_network) {
+        printf("distance network: %d terminals\n", result->stats.num_terminals);
+      }
+      printf("edge events: %lld\n", result->stats.total_num_edge_events);
+      if (result->plan.lazy_edges) {
+        printf("edges never inserted: %lld\n",
+               result->stats.num_uninserted_edges);
+      }
+      if (options.bucket_epsilon > 0.0) {
+        printf("event buckets: %lld\n", result->stats.num_event_buckets);
+      }
+      if (result->plan.exact) {
+        printf("exact: %s, objective bound %.6f, %d components searched, "
+               "%lld subproblems\n",
+               result->stats.optimal ? "optimal" : "not proven optimal",
+               result->stats.objective_bound,
+               result->stats.num_exact_components,
+               result->stats.num_exact_subproblems);
+      }
+      printf("growth stopped at %.6f%s\n", result->stats.final_growth_time,
+             result->stats.growth_time_capped ? " (max growth time)" : "");
+      for (int ii = 0; ii < result->stats.num_memory_entries; ++ii) {
+        printf("memory %-24s peak %12zu bytes\n",
+               result->stats.memory[ii].name,
+               result->stats.memory[ii].peak_bytes);
+      }
+    }
+    pcst_free_result(result);
+  }
+  std::chrono::duration<double> bucketed_seconds =
+      std::chrono::steady_clock::now() - start;
+
+  // The same solves with exact growth, for the price of the approximation.
+  // These runs are not part of the phase report below.
+  if (options.bucket_epsilon > 0.0) {
+    pcst_options_t exact_options = solve_options;
+    exact_options.event_bucket_epsilon = 0.0;
+    exact_options.perf = NULL;
+    double exact_objective = 0.0;
+    long long exact_edge_events = 0;
+    start = std::chrono::steady_clock::now();
+    for (int run = 0; run < options.repeat; ++run) {
+      pcst_result_t* result = solve(&exact_options);
+      if (result == NULL || !result->success) {
+        fprintf(stderr, "Exact solve failed: %s\n",
+                result ? result->error_message : "out of memory");
+        pcst_free_result(result);
+        pcst_builder_free(builder);
+        pcst_perf_close(&perf);
+        return 1;
+      }
+      if (run == 0) {
+        exact_objective = objective(graph, result);
+        exact_edge_events = result->stats.total_num_edge_events;
+      }
+      pcst_free_result(result);
+    }
+    std::chrono::duration<double> exact_seconds =
+        std::chrono::steady_clock::now() - start;
+
+    double loss = exact_objective - bucketed_objective;
+    printf("\nbucket epsilon %g vs exact growth:\n", options.bucket_epsilon);
+    printf("objective %.6f vs %.6f, loss %.6f (%.3f%% of exact)\n",
+           bucketed_objective, exact_objective, loss,
+           exact_objective != 0.0 ? 100.0 * loss / exact_objective : 0.0);
+    printf("edge events %lld vs %lld\n", bucketed_edge_events,
+           exact_edge_events);
+    printf("avg solve %.3f ms vs %.3f ms (%.2fx)\n",
+           1000.0 * bucketed_seconds.count() / options.repeat,
+           1000.0 * exact_seconds.count() / options.repeat,
+           bucketed_seconds.count() > 0.0
+               ? exact_seconds.count() / bucketed_seconds.count() : 0.0);
+  }
+
+  // Random edges of the result fail: repair it, and solve again on the
+  // graph without them. The new solves are not part of the phase report.
+  if (options.repair_failures > 0 && !solution_edges.empty()) {
+    std::mt19937 rng(options.seed);
+    std::vector<int> failed(solution_edges);
+    std::shuffle(failed.begin(), failed.end(), rng);
+    failed.resize(std::min(failed.size(),
+                           static_cast<size_t>(options.repair_failures)));
+    double repaired_objective = 0.0;
+    pcst_stats_t repair_stats;
+    memset(&repair_stats, 0, sizeof(repair_stats));
+    // The repairer is built once per graph, as a server would keep it, and
+    // only the runs are timed against the new solves
+    start = std::chrono::steady_clock::now();
+    pcst_repairer_t* repairer = pcst_repairer_create(
+        graph.sources.data(), graph.targets.data(), graph.costs.data(),
+        static_cast<int>(graph.costs.size()), graph.prizes.data(),
+        static_cast<int>(graph.prizes.size()));
+    std::chrono::duration<double> prepare_seconds(0.0);
+    for (int run = 0; run < options.repeat; ++run) {
+      pcst_result_t* result = repairer == NULL ? NULL : pcst_repairer_run(
+          repairer, solution_edges.data(),
+          static_cast<int>(solution_edges.size()), failed.data(),
+          static_cast<int>(failed.size()), options.root, 0, &solve_options);
+      if (result == NULL || !result->success) {
+        fprintf(stderr, "Repair failed: %s\n",
+                result ? result->error_message : "out of memory");
+        pcst_free_result(result);
+        pcst_repairer_free(repairer);
+        pcst_builder_free(builder);
+        pcst_perf_close(&perf);
+        return 1;
+      }
+      if (run == 0) {
+        // The first run builds the incidence lists
+        prepare_seconds = std::chrono::steady_clock::now() - start;
+        start = std::chrono::steady_clock::now();
+      }
+      if (run == 0) {
+        repaired_objective = objective(graph, result);
+        repair_stats = result->stats;
+      }
+      pcst_free_result(result);
+    }
+    std::chrono::duration<double> repair_seconds =
+        std::chrono::steady_clock::now() - start;
+    pcst_repairer_free(repairer);
+    int num_repair_runs = std::max(1, options.repeat - 1);
+
+    Graph remaining;
+    std::vector<char> is_failed(graph.costs.size(), 0);
+    for (size_t ii = 0; ii < failed.size(); ++ii) {
+      is_failed[failed[ii]] = 1;
+    }
+    for (size_t ii = 0; ii < graph.costs.size(); ++ii) {
+      if (!is_failed[ii]) {
+        remaining.sources.push_back(graph.sources[ii]);
+        remaining.targets.push_back(graph.targets[ii]);
+        remaining.costs.push_back(graph.costs[ii]);
+      }
+    }
+    remaining.prizes = graph.prizes;
+    pcst_options_t resolve_options = solve_options;
+    resolve_options.perf = NULL;
+    double resolved_objective = 0.0;
+    start = std::chrono::steady_clock::now();
+    for (int run = 0; run < options.repeat; ++run) {
+      pcst_result_t* result = pcst_solve_with_options(
+          remaining.sources.data(), remaining.targets.data(),
+          remaining.costs.data(), static_cast<int>(remaining.costs.size()),
+          remaining.prizes.data(), static_cast<int>(remaining.prizes.size()),
+          options.root, num_clusters, options.pruning, 0, &resolve_options);
+      if (result == NULL || !result->success) {
+        fprintf(stderr, "Solve without the failed edges failed: %s\n",
+                result ? result->error_message : "out of memory");
+        pcst_free_result(result);
+        pcst_builder_free(builder);
+        pcst_perf_close(&perf);
+        return 1;
+      }
+      if (run == 0) {
+        resolved_objective = objective(remaining, result);
+      }
+      pcst_free_result(result);
+    }
+    std::chrono::duration<double> resolve_seconds =
+        std::chrono::steady_clock::now() - start;
+
+    printf("\nrepair of %zu failed edges out of %zu vs new solve:\n",
+           failed.size(), solution_edges.size());
+    printf("objective %.6f vs %.6f\n", repaired_objective, resolved_objective);
+    printf("%d fragments, %d paths added, %lld nodes settled\n",
+           repair_stats.num_repair_fragments, repair_stats.num_repair_paths,
+           repair_stats.num_repair_settled_nodes);
+    double repair_ms = options.repeat > 1
+                       ? 1000.0 * repair_seconds.count() / num_repair_runs
+                       : 1000.0 * prepare_seconds.count();
+    double resolve_ms = 1000.0 * resolve_seconds.count() / options.repeat;
+    printf("first repair %.3f ms with the incidence lists\n",
+           1000.0 * prepare_seconds.count());
+    printf("avg %.3f ms vs %.3f ms (%.2fx)\n", repair_ms, resolve_ms,
+           repair_ms > 0.0 ? resolve_ms / repair_ms : 0.0);
+  }
+
+  pcst_builder_free(builder);
+  pcst_perf_close(&perf);
+  print_report(perf, options.perf);
+  return 0;
+}
@@ -0,0 +1,1128 @@
+// Differential test of the solver variants against the reference solve.
+//
+// The reference is plain GW with strong pruning through the C wrapper. Each
+// variant solves the same instance another way (resumed in single-event
+// steps, reused through reset(), with the input handed in small batches to
+// the builder's helper thread, read node by node as growth reaches it, read
+// from a sorted edge file as growth reaches it, with (1 + epsilon)-bucketed
+// events, or with a forced plan: lazy edge insertion,
+// tree DP, tail peeling, prize balls, distance network, the exact step,
+// 'auto') and its result is checked against the reference at the strength
+// the variant promises:
+//
+//   identical   same node and edge sets
+//   objective   same objective within a tolerance (tie-breaking may differ)
+//   not-worse   objective at least the reference's
+//   optimal     objective of the best tree, found by trying every node set
+//               on instances of up to kMaxBruteForceNodes nodes; not-worse
+//               on larger ones
+//   valid       a forest of the input with the root and tree count asked for
+//
+// Variants that may break ties between simultaneous events differently are
+// held to a weaker check on instances where ties are likely (repeated or
+// integral costs, repeated prizes).
+//
+// Instances are generated from a seed in several families (real and integer
+// costs, trees, sparse prizes, disconnected graphs) and can be added from
+// graph files. A failing instance is shrunk by dropping edges, prizes and
+// isolated nodes while it keeps failing, and written out as a graph file
+// that pcst_bench can run.
+//
+// Solver reuse is also timed on one large random graph: a run after reset()
+// must not be much slower than the first, as it would be if a reset left
+// work proportional to the whole graph behind for every event.
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "graph_file.h"
+#include "pcst_fast.h"
+#include "pcst_fast_c_wrapper.h"
+
+using cluster_approx::PCSTFast;
+using pcst_tools::Graph;
+
+namespace {
+
+// Absolute objective tolerance, scaled by the objective's magnitude
+const double kObjectiveTolerance = 1e-9;
+
+// Largest instance whose best tree is found by trying every node set
+const int kMaxBruteForceNodes = 16;
+
+// Components the exact variant solves by branch and bound, all but the
+// largest sparse instances
+const int kExactMaxNodes = 60;
+
+struct Options {
+  int num_instances = 2000;
+  unsigned int seed = 1;
+  std::vector<std::string> graph_files;
+  std::string out_dir = ".";
+  int max_minimized = 5;
+  int reuse_nodes = 50000;
+  bool verbose = false;
+};
+
+struct Instance {
+  Graph graph;
+  int root = -1;
+  int num_clusters = 1;
+  std::string origin;
+};
+
+struct Solution {
+  std::vector<int> nodes;
+  std::vector<int> edges;
+  double objective = 0.0;
+};
+
+enum Check {
+  kIdentical,
+  kSameObjective,
+  kNotWorse,
+  kOptimal,
+  kValid
+};
+
+const char* check_name(Check check) {
+  switch (check) {
+    case kIdentical: return "identical";
+    case kSameObjective: return "objective";
+    case kNotWorse: return "not-worse";
+    case kOptimal: return "optimal";
+    default: return "valid";
+  }
+}
+
+struct Variant {
+  const char* name;
+  Check check;
+  Check check_with_ties;
+  bool (*applies)(const Instance&);
+  bool (*solve)(const Instance&, Solution*);
+};
+
+void usage(const char* program) {
+  fprintf(stderr,
+      "Usage: %s [options]\n"
+      "\n"
+      "Options:\n"
+      "  --instances <n>    generated instances (default 2000)\n"
+      "  --seed <n>         seed for the generated instances (default 1)\n"
+      "  --graph <file>     also run a graph file, unrooted and rooted at its\n"
+      "                     largest prize (may be repeated)\n"
+      "  --out <dir>        where minimized failures are written (default .)\n"
+      "  --max-minimized <n>  failures to minimize (default 5)\n"
+      "  --reuse-nodes <n>  nodes of the graph solver reuse is timed on\n"
+      "                     (default 50000, 0 to skip)\n"
+      "  --verbose          print every failure\n",
+      program);
+}
+
+bool parse_options(int argc, char** argv, Options* options) {
+  for (int ii = 1; ii < argc; ++ii) {
+    std::string arg = argv[ii];
+    bool has_value = ii + 1 < argc;
+    if (arg == "--instances" && has_value) {
+      options->num_instances = atoi(argv[++ii]);
+    } else if (arg == "--seed" && has_value) {
+      options->seed = strtoul(argv[++ii], NULL, 10);
+    } else if (arg == "--graph" && has_value) {
+      options->graph_files.push_back(argv[++ii]);
+    } else if (arg == "--out" && has_value) {
+      options->out_dir = argv[++ii];
+    } else if (arg == "--max-minimized" && has_value) {
+      options->max_minimized = atoi(argv[++ii]);
+    } else if (arg == "--reuse-nodes" && has_value) {
+      options->reuse_nodes = atoi(argv[++ii]);
+    } else if (arg == "--verbose") {
+      options->verbose = true;
+    } else {
+      return false;
+    }
+  }
+  return options->num_instances >= 0;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Instances
+
+bool wants_one_tree(const Instance& instance) {
+  return instance.root >= 0 || instance.num_clusters <= 1;
+}
+
+int num_nodes(const Instance& instance) {
+  return static_cast<int>(instance.graph.prizes.size());
+}
+
+// Random graph: a random spanning tree plus extra random edges
+void add_random_edges(int first_node, int num_nodes, int num_extra,
+                      bool integer_costs, std::mt19937* rng, Graph* graph) {
+  std::uniform_real_distribution<double> cost_dist(0.5, 10.0);
+  std::uniform_int_distribution<int> integer_cost_dist(1, 4);
+  for (int ii = 1; ii < num_nodes + num_extra; ++ii) {
+    int uu, vv;
+    if (ii < num_nodes) {
+      vv = ii;
+      uu = std::uniform_int_distribution<int>(0, ii - 1)(*rng);
+    } else {
+      if (num_nodes < 2) {
+        break;
+      }
+      uu = std::uniform_int_distribution<int>(0, num_nodes - 1)(*rng);
+      vv = std::uniform_int_distribution<int>(0, num_nodes - 2)(*rng);
+      if (vv >= uu) {
+        vv += 1;
+      }
+    }
+    graph->sources.push_back(first_node + uu);
+    graph->targets.push_back(first_node + vv);
+    graph->costs.push_back(integer_costs ? integer_cost_dist(*rng)
+                                         : cost_dist(*rng));
+  }
+}
+
+void generate_instance(int index, std::mt19937* rng, Instance* instance) {
+  static const char* kFamilies[] = {
+    "random", "integer", "tree", "sparse", "forest"
+  };
+  int family = index % 5;
+  instance->origin = std::string(kFamilies[family]) + " #"
+                     + std::to_string(index);
+  Graph& graph = instance->graph;
+
+  int num_nodes = std::uniform_int_distribution<int>(
+      family == 3 ? 20 : 2, family == 3 ? 150 : 40)(*rng);
+  std::uniform_real_distribution<double> unit(0.0, 1.0);
+  graph.prizes.assign(num_nodes, 0.0);
+  if (family == 3) {
+    int num_prized = std::uniform_int_distribution<int>(1, 3)(*rng);
+    for (int ii = 0; ii < num_prized; ++ii) {
+      int node = std::uniform_int_distribution<int>(0, num_nodes - 1)(*rng);
+      graph.prizes[node] = 10.0 + 50.0 * unit(*rng);
+    }
+  } else {
+    for (int ii = 0; ii < num_nodes; ++ii) {
+      if (unit(*rng) < 0.5) {
+        graph.prizes[ii] = family == 1
+            ? std::uniform_int_distribution<int>(1, 8)(*rng)
+            : 25.0 * unit(*rng);
+      }
+    }
+  }
+
+  int num_extra = family == 2 ? 0 : std::uniform_int_distribution<int>(
+      0, 2 * num_nodes)(*rng);
+  if (family == 4 && num_nodes >= 4) {
+    int split = num_nodes / 2;
+    add_random_edges(0, split, num_extra / 2, false, rng, &graph);
+    add_random_edges(split, num_nodes - split, num_extra / 2, false, rng,
+                     &graph);
+  } else {
+    add_random_edges(0, num_nodes, num_extra, family == 1, rng, &graph);
+  }
+
+  // Half unrooted for one tree, some unrooted for more, the rest rooted
+  double scenario = unit(*rng);
+  if (scenario < 0.2 && num_nodes >= 3) {
+    instance->num_clusters = std::uniform_int_distribution<int>(2, 3)(*rng);
+  } else if (scenario >= 0.5 && !graph.sources.empty()) {
+    int edge = std::uniform_int_distribution<int>(
+        0, static_cast<int>(graph.sources.size()) - 1)(*rng);
+    instance->root = graph.sources[edge];
+    instance->num_clusters = 0;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Solving
+
+void ignore_output(const char*) {}
+
+double objective(const Instance& instance, const Solution& solution) {
+  double value = 0.0;
+  for (size_t ii = 0; ii < solution.nodes.size(); ++ii) {
+    value += instance.graph.prizes[solution.nodes[ii]];
+  }
+  for (size_t ii = 0; ii < solution.edges.size(); ++ii) {
+    value -= instance.graph.costs[solution.edges[ii]];
+  }
+  return value;
+}
+
+void finish_solution(const Instance& instance, Solution* solution) {
+  std::sort(solution->nodes.begin(), solution->nodes.end());
+  std::sort(solution->edges.begin(), solution->edges.end());
+  solution->objective = objective(instance, *solution);
+}
+
+// Solve through the C wrapper; plan NULL with pruning_method strong is the
+// reference
+bool solve_wrapper(const Instance& instance, int pruning_method,
+                   const pcst_plan_t* plan, Solution* solution,
+                   int exact_max_nodes = 0) {
+  Graph graph = instance.graph;
+  pcst_options_t options;
+  pcst_init_options(&options);
+  options.distance_network = 0;
+  options.plan = plan;
+  options.exact_max_nodes = exact_max_nodes;
+  pcst_result_t* result = pcst_solve_with_options(
+      graph.sources.data(), graph.targets.data(), graph.costs.data(),
+      static_cast<int>(graph.costs.size()), graph.prizes.data(),
+      static_cast<int>(graph.prizes.size()), instance.root,
+      instance.num_clusters, pruning_method, 0, &options);
+  bool success = result != NULL && result->success;
+  if (success) {
+    solution->nodes.assign(result->result_nodes,
+                           result->result_nodes + result->num_nodes);
+    solution->edges.assign(result->result_edges,
+                           result->result_edges + result->num_edges);
+    finish_solution(instance, solution);
+  }
+  pcst_free_result(result);
+  return success;
+}
+
+bool solve_plan(const Instance& instance, int tree_dp, int peel_tails,
+                int prize_balls, int distance_network, int lazy_edges,
+                Solution* solution) {
+  pcst_plan_t plan;
+  memset(&plan, 0, sizeof(plan));
+  plan.pruning_method = 3;
+  plan.tree_dp = tree_dp;
+  plan.peel_tails = peel_tails;
+  plan.prize_balls = prize_balls;
+  plan.distance_network = distance_network;
+  plan.lazy_edges = lazy_edges;
+  return solve_wrapper(instance, 3, &plan, solution);
+}
+
+void edge_vectors(const Instance& instance,
+                  std::vector<std::pair<int, int> >* edges) {
+  for (size_t ii = 0; ii < instance.graph.sources.size(); ++ii) {
+    edges->push_back(std::make_pair(instance.graph.sources[ii],
+                                    instance.graph.targets[ii]));
+  }
+}
+
+bool solve_reference(const Instance& instance, Solution* solution) {
+  return solve_wrapper(instance, 3, NULL, solution);
+}
+
+// One growth event per step()
+bool solve_stepped(const Instance& instance, Solution* solution) {
+  std::vector<std::pair<int, int> > edges;
+  edge_vectors(instance, &edges);
+  PCSTFast solver(edges, instance.graph.prizes, instance.graph.costs,
+                  instance.root < 0 ? PCSTFast::kNoRoot : instance.root,
+                  instance.num_clusters, PCSTFast::kStrongPruning, 0,
+                  ignore_output);
+  PCSTFast::StepStatus status;
+  do {
+    status = solver.step(1);
+  } while (status == PCSTFast::kInProgress);
+  if (status != PCSTFast::kDone) {
+    return false;
+  }
+  solver.get_result(&solution->nodes, &solution->edges);
+  finish_solution(instance, solution);
+  return true;
+}
+
+// A solver that already ran with other settings, reused through reset()
+bool solve_reset(const Instance& instance, Solution* solution) {
+  std::vector<std::pair<int, int> > edges;
+  edge_vectors(instance, &edges);
+  PCSTFast solver(edges, instance.graph.prizes, instance.graph.costs,
+                  PCSTFast::kNoRoot, 2, PCSTFast::kGWPruning, 0,
+                  ignore_output);
+  std::vector<int> ignored_nodes;
+  std::vector<int> ignored_edges;
+  if (!solver.run(&ignored_nodes, &ignored_edges)) {
+    return false;
+  }
+  solver.reset(instance.root < 0 ? PCSTFast::kNoRoot : instance.root,
+               instance.num_clusters, PCSTFast::kStrongPruning);
+  if (!solver.run(&solution->nodes, &solution->edges)) {
+    return false;
+  }
+  finish_solution(instance, solution);
+  return true;
+}
+
+// Input added to the builder a few edges at a time, checked and profiled on
+// its helper thread
+bool solve_builder(const Instance& instance, Solution* solution) {
+  const Graph& graph = instance.graph;
+  const int kBatchSize = 3;
+  pcst_builder_t* builder = pcst_builder_create(1, 1);
+  for (size_t ii = 0; ii < graph.costs.size(); ii += kBatchSize) {
+    int num_edges = static_cast<int>(
+        std::min(graph.costs.size() - ii, static_cast<size_t>(kBatchSize)));
+    pcst_builder_add_edges(builder, graph.sources.data() + ii,
+                           graph.targets.data() + ii, graph.costs.data() + ii,
+                           num_edges);
+  }
+  pcst_builder_set_prizes(builder, graph.prizes.data(),
+                          static_cast<int>(graph.prizes.size()));
+  pcst_options_t options;
+  pcst_init_options(&options);
+  options.distance_network = 0;
+  pcst_result_t* result = pcst_solve_builder(builder, instance.root,
+                                             instance.num_clusters, 3, 0,
+                                             &options);
+  pcst_builder_free(builder);
+  bool success = result != NULL && result->success;
+  if (success) {
+    solution->nodes.assign(result->result_nodes,
+                           result->result_nodes + result->num_nodes);
+    solution->edges.assign(result->result_edges,
+                           result->result_edges + result->num_edges);
+    finish_solution(instance, solution);
+  }
+  pcst_free_result(result);
+  return success;
+}
+
+// The graph read as growth reaches it, like pgr_pcst_fast_frontier does:
+// the edges of the prize nodes and the root first, then those of every node
+// the solver asks for. Nodes and edges are numbered in the order they are
+// read.
+bool solve_frontier(const Instance& instance, Solution* solution) {
+  const Graph& graph = instance.graph;
+  int num_graph_nodes = num_nodes(instance);
+  std::vector<std::vector<int> > incident(num_graph_nodes);
+  for (size_t ii = 0; ii < graph.sources.size(); ++ii) {
+    incident[graph.sources[ii]].push_back(static_cast<int>(ii));
+    incident[graph.targets[ii]].push_back(static_cast<int>(ii));
+  }
+  std::vector<int> frontier_node(num_graph_nodes, -1);
+  std::vector<int> graph_node;
+  std::vector<int> graph_edge;
+  std::vector<bool> edge_read(graph.costs.size(), false);
+  pcst_frontier_t* frontier = NULL;
+
+  // Read the edges of nodes; returns false when out of memory
+  auto read_edges = [&](const std::vector<int>& nodes) {
+    std::vector<int> sources;
+    std::vector<int> targets;
+    std::vector<double> costs;
+    std::vector<double> prizes;
+    for (size_t ii = 0; ii < nodes.size(); ++ii) {
+      for (size_t jj = 0; jj < incident[nodes[ii]].size(); ++jj) {
+        int edge = incident[nodes[ii]][jj];
+        if (edge_read[edge]) {
+          continue;
+        }
+        edge_read[edge] = true;
+        int ends[2] = {graph.sources[edge], graph.targets[edge]};
+        for (int kk = 0; kk < 2; ++kk) {
+          if (frontier_node[ends[kk]] < 0) {
+            frontier_node[ends[kk]] = static_cast<int>(graph_node.size());
+            graph_node.push_back(ends[kk]);
+            prizes.push_back(graph.prizes[ends[kk]]);
+          }
+        }
+        sources.push_back(frontier_node[ends[0]]);
+        targets.push_back(frontier_node[ends[1]]);
+        costs.push_back(graph.costs[edge]);
+        graph_edge.push_back(edge);
+      }
+    }
+    if (frontier == NULL) {
+      int root = instance.root < 0 ? -1 : frontier_node[instance.root];
+      frontier = pcst_frontier_create(root, instance.num_clusters, 3, 0, NULL);
+    }
+    return frontier != NULL
+        && pcst_frontier_add_nodes(frontier, prizes.data(),
+                                   static_cast<int>(prizes.size()))
+        && pcst_frontier_add_edges(frontier, sources.data(), targets.data(),
+                                   costs.data(),
+                                   static_cast<int>(costs.size()));
+  };
+
+  std::vector<int> seeds;
+  for (int ii = 0; ii < num_graph_nodes; ++ii) {
+    if (graph.prizes[ii] > 0.0 || ii == instance.root) {
+      seeds.push_back(ii);
+    }
+  }
+  bool read = read_edges(seeds);
+  const int* nodes;
+  int num_expand;
+  while (read && (num_expand = pcst_frontier_continue(frontier, &nodes)) > 0) {
+    std::vector<int> expand;
+    for (int ii = 0; ii < num_expand; ++ii) {
+      expand.push_back(graph_node[nodes[ii]]);
+    }
+    read = read_edges(expand);
+  }
+  pcst_result_t* result = read ? pcst_frontier_result(frontier) : NULL;
+  pcst_frontier_free(frontier);
+  bool success = result != NULL && result->success;
+  if (success) {
+    for (int ii = 0; ii < result->num_nodes; ++ii) {
+      solution->nodes.push_back(graph_node[result->result_nodes[ii]]);
+    }
+    for (int ii = 0; ii < result->num_edges; ++ii) {
+      solution->edges.push_back(graph_edge[result->result_edges[ii]]);
+    }
+    finish_solution(instance, solution);
+  }
+  pcst_free_result(result);
+  return success;
+}
+
+bool solve_lazy_edges(const Instance& instance, Solution* solution) {
+  return solve_plan(instance, 0, 0, 0, 0, 1, solution);
+}
+
+// Edges written to a sorted edge file and read back by the solver as growth
+// reaches them
+bool solve_edge_file(const Instance& instance, Solution* solution) {
+  char path[] = "/tmp/pcst_equiv_XXXXXX";
+  int fd = mkstemp(path);
+  if (fd < 0) {
+    return false;
+  }
+  close(fd);
+  std::string error;
+  pcst_tools::SortedEdgeFile file;
+  bool ok = pcst_tools::write_sorted_edge_file(path, instance.graph, &error)
+            && file.open(path, &error);
+  unlink(path);
+  if (!ok) {
+    return false;
+  }
+  PCSTFast solver(&file, file.get_prizes(),
+                  instance.root < 0 ? PCSTFast::kNoRoot : instance.root,
+                  instance.num_clusters, PCSTFast::kStrongPruning, 0,
+                  ignore_output);
+  if (!solver.run(&solution->nodes, &solution->edges)) {
+    return false;
+  }
+  finish_solution(instance, solution);
+  return true;
+}
+
+// Approximate growth, with and without lazy edge insertion
+bool solve_buckets(const Instance& instance, bool lazy_edges,
+                   Solution* solution) {
+  std::vector<std::pair<int, int> > edges;
+  edge_vectors(instance, &edges);
+  PCSTFast solver(edges, instance.graph.prizes, instance.graph.costs,
+                  instance.root < 0 ? PCSTFast::kNoRoot : instance.root,
+                  instance.num_clusters, PCSTFast::kStrongPruning, 0,
+                  ignore_output);
+  solver.set_event_bucket_epsilon(0.1);
+  solver.set_lazy_edge_insertion(lazy_edges);
+  if (!solver.run(&solution->nodes, &solution->edges)) {
+    return false;
+  }
+  finish_solution(instance, solution);
+  return true;
+}
+
+bool solve_event_buckets(const Instance& instance, Solution* solution) {
+  return solve_buckets(instance, false, solution);
+}
+
+bool solve_event_buckets_lazy(const Instance& instance, Solution* solution) {
+  return solve_buckets(instance, true, solution);
+}
+
+bool solve_tree_dp(const Instance& instance, Solution* solution) {
+  return solve_plan(instance, 1, 0, 0, 0, 0, solution);
+}
+
+bool solve_peel_tails(const Instance& instance, Solution* solution) {
+  return solve_plan(instance, 0, 1, 0, 0, 0, solution);
+}
+
+bool solve_prize_balls(const Instance& instance, Solution* solution) {
+  return solve_plan(instance, 0, 0, 1, 0, 0, solution);
+}
+
+bool solve_distance_network(const Instance& instance, Solution* solution) {
+  return solve_plan(instance, 0, 0, 0, 1, 0, solution);
+}
+
+// The exact step after plain GW, so that instances too large for it keep
+// the reference's tree
+bool solve_exact(const Instance& instance, Solution* solution) {
+  pcst_plan_t plan;
+  memset(&plan, 0, sizeof(plan));
+  plan.pruning_method = 3;
+  plan.exact = 1;
+  return solve_wrapper(instance, 3, &plan, solution, kExactMaxNodes);
+}
+
+bool solve_auto(const Instance& instance, Solution* solution) {
+  return solve_wrapper(instance, PCST_PRUNING_AUTO, NULL, solution);
+}
+
+bool applies_always(const Instance&) {
+  return true;
+}
+
+// One connected tree spanning every node
+bool applies_tree(const Instance& instance) {
+  return wants_one_tree(instance)
+      && static_cast<int>(instance.graph.sources.size())
+         == num_nodes(instance) - 1
+      && num_nodes(instance) > 0;
+}
+
+bool applies_one_tree(const Instance& instance) {
+  return wants_one_tree(instance);
+}
+
+bool applies_unrooted_one_tree(const Instance& instance) {
+  return instance.root < 0 && instance.num_clusters <= 1;
+}
+
+// Nodes without edges are never read, so none may have a prize. With fewer
+// prize nodes than trees wanted, growth stops at once and any zero-prize
+// nodes make up the rest, which differ with the nodes read.
+bool applies_frontier(const Instance& instance) {
+  std::vector<bool> has_edge(num_nodes(instance), false);
+  for (size_t ii = 0; ii < instance.graph.sources.size(); ++ii) {
+    has_edge[instance.graph.sources[ii]] = true;
+    has_edge[instance.graph.targets[ii]] = true;
+  }
+  int num_prized = 0;
+  for (int ii = 0; ii < num_nodes(instance); ++ii) {
+    bool seed = instance.graph.prizes[ii] > 0.0 || ii == instance.root;
+    if (seed && !has_edge[ii]) {
+      return false;
+    }
+    num_prized += instance.graph.prizes[ii] > 0.0;
+  }
+  return instance.root >= 0 || num_prized >= instance.num_clusters;
+}
+
+const Variant kVariants[] = {
+  {"stepped", kIdentical, kIdentical, applies_always, solve_stepped},
+  {"reset", kIdentical, kIdentical, applies_always, solve_reset},
+  {"builder", kIdentical, kIdentical, applies_always, solve_builder},
+  {"lazy_edges", kIdentical, kValid, applies_always, solve_lazy_edges},
+  {"edge_file", kIdentical, kValid, applies_always, solve_edge_file},
+  {"frontier", kIdentical, kValid, applies_frontier, solve_frontier},
+  {"event_buckets", kValid, kValid, applies_always, solve_event_buckets},
+  {"event_buckets_lazy", kValid, kValid, applies_always,
+   solve_event_buckets_lazy},
+  {"tree_dp", kNotWorse, kNotWorse, applies_tree, solve_tree_dp},
+  {"prize_balls", kSameObjective, kSameObjective, applies_unrooted_one_tree,
+   solve_prize_balls},
+  {"peel_tails", kValid, kValid, applies_one_tree, solve_peel_tails},
+  {"distance_network", kValid, kValid, applies_one_tree,
+   solve_distance_network},
+  {"exact", kOptimal, kOptimal, applies_one_tree, solve_exact},
+  {"auto", kValid, kValid, applies_always, solve_auto},
+};
+const int kNumVariants = sizeof(kVariants) / sizeof(kVariants[0]);
+
+////////////////////////////////////////////////////////////////////////////
+// Checks
+
+int find_component(std::vector<int>& parent, int node) {
+  while (parent[node] != node) {
+    parent[node] = parent[parent[node]];
+    node = parent[node];
+  }
+  return node;
+}
+
+// Empty when the solution is a forest of the instance with the root and
+// number of trees asked for, otherwise what is wrong
+std::string validate(const Instance& instance, const Solution& solution) {
+  int n = num_nodes(instance);
+  int m = static_cast<int>(instance.graph.sources.size());
+  std::vector<bool> in_solution(n, false);
+  for (size_t ii = 0; ii < solution.nodes.size(); ++ii) {
+    int node = solution.nodes[ii];
+    if (node < 0 || node >= n) {
+      return "node index out of range";
+    }
+    if (in_solution[node]) {
+      return "node listed twice";
+    }
+    in_solution[node] = true;
+  }
+  std::vector<int> parent(n);
+  for (int ii = 0; ii < n; ++ii) {
+    parent[ii] = ii;
+  }
+  int num_trees = static_cast<int>(solution.nodes.size());
+  for (size_t ii = 0; ii < solution.edges.size(); ++ii) {
+    int edge = solution.edges[ii];
+    if (edge < 0 || edge >= m) {
+      return "edge index out of range";
+    }
+    if (ii > 0 && solution.edges[ii - 1] == edge) {
+      return "edge listed twice";
+    }
+    int uu = instance.graph.sources[edge];
+    int vv = instance.graph.targets[edge];
+    if (!in_solution[uu] || !in_solution[vv]) {
+      return "edge endpoint missing from the nodes";
+    }
+    uu = find_component(parent, uu);
+    vv = find_component(parent, vv);
+    if (uu == vv) {
+      return "edges contain a cycle";
+    }
+    parent[uu] = vv;
+    num_trees -= 1;
+  }
+  if (instance.root >= 0 && !in_solution[instance.root]) {
+    return "root missing";
+  }
+  if (wants_one_tree(instance) && num_trees > 1) {
+    return std::to_string(num_trees) + " trees instead of one";
+  }
+  return "";
+}
+
+// Objective of the best tree (containing the root, if any), trying every
+// node set: its spanning tree, if connected, is a minimum spanning tree
+double brute_force_objective(const Instance& instance) {
+  int n = num_nodes(instance);
+  int m = static_cast<int>(instance.graph.sources.size());
+  std::vector<int> order(m);
+  for (int ii = 0; ii < m; ++ii) {
+    order[ii] = ii;
+  }
+  std::sort(order.begin(), order.end(), [&instance](int aa, int bb) {
+    return instance.graph.costs[aa] < instance.graph.costs[bb];
+  });
+  double best = -std::numeric_limits<double>::infinity();
+  std::vector<int> parent(n);
+  for (int mask = 1; mask < (1 << n); ++mask) {
+    if (instance.root >= 0 && !(mask & (1 << instance.root))) {
+      continue;
+    }
+    double value = 0.0;
+    int num_trees = 0;
+    for (int ii = 0; ii < n; ++ii) {
+      parent[ii] = ii;
+      if (mask & (1 << ii)) {
+        value += instance.graph.prizes[ii];
+        num_trees += 1;
+      }
+    }
+    for (int ii = 0; ii < m && num_trees > 1; ++ii) {
+      int uu = instance.graph.sources[order[ii]];
+      int vv = instance.graph.targets[order[ii]];
+      if (!(mask & (1 << uu)) || !(mask & (1 << vv))) {
+        continue;
+      }
+      uu = find_component(parent, uu);
+      vv = find_component(parent, vv);
+      if (uu != vv) {
+        parent[uu] = vv;
+        value -= instance.graph.costs[order[ii]];
+        num_trees -= 1;
+      }
+    }
+    if (num_trees == 1) {
+      best = std::max(best, value);
+    }
+  }
+  return best;
+}
+
+// Empty when the variant's result passes its check against the reference
+std::string compare(const Instance& instance, Check check,
+                    const Solution& reference, const Solution& result) {
+  std::string invalid = validate(instance, result);
+  if (!invalid.empty()) {
+    return invalid;
+  }
+  double tolerance = kObjectiveTolerance
+                     * std::max(1.0, std::fabs(reference.objective));
+  char message[128];
+  switch (check) {
+    case kIdentical:
+      if (result.nodes != reference.nodes || result.edges != reference.edges) {
+        snprintf(message, sizeof(message),
+                 "different tree (%zu nodes, %zu edges vs %zu, %zu)",
+                 result.nodes.size(), result.edges.size(),
+                 reference.nodes.size(), reference.edges.size());
+        return message;
+      }
+      break;
+    case kSameObjective:
+      if (std::fabs(result.objective - reference.objective) > tolerance) {
+        snprintf(message, sizeof(message), "objective %.10g vs %.10g",
+                 result.objective, reference.objective);
+        return message;
+      }
+      break;
+    case kOptimal:
+      if (num_nodes(instance) <= kMaxBruteForceNodes) {
+        double best = brute_force_objective(instance);
+        if (std::fabs(result.objective - best) > tolerance) {
+          snprintf(message, sizeof(message), "objective %.10g, best %.10g",
+                   result.objective, best);
+          return message;
+        }
+        break;
+      }
+      // fall through
+    case kNotWorse:
+      if (result.objective < reference.objective - tolerance) {
+        snprintf(message, sizeof(message), "objective %.10g below %.10g",
+                 result.objective, reference.objective);
+        return message;
+      }
+      break;
+    case kValid:
+      break;
+  }
+  return "";
+}
+
+bool has_repeats(std::vector<double> values) {
+  std::sort(values.begin(), values.end());
+  return std::adjacent_find(values.begin(), values.end()) != values.end();
+}
+
+// Events are likely to happen at the same time
+bool has_ties(const Instance& instance) {
+  const std::vector<double>& costs = instance.graph.costs;
+  bool integral = true;
+  for (size_t ii = 0; ii < costs.size() && integral; ++ii) {
+    integral = costs[ii] == std::floor(costs[ii]);
+  }
+  std::vector<double> prizes;
+  for (size_t ii = 0; ii < instance.graph.prizes.size(); ++ii) {
+    if (instance.graph.prizes[ii] > 0.0) {
+      prizes.push_back(instance.graph.prizes[ii]);
+    }
+  }
+  return (integral && !costs.empty()) || has_repeats(costs)
+         || has_repeats(prizes);
+}
+
+Check check_for(const Instance& instance, const Variant& variant) {
+  return has_ties(instance) ? variant.check_with_ties : variant.check;
+}
+
+// Empty when the variant agrees with the reference on the instance. An
+// instance the reference cannot solve (say, the root lost its edges while
+// minimizing) counts as passing.
+std::string run_variant(const Instance& instance, const Variant& variant) {
+  Solution reference;
+  if (!solve_reference(instance, &reference)) {
+    return "";
+  }
+  Solution result;
+  if (!variant.solve(instance, &result)) {
+    return "solve failed";
+  }
+  return compare(instance, check_for(instance, variant), reference, result);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Minimizing
+
+// Drop nodes without edges (other than the root, and with keep_prized other
+// than those with a prize) and renumber the rest
+Instance compact(const Instance& instance, bool keep_prized) {
+  int n = num_nodes(instance);
+  std::vector<bool> used(n, false);
+  for (size_t ii = 0; ii < instance.graph.sources.size(); ++ii) {
+    used[instance.graph.sources[ii]] = true;
+    used[instance.graph.targets[ii]] = true;
+  }
+  if (instance.root >= 0) {
+    used[instance.root] = true;
+  }
+  for (int ii = 0; ii < n; ++ii) {
+    if (keep_prized && instance.graph.prizes[ii] != 0.0) {
+      used[ii] = true;
+    }
+  }
+  Instance compacted = instance;
+  compacted.graph.prizes.clear();
+  std::vector<int> index(n, -1);
+  for (int ii = 0; ii < n; ++ii) {
+    if (used[ii]) {
+      index[ii] = static_cast<int>(compacted.graph.prizes.size());
+      compacted.graph.prizes.push_back(instance.graph.prizes[ii]);
+    }
+  }
+  for (size_t ii = 0; ii < instance.graph.sources.size(); ++ii) {
+    compacted.graph.sources[ii] = index[instance.graph.sources[ii]];
+    compacted.graph.targets[ii] = index[instance.graph.targets[ii]];
+  }
+  if (instance.root >= 0) {
+    compacted.root = index[instance.root];
+  }
+  return compacted;
+}
+
+Instance without_edges(const Instance& instance, size_t begin, size_t end) {
+  Instance reduced = instance;
+  Graph& graph = reduced.graph;
+  graph.sources.erase(graph.sources.begin() + begin,
+                      graph.sources.begin() + end);
+  graph.targets.erase(graph.targets.begin() + begin,
+                      graph.targets.begin() + end);
+  graph.costs.erase(graph.costs.begin() + begin, graph.costs.begin() + end);
+  return reduced;
+}
+
+// Greedy shrinking: drop runs of edges, halving the run length, then single
+// prizes, until nothing more can go without the failure disappearing
+Instance minimize(const Instance& instance, const Variant& variant) {
+  Instance current = instance;
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (size_t chunk = std::max<size_t>(1, current.graph.sources.size() / 2);
+         chunk >= 1; chunk /= 2) {
+      size_t begin = 0;
+      while (begin < current.graph.sources.size()) {
+        size_t end = std::min(begin + chunk, current.graph.sources.size());
+        Instance candidate = without_edges(current, begin, end);
+        if (!run_variant(candidate, variant).empty()) {
+          current = candidate;
+          changed = true;
+        } else {
+          begin = end;
+        }
+      }
+      if (chunk == 1) {
+        break;
+      }
+    }
+    for (int ii = 0; ii < num_nodes(current); ++ii) {
+      if (current.graph.prizes[ii] == 0.0) {
+        continue;
+      }
+      Instance candidate = current;
+      candidate.graph.prizes[ii] = 0.0;
+      if (!run_variant(candidate, variant).empty()) {
+        current = candidate;
+        changed = true;
+      }
+    }
+    for (int keep_prized = 0; keep_prized <= 1; ++keep_prized) {
+      Instance candidate = compact(current, keep_prized);
+      if (num_nodes(candidate) < num_nodes(current)
+          && !run_variant(candidate, variant).empty()) {
+        current = candidate;
+        changed = true;
+        break;
+      }
+    }
+  }
+  return current;
+}
+
+bool write_instance(const std::string& path, const Instance& instance,
+                    const Variant& variant, const std::string& failure) {
+  FILE* file = fopen(path.c_str(), "w");
+  if (file == NULL) {
+    return false;
+  }
+  fprintf(file, "# %s (%s): %s\n", variant.name,
+          check_name(check_for(instance, variant)),
+          failure.c_str());
+  fprintf(file, "# minimized from %s; root %d, clusters %d\n",
+          instance.origin.c_str(), instance.root, instance.num_clusters);
+  fprintf(file, "%d %zu\n", num_nodes(instance),
+          instance.graph.sources.size());
+  for (int ii = 0; ii < num_nodes(instance); ++ii) {
+    fprintf(file, "%s%.17g", ii > 0 ? " " : "", instance.graph.prizes[ii]);
+  }
+  fprintf(file, "\n");
+  for (size_t ii = 0; ii < instance.graph.sources.size(); ++ii) {
+    fprintf(file, "%d %d %.17g\n", instance.graph.sources[ii],
+            instance.graph.targets[ii], instance.graph.costs[ii]);
+  }
+  return fclose(file) == 0;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Reuse cost
+
+// Time a strong-pruning solve on a random graph of num_nodes nodes and four
+// times as many edges, then the same solve again after reset(). Empty when
+// the second run gives the same tree and takes at most twice as long.
+std::string check_reuse_cost(int num_nodes, unsigned int seed,
+                             double* first_seconds, double* reset_seconds) {
+  std::mt19937 rng(seed);
+  Instance instance;
+  std::uniform_real_distribution<double> unit(0.0, 1.0);
+  instance.graph.prizes.assign(num_nodes, 0.0);
+  for (int ii = 0; ii < num_nodes; ++ii) {
+    if (unit(rng) < 0.2) {
+      instance.graph.prizes[ii] = 50.0 * unit(rng);
+    }
+  }
+  add_random_edges(0, num_nodes, 3 * num_nodes, false, &rng,
+                   &instance.graph);
+  std::vector<std::pair<int, int> > edges;
+  edge_vectors(instance, &edges);
+
+  PCSTFast solver(edges, instance.graph.prizes, instance.graph.costs,
+                  PCSTFast::kNoRoot, 1, PCSTFast::kStrongPruning, 0,
+                  ignore_output);
+  Solution first;
+  Solution again;
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  if (!solver.run(&first.nodes, &first.edges)) {
+    return "first run failed";
+  }
+  std::chrono::steady_clock::time_point middle =
+      std::chrono::steady_clock::now();
+  solver.reset(PCSTFast::kNoRoot, 1, PCSTFast::kStrongPruning);
+  if (!solver.run(&again.nodes, &again.edges)) {
+    return "run after reset() failed";
+  }
+  std::chrono::steady_clock::time_point end =
+      std::chrono::steady_clock::now();
+  *first_seconds = std::chrono::duration<double>(middle - start).count();
+  *reset_seconds = std::chrono::duration<double>(end - middle).count();
+
+  finish_solution(instance, &first);
+  finish_solution(instance, &again);
+  if (first.nodes != again.nodes || first.edges != again.edges) {
+    return "run after reset() gave another tree";
+  }
+  // Some slack for timer noise on short runs
+  if (*reset_seconds > 2.0 * *first_seconds + 0.05) {
+    return "run after reset() is more than twice as slow";
+  }
+  return "";
+}
+
+}  // namespace
+
+
+int main(int argc, char** argv) {
+  Options options;
+  if (!parse_options(argc, argv, &options)) {
+    usage(argv[0]);
+    return 2;
+  }
+
+  std::vector<Instance> instances;
+  std::mt19937 rng(options.seed);
+  for (int ii = 0; ii < options.num_instances; ++ii) {
+    Instance instance;
+    generate_instance(ii, &rng, &instance);
+    instances.push_back(instance);
+  }
+  for (size_t ii = 0; ii < options.graph_files.size(); ++ii) {
+    Instance instance;
+    std::string error;
+    if (!pcst_tools::read_graph_file(options.graph_files[ii], &instance.graph,
+                                     &error)) {
+      fprintf(stderr, "%s\n", error.c_str());
+      return 2;
+    }
+    instance.origin = options.graph_files[ii];
+    instances.push_back(instance);
+    if (!instance.graph.prizes.empty() && !instance.graph.sources.empty()) {
+      // Rooted at the largest prize that has an edge
+      std::vector<bool> has_edge(instance.graph.prizes.size(), false);
+      for (size_t jj = 0; jj < instance.graph.sources.size(); ++jj) {
+        has_edge[instance.graph.sources[jj]] = true;
+        has_edge[instance.graph.targets[jj]] = true;
+      }
+      int root = -1;
+      for (int jj = 0; jj < num_nodes(instance); ++jj) {
+        if (has_edge[jj] && (root < 0
+            || instance.graph.prizes[jj] > instance.graph.prizes[root])) {
+          root = jj;
+        }
+      }
+      instance.root = root;
+      instance.num_clusters = 0;
+      instance.origin += " (rooted)";
+      instances.push_back(instance);
+    }
+  }
+
+  std::vector<int> num_run(kNumVariants, 0);
+  std::vector<int> num_failed(kNumVariants, 0);
+  int num_minimized = 0;
+  for (size_t ii = 0; ii < instances.size(); ++ii) {
+    const Instance& instance = instances[ii];
+    for (int vv = 0; vv < kNumVariants; ++vv) {
+      const Variant& variant = kVariants[vv];
+      if (!variant.applies(instance)) {
+        continue;
+      }
+      num_run[vv] += 1;
+      std::string failure = run_variant(instance, variant);
+      if (failure.empty()) {
+        continue;
+      }
+      num_failed[vv] += 1;
+      if (options.verbose || num_minimized < options.max_minimized) {
+        printf("FAIL %s on %s: %s\n", variant.name, instance.origin.c_str(),
+               failure.c_str());
+      }
+      if (num_minimized < options.max_minimized) {
+        Instance minimized = minimize(instance, variant);
+        std::string path = options.out_dir + "/equiv_" + variant.name + "_"
+                           + std::to_string(num_minimized) + ".txt";
+        if (write_instance(path, minimized, variant,
+                           run_variant(minimized, variant))) {
+          printf("  minimized to %d nodes, %zu edges: %s\n",
+                 num_nodes(minimized), minimized.graph.sources.size(),
+                 path.c_str());
+        } else {
+          printf("  could not write %s\n", path.c_str());
+        }
+        num_minimized += 1;
+      }
+    }
+  }
+
+  std::string reuse_failure;
+  if (options.reuse_nodes > 0) {
+    double first_seconds = 0.0;
+    double reset_seconds = 0.0;
+    reuse_failure = check_reuse_cost(options.reuse_nodes, options.seed,
+                                     &first_seconds, &reset_seconds);
+    printf("reuse on %d nodes: first run %.3f s, after reset() %.3f s\n",
+           options.reuse_nodes, first_seconds, reset_seconds);
+    if (!reuse_failure.empty()) {
+      printf("FAIL reuse: %s\n", reuse_failure.c_str());
+    }
+  }
+
+  printf("\n%-18s %-16s %10s %10s\n", "variant", "check", "instances",
+         "failures");
+  int total_failed = 0;
+  for (int vv = 0; vv < kNumVariants; ++vv) {
+    std::string check = check_name(kVariants[vv].check);
+    if (kVariants[vv].check_with_ties != kVariants[vv].check) {
+      check = check + "/" + check_name(kVariants[vv].check_with_ties);
+    }
+    printf("%-18s %-16s %10d %10d\n", kVariants[vv].name, check.c_str(),
+           num_run[vv], num_failed[vv]);
+    total_failed += num_failed[vv];
+  }
+  return total_failed > 0 || !reuse_failure.empty() ? 1 : 0;
+}
@@ -0,0 +1,872 @@
+// pcstd: PCST solver daemon for latency-sensitive callers.
+//
+// Keeps named graphs resident and answers solve requests over a Unix domain
+// socket, so repeated solves on the same graphs skip both PostgreSQL and
+// graph loading. Requests run on a fixed pool of worker threads; every
+// worker keeps one PCSTFast instance per graph and reuses its buffers
+// through PCSTFast::reset().
+//
+//   pcstd --socket /tmp/pcstd.sock --threads 4 --graph city=city.txt
+//         --graph depots=edges.csv,nodes.csv
+//
+// Graph files are in one of the formats described in graph_file.h. Nodes and
+// edges are addressed by their 0-based index (row order for CSV files).
+//
+// Protocol. Every message is a frame: a uint32 payload length followed by the
+// payload. All integers and doubles are in native byte order; the socket is
+// local. A connection may send any number of requests, one at a time.
+//
+//   request payload:  uint8 opcode, then
+//     PING   (0)      nothing
+//     SOLVE  (1)      uint16 name_length, name bytes,
+//                     int32 root (-1 for unrooted), int32 num_clusters,
+//                     uint8 pruning (0 none, 1 simple, 2 gw, 3 strong),
+//                     uint32 num_prizes, num_prizes x (int32 node, double prize)
+//                     -- prize overrides for this request only
+//     STATS  (2)      nothing
+//     REPAIR (3)      uint16 name_length, name bytes,
+//                     int32 root (-1 for unrooted),
+//                     uint32 num_tree_edges, num_tree_edges x int32 edge,
+//                     uint32 num_failed, num_failed x int32 edge
+//                     -- a previous result and the edges that failed since
+//
+//   response payload: uint8 status (0 ok, 1 error), then
+//     error           message bytes
+//     PING            nothing
+//     SOLVE           double objective, uint32 num_nodes, uint32 num_edges,
+//                     num_nodes x int32 node, num_edges x int32 edge
+//     STATS           text: request counters and latency histograms
+//     REPAIR          as SOLVE: the result reconnected around the failed
+//                     edges (see TreeRepair), with the graph's prizes
+
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "graph_file.h"
+#include "pcst_fast.h"
+#include "pcst_repair.h"
+
+using cluster_approx::PCSTFast;
+using cluster_approx::TreeRepair;
+
+namespace {
+
+enum Opcode {
+  kOpPing = 0,
+  kOpSolve = 1,
+  kOpStats = 2,
+  kOpRepair = 3,
+};
+
+enum Status {
+  kStatusOk = 0,
+  kStatusError = 1,
+};
+
+const uint32_t kMaxFrameBytes = 64u << 20;
+const int kReceiveTimeoutSeconds = 5;
+// Growth events per PCSTFast::step() call; shutdown is checked in between so
+// a long solve does not hold up SIGTERM.
+const long long kSolveSliceEvents = 65536;
+
+typedef std::chrono::steady_clock Clock;
+
+struct ResidentGraph {
+  std::string name;
+  std::vector<std::pair<int, int> > edges;
+  std::vector<double> costs;
+  std::vector<double> prizes;
+};
+
+// Latencies in power-of-two microsecond buckets: bucket b holds requests that
+// took less than 2^b us (and at least 2^(b-1) us).
+class LatencyHistogram {
+ public:
+  static const int kNumBuckets = 32;
+
+  LatencyHistogram() : count(0), total_us(0) {
+    for (int ii = 0; ii < kNumBuckets; ++ii) {
+      buckets[ii] = 0;
+    }
+  }
+
+  void record(Clock::duration elapsed) {
+    long long us = std::chrono::duration_cast<std::chrono::microseconds>(
+        elapsed).count();
+    int bucket = 0;
+    while (bucket + 1 < kNumBuckets && (1LL << bucket) <= us) {
+      ++bucket;
+    }
+    buckets[bucket]++;
+    count++;
+    total_us += us;
+  }
+
+  void print(const char* name, std::ostringstream* out) const {
+    unsigned long long n = count;
+    *out << "latency." << name << ".count " << n << "\n";
+    if (n == 0) {
+      return;
+    }
+    *out << "latency." << name << ".mean_us " << total_us / n << "\n";
+    *out << "latency." << name << ".p50_us " << quantile_bound(n, 0.50)
+         << "\n";
+    *out << "latency." << name << ".p99_us " << quantile_bound(n, 0.99)
+         << "\n";
+    for (int ii = 0; ii < kNumBuckets; ++ii) {
+      if (buckets[ii] > 0) {
+        *out << "latency." << name << ".lt_" << (1LL << ii) << "us "
+             << buckets[ii] << "\n";
+      }
+    }
+  }
+
+ private:
+  std::atomic<unsigned long long> buckets[kNumBuckets];
+  std::atomic<unsigned long long> count;
+  std::atomic<unsigned long long> total_us;
+
+  // Upper bound of the bucket that contains the given quantile.
+  long long quantile_bound(unsigned long long n, double quantile) const {
+    unsigned long long seen = 0;
+    for (int ii = 0; ii < kNumBuckets; ++ii) {
+      seen += buckets[ii];
+      if (seen >= quantile * n) {
+        return 1LL << ii;
+      }
+    }
+    return 1LL << (kNumBuckets - 1);
+  }
+};
+
+// Little helpers to pack and unpack frame payloads.
+class Reader {
+ public:
+  Reader(const std::vector<char>& data) : data_(data), pos_(0) {}
+
+  template <typename T>
+  bool read(T* value) {
+    if (data_.size() - pos_ < sizeof(T)) {
+      return false;
+    }
+    memcpy(value, &data_[pos_], sizeof(T));
+    pos_ += sizeof(T);
+    return true;
+  }
+
+  bool read_string(size_t length, std::string* value) {
+    if (data_.size() - pos_ < length) {
+      return false;
+    }
+    value->assign(&data_[pos_], length);
+    pos_ += length;
+    return true;
+  }
+
+ private:
+  const std::vector<char>& data_;
+  size_t pos_;
+};
+
+class Writer {
+ public:
+  explicit Writer(std::vector<char>* data) : data_(data) {}
+
+  template <typename T>
+  void write(const T& value) {
+    const char* bytes = reinterpret_cast<const char*>(&value);
+    data_->insert(data_->end(), bytes, bytes + sizeof(T));
+  }
+
+  void write_bytes(const std::string& value) {
+    data_->insert(data_->end(), value.begin(), value.end());
+  }
+
+ private:
+  std::vector<char>* data_;
+};
+
+struct SolveRequest {
+  std::string graph_name;
+  int32_t root;
+  int32_t num_clusters;
+  uint8_t pruning;
+  std::vector<std::pair<int32_t, double> > prizes;
+};
+
+bool parse_solve_request(Reader* reader, SolveRequest* request) {
+  uint16_t name_length;
+  uint32_t num_prizes;
+  if (!reader->read(&name_length)
+      || !reader->read_string(name_length, &request->graph_name)
+      || !reader->read(&request->root)
+      || !reader->read(&request->num_clusters)
+      || !reader->read(&request->pruning)
+      || !reader->read(&num_prizes)) {
+    return false;
+  }
+  for (uint32_t ii = 0; ii < num_prizes; ++ii) {
+    std::pair<int32_t, double> prize;
+    if (!reader->read(&prize.first) || !reader->read(&prize.second)) {
+      return false;
+    }
+    request->prizes.push_back(prize);
+  }
+  return true;
+}
+
+struct RepairRequest {
+  std::string graph_name;
+  int32_t root;
+  std::vector<int32_t> tree_edges;
+  std::vector<int32_t> failed_edges;
+};
+
+bool read_edge_list(Reader* reader, std::vector<int32_t>* edges) {
+  uint32_t num_edges;
+  if (!reader->read(&num_edges)) {
+    return false;
+  }
+  for (uint32_t ii = 0; ii < num_edges; ++ii) {
+    int32_t edge;
+    if (!reader->read(&edge)) {
+      return false;
+    }
+    edges->push_back(edge);
+  }
+  return true;
+}
+
+bool parse_repair_request(Reader* reader, RepairRequest* request) {
+  uint16_t name_length;
+  return reader->read(&name_length)
+         && reader->read_string(name_length, &request->graph_name)
+         && reader->read(&request->root)
+         && read_edge_list(reader, &request->tree_edges)
+         && read_edge_list(reader, &request->failed_edges);
+}
+
+void ignore_output(const char*) {}
+
+// Per-thread solver state for one resident graph.
+struct WorkerGraphState {
+  std::vector<double> prizes;   // graph prizes with this request's overrides
+  std::unique_ptr<PCSTFast> solver;
+  std::unique_ptr<TreeRepair> repair;   // built on the first repair
+};
+
+void solution_response(double objective, const std::vector<int>& nodes,
+                       const std::vector<int>& edges,
+                       std::vector<char>* response) {
+  response->clear();
+  response->reserve(1 + sizeof(double) + 2 * sizeof(uint32_t)
+                    + (nodes.size() + edges.size()) * sizeof(int32_t));
+  Writer writer(response);
+  writer.write(static_cast<uint8_t>(kStatusOk));
+  writer.write(objective);
+  writer.write(static_cast<uint32_t>(nodes.size()));
+  writer.write(static_cast<uint32_t>(edges.size()));
+  for (size_t ii = 0; ii < nodes.size(); ++ii) {
+    writer.write(static_cast<int32_t>(nodes[ii]));
+  }
+  for (size_t ii = 0; ii < edges.size(); ++ii) {
+    writer.write(static_cast<int32_t>(edges[ii]));
+  }
+}
+
+class Server {
+ public:
+  Server(std::vector<ResidentGraph>* graphs, int num_threads)
+      : graphs_(graphs), num_threads_(num_threads), stop_(false),
+        num_requests_(0), num_errors_(0), listen_fd_(-1) {
+    wake_pipe_[0] = wake_pipe_[1] = -1;
+  }
+
+  bool listen_on(const std::string& path, std::string* error);
+
+  // Serve until stop() is called (from a signal handler).
+  void serve();
+
+  // Async-signal-safe.
+  void stop() {
+    stop_ = true;
+    wake();
+  }
+
+ private:
+  struct Job {
+    int fd;
+    Clock::time_point ready_time;
+  };
+
+  std::vector<ResidentGraph>* graphs_;
+  int num_threads_;
+  std::atomic<bool> stop_;
+  std::atomic<unsigned long long> num_requests_;
+  std::atomic<unsigned long long> num_errors_;
+  LatencyHistogram request_latency_;
+  LatencyHistogram solve_latency_;
+  LatencyHistogram repair_latency_;
+
+  int listen_fd_;
+  int wake_pipe_[2];
+  std::string socket_path_;
+
+  std::mutex mutex_;
+  std::condition_variable jobs_ready_;
+  std::deque<Job> jobs_;              // connections with a pending request
+  std::vector<int> returned_fds_;     // connections handed back by workers
+
+  void wake() {
+    char byte = 0;
+    ssize_t ignored = write(wake_pipe_[1], &byte, 1);
+    (void) ignored;
+  }
+
+  void worker_loop();
+  bool handle_request(int fd, std::map<const ResidentGraph*,
+                                       WorkerGraphState>* states);
+  void solve(const SolveRequest& request,
+             std::map<const ResidentGraph*, WorkerGraphState>* states,
+             std::vector<char>* response);
+  void repair(const RepairRequest& request,
+              std::map<const ResidentGraph*, WorkerGraphState>* states,
+              std::vector<char>* response);
+  void stats(std::vector<char>* response);
+  const ResidentGraph* find_graph(const std::string& name);
+};
+
+bool read_full(int fd, void* buffer, size_t length) {
+  char* pos = static_cast<char*>(buffer);
+  while (length > 0) {
+    ssize_t n = read(fd, pos, length);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return false;
+    }
+    pos += n;
+    length -= n;
+  }
+  return true;
+}
+
+bool write_full(int fd, const void* buffer, size_t length) {
+  const char* pos = static_cast<const char*>(buffer);
+  while (length > 0) {
+    ssize_t n = send(fd, pos, length, MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return false;
+    }
+    pos += n;
+    length -= n;
+  }
+  return true;
+}
+
+void error_response(const std::string& message, std::vector<char>* response) {
+  response->clear();
+  Writer writer(response);
+  writer.write(static_cast<uint8_t>(kStatusError));
+  writer.write_bytes(message);
+}
+
+bool Server::listen_on(const std::string& path, std::string* error) {
+  struct sockaddr_un address;
+  if (path.size() >= sizeof(address.sun_path)) {
+    *error = "socket path too long";
+    return false;
+  }
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+  listen_fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (listen_fd_ < 0 || pipe(wake_pipe_) != 0) {
+    *error = strerror(errno);
+    return false;
+  }
+  unlink(path.c_str());
+  if (bind(listen_fd_, reinterpret_cast<struct sockaddr*>(&address),
+           sizeof(address)) != 0
+      || listen(listen_fd_, 128) != 0) {
+    *error = "cannot listen on " + path + ": " + strerror(errno);
+    return false;
+  }
+  socket_path_ = path;
+  return true;
+}
+
+void Server::serve() {
+  std::vector<std::thread> workers;
+  for (int ii = 0; ii < num_threads_; ++ii) {
+    workers.push_back(std::thread(&Server::worker_loop, this));
+  }
+
+  // Idle connections are polled here; a connection with a pending request
+  // belongs to a worker until it is handed back through returned_fds_.
+  std::vector<int> idle_fds;
+  std::vector<struct pollfd> poll_fds;
+  while (!stop_) {
+    poll_fds.clear();
+    struct pollfd entry;
+    entry.events = POLLIN;
+    entry.fd = listen_fd_;
+    poll_fds.push_back(entry);
+    entry.fd = wake_pipe_[0];
+    poll_fds.push_back(entry);
+    for (size_t ii = 0; ii < idle_fds.size(); ++ii) {
+      entry.fd = idle_fds[ii];
+      poll_fds.push_back(entry);
+    }
+
+    if (poll(poll_fds.data(), poll_fds.size(), -1) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      perror("poll");
+      break;
+    }
+    Clock::time_point now = Clock::now();
+
+    if (poll_fds[1].revents & POLLIN) {
+      char drain[64];
+      ssize_t ignored = read(wake_pipe_[0], drain, sizeof(drain));
+      (void) ignored;
+    }
+
+    std::vector<int> still_idle;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      for (size_t ii = 2; ii < poll_fds.size(); ++ii) {
+        if (poll_fds[ii].revents & (POLLIN | POLLHUP | POLLERR)) {
+          Job job;
+          job.fd = poll_fds[ii].fd;
+          job.ready_time = now;
+          jobs_.push_back(job);
+          jobs_ready_.notify_one();
+        } else {
+          still_idle.push_back(poll_fds[ii].fd);
+        }
+      }
+      still_idle.insert(still_idle.end(), returned_fds_.begin(),
+                        returned_fds_.end());
+      returned_fds_.clear();
+    }
+    idle_fds.swap(still_idle);
+
+    if (poll_fds[0].revents & POLLIN) {
+      int fd = accept4(listen_fd_, NULL, NULL, SOCK_CLOEXEC);
+      if (fd >= 0) {
+        struct timeval timeout;
+        timeout.tv_sec = kReceiveTimeoutSeconds;
+        timeout.tv_usec = 0;
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        idle_fds.push_back(fd);
+      }
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+    jobs_ready_.notify_all();
+  }
+  for (size_t ii = 0; ii < workers.size(); ++ii) {
+    workers[ii].join();
+  }
+  for (size_t ii = 0; ii < idle_fds.size(); ++ii) {
+    close(idle_fds[ii]);
+  }
+  for (size_t ii = 0; ii < returned_fds_.size(); ++ii) {
+    close(returned_fds_[ii]);
+  }
+  for (size_t ii = 0; ii < jobs_.size(); ++ii) {
+    close(jobs_[ii].fd);
+  }
+  close(listen_fd_);
+  unlink(socket_path_.c_str());
+}
+
+void Server::worker_loop() {
+  std::map<const ResidentGraph*, WorkerGraphState> states;
+  while (true) {
+    Job job;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      while (!stop_ && jobs_.empty()) {
+        jobs_ready_.wait(lock);
+      }
+      if (stop_) {
+        return;
+      }
+      job = jobs_.front();
+      jobs_.pop_front();
+    }
+
+    if (!handle_request(job.fd, &states)) {
+      close(job.fd);
+      continue;
+    }
+    request_latency_.record(Clock::now() - job.ready_time);
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      returned_fds_.push_back(job.fd);
+    }
+    wake();
+  }
+}
+
+// Reads one request from fd and writes the response. Returns false when the
+// connection should be closed.
+bool Server::handle_request(
+    int fd, std::map<const ResidentGraph*, WorkerGraphState>* states) {
+  uint32_t length;
+  if (!read_full(fd, &length, sizeof(length)) || length == 0
+      || length > kMaxFrameBytes) {
+    return false;
+  }
+  std::vector<char> payload(length);
+  if (!read_full(fd, payload.data(), length)) {
+    return false;
+  }
+  num_requests_++;
+
+  Reader reader(payload);
+  uint8_t opcode = 0;
+  reader.read(&opcode);
+  std::vector<char> response;
+  if (opcode == kOpPing) {
+    Writer(&response).write(static_cast<uint8_t>(kStatusOk));
+  } else if (opcode == kOpSolve) {
+    SolveRequest request;
+    if (parse_solve_request(&reader, &request)) {
+      solve(request, states, &response);
+    } else {
+      error_response("malformed solve request", &response);
+    }
+  } else if (opcode == kOpStats) {
+    stats(&response);
+  } else if (opcode == kOpRepair) {
+    RepairRequest request;
+    if (parse_repair_request(&reader, &request)) {
+      repair(request, states, &response);
+    } else {
+      error_response("malformed repair request", &response);
+    }
+  } else {
+    error_response("unknown opcode", &response);
+  }
+  if (response[0] != kStatusOk) {
+    num_errors_++;
+  }
+
+  uint32_t response_length = response.size();
+  return write_full(fd, &response_length, sizeof(response_length))
+         && write_full(fd, response.data(), response.size());
+}
+
+const ResidentGraph* Server::find_graph(const std::string& name) {
+  for (size_t ii = 0; ii < graphs_->size(); ++ii) {
+    if ((*graphs_)[ii].name == name) {
+      return &(*graphs_)[ii];
+    }
+  }
+  return NULL;
+}
+
+void Server::solve(const SolveRequest& request,
+                   std::map<const ResidentGraph*, WorkerGraphState>* states,
+                   std::vector<char>* response) {
+  const ResidentGraph* graph = find_graph(request.graph_name);
+  if (graph == NULL) {
+    error_response("unknown graph " + request.graph_name, response);
+    return;
+  }
+  int num_nodes = static_cast<int>(graph->prizes.size());
+  if (request.root >= num_nodes || request.root < PCSTFast::kNoRoot) {
+    error_response("root out of range", response);
+    return;
+  }
+  if (request.pruning > PCSTFast::kStrongPruning) {
+    error_response("unknown pruning method", response);
+    return;
+  }
+  for (size_t ii = 0; ii < request.prizes.size(); ++ii) {
+    if (request.prizes[ii].first < 0 || request.prizes[ii].first >= num_nodes
+        || request.prizes[ii].second < 0.0) {
+      error_response("prize override out of range", response);
+      return;
+    }
+  }
+
+  Clock::time_point start = Clock::now();
+  WorkerGraphState& state = (*states)[graph];
+  state.prizes = graph->prizes;
+  for (size_t ii = 0; ii < request.prizes.size(); ++ii) {
+    state.prizes[request.prizes[ii].first] = request.prizes[ii].second;
+  }
+
+  // Same convention as the SQL functions: rooted solves grow to 0 clusters.
+  int num_clusters = request.root >= 0 ? 0 : request.num_clusters;
+  PCSTFast::PruningMethod pruning =
+      static_cast<PCSTFast::PruningMethod>(request.pruning);
+
+  std::vector<int> nodes;
+  std::vector<int> edges;
+  bool ok = false;
+  try {
+    if (state.solver) {
+      state.solver->reset(request.root, num_clusters, pruning);
+    } else {
+      state.solver.reset(new PCSTFast(graph->edges, state.prizes, graph->costs,
+                                      request.root, num_clusters, pruning, 0,
+                                      ignore_output));
+    }
+    PCSTFast::StepStatus status;
+    do {
+      status = state.solver->step(kSolveSliceEvents);
+    } while (status == PCSTFast::kInProgress && !stop_);
+    if (status == PCSTFast::kInProgress) {
+      error_response("server shutting down", response);
+      return;
+    }
+    state.solver->get_result(&nodes, &edges);
+    ok = status == PCSTFast::kDone;
+  } catch (const std::exception& e) {
+    state.solver.reset();
+    error_response(std::string("solver error: ") + e.what(), response);
+    return;
+  }
+  solve_latency_.record(Clock::now() - start);
+  if (!ok) {
+    error_response("solver failed", response);
+    return;
+  }
+
+  double objective = 0.0;
+  for (size_t ii = 0; ii < nodes.size(); ++ii) {
+    objective += state.prizes[nodes[ii]];
+  }
+  for (size_t ii = 0; ii < edges.size(); ++ii) {
+    objective -= graph->costs[edges[ii]];
+  }
+  solution_response(objective, nodes, edges, response);
+}
+
+void Server::repair(const RepairRequest& request,
+                    std::map<const ResidentGraph*, WorkerGraphState>* states,
+                    std::vector<char>* response) {
+  const ResidentGraph* graph = find_graph(request.graph_name);
+  if (graph == NULL) {
+    error_response("unknown graph " + request.graph_name, response);
+    return;
+  }
+  int num_nodes = static_cast<int>(graph->prizes.size());
+  int num_edges = static_cast<int>(graph->edges.size());
+  if (request.root >= num_nodes || request.root < PCSTFast::kNoRoot) {
+    error_response("root out of range", response);
+    return;
+  }
+  for (int list = 0; list < 2; ++list) {
+    const std::vector<int32_t>& edges =
+        list == 0 ? request.tree_edges : request.failed_edges;
+    for (size_t ii = 0; ii < edges.size(); ++ii) {
+      if (edges[ii] < 0 || edges[ii] >= num_edges) {
+        error_response("edge out of range", response);
+        return;
+      }
+    }
+  }
+
+  Clock::time_point start = Clock::now();
+  WorkerGraphState& state = (*states)[graph];
+  std::vector<int> tree_edges(request.tree_edges.begin(),
+                              request.tree_edges.end());
+  std::vector<int> failed_edges(request.failed_edges.begin(),
+                                request.failed_edges.end());
+  std::vector<int> nodes;
+  std::vector<int> edges;
+  try {
+    if (!state.repair) {
+      state.repair.reset(new TreeRepair(graph->edges, graph->prizes,
+                                        graph->costs));
+    }
+    state.repair->repair(tree_edges, failed_edges, request.root, false,
+                         &nodes, &edges);
+  } catch (const std::exception& e) {
+    state.repair.reset();
+    error_response(std::string("repair error: ") + e.what(), response);
+    return;
+  }
+  repair_latency_.record(Clock::now() - start);
+
+  double objective = 0.0;
+  for (size_t ii = 0; ii < nodes.size(); ++ii) {
+    objective += graph->prizes[nodes[ii]];
+  }
+  for (size_t ii = 0; ii < edges.size(); ++ii) {
+    objective -= graph->costs[edges[ii]];
+  }
+  solution_response(objective, nodes, edges, response);
+}
+
+void Server::stats(std::vector<char>* response) {
+  std::ostringstream out;
+  out << "requests " << num_requests_ << "\n";
+  out << "errors " << num_errors_ << "\n";
+  out << "threads " << num_threads_ << "\n";
+  for (size_t ii = 0; ii < graphs_->size(); ++ii) {
+    const ResidentGraph& graph = (*graphs_)[ii];
+    out << "graph." << graph.name << ".nodes " << graph.prizes.size() << "\n";
+    out << "graph." << graph.name << ".edges " << graph.edges.size() << "\n";
+  }
+  request_latency_.print("request", &out);
+  solve_latency_.print("solve", &out);
+  repair_latency_.print("repair", &out);
+
+  response->clear();
+  Writer writer(response);
+  writer.write(static_cast<uint8_t>(kStatusOk));
+  writer.write_bytes(out.str());
+}
+
+bool load_graph(const std::string& spec, ResidentGraph* graph,
+                std::string* error) {
+  size_t equals = spec.find('=');
+  if (equals == std::string::npos || equals == 0) {
+    *error = "expected NAME=FILE or NAME=EDGES.csv,NODES.csv: " + spec;
+    return false;
+  }
+  graph->name = spec.substr(0, equals);
+  std::string files = spec.substr(equals + 1);
+  size_t comma = files.find(',');
+
+  pcst_tools::Graph data;
+  bool ok = comma == std::string::npos
+      ? pcst_tools::read_graph_file(files, &data, error)
+      : pcst_tools::read_graph_csv(files.substr(0, comma),
+                                   files.substr(comma + 1), &data, error);
+  if (!ok) {
+    return false;
+  }
+
+  int num_nodes = static_cast<int>(data.prizes.size());
+  for (size_t ii = 0; ii < data.costs.size(); ++ii) {
+    if (data.sources[ii] < 0 || data.sources[ii] >= num_nodes
+        || data.targets[ii] < 0 || data.targets[ii] >= num_nodes) {
+      *error = "edge endpoint out of range in " + files;
+      return false;
+    }
+    graph->edges.push_back(std::make_pair(data.sources[ii], data.targets[ii]));
+  }
+  graph->costs.swap(data.costs);
+  graph->prizes.swap(data.prizes);
+  return true;
+}
+
+Server* running_server = NULL;
+
+void handle_signal(int) {
+  if (running_server != NULL) {
+    running_server->stop();
+  }
+}
+
+void usage(const char* program) {
+  fprintf(stderr,
+      "Usage: %s --socket <path> [--threads <n>] --graph <spec> ...\n"
+      "\n"
+      "  --socket <path>    Unix domain socket to listen on\n"
+      "  --threads <n>      solver threads (default: number of CPUs)\n"
+      "  --graph <spec>     resident graph, NAME=FILE (text format) or\n"
+      "                     NAME=EDGES.csv,NODES.csv; may be repeated\n",
+      program);
+}
+
+}  // namespace
+
+
+int main(int argc, char** argv) {
+  std::string socket_path;
+  int num_threads = std::thread::hardware_concurrency();
+  std::vector<std::string> graph_specs;
+  for (int ii = 1; ii < argc; ++ii) {
+    std::string arg = argv[ii];
+    bool has_value = ii + 1 < argc;
+    if (arg == "--socket" && has_value) {
+      socket_path = argv[++ii];
+    } else if (arg == "--threads" && has_value) {
+      num_threads = atoi(argv[++ii]);
+    } else if (arg == "--graph" && has_value) {
+      graph_specs.push_back(argv[++ii]);
+    } else {
+      usage(argv[0]);
+      return 2;
+    }
+  }
+  if (socket_path.empty() || graph_specs.empty()) {
+    usage(argv[0]);
+    return 2;
+  }
+  if (num_threads <= 0) {
+    num_threads = 1;
+  }
+
+  std::vector<ResidentGraph> graphs(graph_specs.size());
+  for (size_t ii = 0; ii < graph_specs.size(); ++ii) {
+    std::string error;
+    if (!load_graph(graph_specs[ii], &graphs[ii], &error)) {
+      fprintf(stderr, "%s\n", error.c_str());
+      return 1;
+    }
+    printf("graph %s: %zu nodes, %zu edges\n", graphs[ii].name.c_str(),
+           graphs[ii].prizes.size(), graphs[ii].edges.size());
+  }
+
+  Server server(&graphs, num_threads);
+  std::string error;
+  if (!server.listen_on(socket_path, &error)) {
+    fprintf(stderr, "%s\n", error.c_str());
+    return 1;
+  }
+
+  running_server = &server;
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = handle_signal;
+  sigaction(SIGINT, &action, NULL);
+  sigaction(SIGTERM, &action, NULL);
+
+  printf("listening on %s with %d threads\n", socket_path.c_str(),
+         num_threads);
+  fflush(stdout);
+  server.serve();
+  return 0;
+}